@@ -53,6 +53,9 @@ const HexConv = require('./util/hexConv');
 
 const MAX_SUPPORTED_ATT_MTU = 247;
 
+// Notifications queued on a connection before queueNotification asks the caller to wait
+const NOTIFICATION_QUEUE_HIGH_WATER_MARK = 16;
+
 /** Class to mediate error conditions. */
 class Error {
     /**
@@ -76,6 +79,7 @@ const _makeError = function (userMessage, description) {
  * Class representing a transport adapter (SoftDevice RPC module).
  *
  * @fires Adapter#advertiseTimedOut
+ * @fires Adapter#attributeReadsServed
  * @fires Adapter#attMtuChanged
  * @fires Adapter#authKeyRequest
  * @fires Adapter#authStatus
@@ -97,6 +101,7 @@ const _makeError = function (userMessage, description) {
  * @fires Adapter#keyPressed
  * @fires Adapter#lescDhkeyRequest
  * @fires Adapter#logMessage
+ * @fires Adapter#notificationQueueDrain
  * @fires Adapter#opened
  * @fires Adapter#passkeyDisplay
  * @fires Adapter#scanTimedOut
@@ -143,6 +148,7 @@ class Adapter extends EventEmitter {
 
         this._keys = null;
         this._attMtuMap = {};
+        this._gattCacheDirectory = null;
 
         this._init();
     }
@@ -157,8 +163,14 @@ class Adapter extends EventEmitter {
 
         this._gapOperationsMap = {};
         this._gattOperationsMap = {};
-
-        this._preparedWritesMap = {};
+        this._queuedGattOperations = {};
+        this._gattDatabases = {};
+        // The database of each device as last stored in the GATT cache
+        this._storedGattDatabases = {};
+        // Identity addresses of peers, by device instance id
+        this._identityAddresses = {};
+        this._notificationBuffers = {};
+        this._notificationQueues = {};
 
         this._pendingNotificationsAndIndications = {};
     }
@@ -407,6 +419,8 @@ class Adapter extends EventEmitter {
      * <li>{number} [retransmissionInterval=250]: The time interval to wait between retransmitted packets.
      * <li>{number} [responseTimeout=1500]: Response timeout of the data link layer.
      * <li>{boolean} [enableBLE=true]: Whether the BLE stack should be initialized and enabled.
+     * <li>{boolean} [autoConfirmIndications=false]: Whether indications should be confirmed by the binding as soon as
+     *                                               they are received, instead of after the event reaches JavaScript.
      * </ul>
      * @param {function(Error)} [callback] Callback signature: err => {}.
      * @returns {void}
@@ -440,6 +454,7 @@ class Adapter extends EventEmitter {
                 retransmissionInterval: 250,
                 responseTimeout: 1500,
                 enableBLE: true,
+                autoConfirmIndications: false,
             };
         } else {
             if (!options.baudRate) options.baudRate = 1000000;
@@ -450,8 +465,11 @@ class Adapter extends EventEmitter {
             if (!options.retransmissionInterval) options.retransmissionInterval = 250;
             if (!options.responseTimeout) options.responseTimeout = 1500;
             if (options.enableBLE === undefined) options.enableBLE = true;
+            if (options.autoConfirmIndications === undefined) options.autoConfirmIndications = false;
         }
 
+        this._autoConfirmIndications = options.autoConfirmIndications;
+
         this._changeState({
             opening: true,
             baudRate: options.baudRate,
@@ -562,6 +580,87 @@ class Adapter extends EventEmitter {
         return this._adapter.getStats();
     }
 
+    /**
+     * This function is for debugging purposes. It will return an object with one member per
+     * command that has been called on this adapter, e.g. `gattcWrite`. Each member contains:
+     * <ul>
+     * <li>{number} count: Number of completed calls
+     * <li>{number} errorCount: Number of calls that failed
+     * <li>{Object} queueWait: Time from the call until the command started in the thread pool
+     * <li>{Object} call: Time spent executing the command towards the connectivity chip
+     * <li>{Object} callbackDelay: Time from the command completed until the callback was run
+     * </ul>
+     * Each of the latencies is an object with count, total, min, max and avg in microseconds,
+     * and a buckets object with a histogram where each key is the upper bound in microseconds.
+     *
+     * @returns {Object} This adapters command latency stats.
+     */
+    getCommandStats() {
+        return this._adapter.getCommandStats();
+    }
+
+    /**
+     * Get a snapshot of this adapters metrics in the Prometheus text exposition format.
+     * It contains events received per type, entries dropped and depth of the queues to
+     * JavaScript, commands and errors per command, bytes written and notified per
+     * connection and log lines per severity.
+     *
+     * @returns {string} This adapters metrics.
+     */
+    getMetrics() {
+        return this._adapter.getMetrics();
+    }
+
+    /**
+     * Start recording a trace of commands and events. Tracing is shared by all adapters
+     * using the same SoftDevice API version. Use `stopTracing` to write the trace to file.
+     *
+     * @param {Object} [options] Optional tracing options.
+     * @param {number} [options.bufferSize=65536] Number of spans kept per thread. Older spans are overwritten.
+     * @returns {void}
+     */
+    startTracing(options) {
+        this._bleDriver.startTracing(options);
+    }
+
+    /**
+     * Stop recording and write the trace as Chrome Trace Event JSON. The file can be
+     * opened in chrome://tracing or in the Perfetto UI. Each adapter is shown as a
+     * separate process. Events and commands related to a connection have its conn_handle
+     * as argument.
+     *
+     * @param {string} path Path of the trace file to write.
+     * @param {function(Error)} [callback] Callback signature: err => {}.
+     * @returns {void}
+     */
+    stopTracing(path, callback) {
+        this._bleDriver.stopTracing(path, err => {
+            if (this._checkAndPropagateError(err, 'Failed to write trace file.', callback)) { return; }
+            if (callback) callback();
+        });
+    }
+
+    /**
+     * Enable caching of the GATT databases of peers. The services, characteristics and descriptors
+     * found by `getServices`, `getCharacteristics` and `getDescriptors` are stored in a binary file
+     * per peer identity address in the given directory, once all of them have been discovered. On
+     * later connections to the same peer they are returned from the cache instead of being
+     * discovered again.
+     *
+     * Peers with a public or random static address are cached, and peers using private addresses
+     * once they have bonded and distributed their identity address, or when the SoftDevice resolves
+     * their address. Only peers that expose a Database Hash or have bonded with us are cached. Changes on the peer are detected by reading the
+     * Database Hash before the cache is used, or by a Service Changed indication. Characteristic and
+     * descriptor values are not cached, read them with `readCharacteristicValue` and
+     * `readDescriptorValue`.
+     *
+     * @param {string|null} directory Directory of the cache files, or null to disable caching.
+     * @returns {void}
+     */
+    setGattCacheDirectory(directory) {
+        this._gattCacheDirectory = directory;
+    }
+
     /**
      * @summary Enable the BLE stack.
      *
@@ -881,6 +980,11 @@ class Adapter extends EventEmitter {
         device.connected = true;
         this._devices[device.instanceId] = device;
 
+        // The SoftDevice has resolved the private address of a peer in its identity list
+        if (deviceAddress.addr_id_peer) {
+            this._identityAddresses[device.instanceId] = deviceAddress;
+        }
+
         this._attMtuMap[device.instanceId] = this.driver.GATT_MTU_SIZE_DEFAULT || this.driver.BLE_GATT_ATT_MTU_DEFAULT;
 
         this._changeState({ connecting: false });
@@ -954,8 +1058,17 @@ class Adapter extends EventEmitter {
          */
         this.emit('deviceDisconnected', device, event.reason_name, event.reason);
 
+        // The binding has dropped the buffers of the connection when it was disconnected
+        this._stopNotificationBuffers(device);
+
+        // The binding fails the notifications still queued
+        delete this._notificationQueues[device.instanceId];
+
         this._clearDeviceFromAllPerConnectionValues(device.instanceId);
         this._clearDeviceFromDiscoveredServices(device.instanceId);
+        delete this._gattDatabases[device.instanceId];
+        delete this._storedGattDatabases[device.instanceId];
+        delete this._identityAddresses[device.instanceId];
     }
 
     _parseConnectionParameterUpdateEvent(event) {
@@ -1042,6 +1155,17 @@ class Adapter extends EventEmitter {
         const device = this._getDeviceByConnectionHandle(event.conn_handle);
         device.ownPeriphInitiatedPairingPending = false;
 
+        if (event.auth_status === this._bleDriver.BLE_GAP_SEC_STATUS_SUCCESS && event.bonded) {
+            device.paired = true;
+
+            const keysPeer = event.keyset && event.keyset.keys_peer;
+            if (keysPeer && keysPeer.id_key && event.kdist_peer && event.kdist_peer.id) {
+                this._identityAddresses[device.instanceId] = keysPeer.id_key.id_addr_info;
+            }
+
+            this._storeGattDatabase(device);
+        }
+
         /**
          * Authentication procedure completed with status.
          *
@@ -1373,7 +1497,7 @@ class Adapter extends EventEmitter {
             return;
         }
 
-        services.forEach(service => {
+        const newServices = services.map(service => {
             const handle = service.handle_range.start_handle;
             let uuid = HexConv.numberTo16BitUuid(service.uuid.uuid);
 
@@ -1400,8 +1524,12 @@ class Adapter extends EventEmitter {
                  */
                 this.emit('serviceAdded', newService);
             }
+
+            return newService;
         });
 
+        this._indexAttributes(device, newServices);
+
         const nextStartHandle = services[services.length - 1].handle_range.end_handle + 1;
 
         if (nextStartHandle > 0xFFFF) {
@@ -1455,7 +1583,7 @@ class Adapter extends EventEmitter {
         // We should only receive characteristics under one service.
         const service = this._getServiceByHandle(device.instanceId, characteristics[0].handle_decl);
 
-        characteristics.forEach(characteristic => {
+        const newCharacteristics = characteristics.map(characteristic => {
             const declarationHandle = characteristic.handle_decl;
             const valueHandle = characteristic.handle_value;
             let uuid = HexConv.numberTo16BitUuid(characteristic.uuid.uuid);
@@ -1481,8 +1609,12 @@ class Adapter extends EventEmitter {
             if (properties.read) {
                 gattOperation.pendingHandleReads[valueHandle] = newCharacteristic;
             }
+
+            return newCharacteristic;
         });
 
+        this._indexAttributes(device, newCharacteristics);
+
         const nextStartHandle = characteristics[characteristics.length - 1].handle_decl + 1;
         const handleRange = { start_handle: nextStartHandle, end_handle: service.endHandle };
 
@@ -1544,6 +1676,7 @@ class Adapter extends EventEmitter {
 
         // We should only receive descriptors under one characteristic.
         const characteristic = gattOperation.parent;
+        const newDescriptors = [];
         let foundNextServiceOrCharacteristic = false;
 
         descriptors.forEach(descriptor => {
@@ -1570,12 +1703,15 @@ class Adapter extends EventEmitter {
             const newDescriptor = new Descriptor(characteristic.instanceId, uuid, null);
             newDescriptor.handle = handle;
             this._descriptors[newDescriptor.instanceId] = newDescriptor;
+            newDescriptors.push(newDescriptor);
 
             // TODO: We cannot read descriptor 128bit uuid.
 
             gattOperation.pendingHandleReads[handle] = newDescriptor;
         });
 
+        this._indexAttributes(device, newDescriptors);
+
         if (foundNextServiceOrCharacteristic) {
             finishDescriptorDiscovery();
             return;
@@ -1708,111 +1844,36 @@ class Adapter extends EventEmitter {
                 });
                 break;
             }
-        } else {
-            if (event.gatt_status !== this._bleDriver.BLE_GATT_STATUS_SUCCESS) {
-                delete this._gattOperationsMap[device.instanceId];
-                gattOperation.callback(_makeError(`Read operation failed: ${event.gatt_status_name} (0x${HexConv.numberToHexString(event.gatt_status)})`));
-                return;
-            }
-
-            gattOperation.readBytes = gattOperation.readBytes ? gattOperation.readBytes.concat(event.data) : event.data;
-
-            if (event.data.length < this._maxReadPayloadSize(device.instanceId)) {
-                delete this._gattOperationsMap[device.instanceId];
-                gattOperation.callback(undefined, gattOperation.readBytes);
-            } else if (event.data.length === this._maxReadPayloadSize(device.instanceId)) {
-                // We need to read more:
-                this._adapter.gattcRead(event.conn_handle, event.handle, gattOperation.readBytes.length, err => {
-                    if (err) {
-                        delete this._gattOperationsMap[device.instanceId];
-                        this.emit('error', _makeError('Read value failed', err));
-                        gattOperation.callback('Failed reading at byte #' + gattOperation.readBytes.length);
-                    }
-                });
-            } else {
-                delete this._gattOperationsMap[device.instanceId];
-                this.emit('error', 'Length of Read response is > mtu');
-                gattOperation.callback('Invalid read response length. (> mtu)');
-            }
         }
     }
 
     _parseGattcWriteResponseEvent(event) {
-        // 1. Check if there is a long write in progress for this device
-        // 2a. If there is check if it is done after next write
-        // 2ai. If it is done after next write
-        //      Perform the last write and if success, exec write on fail, cancel write
-        //      callback, delete callback, delete pending write, emit
-        // 2aii. if not done, issue one more PREPARED_WRITE, update pendingwrite
-
-        // TODO: Do more checking of write response?
+        // Writes of characteristics and descriptors, including long writes, are queued in the
+        // binding, which handles their responses. Only writes made directly with gattcWrite get here.
         const device = this._getDeviceByConnectionHandle(event.conn_handle);
-        const handle = event.handle;
-        const gattOperation = this._gattOperationsMap[device.instanceId];
-
         if (!device) {
-            delete this._gattOperationsMap[device.instanceId];
-            this.emit('error', 'Failed to handle write event, no device with handle ' + device.instanceId + 'found.');
-            gattOperation.callback(_makeError('Failed to handle write event, no device with connection handle ' + event.conn_handle + 'found'));
+            this.emit('error', _makeError('Failed to handle write event, no device with connection handle ' + event.conn_handle + ' found'));
             return;
         }
 
-        if (event.write_op === this._bleDriver.BLE_GATT_OP_WRITE_CMD) {
-            gattOperation.attribute.value = gattOperation.value;
-        } else if (event.write_op === this._bleDriver.BLE_GATT_OP_PREP_WRITE_REQ) {
-
-            const writeParameters = {
-                write_op: 0,
-                flags: 0,
-                handle: handle,
-                offset: 0,
-                len: 0,
-                value: [],
-            };
-
-            if (gattOperation.bytesWritten < gattOperation.value.length) {
-                const value = gattOperation.value.slice(gattOperation.bytesWritten, gattOperation.bytesWritten + this._maxLongWritePayloadSize(device.instanceId));
-
-                writeParameters.write_op = this._bleDriver.BLE_GATT_OP_PREP_WRITE_REQ;
-                writeParameters.handle = handle;
-                writeParameters.offset = gattOperation.bytesWritten;
-                writeParameters.len = value.length;
-                writeParameters.value = value;
-                gattOperation.bytesWritten += value.length;
-
-                this._adapter.gattcWrite(device.connectionHandle, writeParameters, err => {
-
-                    if (err) {
-                        this._longWriteCancel(device, gattOperation.attribute);
-                        this.emit('error', _makeError('Failed to write value to device/handle ' + device.instanceId + '/' + handle, err));
-                        return;
-                    }
-                });
-            } else {
-                writeParameters.write_op = this._bleDriver.BLE_GATT_OP_EXEC_WRITE_REQ;
-                writeParameters.flags = this._bleDriver.BLE_GATT_EXEC_WRITE_FLAG_PREPARED_WRITE;
+        const gattOperation = this._gattOperationsMap[device.instanceId];
+        if (!gattOperation || !gattOperation.attribute) {
+            return;
+        }
 
-                this._adapter.gattcWrite(device.connectionHandle, writeParameters, err => {
+        if (event.write_op !== this._bleDriver.BLE_GATT_OP_WRITE_REQ &&
+            event.write_op !== this._bleDriver.BLE_GATT_OP_EXEC_WRITE_REQ) {
+            return;
+        }
 
-                    if (err) {
-                        this._longWriteCancel(device, gattOperation.attribute);
-                        this.emit('error', _makeError('Failed to write value to device/handle ' + device.instanceId + '/' + handle, err));
-                        return;
-                    }
-                });
-            }
+        delete this._gattOperationsMap[device.instanceId];
 
+        if (event.gatt_status !== this._bleDriver.BLE_GATT_STATUS_SUCCESS) {
+            gattOperation.callback(_makeError(`Write operation failed: ${event.gatt_status_name} (0x${HexConv.numberToHexString(event.gatt_status)})`));
             return;
-        } else if (event.write_op === this._bleDriver.BLE_GATT_OP_WRITE_REQ ||
-                   event.write_op === this._bleDriver.BLE_GATT_OP_EXEC_WRITE_REQ) {
-            gattOperation.attribute.value = gattOperation.value;
-            delete this._gattOperationsMap[device.instanceId];
-            if (event.gatt_status !== this._bleDriver.BLE_GATT_STATUS_SUCCESS) {
-                gattOperation.callback(_makeError(`Write operation failed: ${event.gatt_status_name} (0x${HexConv.numberToHexString(event.gatt_status)})`));
-                return;
-            }
         }
 
+        gattOperation.attribute.value = gattOperation.value;
         this._emitAttributeValueChanged(gattOperation.attribute);
 
         gattOperation.callback(undefined, gattOperation.attribute);
@@ -1860,6 +1921,17 @@ class Adapter extends EventEmitter {
         return _.find(this._characteristics, characteristic => this._services[characteristic.serviceInstanceId].deviceInstanceId === devinceInstanceId && characteristic.valueHandle === valueHandle);
     }
 
+    _getCharacteristicByEvent(device, event) {
+        // The binding annotates the event with the instance id of attributes registered with _indexAttributes
+        const characteristic = this._characteristics[event.attribute_instance_id];
+
+        if (characteristic && characteristic.valueHandle === event.handle) {
+            return characteristic;
+        }
+
+        return this._getCharacteristicByValueHandle(device.instanceId, event.handle);
+    }
+
     _getDescriptorByHandle(deviceInstanceId, handle) {
         const characteristic = this._getCharacteristicByHandle(deviceInstanceId, handle);
 
@@ -1908,7 +1980,7 @@ class Adapter extends EventEmitter {
     }
 
     _parseGattcHvxEvent(event) {
-        if (event.type === this._bleDriver.BLE_GATT_HVX_INDICATION) {
+        if (event.type === this._bleDriver.BLE_GATT_HVX_INDICATION && !this._autoConfirmIndications) {
             this._adapter.gattcConfirmHandleValue(event.conn_handle, event.handle, error => {
                 if (error) {
                     this.emit('error', _makeError('Failed to call gattcConfirmHandleValue', error));
@@ -1917,12 +1989,17 @@ class Adapter extends EventEmitter {
         }
 
         const device = this._getDeviceByConnectionHandle(event.conn_handle);
-        const characteristic = this._getCharacteristicByValueHandle(device.instanceId, event.handle);
+        const characteristic = this._getCharacteristicByEvent(device, event);
         if (!characteristic) {
             this.emit('logMessage', logLevel.DEBUG, `Cannot handle HVX event. No characteristic value with handle ${event.handle} found.`);
             return;
         }
 
+        if (characteristic.uuid === '2A05') {
+            // Service Changed, the cached attribute table of the peer is no longer valid.
+            this._removeGattDatabase(device);
+        }
+
         characteristic.value = event.data;
         this.emit('characteristicValueChanged', characteristic);
     }
@@ -1991,7 +2068,6 @@ class Adapter extends EventEmitter {
     }
 
     _parseGattsRWAutorizeRequestEvent(event) {
-        const device = this._getDeviceByConnectionHandle(event.conn_handle);
         let promiseChain = new Promise(resolve => resolve());
         let authorizeReplyParams;
 
@@ -2026,59 +2102,18 @@ class Adapter extends EventEmitter {
                         data: event.write.data,
                     },
                 };
-            } else if (event.write.op === this._bleDriver.BLE_GATTS_OP_PREP_WRITE_REQ) {
-                if (!this._preparedWritesMap[device.instanceId]) {
-                    this._preparedWritesMap[device.instanceId] = [];
-                }
-
-                let preparedWrites = this._preparedWritesMap[device.instanceId];
-                preparedWrites = preparedWrites.concat({ handle: event.write.handle, value: event.write.data, offset: event.write.offset });
-
-                this._preparedWritesMap[device.instanceId] = preparedWrites;
-
-                authorizeReplyParams = {
-                    type: event.type,
-                    write: {
-                        gatt_status: this._bleDriver.BLE_GATT_STATUS_SUCCESS,
-                        update: 1,
-                        offset: event.write.offset,
-                        len: event.write.len,
-                        data: event.write.data,
-                    },
-                };
-
-            } else if (event.write.op === this._bleDriver.BLE_GATTS_OP_EXEC_WRITE_REQ_CANCEL) {
-                delete this._preparedWritesMap[device.instanceId];
-
-                authorizeReplyParams = {
-                    type: event.type,
-                    write: {
-                        gatt_status: this._bleDriver.BLE_GATT_STATUS_SUCCESS,
-                        update: 0,
-                        offset: 0,
-                        len: 0,
-                        data: [],
-                    },
-                };
             } else if (event.write.op === this._bleDriver.BLE_GATTS_OP_EXEC_WRITE_REQ_NOW) {
-                for (let preparedWrite of this._preparedWritesMap[device.instanceId]) {
-                    promiseChain = promiseChain.then(() => {
-                        createWritePromise(preparedWrite.handle, preparedWrite.value, preparedWrite.offset);
-                    });
-                }
+                // The binding queues, executes and replies to prepared writes. The values are already set.
+                for (const preparedWrite of event.executed_writes || []) {
+                    const attribute = this._getAttributeByHandle('local.server', preparedWrite.handle);
 
-                delete this._preparedWritesMap[device.instanceId];
+                    if (attribute) {
+                        this._setAttributeValueWithOffset(attribute, preparedWrite.value, preparedWrite.offset);
+                        this._emitAttributeValueChanged(attribute);
+                    }
+                }
 
-                authorizeReplyParams = {
-                    type: event.type,
-                    write: {
-                        gatt_status: this._bleDriver.BLE_GATT_STATUS_SUCCESS,
-                        update: 0,
-                        offset: 0,
-                        len: 0,
-                        data: [],
-                    },
-                };
+                return;
             }
         } else if (event.type === this._bleDriver.BLE_GATTS_AUTHORIZE_TYPE_READ) {
             authorizeReplyParams = {
@@ -2798,7 +2833,7 @@ class Adapter extends EventEmitter {
             return;
         }
 
-        if (this._gattOperationsMap[device.instanceId]) {
+        if (this._isGattOperationInProgress(device)) {
             this.emit('error', _makeError('Failed to request att mtu. A GATT operation already in progress.'));
             return;
         }
@@ -3178,150 +3213,66 @@ class Adapter extends EventEmitter {
      * @returns {void}
      */
     setServices(services, callback) {
-        let decodeUUID = (uuid, data) => {
-            return new Promise((resolve, reject) => {
-                const length = uuid.length === 32 ? 16 : 2;
+        let tableCharacteristics = service => service._factory_characteristics || [];
 
-                this._adapter.decodeUUID(length, uuid, (err, _uuid) => {
-                    if (err) {
-                        // If the UUID is not found it is a 128-bit UUID
-                        // so we have to add it to the SD and try again
-                        if (err.errno === this._bleDriver.NRF_ERROR_NOT_FOUND && length === 16) {
-                            this._converter.uuidToDriver(uuid, (err, type) => {
-                                if (err) {
-                                    reject(_makeError(`Unable to add UUID ${uuid} to SoftDevice`, err));
-                                } else {
-                                    this._adapter.decodeUUID(length, uuid, (err, _uuid) => {
-                                        if (err) {
-                                            reject(_makeError(`Unable to decode UUID ${uuid}`, err));
-                                        } else {
-                                            data.decoded_uuid = _uuid;
-                                            resolve(data);
-                                        }
-                                    });
-                                }
-                            });
-                        } else {
-                            reject(_makeError(`Unable to decode UUID ${uuid}`, err));
-                        }
-                    } else {
-                        data.decoded_uuid = _uuid;
-                        resolve(data);
-                    }
-                });
-            });
+        // CCCD, SCCD and User Description descriptors are added with their characteristic
+        let tableDescriptors = characteristic => (characteristic._factory_descriptors || []).filter(descriptor => {
+            return !this._converter.isSpecialUUID(descriptor.uuid);
+        });
+
+        let serviceToTable = service => {
+            return {
+                type: this._getServiceType(service),
+                uuid: service.uuid.replace(/-/g, ''),
+                characteristics: tableCharacteristics(service).map(characteristic => {
+                    const characteristicForDriver = this._converter.characteristicToTable(characteristic);
+
+                    return {
+                        metadata: characteristicForDriver.metadata,
+                        attribute: characteristicForDriver.attribute,
+                        descriptors: tableDescriptors(characteristic).map(descriptor => this._converter.descriptorToTable(descriptor)),
+                    };
+                }),
+            };
         };
 
-        let addService = (service, type, data) => {
-            return new Promise((resolve, reject) => {
-                var p = Promise.resolve(data);
-                var decode = decodeUUID.bind(undefined, service.uuid);
+        let setCharacteristicHandles = (characteristic, handles) => {
+            characteristic.valueHandle = handles.value_handle;
+            characteristic.declarationHandle = characteristic.valueHandle - 1; // valueHandle is always directly after declarationHandle
+            this._characteristics[characteristic.instanceId] = characteristic;
 
-                p.then(decode).then(data => {
-                    this._adapter.gattsAddService(type, data.decoded_uuid, (err, serviceHandle) => {
-                        if (err) {
-                            reject(_makeError('Error occurred adding service.', err));
-                        } else {
-                            data.serviceHandle = serviceHandle;
-                            service.startHandle = serviceHandle;
-                            this._services[service.instanceId] = service; // TODO: what if we fail later on this service ?
-                            resolve(data);
-                        }
-                    });
-                }).catch(err => {
-                    reject(err);
-                });
-            });
-        };
+            if (!characteristic._factory_descriptors) {
+                return;
+            }
 
-        let addCharacteristic = (characteristic, data) => {
-            return new Promise((resolve, reject) => {
-                this._converter.characteristicToDriver(characteristic, (err, characteristicForDriver) => {
-                    if (err) {
-                        reject(_makeError('Error converting characteristic to driver.', err));
-                    } else {
-                        this._adapter.gattsAddCharacteristic(
-                            data.serviceHandle,
-                            characteristicForDriver.metadata,
-                            characteristicForDriver.attribute,
-                            (err, handles) => {
-                                if (err) {
-                                    reject(_makeError('Error occurred adding characteristic.', err));
-                                } else {
-                                    characteristic.valueHandle = data.characteristicHandle = handles.value_handle;
-                                    characteristic.declarationHandle = characteristic.valueHandle - 1; // valueHandle is always directly after declarationHandle
-                                    this._characteristics[characteristic.instanceId] = characteristic; // TODO: what if we fail later on this ?
-                                    resolve(data);
-
-                                    if (!characteristic._factory_descriptors) {
-                                        return;
-                                    }
-
-                                    const findDescriptor = uuid => {
-                                        return characteristic._factory_descriptors.find(descriptor => {
-                                            return descriptor.uuid === uuid;
-                                        });
-                                    };
-
-                                    if (handles.user_desc_handle) {
-                                        const userDescriptionDescriptor = findDescriptor('2901');
-                                        this._descriptors[userDescriptionDescriptor.instanceId] = userDescriptionDescriptor;
-                                        userDescriptionDescriptor.handle = handles.user_desc_handle;
-                                    }
-
-                                    if (handles.cccd_handle) {
-                                        const cccdDescriptor = findDescriptor('2902');
-                                        this._descriptors[cccdDescriptor.instanceId] = cccdDescriptor;
-                                        cccdDescriptor.handle = handles.cccd_handle;
-                                        cccdDescriptor.value = {};
-
-                                        for (let deviceInstanceId in this._devices) {
-                                            this._setDescriptorValue(cccdDescriptor, [0, 0], deviceInstanceId);
-                                        }
-                                    }
-
-                                    if (handles.sccd_handle) {
-                                        const sccdDescriptor = findDescriptor('2903');
-                                        this._descriptors[sccdDescriptor.instanceId] = sccdDescriptor;
-                                        sccdDescriptor.handle = handles.sccd_handle;
-                                    }
-                                }
-                            }
-                        );
-                    }
+            const findDescriptor = uuid => {
+                return characteristic._factory_descriptors.find(descriptor => {
+                    return descriptor.uuid === uuid;
                 });
-            });
-        };
+            };
 
-        let addDescriptor = (descriptor, data) => {
-            return new Promise((resolve, reject) => {
-                this._converter.descriptorToDriver(descriptor, (err, descriptorForDriver) => {
-                    if (err) {
-                        reject(_makeError('Error converting descriptor.', err));
-                    } else if (descriptorForDriver) {
-                        this._adapter.gattsAddDescriptor(
-                            data.characteristicHandle,
-                            descriptorForDriver,
-                            (err, handle) => {
-                                if (err) {
-                                    reject(_makeError(err, 'Error adding descriptor.'));
-                                } else {
-                                    descriptor.handle = data.descriptorHandle = handle;
-                                    this._descriptors[descriptor.instanceId] = descriptor; // TODO: what if we fail later on this ?
-                                    resolve(data);
-                                }
-                            }
-                        );
-                    }
-                });
-            });
-        };
+            if (handles.user_desc_handle) {
+                const userDescriptionDescriptor = findDescriptor('2901');
+                this._descriptors[userDescriptionDescriptor.instanceId] = userDescriptionDescriptor;
+                userDescriptionDescriptor.handle = handles.user_desc_handle;
+            }
+
+            if (handles.cccd_handle) {
+                const cccdDescriptor = findDescriptor('2902');
+                this._descriptors[cccdDescriptor.instanceId] = cccdDescriptor;
+                cccdDescriptor.handle = handles.cccd_handle;
+                cccdDescriptor.value = {};
+
+                for (let deviceInstanceId in this._devices) {
+                    this._setDescriptorValue(cccdDescriptor, [0, 0], deviceInstanceId);
+                }
+            }
 
-        let promiseSequencer = (list, data) => {
-            var p = Promise.resolve(data);
-            return list.reduce((previousP, nextP) => {
-                return previousP.then(nextP);
-            }, p);
+            if (handles.sccd_handle) {
+                const sccdDescriptor = findDescriptor('2903');
+                this._descriptors[sccdDescriptor.instanceId] = sccdDescriptor;
+                sccdDescriptor.handle = handles.sccd_handle;
+            }
         };
 
         let applyGapServiceCharacteristics = gapService => {
@@ -3362,12 +3313,10 @@ class Adapter extends EventEmitter {
             }
         };
 
-        // Create array of function objects to call in sequence.
-        var promises = [];
+        // The GAP and GATT services are there already, the rest of the table is added with one call.
+        const tableServices = [];
 
         for (let service of services) {
-            var p;
-
             if (service.uuid === '1800') {
                 service.startHandle = 1;
                 service.endHandle = 7;
@@ -3381,34 +3330,52 @@ class Adapter extends EventEmitter {
                 continue;
             }
 
-            p = addService.bind(undefined, service, this._getServiceType(service));
-            promises.push(p);
+            tableServices.push(service);
+        }
 
-            if (service._factory_characteristics) {
-                for (let characteristic of service._factory_characteristics) {
-                    p = addCharacteristic.bind(undefined, characteristic);
-                    promises.push(p);
+        let table;
 
-                    if (characteristic._factory_descriptors) {
-                        for (let descriptor of characteristic._factory_descriptors) {
-                            if (!this._converter.isSpecialUUID(descriptor.uuid)) {
-                                p = addDescriptor.bind(undefined, descriptor);
-                                promises.push(p);
-                            }
-                        }
-                    }
-                }
-            }
+        try {
+            table = tableServices.map(serviceToTable);
+        } catch (err) {
+            const error = _makeError('Error converting services to driver.', err);
+            this.emit('error', error);
+            if (callback) { callback(error); }
+            return;
         }
 
-        // Execute the promises in sequence, start with an empty object that
-        // is propagated to all promises.
-        promiseSequencer(promises, {}).then(data => {
-            // TODO: Ierate over all servicses, descriptors, characterstics from parameter services
+        this._adapter.gattsBuildTable(table, (err, handles) => {
+            if (err) {
+                const error = _makeError('Error occurred building GATT table.', err);
+                this.emit('error', error);
+                if (callback) { callback(error); }
+                return;
+            }
+
+            // Bases of vendor specific UUIDs registered by the binding
+            for (let vendorUuid of handles.vendor_uuids) {
+                this._converter.addVsUuid(vendorUuid.uuid, vendorUuid.type);
+            }
+
+            tableServices.forEach((service, serviceIndex) => {
+                const serviceHandles = handles.services[serviceIndex];
+
+                service.startHandle = serviceHandles.handle;
+                this._services[service.instanceId] = service;
+
+                tableCharacteristics(service).forEach((characteristic, characteristicIndex) => {
+                    const characteristicHandles = serviceHandles.characteristics[characteristicIndex];
+
+                    setCharacteristicHandles(characteristic, characteristicHandles);
+
+                    tableDescriptors(characteristic).forEach((descriptor, descriptorIndex) => {
+                        descriptor.handle = characteristicHandles.descriptor_handles[descriptorIndex];
+                        this._descriptors[descriptor.instanceId] = descriptor;
+                    });
+                });
+            });
+
             if (callback) { callback(); }
-        }).catch(err => {
-            this.emit('error', err);
-            if (callback) { callback(err); }
         });
     }
 
@@ -3435,7 +3402,7 @@ class Adapter extends EventEmitter {
         // TODO: Implement something for when device is local
         const device = this.getDevice(deviceInstanceId);
 
-        if (this._gattOperationsMap[device.instanceId]) {
+        if (this._isGattOperationInProgress(device)) {
             this.emit('error', _makeError('Failed to get services, a GATT operation already in progress'));
             return;
         }
@@ -3450,13 +3417,50 @@ class Adapter extends EventEmitter {
             return;
         }
 
-        this._gattOperationsMap[device.instanceId] = { callback: callback, pendingHandleReads: {}, parent: device };
-        this._adapter.gattcDiscoverPrimaryServices(device.connectionHandle, 1, null, (err, services) => {
-            if (err) {
-                this.emit('error', _makeError('Failed to get services', err));
-                if (callback) { callback(err); }
+        const servicesCallback = (err, services) => {
+            // Also kept for peers that are cached only once they have bonded
+            if (!err && this._gattCacheDirectory) {
+                this._gattDatabases[device.instanceId] = {
+                    hash: null,
+                    hashHandle: 0,
+                    services: services.map(service => ({
+                        startHandle: service.startHandle,
+                        endHandle: service.endHandle,
+                        uuid: service.uuid,
+                        characteristics: null,
+                    })),
+                };
+                this._storeGattDatabase(device);
+            }
+
+            if (callback) { callback(err, services); }
+        };
+
+        const discoverServices = () => {
+            this._gattOperationsMap[device.instanceId] = { callback: servicesCallback, pendingHandleReads: {}, parent: device };
+            this._adapter.gattcDiscoverPrimaryServices(device.connectionHandle, 1, null, (err, services) => {
+                if (err) {
+                    this.emit('error', _makeError('Failed to get services', err));
+                    if (callback) { callback(err); }
+                    return;
+                }
+            });
+        };
+
+        if (!this._isGattCacheable(device)) {
+            discoverServices();
+            return;
+        }
+
+        this._loadGattDatabase(device, database => {
+            if (!database) {
+                discoverServices();
                 return;
             }
+
+            const services = this._addServicesFromGattDatabase(device, database);
+            this._storedGattDatabases[device.instanceId] = database;
+            if (callback) { callback(undefined, services); }
         });
     }
 
@@ -3492,7 +3496,7 @@ class Adapter extends EventEmitter {
 
         const device = this.getDevice(service.deviceInstanceId);
 
-        if (this._gattOperationsMap[device.instanceId]) {
+        if (this._isGattOperationInProgress(device)) {
             this._checkAndPropagateError(undefined, 'Failed to get characteristics, a gatt operation already in progress', callback);
             return;
         }
@@ -3506,13 +3510,49 @@ class Adapter extends EventEmitter {
             return;
         }
 
+        const cachedService = this._getCachedService(device, service);
+
+        if (cachedService && cachedService.characteristics) {
+            const characteristics = this._addCharacteristicsFromGattDatabase(service, cachedService);
+            if (callback) { callback(undefined, characteristics); }
+            return;
+        }
+
+        const characteristicsCallback = (err, characteristics) => {
+            if (!err && cachedService) {
+                const database = this._gattDatabases[device.instanceId];
+
+                cachedService.characteristics = characteristics.map(characteristic => ({
+                    declarationHandle: characteristic.declarationHandle,
+                    valueHandle: characteristic.valueHandle,
+                    uuid: characteristic.uuid,
+                    properties: characteristic.properties,
+                    descriptors: null,
+                }));
+
+                // The Database Hash of the Generic Attribute service is used to validate the cache.
+                if (service.uuid === '1801') {
+                    const hashCharacteristic = _.find(characteristics, characteristic => characteristic.uuid === '2B2A');
+
+                    if (hashCharacteristic && hashCharacteristic.value && hashCharacteristic.value.length === 16) {
+                        database.hash = hashCharacteristic.value;
+                        database.hashHandle = hashCharacteristic.valueHandle;
+                    }
+                }
+
+                this._storeGattDatabase(device);
+            }
+
+            if (callback) { callback(err, characteristics); }
+        };
+
         const handleRange = {
             start_handle: service.startHandle,
             end_handle: service.endHandle
         };
 
         this._gattOperationsMap[device.instanceId] = {
-            callback: callback,
+            callback: characteristicsCallback,
             pendingHandleReads: {},
             parent: service
         };
@@ -3594,36 +3634,238 @@ class Adapter extends EventEmitter {
         return newCollection;
     }
 
-    /**
-     * Initiate or continue a GATT Characteristic Descriptor Discovery procedure.
-     *
-     * @param {string} characteristicId Unique ID of of the GATT characteristic.
-     * @param {function(Error, Descriptor[])} [callback] Callback signature: (err, descriptors) => {} where
-     *                                        `descriptors` is an array of `Descriptor` instances corresponding to the
-     *                                        discovered GATT descriptors attached to the characteristic.
-     * @returns {void}
-     */
-    getDescriptors(characteristicId, callback) {
-        const characteristic = this.getCharacteristic(characteristicId);
-        const service = this.getService(characteristic.serviceInstanceId);
-        const device = this.getDevice(service.deviceInstanceId);
+    _isGattCacheable(device) {
+        return !!this._gattCacheDirectory && !!this._gattCacheAddress(device);
+    }
 
-        if (this._gattOperationsMap[device.instanceId]) {
-            this.emit('error', _makeError('Failed to get descriptors, a gatt operation already in progress', undefined));
-            return;
+    _gattCacheAddress(device) {
+        const identity = this._identityAddresses[device.instanceId];
+
+        if (identity) {
+            return identity.address;
         }
 
-        const alreadyFoundDescriptor = _.filter(this._descriptors, descriptor => {
-            return characteristicId === descriptor.characteristicInstanceId;
-        });
+        // Resolvable and non-resolvable private addresses do not identify the peer across connections.
+        if (device.addressType === 'BLE_GAP_ADDR_TYPE_PUBLIC' || device.addressType === 'BLE_GAP_ADDR_TYPE_RANDOM_STATIC') {
+            return device.address;
+        }
 
-        if (!_.isEmpty(alreadyFoundDescriptor)) {
+        return null;
+    }
+
+    _isGattDatabaseComplete(database) {
+        return database.services.every(service => {
+            return service.characteristics && service.characteristics.every(characteristic => characteristic.descriptors);
+        });
+    }
+
+    _loadGattDatabase(device, callback) {
+        this._bleDriver.gattCacheLoad(this._gattCacheDirectory, this._gattCacheAddress(device), (err, database) => {
+            if (err || !database || !database.hash || !database.hashHandle) {
+                callback(err ? null : database);
+                return;
+            }
+
+            // Hold the GATT operation of the device while the Database Hash read from the peer
+            // is verified against the cached one.
+            this._gattOperationsMap[device.instanceId] = { parent: device };
+
+            const chunkSize = this._maxReadPayloadSize(device.instanceId);
+
+            this._queueGattOperation(device, done => this._adapter.gattcQueueLongRead(device.connectionHandle, database.hashHandle, chunkSize, done), (readErr, hash) => {
+                delete this._gattOperationsMap[device.instanceId];
+
+                if (readErr || !_.isEqual(hash, database.hash)) {
+                    this.emit('logMessage', logLevel.DEBUG, `Database Hash of ${device.address} changed, discovering services.`);
+                    callback(null);
+                    return;
+                }
+
+                callback(database);
+            });
+        });
+    }
+
+    _addServicesFromGattDatabase(device, database) {
+        this._gattDatabases[device.instanceId] = database;
+
+        const services = database.services.map(cachedService => {
+            const service = new Service(device.instanceId, cachedService.uuid);
+            service.startHandle = cachedService.startHandle;
+            service.endHandle = cachedService.endHandle;
+            this._services[service.instanceId] = service;
+            this.emit('serviceAdded', service);
+            return service;
+        });
+
+        this._indexAttributes(device, services);
+        return services;
+    }
+
+    _addCharacteristicsFromGattDatabase(service, cachedService) {
+        const characteristics = cachedService.characteristics.map(cachedCharacteristic => {
+            const characteristic = new Characteristic(service.instanceId, cachedCharacteristic.uuid, [], cachedCharacteristic.properties);
+            characteristic.declarationHandle = cachedCharacteristic.declarationHandle;
+            characteristic.valueHandle = cachedCharacteristic.valueHandle;
+            this._characteristics[characteristic.instanceId] = characteristic;
+            this.emit('characteristicAdded', characteristic);
+            return characteristic;
+        });
+
+        this._indexAttributes(this.getDevice(service.deviceInstanceId), characteristics);
+        return characteristics;
+    }
+
+    _addDescriptorsFromGattDatabase(characteristic, cachedCharacteristic) {
+        const descriptors = cachedCharacteristic.descriptors.map(cachedDescriptor => {
+            const descriptor = new Descriptor(characteristic.instanceId, cachedDescriptor.uuid, null);
+            descriptor.handle = cachedDescriptor.handle;
+            this._descriptors[descriptor.instanceId] = descriptor;
+            this.emit('descriptorAdded', descriptor);
+            return descriptor;
+        });
+
+        const service = this._services[characteristic.serviceInstanceId];
+        this._indexAttributes(this.getDevice(service.deviceInstanceId), descriptors);
+        return descriptors;
+    }
+
+    _indexAttributes(device, attributes) {
+        const entries = [];
+
+        attributes.forEach(attribute => {
+            if (attribute instanceof Service) {
+                entries.push({ handle: attribute.startHandle, instanceId: attribute.instanceId });
+            } else if (attribute instanceof Characteristic) {
+                entries.push({ handle: attribute.declarationHandle, instanceId: attribute.instanceId });
+                entries.push({ handle: attribute.valueHandle, instanceId: attribute.instanceId });
+            } else if (attribute instanceof Descriptor) {
+                entries.push({ handle: attribute.handle, instanceId: attribute.instanceId });
+            }
+        });
+
+        if (entries.length > 0) {
+            this._adapter.gattcIndexAttributes(device.connectionHandle, entries);
+        }
+    }
+
+    _getCachedService(device, service) {
+        const database = this._gattDatabases[device.instanceId];
+
+        if (!database) {
+            return undefined;
+        }
+
+        return _.find(database.services, cachedService => cachedService.startHandle === service.startHandle);
+    }
+
+    _getCachedCharacteristic(device, service, characteristic) {
+        const cachedService = this._getCachedService(device, service);
+
+        if (!cachedService || !cachedService.characteristics) {
+            return undefined;
+        }
+
+        return _.find(cachedService.characteristics, cachedCharacteristic => {
+            return cachedCharacteristic.declarationHandle === characteristic.declarationHandle;
+        });
+    }
+
+    _storeGattDatabase(device) {
+        const database = this._gattDatabases[device.instanceId];
+
+        // Without a Database Hash changes are only announced to bonded peers by Service Changed.
+        if (!database || !this._isGattCacheable(device) || !(database.hash || device.paired)) {
+            return;
+        }
+
+        // Stored once, when the discovery of the peer is complete.
+        if (this._storedGattDatabases[device.instanceId] === database || !this._isGattDatabaseComplete(database)) {
+            return;
+        }
+
+        const address = this._gattCacheAddress(device);
+        this._storedGattDatabases[device.instanceId] = database;
+
+        try {
+            this._bleDriver.gattCacheStore(this._gattCacheDirectory, address, database, err => {
+                if (err) {
+                    this.emit('logMessage', logLevel.WARNING, `Failed to store GATT cache of ${address}: ${err.message}`);
+                }
+            });
+        } catch (error) {
+            // Attributes with unresolved UUIDs can not be cached.
+            this.emit('logMessage', logLevel.DEBUG, `Not storing GATT cache of ${address}: ${error.message}`);
+        }
+    }
+
+    _removeGattDatabase(device) {
+        delete this._gattDatabases[device.instanceId];
+        delete this._storedGattDatabases[device.instanceId];
+
+        if (!this._isGattCacheable(device)) {
+            return;
+        }
+
+        const address = this._gattCacheAddress(device);
+
+        this._bleDriver.gattCacheRemove(this._gattCacheDirectory, address, err => {
+            if (err) {
+                this.emit('logMessage', logLevel.WARNING, `Failed to remove GATT cache of ${address}: ${err.message}`);
+            }
+        });
+    }
+
+    /**
+     * Initiate or continue a GATT Characteristic Descriptor Discovery procedure.
+     *
+     * @param {string} characteristicId Unique ID of of the GATT characteristic.
+     * @param {function(Error, Descriptor[])} [callback] Callback signature: (err, descriptors) => {} where
+     *                                        `descriptors` is an array of `Descriptor` instances corresponding to the
+     *                                        discovered GATT descriptors attached to the characteristic.
+     * @returns {void}
+     */
+    getDescriptors(characteristicId, callback) {
+        const characteristic = this.getCharacteristic(characteristicId);
+        const service = this.getService(characteristic.serviceInstanceId);
+        const device = this.getDevice(service.deviceInstanceId);
+
+        if (this._isGattOperationInProgress(device)) {
+            this.emit('error', _makeError('Failed to get descriptors, a gatt operation already in progress', undefined));
+            return;
+        }
+
+        const alreadyFoundDescriptor = _.filter(this._descriptors, descriptor => {
+            return characteristicId === descriptor.characteristicInstanceId;
+        });
+
+        if (!_.isEmpty(alreadyFoundDescriptor)) {
             if (callback) { callback(undefined, alreadyFoundDescriptor); }
             return;
         }
 
+        const cachedCharacteristic = this._getCachedCharacteristic(device, service, characteristic);
+
+        if (cachedCharacteristic && cachedCharacteristic.descriptors) {
+            const descriptors = this._addDescriptorsFromGattDatabase(characteristic, cachedCharacteristic);
+            if (callback) { callback(undefined, descriptors); }
+            return;
+        }
+
+        const descriptorsCallback = (err, descriptors) => {
+            if (!err && cachedCharacteristic) {
+                cachedCharacteristic.descriptors = descriptors.map(descriptor => ({
+                    handle: descriptor.handle,
+                    uuid: descriptor.uuid,
+                }));
+                this._storeGattDatabase(device);
+            }
+
+            if (callback) { callback(err, descriptors); }
+        };
+
         const handleRange = { start_handle: characteristic.valueHandle + 1, end_handle: service.endHandle };
-        this._gattOperationsMap[device.instanceId] = { callback, pendingHandleReads: {}, parent: characteristic };
+        this._gattOperationsMap[device.instanceId] = { callback: descriptorsCallback, pendingHandleReads: {}, parent: characteristic };
         this._adapter.gattcDiscoverDescriptors(device.connectionHandle, handleRange, err => {
             //this._checkAndPropagateError('Failed to get descriptors', err, callback);
         });
@@ -3725,6 +3967,70 @@ class Adapter extends EventEmitter {
             .catch(error => { if (callback) callback(error); });
     }
 
+    /**
+     * Discovers all services, characteristics and descriptors of a device in one procedure. The discovery
+     * runs in the native binding, which answers each response with the next request without a round trip
+     * to JavaScript. Vendor specific UUIDs are resolved as well. Attributes found earlier for the device are
+     * replaced, and `getServices`, `getCharacteristics` and `getDescriptors` return the found attributes
+     * right away. Characteristic and descriptor values are not read. The result is stored in the GATT cache
+     * if enabled, see `setGattCacheDirectory`.
+     *
+     * @param {string} deviceInstanceId The device's unique Id.
+     * @param {function(Error, Object)} [callback] Callback signature: (err, attributes) => {} where `attributes` contains
+     *                                           the device's GATT attributes in the same format as `getAttributes`.
+     * @returns {void}
+     */
+    discoverAll(deviceInstanceId, callback) {
+        const device = this.getDevice(deviceInstanceId);
+
+        if (this._isGattOperationInProgress(device)) {
+            const error = _makeError('Failed to discover attributes, a GATT operation already in progress');
+            this.emit('error', error);
+            if (callback) { callback(error); }
+            return;
+        }
+
+        // Keep other GATT operations out while the binding runs the discovery.
+        this._gattOperationsMap[device.instanceId] = { parent: device };
+
+        this._adapter.gattcDiscoverAll(device.connectionHandle, (err, database) => {
+            delete this._gattOperationsMap[device.instanceId];
+
+            if (this._checkAndPropagateError(err, 'Failed to discover attributes', callback)) {
+                return;
+            }
+
+            this._clearDeviceFromDiscoveredServices(device.instanceId);
+
+            const data = { services: {} };
+            const services = this._addServicesFromGattDatabase(device, database);
+
+            services.forEach((service, serviceIndex) => {
+                const cachedService = database.services[serviceIndex];
+                data.services[service.instanceId] = service;
+                service.characteristics = {};
+
+                const characteristics = this._addCharacteristicsFromGattDatabase(service, cachedService);
+
+                characteristics.forEach((characteristic, characteristicIndex) => {
+                    const cachedCharacteristic = cachedService.characteristics[characteristicIndex];
+                    service.characteristics[characteristic.instanceId] = characteristic;
+                    characteristic.descriptors = {};
+
+                    const descriptors = this._addDescriptorsFromGattDatabase(characteristic, cachedCharacteristic);
+
+                    descriptors.forEach(descriptor => {
+                        characteristic.descriptors[descriptor.instanceId] = descriptor;
+                    });
+                });
+            });
+
+            this._storeGattDatabase(device);
+
+            if (callback) { callback(undefined, data); }
+        });
+    }
+
     /**
      * Reads the value of a GATT characteristic.
      *
@@ -3750,17 +4056,7 @@ class Adapter extends EventEmitter {
             throw new Error('Characteristic value read failed: Could not get device');
         }
 
-        if (this._gattOperationsMap[device.instanceId]) {
-            throw new Error('Characteristic value read failed: A gatt operation already in progress with device id ' + device.instanceId);
-        }
-
-        this._gattOperationsMap[device.instanceId] = { callback: callback, readBytes: [] };
-
-        this._adapter.gattcRead(device.connectionHandle, characteristic.valueHandle, 0, err => {
-            if (err) {
-                this.emit('error', _makeError('Read characteristic value failed', err));
-            }
-        });
+        this._readValue(device, characteristic.valueHandle, 'Read characteristic value failed', callback);
     }
 
     /**
@@ -3769,7 +4065,8 @@ class Adapter extends EventEmitter {
      * @param {string} characteristicId Unique ID of the GATT characteristic.
      * @param {array} value The value (array of bytes) to be written.
      * @param {boolean} ack Require acknowledge from device, irrelevant in GATTS role.
-     * @param {function(Error)} completeCallback Callback signature: err => {}
+     * @param {function(Error)} completeCallback Callback signature: err => {}. Without `ack` it is called when the
+     *                                           SoftDevice has accepted the write command, not when it has been sent.
      * @param {function} deviceNotifiedOrIndicated TODO
      * @returns {void}
      */
@@ -3789,24 +4086,58 @@ class Adapter extends EventEmitter {
             throw new Error('Characteristic value write failed: Could not get device');
         }
 
-        if (this._gattOperationsMap[device.instanceId]) {
-            throw new Error('Characteristic value write failed: A gatt operation already in progress with device id ' + device.instanceId);
+        if (value.length <= this._maxShortWritePayloadSize(device.instanceId)) {
+            this._shortWrite(device, characteristic, value, ack, completeCallback);
+            return;
         }
 
-        this._gattOperationsMap[device.instanceId] = { callback: completeCallback, bytesWritten: 0, value: value.slice(), attribute: characteristic };
+        if (!ack) {
+            throw new Error('Long writes do not support BLE_GATT_OP_WRITE_CMD');
+        }
 
-        if (value.length > this._maxShortWritePayloadSize(device.instanceId)) {
-            if (!ack) {
-                delete this._gattOperationsMap[device.instanceId];
-                throw new Error('Long writes do not support BLE_GATT_OP_WRITE_CMD');
-            }
+        this._longWrite(device, characteristic, value, completeCallback);
+    }
 
-            this._gattOperationsMap[device.instanceId].bytesWritten = this._maxLongWritePayloadSize(device.instanceId);
-            this._longWrite(device, characteristic, value, completeCallback);
-        } else {
-            this._gattOperationsMap[device.instanceId].bytesWritten = value.length;
-            this._shortWrite(device, characteristic, value, ack, completeCallback);
+    /**
+     * Writes data to a GATT characteristic as a stream of write commands (write without response).
+     *
+     * The binding splits the data in chunks of the current ATT MTU and keeps the transmit queue of the SoftDevice
+     * full, so that every connection event can be used.
+     *
+     * @param {string} characteristicId Unique ID of the GATT characteristic.
+     * @param {Buffer|array} data The data (Buffer or array of bytes) to be written.
+     * @param {function(number, number)} [progress] Progress signature: (bytesWritten, bytesTotal) => {}, called for
+     *                                              every batch of write commands accepted by the SoftDevice.
+     * @param {function(Error, number)} [callback] Callback signature: (err, bytesWritten) => {}, called when all
+     *                                             data is accepted by the SoftDevice.
+     * @returns {void}
+     */
+    writeCharacteristicValueStream(characteristicId, data, progress, callback) {
+        const characteristic = this.getCharacteristic(characteristicId);
+        if (!characteristic) {
+            throw new Error('Characteristic value stream failed: Could not get characteristic with id ' + characteristicId);
+        }
+
+        const device = this._getDeviceByCharacteristicId(characteristicId);
+        if (!device) {
+            throw new Error('Characteristic value stream failed: Could not get device');
         }
+
+        const chunkSize = this._maxShortWritePayloadSize(device.instanceId);
+        const progressCallback = (bytesWritten, bytesTotal) => {
+            if (progress) { progress(bytesWritten, bytesTotal); }
+        };
+
+        this._queueGattOperation(device, done => this._adapter.gattcWriteStream(device.connectionHandle, characteristic.valueHandle, data, chunkSize, progressCallback, done), (err, bytesWritten) => {
+            if (err) {
+                const error = _makeError(`Failed to stream to characteristic with handle: ${characteristic.valueHandle}: ${err.message}`);
+                this.emit('error', error);
+                if (callback) callback(error);
+                return;
+            }
+
+            if (callback) { callback(undefined, bytesWritten); }
+        });
     }
 
     _getDeviceByDescriptorId(descriptorId) {
@@ -3880,16 +4211,46 @@ class Adapter extends EventEmitter {
             throw new Error('Descriptor read failed: Could not get device');
         }
 
-        if (this._gattOperationsMap[device.instanceId]) {
-            throw new Error('Descriptor read failed: A gatt operation already in progress with device with id ' + device.instanceId);
+        this._readValue(device, descriptor.handle, 'Read descriptor value failed', callback);
+    }
+
+    /**
+     * Reads the values of many attributes of a device with as few requests as possible. Attributes
+     * of known length are read together with Read Multiple requests that fit the ATT MTU, the
+     * others are read one at a time.
+     *
+     * @param {string} deviceInstanceId The device's unique Id.
+     * @param {Array<number|Object>} attributes Handles of the attributes, or objects with the
+     *                                          <code>handle</code> and the fixed <code>length</code> of the value.
+     * @param {function(Error, Object)} [callback] Callback signature: (err, values) => {} where
+     *                                             <code>values</code> maps each handle to its value.
+     * @returns {void}
+     */
+    readMany(deviceInstanceId, attributes, callback) {
+        const device = this.getDevice(deviceInstanceId);
+        if (!device) {
+            throw new Error('Read many failed: Could not get device with id ' + deviceInstanceId);
         }
 
-        this._gattOperationsMap[device.instanceId] = { callback: callback, readBytes: [] };
+        if (attributes.length === 0) {
+            if (callback) { callback(undefined, {}); }
+            return;
+        }
 
-        this._adapter.gattcRead(device.connectionHandle, descriptor.handle, 0, err => {
+        const chunkSize = this._maxReadPayloadSize(device.instanceId);
+
+        this._queueGattOperation(device, done => this._adapter.gattcQueueReadMany(device.connectionHandle, attributes, chunkSize, done), (err, values) => {
             if (err) {
-                this.emit('error', _makeError('Read descriptor value failed', err));
+                // Errors from the peer are for the caller only, as they are part of normal operation
+                if (err.gatt_status === undefined) {
+                    this.emit('error', _makeError('Read many failed', err));
+                }
+
+                if (callback) { callback(err); }
+                return;
             }
+
+            if (callback) { callback(undefined, values); }
         });
     }
 
@@ -3901,6 +4262,8 @@ class Adapter extends EventEmitter {
      * @param {boolean} ack Require acknowledge from device, irrelevant in GATTS role.
      * @param {function(Error)} [callback] Callback signature: err => {}.
      *                                   (not called until ack is received if `requireAck`).
+     *                                   Without `ack` it is called when the SoftDevice has accepted the
+     *                                   write command, not when it has been sent.
      *                                   options: {ack, long, offset}
      * @returns {void}
      */
@@ -3921,24 +4284,16 @@ class Adapter extends EventEmitter {
             throw new Error('Descriptor write failed: Could not get device');
         }
 
-        if (this._gattOperationsMap[device.instanceId]) {
-            throw new Error('Descriptor write failed: A gatt operation already in progress with device with id ' + device.instanceId);
+        if (value.length <= this._maxShortWritePayloadSize(device.instanceId)) {
+            this._shortWrite(device, descriptor, value, ack, callback);
+            return;
         }
 
-        this._gattOperationsMap[device.instanceId] = { callback: callback, bytesWritten: 0, value: value.slice(), attribute: descriptor };
-
-        if (value.length > this._maxShortWritePayloadSize(device.instanceId)) {
-            if (!ack) {
-                delete this._gattOperationsMap[device.instanceId];
-                throw new Error('Long writes do not support BLE_GATT_OP_WRITE_CMD');
-            }
-
-            this._gattOperationsMap[device.instanceId].bytesWritten = this._maxLongWritePayloadSize(device.instanceId);
-            this._longWrite(device, descriptor, value, callback);
-        } else {
-            this._gattOperationsMap[device.instanceId].bytesWritten = value.length;
-            this._shortWrite(device, descriptor, value, ack, callback);
+        if (!ack) {
+            throw new Error('Long writes do not support BLE_GATT_OP_WRITE_CMD');
         }
+
+        this._longWrite(device, descriptor, value, callback);
     }
 
     _shortWrite(device, attribute, value, ack, callback) {
@@ -3951,61 +4306,57 @@ class Adapter extends EventEmitter {
             value,
         };
 
-        Promise.resolve()
-            .then(() => {
-                if (ack) {
-                    return this._shortWriteWithResponse(device, writeParameters);
-                }
-                return this._shortWriteWithoutResponse(device, writeParameters)
-                    .then(() => {
-                        delete this._gattOperationsMap[device.instanceId];
-                        attribute.value = value;
-                        if (callback) { callback(undefined, attribute); }
-                    });
-            })
-            .catch(err => {
-                delete this._gattOperationsMap[device.instanceId];
+        // Write commands are done when the SoftDevice has accepted them, write requests when the peer has responded.
+        this._queueGattOperation(device, done => this._adapter.gattcQueueWrite(device.connectionHandle, writeParameters, done), err => {
+            if (err) {
                 const error = _makeError(`Failed to write to attribute with handle: ${attribute.handle}: ${err.message}`);
                 this.emit('error', error);
                 if (callback) callback(error);
-            });
+                return;
+            }
+
+            attribute.value = value;
+
+            if (ack) {
+                this._emitAttributeValueChanged(attribute);
+            }
+
+            if (callback) { callback(undefined, attribute); }
+        });
     }
 
-    _shortWriteWithResponse(device, writeParameters) {
-        return new Promise((resolve, reject) => {
-            this._adapter.gattcWrite(device.connectionHandle, writeParameters, err => {
-                if (err) {
-                    reject(err);
-                } else {
-                    resolve();
+    _readValue(device, handle, errorMessage, callback) {
+        // The binding continues reading at the next offset as long as the responses are full.
+        const chunkSize = this._maxReadPayloadSize(device.instanceId);
+
+        this._queueGattOperation(device, done => this._adapter.gattcQueueLongRead(device.connectionHandle, handle, chunkSize, done), (err, readBytes) => {
+            if (err) {
+                // Errors from the peer are for the caller only, as they are part of normal operation
+                if (err.gatt_status === undefined) {
+                    this.emit('error', _makeError(errorMessage, err));
                 }
-            });
+
+                if (callback) { callback(err); }
+                return;
+            }
+
+            if (callback) { callback(undefined, readBytes); }
         });
     }
 
-    _shortWriteWithoutResponse(device, writeParameters) {
-        let timeoutId;
+    _queueGattOperation(device, queue, callback) {
+        // The binding issues the queued operations of a connection in order, as the ATT bearer allows.
+        this._queuedGattOperations[device.instanceId] = (this._queuedGattOperations[device.instanceId] || 0) + 1;
 
-        return Promise.race([
-            new Promise((resolve, reject) => {
-                const txCompleteHandler = txCompleteDevice => {
-                    if (device.connectionHandle === txCompleteDevice.connectionHandle) {
-                        this.removeListener('txComplete', txCompleteHandler);
-                        clearTimeout(timeoutId);
-                        resolve();
-                    }
-                };
-                this.on('txComplete', txCompleteHandler);
-                this._adapter.gattcWrite(device.connectionHandle, writeParameters, err => {
-                    if (err) reject(err);
-                });
-            }),
-            new Promise((resolve, reject) => {
-                timeoutId = setTimeout(() => {
-                    reject(_makeError('Timed out while waiting for BLE_EVT_TX_COMPLETE'));
-                }, 4000);
-            }),
-        ]);
+        queue((err, data) => {
+            this._queuedGattOperations[device.instanceId] -= 1;
+            callback(err, data);
+        });
+    }
+
+    _isGattOperationInProgress(device) {
+        // Procedures with several requests, in _gattOperationsMap, cannot share the connection with queued operations.
+        return !!this._gattOperationsMap[device.instanceId] || this._queuedGattOperations[device.instanceId] > 0;
     }
 
     _longWrite(device, attribute, value, callback) {
@@ -4013,45 +4364,21 @@ class Adapter extends EventEmitter {
             throw new Error('Wrong write method. Use regular write for payload sizes < ' + this._maxShortWritePayloadSize(device.instanceId));
         }
 
-        const writeParameters = {
-            write_op: this._bleDriver.BLE_GATT_OP_PREP_WRITE_REQ,
-            flags: this._bleDriver.BLE_GATT_EXEC_WRITE_FLAG_PREPARED_WRITE,
-            handle: attribute.handle,
-            offset: 0,
-            len: this._maxLongWritePayloadSize(device.instanceId),
-            value: value.slice(0, this._maxLongWritePayloadSize(device.instanceId)),
-        };
+        // The binding prepares the value in chunks and executes the write, or cancels it on failure.
+        const chunkSize = this._maxLongWritePayloadSize(device.instanceId);
 
-        this._adapter.gattcWrite(device.connectionHandle, writeParameters, err => {
+        this._queueGattOperation(device, done => this._adapter.gattcQueueLongWrite(device.connectionHandle, attribute.handle, value, chunkSize, done), err => {
             if (err) {
-                this._longWriteCancel(device, attribute);
-                this.emit('error', _makeError('Failed to write value to device/handle ' + device.instanceId + '/' + attribute.handle, err));
+                const error = _makeError(`Failed to write value to device/handle ${device.instanceId}/${attribute.handle}: ${err.message}`);
+                this.emit('error', error);
+                if (callback) callback(error);
                 return;
             }
 
-        });
-    }
-
-    _longWriteCancel(device, attribute) {
-        const gattOperation = this._gattOperationsMap[device.instanceId];
-        const writeParameters = {
-            write_op: this._bleDriver.BLE_GATT_OP_EXEC_WRITE_REQ,
-            flags: this._bleDriver.BLE_GATT_EXEC_WRITE_FLAG_PREPARED_CANCEL,
-            handle: attribute.handle,
-            offset: 0,
-            len: 0,
-            value: [],
-        };
-
-        this._adapter.gattcWrite(device.connectionHandle, writeParameters, err => {
-            delete this._gattOperationsMap[device.instanceId];
+            attribute.value = value;
+            this._emitAttributeValueChanged(attribute);
 
-            if (err) {
-                this.emit('error', _makeError('Failed to cancel failed long write', err));
-                gattOperation.callback('Failed to write and failed to cancel write');
-            } else {
-                gattOperation.callback('Failed to write value to device/handle ' + device.instanceId + '/' + attribute.handle);
-            }
+            if (callback) { callback(undefined, attribute); }
         });
     }
 
@@ -4290,10 +4617,542 @@ class Adapter extends EventEmitter {
                 this.emit('error', 'Failed to stop characteristics notifications');
             }
 
+            // Notifications not drained by now are discarded
+            if (characteristicId in this._notificationBuffers) {
+                this._stopNotificationBuffer(characteristicId);
+            }
+
+            if (callback) { callback(err); }
+        });
+    }
+
+    /**
+     * Writes the CCCDs of many characteristics, on one or more devices, at once. The writes to a
+     * device are queued in the binding, the writes to different devices are in flight in parallel.
+     *
+     * Only for GATT central role.
+     *
+     * @param {Array<Object>} subscriptions Objects with the <code>characteristicId</code> and the
+     *                                      <code>mode</code>: 0 to stop, 1 for notifications and 2 for indications.
+     * @param {function(Error, Array)} [callback] Callback signature: (err, errors) => {}. <code>err</code> is set if
+     *                                            any of the writes failed, <code>errors</code> has the error of each
+     *                                            subscription, or undefined if it succeeded.
+     * @returns {void}
+     */
+    subscribeMany(subscriptions, callback) {
+        const writes = subscriptions.map(subscription => {
+            const cccdDescriptor = this._getCCCDOfCharacteristic(subscription.characteristicId);
+            if (!cccdDescriptor) {
+                throw new Error('Subscribe many failed: Could not find CCCD descriptor with parent characteristic id: ' + subscription.characteristicId);
+            }
+
+            const device = this._getDeviceByCharacteristicId(subscription.characteristicId);
+            if (!device) {
+                throw new Error('Subscribe many failed: Could not get device');
+            }
+
+            return { device, descriptor: cccdDescriptor, mode: subscription.mode };
+        });
+
+        if (writes.length === 0) {
+            if (callback) { callback(undefined, []); }
+            return;
+        }
+
+        const devices = _.uniq(writes.map(write => write.device));
+        devices.forEach(device => {
+            this._queuedGattOperations[device.instanceId] = (this._queuedGattOperations[device.instanceId] || 0) + 1;
+        });
+
+        const cccdWrites = writes.map(write => ({
+            conn_handle: write.device.connectionHandle,
+            cccd_handle: write.descriptor.handle,
+            mode: write.mode,
+        }));
+
+        this._adapter.gattcSubscribeMany(cccdWrites, (err, errors) => {
+            devices.forEach(device => {
+                this._queuedGattOperations[device.instanceId] -= 1;
+            });
+
+            writes.forEach((write, index) => {
+                if (!errors[index]) {
+                    write.descriptor.value = [write.mode, 0];
+                    this._emitAttributeValueChanged(write.descriptor);
+                }
+            });
+
+            const failed = errors.filter(error => error);
+            if (failed.length > 0) {
+                const error = _makeError(`Subscribe many failed: ${failed.length} of ${writes.length} CCCD writes failed, first error: ${failed[0].message}`);
+                if (callback) { callback(error, errors); }
+                return;
+            }
+
+            if (callback) { callback(undefined, errors); }
+        });
+    }
+
+    /**
+     * Starts notifications on a GATT characteristic, buffering them in the binding instead of
+     * emitting <code>characteristicValueChanged</code> for each of them. The notifications are
+     * read in batches with <code>drainCharacteristicNotifications</code>. When the buffer is
+     * full, the oldest notifications are dropped. The buffer is dropped when the device
+     * disconnects, along with the notifications not drained by then.
+     *
+     * Only for GATT central role.
+     *
+     * @param {string} characteristicId Unique ID of the GATT characteristic.
+     * @param {number} capacity Size of the buffer in bytes of notification data.
+     * @param {function(Error)} [callback] Callback signature: err => {}.
+     * @returns {void}
+     */
+    startCharacteristicsNotificationBuffer(characteristicId, capacity, callback) {
+        const characteristic = this._characteristics[characteristicId];
+        if (!characteristic) {
+            throw new Error('Start characteristic notification buffer failed: Could not get characteristic with id ' + characteristicId);
+        }
+
+        const device = this._getDeviceByCharacteristicId(characteristicId);
+        if (!device) {
+            throw new Error('Start characteristic notification buffer failed: Could not get device');
+        }
+
+        this._adapter.gattcStartNotificationBuffer(device.connectionHandle, characteristic.valueHandle, capacity);
+        this._notificationBuffers[characteristicId] = device.instanceId;
+
+        this.startCharacteristicsNotifications(characteristicId, false, err => {
+            if (err) {
+                this._stopNotificationBuffer(characteristicId);
+            }
+
             if (callback) { callback(err); }
         });
     }
 
+    /**
+     * Takes the notifications buffered since the previous drain.
+     *
+     * @param {string} characteristicId Unique ID of the GATT characteristic.
+     * @returns {Object} Batch with the payloads concatenated in <code>data</code> (Buffer), the
+     *                   start of each payload in <code>offsets</code>, when each notification was
+     *                   received in <code>timestamps</code> (milliseconds of a monotonic clock), and
+     *                   the number of notifications <code>dropped</code> as the buffer was full.
+     */
+    drainCharacteristicNotifications(characteristicId) {
+        const characteristic = this._characteristics[characteristicId];
+        if (!characteristic || !(characteristicId in this._notificationBuffers)) {
+            throw new Error('Drain characteristic notifications failed: No notification buffer for characteristic with id ' + characteristicId);
+        }
+
+        const device = this.getDevice(this._notificationBuffers[characteristicId]);
+        return this._adapter.gattcDrainNotificationBuffer(device.connectionHandle, characteristic.valueHandle);
+    }
+
+    _stopNotificationBuffer(characteristicId) {
+        const device = this.getDevice(this._notificationBuffers[characteristicId]);
+        const characteristic = this._characteristics[characteristicId];
+
+        if (device && characteristic) {
+            this._adapter.gattcStopNotificationBuffer(device.connectionHandle, characteristic.valueHandle);
+        }
+
+        delete this._notificationBuffers[characteristicId];
+    }
+
+    _stopNotificationBuffers(device) {
+        for (const characteristicId of Object.keys(this._notificationBuffers)) {
+            if (this._notificationBuffers[characteristicId] === device.instanceId) {
+                this._stopNotificationBuffer(characteristicId);
+            }
+        }
+    }
+
+    /**
+     * Queues a notification of a local characteristic to a device. The binding sends the queued
+     * notifications as fast as the SoftDevice accepts them, and continues by itself when packets
+     * have been sent. As with writable streams, the return value tells when the caller should
+     * wait for <code>notificationQueueDrain</code> before queueing more.
+     *
+     * Only for GATT peripheral role. The device must have enabled notifications in the CCCD.
+     *
+     * @param {string} deviceInstanceId The device to notify.
+     * @param {string} characteristicId Unique ID of the local GATT characteristic.
+     * @param {Array<number>|Buffer} value Value to notify.
+     * @param {function(Error)} [callback] Callback signature: err => {}, called when the SoftDevice
+     *                                     has accepted the notification.
+     * @returns {boolean} false if the queue of the device is full.
+     */
+    queueNotification(deviceInstanceId, characteristicId, value, callback) {
+        const device = this.getDevice(deviceInstanceId);
+        if (!device) {
+            throw new Error('Queue notification failed: No device with instance id: ' + deviceInstanceId);
+        }
+
+        const characteristic = this._characteristics[characteristicId];
+        if (!characteristic || !this._instanceIdIsOnLocalDevice(characteristicId)) {
+            throw new Error('Queue notification failed: Could not get local characteristic with id ' + characteristicId);
+        }
+
+        if (!this._notificationQueues[deviceInstanceId]) {
+            this._notificationQueues[deviceInstanceId] = { queued: 0, full: false };
+        }
+
+        const queue = this._notificationQueues[deviceInstanceId];
+        queue.queued += 1;
+
+        this._adapter.gattsQueueNotification(device.connectionHandle, characteristic.valueHandle, value, err => {
+            queue.queued -= 1;
+
+            if (err) {
+                if (callback) { callback(_makeError('Failed to send notification', err)); }
+            } else {
+                this.emit('deviceNotifiedOrIndicated', device, characteristic);
+                if (callback) { callback(); }
+            }
+
+            if (queue.full && queue.queued === 0 && this._notificationQueues[deviceInstanceId] === queue) {
+                queue.full = false;
+
+                /**
+                 * All notifications queued to a device have been accepted by the SoftDevice,
+                 * after <code>queueNotification</code> returned false.
+                 *
+                 * @event Adapter#notificationQueueDrain
+                 * @type {Object}
+                 * @property {Device} device - The <code>Device</code> instance representing the BLE peer.
+                 */
+                this.emit('notificationQueueDrain', device);
+            }
+        });
+
+        if (queue.queued >= NOTIFICATION_QUEUE_HIGH_WATER_MARK) {
+            queue.full = true;
+        }
+
+        return !queue.full;
+    }
+
+    /**
+     * Notifies a local characteristic value to all devices that have enabled notifications in its
+     * CCCD. The binding tracks the CCCD writes of the devices, and queues a notification to each
+     * subscribed device as with <code>queueNotification</code>.
+     *
+     * Only for GATT peripheral role.
+     *
+     * @param {string} characteristicId Unique ID of the local GATT characteristic.
+     * @param {Array<number>|Buffer} value Value to notify.
+     * @param {function(Error, Object)} [callback] Callback signature: (err, errors) => {}. <code>err</code> is set if
+     *                                             any of the notifications failed, <code>errors</code> has the error
+     *                                             of each notified device by instance id, or undefined if it succeeded.
+     * @returns {void}
+     */
+    notifyAll(characteristicId, value, callback) {
+        const characteristic = this._characteristics[characteristicId];
+        if (!characteristic || !this._instanceIdIsOnLocalDevice(characteristicId)) {
+            throw new Error('Notify all failed: Could not get local characteristic with id ' + characteristicId);
+        }
+
+        this._adapter.gattsNotifyAll(characteristic.valueHandle, value, (err, results) => {
+            const errors = {};
+            let failed = 0;
+
+            Object.keys(results).forEach(connectionHandle => {
+                const device = this._getDeviceByConnectionHandle(Number(connectionHandle));
+                if (!device) {
+                    return;
+                }
+
+                errors[device.instanceId] = results[connectionHandle];
+
+                if (results[connectionHandle]) {
+                    failed += 1;
+                } else {
+                    this.emit('deviceNotifiedOrIndicated', device, characteristic);
+                }
+            });
+
+            if (failed > 0) {
+                const error = _makeError(`Notify all failed: ${failed} of ${Object.keys(errors).length} notifications failed`);
+                if (callback) { callback(error, errors); }
+                return;
+            }
+
+            if (callback) { callback(undefined, errors); }
+        });
+    }
+
+    /**
+     * Queues an indication of a local characteristic to a device. The binding issues the queued
+     * indications one at a time, and issues the next one as soon as the device confirms the previous
+     * one, without waiting for the <code>Adapter</code> to handle the confirmation.
+     *
+     * Indications are not shared by the weights set with <code>setNotificationWeight</code>. A device
+     * has at most one indication waiting for confirmation, so it can not take more than one packet of
+     * the link per round trip, however many indications are queued to it.
+     *
+     * Only for GATT peripheral role. The device must have enabled indications in the CCCD.
+     *
+     * @param {string} deviceInstanceId The device to indicate to.
+     * @param {string} characteristicId Unique ID of the local GATT characteristic.
+     * @param {Array<number>|Buffer} value Value to indicate.
+     * @param {function(Error)} [callback] Callback signature: err => {}, called when the device has
+     *                                     confirmed the indication, or with an error if it did not
+     *                                     within the timeout set with <code>setIndicationTimeout</code>.
+     * @returns {void}
+     */
+    queueIndication(deviceInstanceId, characteristicId, value, callback) {
+        const device = this.getDevice(deviceInstanceId);
+        if (!device) {
+            throw new Error('Queue indication failed: No device with instance id: ' + deviceInstanceId);
+        }
+
+        const characteristic = this._characteristics[characteristicId];
+        if (!characteristic || !this._instanceIdIsOnLocalDevice(characteristicId)) {
+            throw new Error('Queue indication failed: Could not get local characteristic with id ' + characteristicId);
+        }
+
+        this._adapter.gattsQueueIndication(device.connectionHandle, characteristic.valueHandle, value, err => {
+            if (err) {
+                if (callback) { callback(_makeError('Failed to send indication', err)); }
+                return;
+            }
+
+            this.emit('deviceNotifiedOrIndicated', device, characteristic);
+            if (callback) { callback(); }
+        });
+    }
+
+    /**
+     * Sets the time a device has to confirm an indication queued with <code>queueIndication</code>.
+     * Indications that are not confirmed in time fail with a timeout error. The device can not be
+     * sent more indications before it confirms, or the ATT transaction times out after 30 seconds.
+     *
+     * @param {number} milliseconds The timeout. Default 30000.
+     * @returns {void}
+     */
+    setIndicationTimeout(milliseconds) {
+        this._adapter.gattsSetIndicationTimeout(milliseconds);
+    }
+
+    /**
+     * Sets the share of a device in the notifications sent with <code>queueNotification</code> and
+     * <code>notifyAll</code>. While several devices have notifications queued, the binding takes
+     * turns between them, and a device with weight 2 is given twice the bytes of a device with
+     * weight 1 in each turn. A device has at most 4 notifications per unit of weight waiting in the
+     * SoftDevice to be sent, so the weights share the link also while the SoftDevice has room for
+     * all of them. All devices start with weight 1, and the weight is kept until the device
+     * disconnects. The time notifications wait in the queues is reported by <code>getMetrics</code>.
+     * Indications queued with <code>queueIndication</code> are sent one at a time as they are
+     * confirmed, and are not counted in the turns.
+     *
+     * Only for GATT peripheral role.
+     *
+     * @param {string} deviceInstanceId The device to set the weight of.
+     * @param {number} weight Weight of the device, an integer larger than 0.
+     * @returns {void}
+     */
+    setNotificationWeight(deviceInstanceId, weight) {
+        const device = this.getDevice(deviceInstanceId);
+        if (!device) {
+            throw new Error('Set notification weight failed: No device with instance id: ' + deviceInstanceId);
+        }
+
+        this._adapter.gattsSetConnectionWeight(device.connectionHandle, weight);
+    }
+
+    /**
+     * Keeps the value of a local characteristic or descriptor with read or write authorization in
+     * the binding. The binding replies to the authorize requests of the attribute as soon as they
+     * are received, instead of passing them on to the <code>Adapter</code>. Accepted writes update
+     * the value of the attribute, and reads are reported in batches with
+     * <code>attributeReadsServed</code>. Values set with <code>writeCharacteristicValue</code> or
+     * <code>writeDescriptorValue</code> are served from then on.
+     *
+     * Prepared writes are queued and executed by the binding whether or not the attribute has a store.
+     * The store rejects them with its rejectStatus when writes are rejected, and with
+     * BLE_GATT_STATUS_ATTERR_INVALID_ATT_VAL_LENGTH when they do not fit in maxLength. The queue is
+     * executed only if all of its writes fit in the attributes, otherwise none of them is applied.
+     *
+     * Only for GATT peripheral role.
+     *
+     * @param {string} attributeId Unique ID of the local characteristic or descriptor.
+     * @param {Object} [options] The options of the store:
+     *                           <ul>
+     *                           <li>{boolean} serveReads: Reply to reads with the value. Default true.
+     *                           <li>{string} writes: 'accept' to write into the value, 'reject' to reject writes, or
+     *                               'pass' to handle them in the <code>Adapter</code>. Default 'accept'.
+     *                           <li>{number} maxLength: Writes longer than this are rejected. Default the maxLength of
+     *                               the attribute.
+     *                           <li>{number} rejectStatus: GATT status of rejected writes. Default
+     *                               BLE_GATT_STATUS_ATTERR_WRITE_NOT_PERMITTED.
+     *                           </ul>
+     * @returns {void}
+     */
+    startLocalAttributeStore(attributeId, options) {
+        const attribute = this._getLocalAttribute(attributeId);
+        if (!attribute) {
+            throw new Error('Start local attribute store failed: Could not get local attribute with id ' + attributeId);
+        }
+
+        const storeOptions = Object.assign({
+            serveReads: true,
+            writes: 'accept',
+            maxLength: attribute.maxLength,
+            rejectStatus: this._bleDriver.BLE_GATT_STATUS_ATTERR_WRITE_NOT_PERMITTED,
+        }, options);
+
+        this._adapter.gattsSetAttributeStore(this._getLocalValueHandle(attribute), {
+            value: attribute.value || [],
+            serve_reads: storeOptions.serveReads,
+            write_policy: storeOptions.writes,
+            max_length: storeOptions.maxLength,
+            reject_status: storeOptions.rejectStatus,
+        }, summary => {
+            if (summary.reads !== undefined) {
+                /**
+                 * Reads of a local attribute were served by the binding, see
+                 * <code>startLocalAttributeStore</code>.
+                 *
+                 * @event Adapter#attributeReadsServed
+                 * @type {Object}
+                 * @property {Characteristic|Descriptor} attribute - The attribute that was read.
+                 * @property {number} reads - Number of reads since the previous event.
+                 */
+                this.emit('attributeReadsServed', attribute, summary.reads);
+                return;
+            }
+
+            attribute.value = summary.value;
+            this._emitAttributeValueChanged(attribute);
+        });
+    }
+
+    /**
+     * Passes the authorize requests of a local attribute to the <code>Adapter</code> again.
+     *
+     * @param {string} attributeId Unique ID of the local characteristic or descriptor.
+     * @returns {void}
+     */
+    stopLocalAttributeStore(attributeId) {
+        const attribute = this._getLocalAttribute(attributeId);
+        if (!attribute) {
+            throw new Error('Stop local attribute store failed: Could not get local attribute with id ' + attributeId);
+        }
+
+        this._adapter.gattsClearAttributeStore(this._getLocalValueHandle(attribute));
+    }
+
+    /**
+     * Sets the values of many local characteristics and descriptors in one call. Buffers are passed
+     * to the SoftDevice without being copied, they are read in a worker thread until the callback is
+     * called. Changing a Buffer before then races with the worker and may set a mix of the old and
+     * the new contents. The values of the <code>Characteristic</code> and <code>Descriptor</code>
+     * objects are not updated, read them with <code>getLocalValues</code>.
+     *
+     * Only for GATT peripheral role.
+     *
+     * @param {Array<Object>} values Objects with the <code>attributeId</code>, the <code>value</code> (Buffer or
+     *                               array of numbers) and optionally the <code>offset</code> to write at.
+     * @param {function(Error, Array)} [callback] Callback signature: (err, errors) => {}. <code>err</code> is set if
+     *                                            any of the values failed, <code>errors</code> has the error of each
+     *                                            value, or undefined if it was set.
+     * @returns {void}
+     */
+    setLocalValues(values, callback) {
+        const writes = values.map(value => {
+            const attribute = this._getLocalAttribute(value.attributeId);
+            if (!attribute) {
+                throw new Error('Set local values failed: Could not get local attribute with id ' + value.attributeId);
+            }
+
+            return { handle: this._getLocalValueHandle(attribute), offset: value.offset || 0, value: value.value };
+        });
+
+        this._adapter.gattsSetValues(this._bleDriver.BLE_CONN_HANDLE_INVALID, writes, (err, errors) => {
+            const failed = errors.filter(error => error);
+            if (failed.length > 0) {
+                const error = _makeError(`Set local values failed: ${failed.length} of ${writes.length} values failed, first error: ${failed[0].message}`);
+                if (callback) { callback(error, errors); }
+                return;
+            }
+
+            if (callback) { callback(undefined, errors); }
+        });
+    }
+
+    /**
+     * Gets the values of many local characteristics and descriptors in one call. The values are
+     * Buffers that share the memory the binding read them into.
+     *
+     * Only for GATT peripheral role.
+     *
+     * @param {Array<string>} attributeIds Unique IDs of the local characteristics and descriptors.
+     * @param {function(Error, Object)} callback Callback signature: (err, values) => {}. <code>values</code> has
+     *                                           the value of each attribute by attribute id.
+     * @returns {void}
+     */
+    getLocalValues(attributeIds, callback) {
+        const handles = attributeIds.map(attributeId => {
+            const attribute = this._getLocalAttribute(attributeId);
+            if (!attribute) {
+                throw new Error('Get local values failed: Could not get local attribute with id ' + attributeId);
+            }
+
+            return this._getLocalValueHandle(attribute);
+        });
+
+        this._adapter.gattsGetValues(this._bleDriver.BLE_CONN_HANDLE_INVALID, handles, (err, result) => {
+            if (err) {
+                const error = _makeError('Get local values failed', err);
+                this.emit('error', error);
+                callback(error);
+                return;
+            }
+
+            const values = {};
+            attributeIds.forEach((attributeId, index) => {
+                const end = index + 1 < result.offsets.length ? result.offsets[index + 1] : result.data.length;
+                values[attributeId] = result.data.subarray(result.offsets[index], end);
+            });
+
+            callback(undefined, values);
+        });
+    }
+
+    _getLocalAttribute(attributeId) {
+        if (!this._instanceIdIsOnLocalDevice(attributeId)) {
+            return undefined;
+        }
+
+        return this._characteristics[attributeId] || this._descriptors[attributeId];
+    }
+
+    _getLocalValueHandle(attribute) {
+        return attribute instanceof Characteristic ? attribute.valueHandle : attribute.handle;
+    }
+
+    /**
+     * Persists the system attributes, i.e. the CCCD values, of bonded centrals in a directory, one
+     * file for each identity address. When a bonded central connects again, the binding restores its
+     * system attributes before the <code>Adapter</code> is told that they are missing, so that
+     * notifications can be sent right away without the central writing its CCCDs again.
+     *
+     * Centrals connecting with a public or static address are recognized by that address. The
+     * identity resolving keys that centrals distribute when bonding are saved in the directory, and
+     * a central connecting with a resolvable private address is recognized by resolving it with
+     * them. Centrals that bonded before the directory was set are not recognized this way.
+     * The files are written in the background.
+     *
+     * Only for GATT peripheral role.
+     *
+     * @param {string} directory Existing directory to keep the files in, or an empty string to stop persisting.
+     * @returns {void}
+     */
+    setSystemAttributeDirectory(directory) {
+        this._adapter.gattsSetSystemAttributeDirectory(directory);
+    }
+
     phyUpdate(deviceInstanceId, phys, callback) {
         const device = this.getDevice(deviceInstanceId);
         if (!device) {
@@ -122,8 +122,9 @@ class AdapterFactory extends EventEmitter {
         super();
         this._bleDrivers = bleDrivers;
         this._adapters = {};
+        this._adapterMonitorReady = false;
 
-        if (options.enablePolling) {
+        if (options.enablePolling && !this._startAdapterMonitor()) {
             this.updateInterval = setInterval(this._updateAdapterList.bind(this), UPDATE_INTERVAL_MS);
         }
     }
@@ -133,9 +134,10 @@ class AdapterFactory extends EventEmitter {
      *
      * The mapping of SoftDevice API version to pc-ble-driver AddOn can be overridden
      * by providing a custom `bleDrivers` argument. By default the AdapterFactory will
-     * poll for added/removed adapters every 2 seconds and emit 'added' and 'removed'
-     * events. This can be disabled by passing `enablePolling: false` as part of the
-     * options object.
+     * watch for added/removed adapters and emit 'added' and 'removed' events. Hotplug
+     * monitoring is used where the AddOn supports it, otherwise the adapter list is
+     * polled every 2 seconds. This can be disabled by passing `enablePolling: false`
+     * as part of the options object.
      *
      * @param {Object} [bleDrivers] Optional object mapping version to pc-ble-driver AddOn.
      * @param {Object} [options] Optional object for customizing the behavior of the adapter factory.
@@ -231,6 +233,79 @@ class AdapterFactory extends EventEmitter {
         });
     }
 
+    _addAdapter(adapter) {
+        const adapterInstanceId = this._getInstanceId(adapter);
+
+        try {
+            const newAdapter = this._parseAndCreateAdapter(adapter);
+
+            if (this._adapters[adapterInstanceId] === undefined) {
+                this._adapters[adapterInstanceId] = newAdapter;
+                this._setUpListenersForAdapterOpenAndClose(newAdapter);
+                this.emit('added', newAdapter);
+            }
+        } catch (error) {
+            this.emit('logMessage', logLevel.DEBUG, `Unable to create adapter: ${error.message}`);
+        }
+    }
+
+    _removeAdapter(adapterInstanceId) {
+        const removedAdapter = this._adapters[adapterInstanceId];
+
+        if (removedAdapter === undefined) {
+            return;
+        }
+
+        removedAdapter.removeAllListeners('opened');
+        delete this._adapters[adapterInstanceId];
+        this.emit('removed', removedAdapter);
+    }
+
+    /**
+     * Start hotplug monitoring of adapters in the pc-ble-driver AddOn.
+     *
+     * The AddOn keeps a cached adapter list that is updated on added/removed events,
+     * so there is no need to poll. Not supported on all platforms.
+     *
+     * @private
+     * @returns {boolean} True if adapter monitoring was started.
+     */
+    _startAdapterMonitor() {
+        const driver = this._bleDrivers.v2;
+
+        if (typeof driver.startAdapterMonitor !== 'function') {
+            return false;
+        }
+
+        return driver.startAdapterMonitor((err, action, adapter) => {
+            if (err) {
+                // The AddOn stops monitoring on error, fall back to polling
+                this._adapterMonitorReady = false;
+                this.emit('error', err);
+
+                if (!this.updateInterval) {
+                    this.updateInterval = setInterval(this._updateAdapterList.bind(this), UPDATE_INTERVAL_MS);
+                }
+
+                return;
+            }
+
+            switch (action) {
+                case 'added':
+                    this._addAdapter(adapter);
+                    break;
+                case 'removed':
+                    this._removeAdapter(this._getInstanceId(adapter));
+                    break;
+                case 'ready':
+                    this._adapterMonitorReady = true;
+                    break;
+                default:
+                    break;
+            }
+        });
+    }
+
     // TODO: create a separate npm module that gets connected adapters and information about them
     _updateAdapterList(callback) {
         // for getting the adapters we just use pc-ble-driver AddOn v2
@@ -248,31 +323,11 @@ class AdapterFactory extends EventEmitter {
 
             const removedAdapters = Object.assign({}, this._adapters);
             for (const adapter of adapters) {
-                const adapterInstanceId = this._getInstanceId(adapter);
-
-                if (this._adapters[adapterInstanceId]) {
-                    delete removedAdapters[adapterInstanceId];
-                }
-
-                try {
-                    const newAdapter = this._parseAndCreateAdapter(adapter);
-
-                    if (this._adapters[adapterInstanceId] === undefined) {
-                        this._adapters[adapterInstanceId] = newAdapter;
-                        this._setUpListenersForAdapterOpenAndClose(newAdapter);
-                        this.emit('added', newAdapter);
-                    }
-                } catch (error) {
-                    this.emit('logMessage', logLevel.DEBUG, `Unable to create adapter: ${error.message}`);
-                }
+                delete removedAdapters[this._getInstanceId(adapter)];
+                this._addAdapter(adapter);
             }
 
-            Object.keys(removedAdapters).forEach(adapterId => {
-                const removedAdapter = this._adapters[adapterId];
-                removedAdapter.removeAllListeners('opened');
-                delete this._adapters[adapterId];
-                this.emit('removed', removedAdapter);
-            });
+            Object.keys(removedAdapters).forEach(adapterId => this._removeAdapter(adapterId));
 
             if (isCallback) {
                 callback(undefined, this._adapters);
@@ -283,13 +338,24 @@ class AdapterFactory extends EventEmitter {
     /**
      * Get connected adapters.
      *
+     * If the adapter list is kept up to date by hotplug monitoring, the callback is
+     * called with the current adapters without enumerating serial ports.
+     *
      * @param {null|function} callback Optional callback signature: (err, adapters) => {}.
      * @returns {void}
      */
     getAdapters(callback) {
-        this._updateAdapterList((err, adapters) => {
-            const isCallback = callback && (typeof callback === 'function');
+        const isCallback = callback && (typeof callback === 'function');
+
+        if (this._adapterMonitorReady) {
+            if (isCallback) {
+                callback(undefined, this._adapters);
+            }
+
+            return;
+        }
 
+        this._updateAdapterList((err, adapters) => {
             if (err) {
                 this.emit('error', err);
                 if (isCallback) {
@@ -305,6 +371,25 @@ class AdapterFactory extends EventEmitter {
         });
     }
 
+    /**
+     * Stop watching for added and removed adapters.
+     *
+     * Closes the hotplug monitor of the pc-ble-driver AddOn, or stops the polling, so that
+     * nothing is left running in the AddOn or the event loop. No more 'added' or 'removed'
+     * events are emitted. Later calls to `getAdapters` enumerate the serial ports.
+     *
+     * @returns {void}
+     */
+    stopMonitoring() {
+        if (this.updateInterval) {
+            clearInterval(this.updateInterval);
+            this.updateInterval = undefined;
+        }
+
+        this._adapterMonitorReady = false;
+        this._bleDrivers.v2.stopAdapterMonitor();
+    }
+
     /**
      * Create Adapter with custom serialport
      *
@@ -0,0 +1,140 @@
+/* Copyright (c) 2010 - 2017, Nordic Semiconductor ASA
+ *
+ * All rights reserved.
+ *
+ * Use in source and binary forms, redistribution in binary form only, with
+ * or without modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions in binary form, except as embedded into a Nordic
+ *    Semiconductor ASA integrated circuit in a product or a software update for
+ *    such product, must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other
+ *    materials provided with the distribution.
+ *
+ * 2. Neither the name of Nordic Semiconductor ASA nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * 3. This software, with or without modification, must only be used with a Nordic
+ *    Semiconductor ASA integrated circuit.
+ *
+ * 4. Any software provided in binary form under this license must not be reverse
+ *    engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY NORDIC SEMICONDUCTOR ASA "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NORDIC SEMICONDUCTOR ASA OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+ * TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+'use strict';
+
+const SoftDeviceConverter = require('../sdConv');
+
+const bleDriver = {
+    BLE_UUID_TYPE_BLE: 1,
+    BLE_GATTS_VLOC_STACK: 1,
+};
+
+const characteristic = {
+    uuid: '6E400002-B5A3-F393-E0A9-E50E24DCCA9E',
+    value: [1, 2, 3],
+    maxLength: 20,
+    readPerm: ['open'],
+    writePerm: ['encrypt'],
+    properties: {
+        read: true,
+        notify: true,
+    },
+    _factory_descriptors: [{
+        uuid: '2902',
+        value: [0, 0],
+        maxLength: 2,
+        readPerm: ['open'],
+        writePerm: ['open'],
+    }],
+};
+
+describe('characteristicToTable', () => {
+    it('should keep the uuid as a string without dashes', () => {
+        const converter = new SoftDeviceConverter(bleDriver, {});
+        const table = converter.characteristicToTable(characteristic);
+
+        expect(table.attribute.uuid).toEqual('6E400002B5A3F393E0A9E50E24DCCA9E');
+    });
+
+    it('should convert the value attribute and metadata', () => {
+        const converter = new SoftDeviceConverter(bleDriver, {});
+        const table = converter.characteristicToTable(characteristic);
+
+        expect(table.attribute.value).toEqual([1, 2, 3]);
+        expect(table.attribute.init_len).toEqual(3);
+        expect(table.attribute.max_len).toEqual(20);
+        expect(table.attribute.attr_md.write_perm).toEqual({ sm: 1, lv: 2 });
+        expect(table.metadata.char_props.read).toEqual(true);
+        expect(table.metadata.char_props.write).toEqual(false);
+        expect(table.metadata.cccd_md.read_perm).toEqual({ sm: 1, lv: 1 });
+        expect(table.metadata.sccd_md).toBeNull();
+    });
+
+    it('should throw if mandatory attributes are missing', () => {
+        const converter = new SoftDeviceConverter(bleDriver, {});
+
+        let error;
+
+        try {
+            converter.characteristicToTable({ uuid: '2A37' });
+        } catch (err) {
+            error = err;
+        }
+
+        expect(error).toEqual('value must be provided. properties must be provided. maxLength must be provided. ');
+    });
+});
+
+describe('descriptorToTable', () => {
+    it('should convert a descriptor', () => {
+        const converter = new SoftDeviceConverter(bleDriver, {});
+        const table = converter.descriptorToTable({
+            uuid: '2904',
+            value: [4, 0, 0, 0x27, 1, 0, 0],
+            maxLength: 7,
+            readPerm: ['open'],
+            writePerm: ['no-access'],
+        });
+
+        expect(table.uuid).toEqual('2904');
+        expect(table.init_len).toEqual(7);
+        expect(table.attr_md.write_perm).toEqual({ sm: 0, lv: 0 });
+    });
+});
+
+describe('addVsUuid', () => {
+    it('should make the base of the uuid known by its type', () => {
+        const converter = new SoftDeviceConverter(bleDriver, {});
+        converter.addVsUuid('6e400001-b5a3-f393-e0a9-e50e24dcca9e', 3);
+
+        expect(converter.lookupVsUuid({ type: 3, uuid: 0x0003 })).toEqual('6E400003B5A3F393E0A9E50E24DCCA9E');
+    });
+
+    it('should not register the base again when converting the uuid', done => {
+        const adapter = {
+            addVendorspecificUUID: () => { throw new Error('Registered twice'); },
+        };
+        const converter = new SoftDeviceConverter(bleDriver, adapter);
+        converter.addVsUuid('6E400001B5A3F393E0A9E50E24DCCA9E', 2);
+
+        converter.uuidToDriver('6e400002-b5a3-f393-e0a9-e50e24dcca9e', (err, uuid) => {
+            expect(err).toBeUndefined();
+            expect(uuid).toEqual({ type: 2, uuid: 0x0002 });
+            done();
+        });
+    });
+});
@@ -115,6 +115,15 @@ class SoftDeviceConverter {
         return uuid128.slice(0, 4) + uuid16 + uuid128.slice(8);
     }
 
+    _vsUuidBase(uuid) {
+        return this._replace16bitUuidIn128bitUuid(uuid.replace(/-/g, '').toUpperCase(), '0000');
+    }
+
+    // Record the type the SoftDevice has given the base of a vendor specific UUID
+    addVsUuid(uuid, type) {
+        this.vsUuidStore[type - 2] = this._vsUuidBase(uuid);
+    }
+
     // Callback: function(err, uuid)
     uuidToDriver(uuid, callback) {
         var retval = {};
@@ -130,7 +139,7 @@ class SoftDeviceConverter {
             callback(undefined, retval);
         } else if (uuid.length == 32) {
             // Register UUID with SoftDevice
-            const uuidBase = this._replace16bitUuidIn128bitUuid(uuid, '0000');
+            const uuidBase = this._vsUuidBase(uuid);
             const vsUuidIndex = this.vsUuidStore.indexOf(uuidBase);
             if (vsUuidIndex >= 0) {
                 retval.type = vsUuidIndex + 2;
@@ -145,7 +154,7 @@ class SoftDeviceConverter {
                     return;
                 }
 
-                this.vsUuidStore.push(uuidBase);
+                this.addVsUuid(uuid, type);
                 retval.type = type;
                 retval.uuid = parseInt(uuid.slice(4, 8), 16);
                 callback(undefined, retval);
@@ -193,7 +202,8 @@ class SoftDeviceConverter {
         return false;
     }
 
-    descriptorToDriver(descriptor, callback) {
+    // Throws an error string if the descriptor is not valid. The UUID is left out.
+    _descriptorWithoutUuidToDriver(descriptor) {
         var err = '';
 
         // Check if mandatory attributes are present in the characteristic object
@@ -202,13 +212,31 @@ class SoftDeviceConverter {
         if (!descriptor.maxLength) err += 'maxLength must be provided. ';
 
         if (err.length !== 0) {
-            callback(err);
-            return;
+            throw err;
         }
 
         // Now let's start converting
         var retval = {};
-        retval.attr_md = {};
+
+        retval.attr_md = this.attributeMetadataToDriver(descriptor);
+
+        retval.init_len = descriptor.value.length;
+        retval.init_offs = 0;
+        retval.max_len = descriptor.maxLength || retval.init_len;
+        retval.value = descriptor.value;
+
+        return retval;
+    }
+
+    descriptorToDriver(descriptor, callback) {
+        var retval;
+
+        try {
+            retval = this._descriptorWithoutUuidToDriver(descriptor);
+        } catch (err) {
+            callback(err);
+            return;
+        }
 
         this.uuidToDriver(descriptor.uuid, (err, uuid) => {
             if (err) {
@@ -219,17 +247,18 @@ class SoftDeviceConverter {
 
             retval.uuid = uuid;
 
-            retval.attr_md = this.attributeMetadataToDriver(descriptor);
-
-            retval.init_len = descriptor.value.length;
-            retval.init_offs = 0;
-            retval.max_len = descriptor.maxLength || retval.init_len;
-            retval.value = descriptor.value;
-
             callback(undefined, retval);
         });
     }
 
+    // Descriptor for gattsBuildTable, which registers the UUID itself. Throws an error string
+    // if the descriptor is not valid.
+    descriptorToTable(descriptor) {
+        const retval = this._descriptorWithoutUuidToDriver(descriptor);
+        retval.uuid = descriptor.uuid.replace(/-/g, '');
+        return retval;
+    }
+
     getAttributeMetadataForSpecialDescriptor(characteristic, uuid) {
         if (characteristic._factory_descriptors === undefined) {
             return null;
@@ -275,6 +304,37 @@ class SoftDeviceConverter {
 
         */
 
+        var retval;
+
+        try {
+            retval = this._characteristicWithoutUuidToDriver(characteristic);
+        } catch (err) {
+            callback(err);
+            return;
+        }
+
+        this.uuidToDriver(characteristic.uuid, (err, uuid) => {
+            if (err) {
+                callback(err);
+                return;
+            }
+
+            retval.attribute.uuid = uuid;
+
+            callback(undefined, retval);
+        });
+    }
+
+    // Characteristic for gattsBuildTable, which registers the UUID itself. Throws an error string
+    // if the characteristic is not valid.
+    characteristicToTable(characteristic) {
+        const retval = this._characteristicWithoutUuidToDriver(characteristic);
+        retval.attribute.uuid = characteristic.uuid.replace(/-/g, '');
+        return retval;
+    }
+
+    // Throws an error string if the characteristic is not valid. The UUID of the attribute is left out.
+    _characteristicWithoutUuidToDriver(characteristic) {
         var err = '';
 
         // Check if mandatory attributes are present in the characteristic object
@@ -284,8 +344,7 @@ class SoftDeviceConverter {
         if (!characteristic.maxLength) err += 'maxLength must be provided. ';
 
         if (err.length !== 0) {
-            callback(err);
-            return;
+            throw err;
         }
 
         // Now let's start converting
@@ -316,22 +375,13 @@ class SoftDeviceConverter {
         retval.metadata.cccd_md = this.getAttributeMetadataForSpecialDescriptor(characteristic, '2902');
         retval.metadata.sccd_md = this.getAttributeMetadataForSpecialDescriptor(characteristic, '2903');
 
-        this.uuidToDriver(characteristic.uuid, (err, uuid) => {
-            if (err) {
-                callback(err);
-                return;
-            }
-
-            retval.attribute.uuid = uuid;
-
-            retval.attribute.value = characteristic.value;
-            retval.attribute.attr_md = this.attributeMetadataToDriver(characteristic);
-            retval.attribute.init_len = characteristic.value.length;
-            retval.attribute.init_offs = 0;
-            retval.attribute.max_len = characteristic.maxLength || retval.attribute.init_len;
+        retval.attribute.value = characteristic.value;
+        retval.attribute.attr_md = this.attributeMetadataToDriver(characteristic);
+        retval.attribute.init_len = characteristic.value.length;
+        retval.attribute.init_offs = 0;
+        retval.attribute.max_len = characteristic.maxLength || retval.attribute.init_len;
 
-            callback(undefined, retval);
-        });
+        return retval;
     }
 }
 
@@ -32,9 +32,25 @@ for pca in "${test_pcas[@]}"; do
     # Run each tests in a new Jest instance. Sheduling more in
     # Jest it introduces a module reloading behaviour that is
     # incompatible with our dependencies.
+    run_test adapterMonitor.test.js
     run_test advertise.test.js
+    run_test concurrentOpen.test.js
+    run_test commandStats.test.js
+    run_test tracing.test.js
+    run_test metrics.test.js
     run_test connection.test.js
     run_test mtu.test.js
+    run_test gattQueues.test.js
+    run_test notificationQueue.test.js
+    run_test notifyAll.test.js
+    run_test indicationQueue.test.js
+    run_test attributeStore.test.js
+    run_test preparedWrites.test.js
+    run_test localValues.test.js
+    run_test valueMirror.test.js
+    run_test systemAttributes.test.js
+    run_test addressResolution.test.js
+    run_test notificationWeights.test.js
     run_test simpleScan.test.js
     run_test simpleSecurity.test.js -t LegacyJustWorks
     run_test simpleSecurity.test.js -t LegacyOOB
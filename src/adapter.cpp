@@ -38,11 +38,16 @@
 #include "common.h"
 
 #include <algorithm>
+#include <atomic>
 #include <iostream>
 
 Nan::Persistent<v8::Function> Adapter::constructor;
 
-std::vector<Adapter *> adapters;
+std::unordered_map<void *, Adapter *> Adapter::adapterRegistry;
+std::mutex Adapter::adapterRegistryMutex;
+
+// Counter used to give each adapter a unique id
+static std::atomic<uint32_t> adapterIdCounter(0);
 
 NAN_MODULE_INIT(Adapter::Init)
 {
@@ -59,27 +64,45 @@ NAN_MODULE_INIT(Adapter::Init)
     Nan::Set(target, Nan::New("Adapter").ToLocalChecked(), Nan::GetFunction(tpl).ToLocalChecked());
 }
 
-Adapter *Adapter::getAdapter(adapter_t *adapter, Adapter *defaultAdapter)
+Adapter *Adapter::getAdapter(adapter_t *adapter)
 {
     if (adapter == nullptr)
     {
-        return defaultAdapter;
+        return nullptr;
     }
 
-    for (auto value : adapters)
+    std::lock_guard<std::mutex> lock(adapterRegistryMutex);
+
+    auto it = adapterRegistry.find(adapter->internal);
+
+    if (it == adapterRegistry.end())
     {
-        auto deviceAdapter = value->getInternalAdapter();
+        return nullptr;
+    }
 
-        if (deviceAdapter != nullptr)
-        {
-            if (value->getInternalAdapter()->internal == adapter->internal)
-            {
-                return value;
-            }
-        }
+    return it->second;
+}
+
+void Adapter::registerAdapter(adapter_t *adapter, Adapter *jsAdapter)
+{
+    if (adapter == nullptr)
+    {
+        return;
     }
 
-    return defaultAdapter;
+    std::lock_guard<std::mutex> lock(adapterRegistryMutex);
+    adapterRegistry[adapter->internal] = jsAdapter;
+}
+
+void Adapter::unregisterAdapter(adapter_t *adapter)
+{
+    if (adapter == nullptr)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(adapterRegistryMutex);
+    adapterRegistry.erase(adapter->internal);
 }
 
 adapter_t *Adapter::getInternalAdapter() const
@@ -87,6 +110,16 @@ adapter_t *Adapter::getInternalAdapter() const
     return adapter;
 }
 
+uint32_t Adapter::getAdapterId() const
+{
+    return adapterId;
+}
+
+AdapterMetrics &Adapter::getMetrics()
+{
+    return metrics;
+}
+
 // This compilation unit will be linked several times. So
 // log_handler must not have external linkage. Otherwise, we get
 // problems like a v3 Adapter getting cast into a v2 Adapter.
@@ -147,6 +180,9 @@ void Adapter::initEventHandling(std::unique_ptr<Nan::Callback> callback, uint32_
         std::terminate();
     }
 
+    gattClient.initCompletionHandling();
+    gattServer.initCompletionHandling();
+
     // Clear the statistics
     eventCallbackCount = 0;
 
@@ -320,6 +356,10 @@ void Adapter::cleanUpV8Resources()
     }
 
     uv_mutex_unlock(&adapterCloseMutex);
+
+    // Aborted GATT client and server procedures call back into JavaScript
+    gattClient.cleanUpV8Resources();
+    gattServer.cleanUpV8Resources();
 }
 
 void Adapter::initGeneric(v8::Local<v8::FunctionTemplate> tpl)
@@ -337,6 +377,8 @@ void Adapter::initGeneric(v8::Local<v8::FunctionTemplate> tpl)
     Nan::SetPrototypeMethod(tpl, "getBleOption", GetBleOption);
 
     Nan::SetPrototypeMethod(tpl, "getStats", GetStats);
+    Nan::SetPrototypeMethod(tpl, "getCommandStats", GetCommandStats);
+    Nan::SetPrototypeMethod(tpl, "getMetrics", GetMetrics);
 
 #if NRF_SD_BLE_API_VERSION >= 5
     Nan::SetPrototypeMethod(tpl, "setBleConfig", SetBleConfig);
@@ -397,6 +439,18 @@ void Adapter::initGattC(v8::Local<v8::FunctionTemplate> tpl)
 #if NRF_SD_BLE_API_VERSION >= 5
     Nan::SetPrototypeMethod(tpl, "gattcExchangeMtuRequest", GattcExchangeMtuRequest);
 #endif
+    Nan::SetPrototypeMethod(tpl, "gattcDiscoverAll", GattcDiscoverAll);
+    Nan::SetPrototypeMethod(tpl, "gattcQueueRead", GattcQueueRead);
+    Nan::SetPrototypeMethod(tpl, "gattcQueueWrite", GattcQueueWrite);
+    Nan::SetPrototypeMethod(tpl, "gattcQueueLongRead", GattcQueueLongRead);
+    Nan::SetPrototypeMethod(tpl, "gattcQueueLongWrite", GattcQueueLongWrite);
+    Nan::SetPrototypeMethod(tpl, "gattcQueueReadMany", GattcQueueReadMany);
+    Nan::SetPrototypeMethod(tpl, "gattcSubscribeMany", GattcSubscribeMany);
+    Nan::SetPrototypeMethod(tpl, "gattcWriteStream", GattcWriteStream);
+    Nan::SetPrototypeMethod(tpl, "gattcIndexAttributes", GattcIndexAttributes);
+    Nan::SetPrototypeMethod(tpl, "gattcStartNotificationBuffer", GattcStartNotificationBuffer);
+    Nan::SetPrototypeMethod(tpl, "gattcStopNotificationBuffer", GattcStopNotificationBuffer);
+    Nan::SetPrototypeMethod(tpl, "gattcDrainNotificationBuffer", GattcDrainNotificationBuffer);
 }
 
 void Adapter::initGattS(v8::Local<v8::FunctionTemplate> tpl)
@@ -404,19 +458,31 @@ void Adapter::initGattS(v8::Local<v8::FunctionTemplate> tpl)
     Nan::SetPrototypeMethod(tpl, "gattsAddService", GattsAddService);
     Nan::SetPrototypeMethod(tpl, "gattsAddCharacteristic", GattsAddCharacteristic);
     Nan::SetPrototypeMethod(tpl, "gattsAddDescriptor", GattsAddDescriptor);
+    Nan::SetPrototypeMethod(tpl, "gattsBuildTable", GattsBuildTable);
     Nan::SetPrototypeMethod(tpl, "gattsHVX", GattsHVX);
+    Nan::SetPrototypeMethod(tpl, "gattsQueueNotification", GattsQueueNotification);
+    Nan::SetPrototypeMethod(tpl, "gattsQueueIndication", GattsQueueIndication);
+    Nan::SetPrototypeMethod(tpl, "gattsNotifyAll", GattsNotifyAll);
     Nan::SetPrototypeMethod(tpl, "gattsSystemAttributeSet", GattsSystemAttributeSet);
     Nan::SetPrototypeMethod(tpl, "gattsSetValue", GattsSetValue);
     Nan::SetPrototypeMethod(tpl, "gattsGetValue", GattsGetValue);
+    Nan::SetPrototypeMethod(tpl, "gattsSetValues", GattsSetValues);
+    Nan::SetPrototypeMethod(tpl, "gattsGetValues", GattsGetValues);
     Nan::SetPrototypeMethod(tpl, "gattsReplyReadWriteAuthorize", GattsReplyReadWriteAuthorize);
+    Nan::SetPrototypeMethod(tpl, "gattsSetAttributeStore", GattsSetAttributeStore);
+    Nan::SetPrototypeMethod(tpl, "gattsClearAttributeStore", GattsClearAttributeStore);
+    Nan::SetPrototypeMethod(tpl, "gattsSetSystemAttributeDirectory", GattsSetSystemAttributeDirectory);
+    Nan::SetPrototypeMethod(tpl, "gattsSetConnectionWeight", GattsSetConnectionWeight);
+    Nan::SetPrototypeMethod(tpl, "gattsSetIndicationTimeout", GattsSetIndicationTimeout);
 #if NRF_SD_BLE_API_VERSION >= 5
     Nan::SetPrototypeMethod(tpl, "gattsExchangeMtuReply", GattsExchangeMtuReply);
 #endif
 }
 
-Adapter::Adapter()
+Adapter::Adapter() : gattServer(metrics)
 {
     adapter = nullptr;
+    adapterId = ++adapterIdCounter;
 
     eventCallbackMaxCount = 0;
     eventCallbackBatchEventCounter = 0;
@@ -428,14 +494,26 @@ Adapter::Adapter()
         std::cerr << "Not able to create adapterCloseMutex! Terminating." << std::endl;
         std::terminate();
     }
-
-    adapters.push_back(this);
 }
 
 Adapter::~Adapter()
 {
-    // Remove this adapter from the global container of adapters
-    adapters.erase(std::find(adapters.begin(), adapters.end(), this));
+    // Remove any driver adapter still pointing to this adapter
+    {
+        std::lock_guard<std::mutex> lock(adapterRegistryMutex);
+
+        for (auto it = adapterRegistry.begin(); it != adapterRegistry.end();)
+        {
+            if (it->second == this)
+            {
+                it = adapterRegistry.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+    }
 
     // Remove callbacks and cleanup uv_handle_t instances
     cleanUpV8Resources();
@@ -504,6 +582,76 @@ void Adapter::addEventBatchStatistics(std::chrono::milliseconds duration)
     eventCallbackBatchNumber += 1;
 }
 
+void Adapter::addCommandStatistics(const Baton *baton, std::chrono::steady_clock::time_point callbackTime)
+{
+    if (baton->command == nullptr)
+    {
+        return;
+    }
+
+    auto &statistics = commandStatistics[baton->command];
+
+    statistics.count++;
+
+    if (baton->result != NRF_SUCCESS)
+    {
+        statistics.errorCount++;
+    }
+
+    statistics.queueWait.add(std::chrono::duration_cast<std::chrono::microseconds>(baton->workStartTime - baton->queuedTime));
+    statistics.call.add(std::chrono::duration_cast<std::chrono::microseconds>(baton->workEndTime - baton->workStartTime));
+    statistics.callbackDelay.add(std::chrono::duration_cast<std::chrono::microseconds>(callbackTime - baton->workEndTime));
+}
+
+LatencyHistogram::LatencyHistogram() : count(0), total(0), min(0), max(0)
+{
+    std::fill(std::begin(buckets), std::end(buckets), 0);
+}
+
+void LatencyHistogram::add(std::chrono::microseconds duration)
+{
+    auto value = static_cast<uint64_t>(std::max<int64_t>(duration.count(), 0));
+
+    min = (count == 0) ? value : std::min(min, value);
+    max = std::max(max, value);
+    total += value;
+    count++;
+
+    auto bucket = 0;
+
+    while (bucket < LATENCY_HISTOGRAM_BUCKETS - 1 && value >= (static_cast<uint64_t>(2) << bucket))
+    {
+        bucket++;
+    }
+
+    buckets[bucket]++;
+}
+
+v8::Local<v8::Object> LatencyHistogram::ToJs() const
+{
+    Nan::EscapableHandleScope scope;
+    v8::Local<v8::Object> obj = Nan::New<v8::Object>();
+
+    Utility::Set(obj, "count", count);
+    Utility::Set(obj, "total", static_cast<double>(total));
+    Utility::Set(obj, "min", static_cast<double>(min));
+    Utility::Set(obj, "max", static_cast<double>(max));
+    Utility::Set(obj, "avg", count == 0 ? 0.0 : static_cast<double>(total) / count);
+
+    // Upper bound of each bucket in microseconds, the last bucket is unbounded
+    v8::Local<v8::Object> histogram = Nan::New<v8::Object>();
+
+    for (auto i = 0; i < LATENCY_HISTOGRAM_BUCKETS; i++)
+    {
+        auto name = (i == LATENCY_HISTOGRAM_BUCKETS - 1) ? std::string("+Inf") : std::to_string(static_cast<uint64_t>(2) << i);
+        Utility::Set(histogram, name.c_str(), buckets[i]);
+    }
+
+    Utility::Set(obj, "buckets", histogram);
+
+    return scope.Escape(obj);
+}
+
 void Adapter::createSecurityKeyStorage(const uint16_t connHandle, ble_gap_sec_keyset_t *keyset)
 {
     ble_gap_sec_keyset_t *set = new ble_gap_sec_keyset_t();
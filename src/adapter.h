@@ -41,15 +41,26 @@
 #include <chrono>
 #include <map>
 #include <memory>
+#include <mutex>
+#include <unordered_map>
 
 #include "sd_rpc.h"
 
 #include "circular_fifo_unsafe.h"
+#include "common.h"
+#include "gatt_client.h"
+#include "gatt_server.h"
+#include "metrics.h"
+#include "tracer.h"
 
 const auto EVENT_QUEUE_SIZE = 64;
 const auto LOG_QUEUE_SIZE = 64;
 const auto STATUS_QUEUE_SIZE = 64;
 
+// Number of buckets in command latency histograms. Bucket n counts durations
+// below 2^(n + 1) microseconds, the last bucket counts the rest.
+const auto LATENCY_HISTOGRAM_BUCKETS = 24;
+
 #define ADAPTER_METHOD_DEFINITIONS(MainName) \
     static NAN_METHOD(MainName); \
     static void MainName(uv_work_t *req); \
@@ -95,6 +106,7 @@ public:
     ble_evt_t *event;
     std::string timestamp;
     int adapterID;
+    std::chrono::steady_clock::time_point arrivalTime;
 };
 
 struct StatusEntry
@@ -105,6 +117,37 @@ public:
     std::string timestamp;
 };
 
+struct LatencyHistogram
+{
+public:
+    LatencyHistogram();
+
+    void add(std::chrono::microseconds duration);
+    v8::Local<v8::Object> ToJs() const;
+
+    uint32_t count;
+    uint64_t total;
+    uint64_t min;
+    uint64_t max;
+    uint32_t buckets[LATENCY_HISTOGRAM_BUCKETS];
+};
+
+struct CommandStatistics
+{
+public:
+    CommandStatistics() : count(0), errorCount(0) {}
+
+    uint32_t count;
+    uint32_t errorCount;
+
+    // Time from uv_queue_work until the worker starts
+    LatencyHistogram queueWait;
+    // Time spent in the worker, mainly the serialized sd_ble_* call
+    LatencyHistogram call;
+    // Time from the worker ending until the After callback runs on the main thread
+    LatencyHistogram callbackDelay;
+};
+
 //using namespace memory_relaxed_aquire_release;
 using namespace memory_sequential_unsafe;
 
@@ -117,10 +160,21 @@ class Adapter : public Nan::ObjectWrap
 public:
     static NAN_MODULE_INIT(Init);
 
-    static Adapter *getAdapter(adapter_t *adapter, Adapter *defaultAdapter = nullptr);
+    static Adapter *getAdapter(adapter_t *adapter);
+
+    // Register/unregister the mapping between a driver adapter and this AddOn adapter.
+    // Registration must be done before sd_rpc_open so that callbacks received while
+    // opening are routed to the correct AddOn adapter.
+    static void registerAdapter(adapter_t *adapter, Adapter *jsAdapter);
+    static void unregisterAdapter(adapter_t *adapter);
 
     adapter_t *getInternalAdapter() const;
 
+    // Id of this adapter, used to tag traces and metrics
+    uint32_t getAdapterId() const;
+
+    AdapterMetrics &getMetrics();
+
     void initEventHandling(std::unique_ptr<Nan::Callback> callback, const uint32_t interval);
     void appendEvent(ble_evt_t *event);
 
@@ -149,6 +203,7 @@ public:
     double getAverageCallbackBatchCount() const;
 
     void addEventBatchStatistics(std::chrono::milliseconds duration);
+    void addCommandStatistics(const Baton *baton, std::chrono::steady_clock::time_point callbackTime);
 
 private:
     explicit Adapter();
@@ -156,6 +211,10 @@ private:
 
     static Nan::Persistent<v8::Function> constructor;
 
+    // Lookup from driver adapter (adapter_t::internal) to AddOn adapter
+    static std::unordered_map<void *, Adapter *> adapterRegistry;
+    static std::mutex adapterRegistryMutex;
+
     static NAN_METHOD(New);
 
     // General async methods
@@ -177,6 +236,93 @@ private:
 
     // General sync methods
     static NAN_METHOD(GetStats);
+    static NAN_METHOD(GetCommandStats);
+    static NAN_METHOD(GetMetrics);
+
+    // Queue a command on the libuv thread pool, recording its latencies
+    template <void (*Work)(uv_work_t *), void (*After)(uv_work_t *), typename T>
+    static void queueCommand(T *baton, const char *command)
+    {
+        baton->command = command;
+        baton->connHandle = commandConnHandle(baton, 0);
+
+        if (baton->owner == nullptr)
+        {
+            baton->owner = getAdapter(baton->adapter);
+        }
+
+        baton->queuedTime = std::chrono::steady_clock::now();
+        uv_queue_work(uv_default_loop(), baton->req, timedWork<Work>, timedAfter<After>);
+    }
+
+    // Connection handle of the batons of commands on a connection
+    template <typename T>
+    static auto commandConnHandle(const T *baton, int) -> decltype(static_cast<uint16_t>(baton->conn_handle))
+    {
+        return baton->conn_handle;
+    }
+
+    template <typename T>
+    static uint16_t commandConnHandle(const T *, long)
+    {
+        return TRACE_NO_CONN_HANDLE;
+    }
+
+    // This runs in a worker thread (not Main Thread)
+    template <void (*Work)(uv_work_t *)>
+    static void timedWork(uv_work_t *req)
+    {
+        auto baton = static_cast<Baton *>(req->data);
+        baton->workStartTime = std::chrono::steady_clock::now();
+        Work(req);
+        baton->workEndTime = std::chrono::steady_clock::now();
+
+        if (Tracer::isEnabled())
+        {
+            auto jsAdapter = baton->owner;
+            auto adapterId = (jsAdapter != nullptr) ? jsAdapter->getAdapterId() : 0;
+            Tracer::addSpan("command.call", baton->command, adapterId, baton->connHandle, baton->workStartTime, baton->workEndTime);
+        }
+    }
+
+    // This runs in Main Thread
+    template <void (*After)(uv_work_t *)>
+    static void timedAfter(uv_work_t *req, int status)
+    {
+        auto baton = static_cast<Baton *>(req->data);
+        auto callbackTime = std::chrono::steady_clock::now();
+
+        // The After function deletes the baton, record statistics first
+        auto jsAdapter = baton->owner;
+
+        if (jsAdapter != nullptr)
+        {
+            jsAdapter->addCommandStatistics(baton, callbackTime);
+        }
+
+        if (!Tracer::isEnabled())
+        {
+            After(req);
+            return;
+        }
+
+        auto command = baton->command;
+        auto connHandle = baton->connHandle;
+        auto adapterId = (jsAdapter != nullptr) ? jsAdapter->getAdapterId() : 0;
+        auto createdTime = baton->createdTime;
+        auto queuedTime = baton->queuedTime;
+        auto workStartTime = baton->workStartTime;
+        auto workEndTime = baton->workEndTime;
+
+        After(req);
+
+        auto callbackEndTime = std::chrono::steady_clock::now();
+
+        Tracer::addSpan("command.entry", command, adapterId, connHandle, createdTime, queuedTime);
+        Tracer::addSpan("command.queue", command, adapterId, connHandle, queuedTime, workStartTime, Tracer::nextAsyncId());
+        Tracer::addSpan("command.callbackDelay", command, adapterId, connHandle, workEndTime, callbackTime, Tracer::nextAsyncId());
+        Tracer::addSpan("command.callback", command, adapterId, connHandle, callbackTime, callbackEndTime);
+    }
 
     // Gap async mehtods
     ADAPTER_METHOD_DEFINITIONS(GapSetAddress);
@@ -230,20 +376,47 @@ private:
 #if NRF_SD_BLE_API_VERSION >= 5
     ADAPTER_METHOD_DEFINITIONS(GattcExchangeMtuRequest);
 #endif
+    ADAPTER_METHOD_DEFINITIONS(GattcDiscoverAll);
+    ADAPTER_METHOD_DEFINITIONS(GattcQueueRead);
+    ADAPTER_METHOD_DEFINITIONS(GattcQueueWrite);
+    ADAPTER_METHOD_DEFINITIONS(GattcQueueLongRead);
+    ADAPTER_METHOD_DEFINITIONS(GattcQueueLongWrite);
+    ADAPTER_METHOD_DEFINITIONS(GattcQueueReadMany);
+    ADAPTER_METHOD_DEFINITIONS(GattcSubscribeMany);
+    ADAPTER_METHOD_DEFINITIONS(GattcWriteStream);
+
+    // Release a GATTC request from JavaScript that the SoftDevice did not accept
+    static void cancelGattcRequest(adapter_t *adapter, uint16_t connHandle);
+    static NAN_METHOD(GattcIndexAttributes);
+    static NAN_METHOD(GattcStartNotificationBuffer);
+    static NAN_METHOD(GattcStopNotificationBuffer);
+    static NAN_METHOD(GattcDrainNotificationBuffer);
 
     // Gatts async mehtods
     ADAPTER_METHOD_DEFINITIONS(GattsAddService);
     ADAPTER_METHOD_DEFINITIONS(GattsAddCharacteristic);
     ADAPTER_METHOD_DEFINITIONS(GattsAddDescriptor);
+    ADAPTER_METHOD_DEFINITIONS(GattsBuildTable);
     ADAPTER_METHOD_DEFINITIONS(GattsHVX);
+    ADAPTER_METHOD_DEFINITIONS(GattsQueueNotification);
+    ADAPTER_METHOD_DEFINITIONS(GattsQueueIndication);
+    ADAPTER_METHOD_DEFINITIONS(GattsNotifyAll);
     ADAPTER_METHOD_DEFINITIONS(GattsSystemAttributeSet);
     ADAPTER_METHOD_DEFINITIONS(GattsSetValue);
     ADAPTER_METHOD_DEFINITIONS(GattsGetValue);
+    ADAPTER_METHOD_DEFINITIONS(GattsSetValues);
+    ADAPTER_METHOD_DEFINITIONS(GattsGetValues);
     ADAPTER_METHOD_DEFINITIONS(GattsReplyReadWriteAuthorize);
 #if NRF_SD_BLE_API_VERSION >= 5
     ADAPTER_METHOD_DEFINITIONS(GattsExchangeMtuReply);
 #endif
 
+    static NAN_METHOD(GattsSetAttributeStore);
+    static NAN_METHOD(GattsClearAttributeStore);
+    static NAN_METHOD(GattsSetSystemAttributeDirectory);
+    static NAN_METHOD(GattsSetConnectionWeight);
+    static NAN_METHOD(GattsSetIndicationTimeout);
+
     static void initGeneric(v8::Local<v8::FunctionTemplate> tpl);
     static void initGap(v8::Local<v8::FunctionTemplate> tpl);
     static void initGattC(v8::Local<v8::FunctionTemplate> tpl);
@@ -260,6 +433,7 @@ private:
     std::map<uint16_t, ble_gap_sec_keyset_t *> keysetMap;
 
     adapter_t *adapter;
+    uint32_t adapterId;
     EventQueue eventQueue;
     LogQueue logQueue;
     StatusQueue statusQueue;
@@ -288,5 +462,13 @@ private:
     uint32_t eventCallbackBatchEventCounter;
     uint32_t eventCallbackBatchEventTotalCount;
     uint32_t eventCallbackBatchNumber;
+
+    // Command latencies per API name, only accessed from the main thread
+    std::map<std::string, CommandStatistics> commandStatistics;
+
+    AdapterMetrics metrics;
+
+    GattClient gattClient;
+    GattServer gattServer;
 };
 #endif
@@ -35,11 +35,26 @@
  */
 
 #include <chrono>
+#include <cerrno>
 #include <ctime>
+#include <cstdio>
+#include <fstream>
 #include <sstream>
 #include <iostream>
 #include <cassert>
 
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 #include "common.h"
 #include "ble_hci.h"
 
@@ -182,6 +197,119 @@ const std::string getCurrentTimeInMilliseconds()
     return result;
 }
 
+bool writeFileAtomically(const std::string &path, const std::vector<uint8_t> &data, bool ownerOnly)
+{
+    auto temporaryPath = path + ".tmp";
+
+#ifdef _WIN32
+    (void)ownerOnly;
+
+    std::ofstream out(temporaryPath, std::ios::out | std::ios::binary | std::ios::trunc);
+
+    if (!out.is_open())
+    {
+        return false;
+    }
+
+    out.write(reinterpret_cast<const char *>(data.data()), data.size());
+    out.close();
+
+    if (out.fail() || !MoveFileExA(temporaryPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH))
+    {
+        std::remove(temporaryPath.c_str());
+        return false;
+    }
+
+    return true;
+#else
+    const mode_t mode = ownerOnly ? (S_IRUSR | S_IWUSR) : (S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH | S_IWOTH);
+    auto fd = open(temporaryPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, mode);
+
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    // A temporary file left behind by a crash keeps the mode it was created with
+    auto written = !ownerOnly || fchmod(fd, mode) == 0;
+    size_t offset = 0;
+
+    while (written && offset < data.size())
+    {
+        auto count = write(fd, data.data() + offset, data.size() - offset);
+
+        if (count < 0)
+        {
+            written = (errno == EINTR);
+            continue;
+        }
+
+        offset += static_cast<size_t>(count);
+    }
+
+    // The data must be on disk before the rename makes it visible under the path
+    written = written && fsync(fd) == 0;
+    written = (close(fd) == 0) && written;
+
+    if (!written || rename(temporaryPath.c_str(), path.c_str()) != 0)
+    {
+        unlink(temporaryPath.c_str());
+        return false;
+    }
+
+    return true;
+#endif
+}
+
+bool listDirectory(const std::string &directory, const std::string &suffix, std::vector<std::string> &names)
+{
+    auto matches = [&suffix](const std::string &name) {
+        return name.size() >= suffix.size() && name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0;
+    };
+
+#ifdef _WIN32
+    WIN32_FIND_DATAA entry;
+    auto find = FindFirstFileA((directory + "\\*" + suffix).c_str(), &entry);
+
+    if (find == INVALID_HANDLE_VALUE)
+    {
+        return GetLastError() == ERROR_FILE_NOT_FOUND;
+    }
+
+    do
+    {
+        // The pattern also matches longer extensions starting with the suffix
+        if ((entry.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) == 0 && matches(entry.cFileName))
+        {
+            names.emplace_back(entry.cFileName);
+        }
+    } while (FindNextFileA(find, &entry));
+
+    FindClose(find);
+    return true;
+#else
+    auto dir = opendir(directory.c_str());
+
+    if (dir == nullptr)
+    {
+        return false;
+    }
+
+    while (auto entry = readdir(dir))
+    {
+        std::string name(entry->d_name);
+
+        if (matches(name))
+        {
+            names.push_back(name);
+        }
+    }
+
+    closedir(dir);
+    return true;
+#endif
+}
+
 uint16_t uint16_decode(const uint8_t *p_encoded_data)
 {
         return ( (static_cast<uint16_t>(const_cast<uint8_t *>(p_encoded_data)[0])) |
@@ -333,6 +461,32 @@ uint8_t *ConversionUtility::getNativePointerToUint8(v8::Local<v8::Value> js)
     return string;
 }
 
+std::vector<uint8_t> ConversionUtility::getNativeBytes(v8::Local<v8::Value> js)
+{
+    if (node::Buffer::HasInstance(js))
+    {
+        auto data = reinterpret_cast<uint8_t *>(node::Buffer::Data(js));
+        return std::vector<uint8_t>(data, data + node::Buffer::Length(js));
+    }
+
+    if (!js->IsArray())
+    {
+        throw std::string("Buffer or array");
+    }
+
+    v8::Local<v8::Array> jsarray = v8::Local<v8::Array>::Cast(js);
+    std::vector<uint8_t> bytes;
+    bytes.reserve(jsarray->Length());
+
+    for (uint32_t i = 0; i < jsarray->Length(); ++i)
+    {
+        bytes.push_back(static_cast<uint8_t>(
+            Nan::Get(jsarray, i).ToLocalChecked()->Uint32Value(Nan::GetCurrentContext()).FromJust()));
+    }
+
+    return bytes;
+}
+
 uint16_t *ConversionUtility::getNativePointerToUint16(v8::Local<v8::Object>js, const char *name)
 {
     v8::Local<v8::Value> value = Utility::Get(js, name);
@@ -38,9 +38,11 @@
 #define SD_COMMON_H
 
 #include <nan.h>
+#include <chrono>
 #include <map>
 #include <mutex>
 #include <string>
+#include <vector>
 
 #include "sd_rpc.h"
 
@@ -70,6 +72,7 @@ extern int adapterCount;
 int findAdapterID(adapter_t *adapter);
 
 class ConversionUtility;
+class Adapter;
 
 
 template<typename NativeType>
@@ -186,6 +189,11 @@ public:
         req = new uv_work_t();
         callback = new Nan::Callback(cb);
         req->data = static_cast<void*>(this);
+        adapter = nullptr;
+        command = nullptr;
+        owner = nullptr;
+        connHandle = 0xFFFF;
+        createdTime = std::chrono::steady_clock::now();
     }
 
     ~Baton()
@@ -199,10 +207,33 @@ public:
 
     int result;
     adapter_t *adapter;
+
+    // AddOn adapter the command is queued for, set by Adapter::queueCommand. The driver
+    // adapter may be deleted before the command completes, this pointer stays valid.
+    Adapter *owner;
+
+    // Command timing, set when queued by Adapter::queueCommand
+    const char *command;
+    // Connection of the command for tracing, BLE_CONN_HANDLE_INVALID if it has none
+    uint16_t connHandle;
+    std::chrono::steady_clock::time_point createdTime;
+    std::chrono::steady_clock::time_point queuedTime;
+    std::chrono::steady_clock::time_point workStartTime;
+    std::chrono::steady_clock::time_point workEndTime;
 };
 
 const std::string getCurrentTimeInMilliseconds();
 
+// Writes the file next to its path first and renames it into place, so that a
+// crash or a full disk never leaves a truncated file behind. With ownerOnly
+// the file can only be read by the current user (not applied on Windows,
+// where files get the permissions of the directory).
+bool writeFileAtomically(const std::string &path, const std::vector<uint8_t> &data, bool ownerOnly);
+
+// Names of the files in the directory that end with the suffix. Returns
+// false if the directory cannot be read.
+bool listDirectory(const std::string &directory, const std::string &suffix, std::vector<std::string> &names);
+
 uint16_t uint16_decode(const uint8_t *p_encoded_data);
 uint32_t uint32_decode(const uint8_t *p_encoded_data);
 
@@ -306,6 +337,8 @@ public:
     static uint8_t *    getNativePointerToUint8(v8::Local<v8::Value>js);
     static uint16_t *   getNativePointerToUint16(v8::Local<v8::Object>js, const char *name);
     static uint16_t *   getNativePointerToUint16(v8::Local<v8::Value>js);
+    // Bytes of a Buffer or an array of numbers
+    static std::vector<uint8_t> getNativeBytes(v8::Local<v8::Value>js);
     static v8::Local<v8::Object> getJsObject(v8::Local<v8::Object>js, const char *name);
     static v8::Local<v8::Object> getJsObject(v8::Local<v8::Value>js);
     static v8::Local<v8::Object> getJsObjectOrNull(v8::Local<v8::Object>js, const char *name);
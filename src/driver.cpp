@@ -49,12 +49,10 @@
 #include "driver_gattc.h"
 #include "driver_gatts.h"
 #include "driver_uecc.h"
+#include "gatt_database.h"
 
 using namespace std;
 
-// Variable to use to handle callbacks while device is opened and the corresponding callbacks is not fully operational
-Adapter *adapterBeingOpened = nullptr;
-
 // Macro for keeping sanity in event switch case below
 #define COMMON_EVT_CASE(evt_enum, evt_to_js, params_name, event_array, event_array_idx, eventEntry) \
     case BLE_EVT_##evt_enum:                                                                                         \
@@ -110,6 +108,22 @@ static name_map_t uuid_type_name_map = {
     NAME_MAP_ENTRY(BLE_UUID_TYPE_VENDOR_BEGIN)
 };
 
+// Name of a BLE event, used for tracing. The returned string is a literal.
+static const char *eventName(uint16_t evt_id)
+{
+    for (auto name_map : { &common_event_name_map, &gap_event_name_map, &gattc_event_name_map, &gatts_event_name_map })
+    {
+        auto it = name_map->find(evt_id);
+
+        if (it != name_map->end())
+        {
+            return it->second;
+        }
+    }
+
+    return "Unknown event";
+}
+
 // This function is ran by the thread that the SoftDevice Driver has initiated
 void sd_rpc_on_log_event(adapter_t *adapter, sd_rpc_log_severity_t severity, const char *log_message)
 {
@@ -117,7 +131,7 @@ void sd_rpc_on_log_event(adapter_t *adapter, sd_rpc_log_severity_t severity, con
     logEntry->message = std::string(log_message);
     logEntry->severity = severity;
 
-    auto jsAdapter = Adapter::getAdapter(adapter, adapterBeingOpened);
+    auto jsAdapter = Adapter::getAdapter(adapter);
 
     if (jsAdapter != nullptr)
     {
@@ -132,9 +146,18 @@ void sd_rpc_on_log_event(adapter_t *adapter, sd_rpc_log_severity_t severity, con
 
 void Adapter::appendLog(LogEntry *log)
 {
+    metrics.countLog(static_cast<int>(log->severity));
+
     if (asyncLog != nullptr)
     {
-        logQueue.push(log);
+        if (!logQueue.push(log))
+        {
+            metrics.logQueue.drop();
+            delete log;
+            return;
+        }
+
+        metrics.logQueue.push();
         uv_async_send(asyncLog.get());
     }
 }
@@ -148,6 +171,7 @@ void Adapter::onLogEvent(uv_async_t *handle)
     {
         LogEntry *logEntry;
         logQueue.pop(logEntry);
+        metrics.logQueue.pop();
 
         if (logCallback != nullptr)
         {
@@ -219,7 +243,7 @@ static void sd_rpc_on_event(adapter_t *adapter, ble_evt_t *event)
         return;
     }
 
-    auto jsAdapter = Adapter::getAdapter(adapter, adapterBeingOpened);
+    auto jsAdapter = Adapter::getAdapter(adapter);
 
     if (jsAdapter != nullptr)
     {
@@ -234,6 +258,13 @@ static void sd_rpc_on_event(adapter_t *adapter, ble_evt_t *event)
 
 void Adapter::appendEvent(ble_evt_t *event)
 {
+    // Responses to native GATT procedures are handled here and not sent to JavaScript
+    if (gattClient.onEvent(adapter, event) || gattServer.onEvent(adapter, event))
+    {
+        metrics.countEvent(event->header.evt_id);
+        return;
+    }
+
     eventCallbackCount += 1;
     eventCallbackBatchEventCounter += 1;
 
@@ -252,8 +283,21 @@ void Adapter::appendEvent(ble_evt_t *event)
     auto eventEntry = new EventEntry();
     eventEntry->event = static_cast<ble_evt_t*>(evt);
     eventEntry->timestamp = getCurrentTimeInMilliseconds();
+    eventEntry->arrivalTime = std::chrono::steady_clock::now();
+
+    metrics.countEvent(event->header.evt_id);
 
-    eventQueue.push(eventEntry);
+    // Dropped events are counted in pc_ble_driver_queue_dropped_total, printing
+    // each of them would only slow down this thread while JavaScript is behind
+    if (!eventQueue.push(eventEntry))
+    {
+        metrics.eventQueue.drop();
+        free(eventEntry->event);
+        delete eventEntry;
+        return;
+    }
+
+    metrics.eventQueue.push();
 
     // If the event interval is not set, send the events to NodeJS as soon as possible.
     if (eventInterval == 0)
@@ -274,11 +318,16 @@ void Adapter::onRpcEvent(uv_async_t *handle)
 
     auto array = Nan::New<v8::Array>();
     auto arrayIndex = 0;
+    auto tracing = Tracer::isEnabled();
+
+    // Connections with GATTC requests from JavaScript answered in this batch
+    std::vector<uint16_t> answeredRequests;
 
     while (!eventQueue.wasEmpty())
     {
         EventEntry *eventEntry = nullptr;
         eventQueue.pop(eventEntry);
+        metrics.eventQueue.pop();
 
         if (eventEntry == nullptr)
         {
@@ -293,6 +342,13 @@ void Adapter::onRpcEvent(uv_async_t *handle)
             std::terminate();
         }
 
+        std::chrono::steady_clock::time_point toJsStartTime;
+
+        if (tracing)
+        {
+            toJsStartTime = std::chrono::steady_clock::now();
+        }
+
         if (eventCallback != nullptr)
         {
             switch (event->header.evt_id)
@@ -369,6 +425,13 @@ void Adapter::onRpcEvent(uv_async_t *handle)
                 if (keyset != 0)
                 {
                     Utility::Set(obj, "keyset", static_cast<v8::Handle<v8::Value>>(GapSecKeyset(keyset)));
+
+                    auto &authStatus = event->evt.gap_evt.params.auth_status;
+
+                    if (authStatus.auth_status == BLE_GAP_SEC_STATUS_SUCCESS && authStatus.bonded && authStatus.kdist_peer.id && keyset->keys_peer.p_id_key != nullptr)
+                    {
+                        gattServer.setPeerIdentity(event->evt.gap_evt.conn_handle, *keyset->keys_peer.p_id_key);
+                    }
                 }
                 else
                 {
@@ -377,10 +440,87 @@ void Adapter::onRpcEvent(uv_async_t *handle)
 
                 destroySecurityKeyStorage(event->evt.gap_evt.conn_handle);
             }
+            else if (event->header.evt_id == BLE_GAP_EVT_DISCONNECTED)
+            {
+                gattClient.clearAttributeIndex(event->evt.gap_evt.conn_handle);
+            }
+            else if (event->header.evt_id == BLE_GATTS_EVT_RW_AUTHORIZE_REQUEST)
+            {
+                // Prepared writes are executed and replied to by the GattServer
+                auto &request = event->evt.gatts_evt.params.authorize_request;
+                GattExecutedWrites executed;
+
+                if (request.type == BLE_GATTS_AUTHORIZE_TYPE_WRITE &&
+                    request.request.write.op == BLE_GATTS_OP_EXEC_WRITE_REQ_NOW &&
+                    gattServer.takeExecutedWrites(event->evt.gatts_evt.conn_handle, executed))
+                {
+                    v8::Local<v8::Object> obj = Nan::To<v8::Object>(Utility::Get(array, arrayIndex)).ToLocalChecked();
+                    auto writes = Nan::New<v8::Array>(static_cast<uint32_t>(executed.writes.size()));
+
+                    for (uint32_t i = 0; i < executed.writes.size(); i++)
+                    {
+                        auto &write = executed.writes[i];
+                        auto writeObj = Nan::New<v8::Object>();
+
+                        Utility::Set(writeObj, "handle", write.handle);
+                        Utility::Set(writeObj, "offset", write.offset);
+                        Utility::Set(writeObj, "value", ConversionUtility::toJsValueArray(write.value.data(), static_cast<uint16_t>(write.value.size())));
+                        Nan::Set(writes, i, writeObj);
+                    }
+
+                    Utility::Set(obj, "executed_gatt_status", executed.gattStatus);
+                    Utility::Set(obj, "executed_writes", writes);
+                }
+            }
+            else if (event->header.evt_id == BLE_GATTC_EVT_HVX ||
+                     event->header.evt_id == BLE_GATTC_EVT_READ_RSP ||
+                     event->header.evt_id == BLE_GATTC_EVT_WRITE_RSP)
+            {
+                // Let JavaScript look up the attribute by instance id instead of searching by handle
+                auto gattcEvent = &event->evt.gattc_evt;
+                uint16_t handle;
+
+                if (event->header.evt_id == BLE_GATTC_EVT_HVX)
+                {
+                    handle = gattcEvent->params.hvx.handle;
+                }
+                else if (event->header.evt_id == BLE_GATTC_EVT_READ_RSP)
+                {
+                    handle = gattcEvent->params.read_rsp.handle;
+                }
+                else
+                {
+                    handle = gattcEvent->params.write_rsp.handle;
+                }
+
+                auto instanceId = gattClient.findAttribute(gattcEvent->conn_handle, handle);
+
+                if (instanceId != nullptr)
+                {
+                    v8::Local<v8::Object> obj = Nan::To<v8::Object>(Utility::Get(array, arrayIndex)).ToLocalChecked();
+                    Utility::Set(obj, "attribute_instance_id", ConversionUtility::toJsString(*instanceId));
+                }
+            }
         }
 
         arrayIndex++;
 
+        if (event->header.evt_id >= BLE_GATTC_EVT_BASE && event->header.evt_id <= BLE_GATTC_EVT_LAST &&
+            GattClient::isResponse(event->header.evt_id, &event->evt.gattc_evt))
+        {
+            answeredRequests.push_back(event->evt.gattc_evt.conn_handle);
+        }
+
+        if (tracing)
+        {
+            // All event structs start with the connection handle
+            auto name = eventName(event->header.evt_id);
+            auto connHandle = event->evt.common_evt.conn_handle;
+
+            Tracer::addSpan("event.queue", name, adapterId, connHandle, eventEntry->arrivalTime, toJsStartTime, Tracer::nextAsyncId());
+            Tracer::addSpan("event.toJs", name, adapterId, connHandle, toJsStartTime, std::chrono::steady_clock::now());
+        }
+
         // Free memory for current entry
         free(eventEntry->event);
         delete eventEntry;
@@ -389,7 +529,7 @@ void Adapter::onRpcEvent(uv_async_t *handle)
     v8::Local<v8::Value> callback_value[1];
     callback_value[0] = array;
 
-    auto start = chrono::high_resolution_clock::now();
+    auto start = chrono::steady_clock::now();
 
     if (eventCallback != nullptr)
     {
@@ -401,10 +541,23 @@ void Adapter::onRpcEvent(uv_async_t *handle)
         std::cerr << "BLE event received, but no callback is registered." << std::endl;
     }
 
-    auto end = chrono::high_resolution_clock::now();
+    auto end = chrono::steady_clock::now();
+
+    if (tracing)
+    {
+        Tracer::addSpan("event.callback", "eventCallback", adapterId, TRACE_NO_CONN_HANDLE, start, end);
+    }
 
     auto duration = chrono::duration_cast<chrono::milliseconds>(end - start);
     addEventBatchStatistics(duration);
+
+    // JavaScript has issued its follow-up requests, if any, queued GATTC operations can go now
+    for (auto connHandle : answeredRequests)
+    {
+        gattClient.endRequest(connHandle);
+    }
+
+    gattClient.resume(adapter);
 }
 
 static void sd_rpc_on_status(adapter_t *adapter, sd_rpc_app_status_t id, const char * message)
@@ -414,7 +567,7 @@ static void sd_rpc_on_status(adapter_t *adapter, sd_rpc_app_status_t id, const c
     statusEntry->id = id;
     statusEntry->message = std::string(message);
 
-    auto jsAdapter = Adapter::getAdapter(adapter, adapterBeingOpened);
+    auto jsAdapter = Adapter::getAdapter(adapter);
 
     if (jsAdapter != nullptr)
     {
@@ -431,7 +584,14 @@ void Adapter::appendStatus(StatusEntry *status)
 {
     if (asyncStatus != nullptr)
     {
-        statusQueue.push(status);
+        if (!statusQueue.push(status))
+        {
+            metrics.statusQueue.drop();
+            delete status;
+            return;
+        }
+
+        metrics.statusQueue.push();
         uv_async_send(asyncStatus.get());
     }
 }
@@ -445,6 +605,7 @@ void Adapter::onStatusEvent(uv_async_t *handle)
     {
         StatusEntry *statusEntry;
         statusQueue.pop(statusEntry);
+        metrics.statusQueue.pop();
 
         if (statusCallback != nullptr)
         {
@@ -600,7 +761,7 @@ NAN_METHOD(Adapter::EnableBLE)
         return;
     }
 
-    uv_queue_work(uv_default_loop(), baton->req, EnableBLE, reinterpret_cast<uv_after_work_cb>(AfterEnableBLE));
+    queueCommand<EnableBLE, AfterEnableBLE>(baton, "enableBLE");
 }
 
 // This runs in a worker thread (not Main Thread)
@@ -662,6 +823,7 @@ NAN_METHOD(Adapter::Open)
 
     auto baton = new OpenBaton(callback);
     baton->mainObject = obj;
+    baton->owner = obj;
     baton->path = path;
 
     auto parameter = 0;
@@ -677,6 +839,7 @@ NAN_METHOD(Adapter::Open)
         baton->response_timeout = ConversionUtility::getNativeUint32(options, "responseTimeout"); parameter++;
         baton->enable_ble = ConversionUtility::getBool(options, "enableBLE"); parameter++;
         baton->enable_ble_params = EnableParameters(ConversionUtility::getJsObject(options, "enableBLEParams")); parameter++;
+        baton->auto_confirm_indications = ConversionUtility::getBool(options, "autoConfirmIndications"); parameter++;
     }
     catch (std::string error)
     {
@@ -691,7 +854,8 @@ NAN_METHOD(Adapter::Open)
             "retransmissionInterval",
             "responseTimeout",
             "enableBLE",
-            "enableBLEParams"
+            "enableBLEParams",
+            "autoConfirmIndications"
         };
         errormessage << _options[parameter] << ". Reason: " << error;
         Nan::ThrowTypeError(errormessage.str().c_str());
@@ -731,7 +895,7 @@ NAN_METHOD(Adapter::Open)
         return;
     }
 
-    uv_queue_work(uv_default_loop(), baton->req, Open, reinterpret_cast<uv_after_work_cb>(AfterOpen));
+    queueCommand<Open, AfterOpen>(baton, "open");
 }
 
 // This runs in a worker thread (not Main Thread)
@@ -742,10 +906,7 @@ void Adapter::Open(uv_work_t *req)
     baton->mainObject->initEventHandling(std::move(baton->event_callback), baton->evt_interval);
     baton->mainObject->initLogHandling(std::move(baton->log_callback));
     baton->mainObject->initStatusHandling(std::move(baton->status_callback));
-
-    // Ensure that the correct adapter gets the callbacks as long as we have no reference to
-    // the driver adapter until after sd_rpc_open is called
-    adapterBeingOpened = baton->mainObject;
+    baton->mainObject->gattClient.setAutoConfirmIndications(baton->auto_confirm_indications);
 
     auto path = baton->path.c_str();
 
@@ -762,6 +923,10 @@ void Adapter::Open(uv_work_t *req)
     baton->adapter = adapter;
     baton->mainObject->adapter = adapter;
 
+    // Register the driver adapter before sd_rpc_open so that callbacks received while
+    // opening are routed to this adapter. Several adapters may be opened in parallel.
+    Adapter::registerAdapter(adapter, baton->mainObject);
+
     // Set the log level
     auto error_code = sd_rpc_log_handler_severity_filter_set(adapter, baton->log_level);
 
@@ -769,23 +934,27 @@ void Adapter::Open(uv_work_t *req)
     {
         std::cerr << std::endl << "Failed to set log severity filter." << std::endl;
         baton->result = error_code;
+
+        Adapter::unregisterAdapter(adapter);
         return;
     }
 
     error_code = sd_rpc_open(adapter, sd_rpc_on_status, sd_rpc_on_event, sd_rpc_on_log_event);
 
-    // Let the normal log handling handle the rest of the log calls
-    adapterBeingOpened = nullptr;
-
     if (error_code != NRF_SUCCESS)
     {
         std::cerr << std::endl << "Failed to open the nRF5 BLE driver." << std::endl;
         baton->result = error_code;
 
+        Adapter::unregisterAdapter(adapter);
+
         // Delete the adapter layer and all layers below
         sd_rpc_adapter_delete(adapter);
         free(adapter);
 
+        baton->adapter = nullptr;
+        baton->mainObject->adapter = nullptr;
+
         return;
     }
 
@@ -856,7 +1025,7 @@ NAN_METHOD(Adapter::Close)
     baton->adapter = obj->adapter;
     baton->mainObject = obj;
 
-    uv_queue_work(uv_default_loop(), baton->req, Close, reinterpret_cast<uv_after_work_cb>(AfterClose));
+    queueCommand<Close, AfterClose>(baton, "close");
 }
 
 void Adapter::Close(uv_work_t *req)
@@ -884,8 +1053,15 @@ void Adapter::AfterClose(uv_work_t *req)
         {
             argv[0] = Nan::Undefined();
 
+            Adapter::unregisterAdapter(baton->adapter);
             sd_rpc_adapter_delete(baton->adapter);
             free(baton->adapter);
+
+            if (baton->mainObject->adapter == baton->adapter)
+            {
+                baton->mainObject->adapter = nullptr;
+            }
+
             baton->adapter = nullptr;
         }
 
@@ -918,7 +1094,7 @@ NAN_METHOD(Adapter::ConnReset)
     /* Hardcoding the reset mode. Consider adding argument for letting user choose reset mode. */
     baton->reset = SOFT_RESET;
 
-    uv_queue_work(uv_default_loop(), baton->req, ConnReset, reinterpret_cast<uv_after_work_cb>(AfterConnReset));
+    queueCommand<ConnReset, AfterConnReset>(baton, "connReset");
 }
 
 void Adapter::ConnReset(uv_work_t *req)
@@ -979,7 +1155,7 @@ NAN_METHOD(Adapter::AddVendorSpecificUUID)
     baton->p_vs_uuid = BleUUID128(uuid);
     baton->adapter = obj->adapter;
 
-    uv_queue_work(uv_default_loop(), baton->req, AddVendorSpecificUUID, reinterpret_cast<uv_after_work_cb>(AfterAddVendorSpecificUUID));
+    queueCommand<AddVendorSpecificUUID, AfterAddVendorSpecificUUID>(baton, "addVendorSpecificUUID");
 }
 
 void Adapter::AddVendorSpecificUUID(uv_work_t *req)
@@ -1094,7 +1270,7 @@ NAN_METHOD(Adapter::GetVersion)
     baton->version = version;
     baton->adapter = obj->adapter;
 
-    uv_queue_work(uv_default_loop(), baton->req, GetVersion, reinterpret_cast<uv_after_work_cb>(AfterGetVersion));
+    queueCommand<GetVersion, AfterGetVersion>(baton, "getVersion");
 
     return;
 }
@@ -1167,7 +1343,7 @@ NAN_METHOD(Adapter::EncodeUUID)
     baton->uuid_le = new uint8_t[16];
     baton->adapter = obj->adapter;
 
-    uv_queue_work(uv_default_loop(), baton->req, EncodeUUID, reinterpret_cast<uv_after_work_cb>(AfterEncodeUUID));
+    queueCommand<EncodeUUID, AfterEncodeUUID>(baton, "encodeUUID");
 
     return;
 }
@@ -1237,7 +1413,7 @@ NAN_METHOD(Adapter::DecodeUUID)
     baton->p_uuid = new ble_uuid_t();
     baton->adapter = obj->adapter;
 
-    uv_queue_work(uv_default_loop(), baton->req, DecodeUUID, reinterpret_cast<uv_after_work_cb>(AfterDecodeUUID));
+    queueCommand<DecodeUUID, AfterDecodeUUID>(baton, "decodeUUID");
 
     return;
 }
@@ -1284,6 +1460,150 @@ NAN_METHOD(Adapter::GetStats)
     Utility::SetReturnValue(info, stats);
 }
 
+NAN_METHOD(Adapter::GetCommandStats)
+{
+    auto obj = Nan::ObjectWrap::Unwrap<Adapter>(info.Holder());
+    auto stats = Nan::New<v8::Object>();
+
+    for (auto &entry : obj->commandStatistics)
+    {
+        auto command = Nan::New<v8::Object>();
+
+        Utility::Set(command, "count", entry.second.count);
+        Utility::Set(command, "errorCount", entry.second.errorCount);
+        Utility::Set(command, "queueWait", entry.second.queueWait.ToJs());
+        Utility::Set(command, "call", entry.second.call.ToJs());
+        Utility::Set(command, "callbackDelay", entry.second.callbackDelay.ToJs());
+
+        Utility::Set(stats, entry.first.c_str(), command);
+    }
+
+    Utility::SetReturnValue(info, stats);
+}
+
+NAN_METHOD(Adapter::GetMetrics)
+{
+    auto obj = Nan::ObjectWrap::Unwrap<Adapter>(info.Holder());
+    auto &metrics = obj->metrics;
+    auto adapterLabel = MetricsWriter::label("adapter", std::to_string(obj->getAdapterId()));
+    MetricsWriter writer;
+
+    writer.family("pc_ble_driver_events_total", "counter", "BLE events received from the connectivity chip.");
+
+    for (uint16_t evt_id = 0; evt_id < METRICS_EVENT_ID_COUNT; evt_id++)
+    {
+        auto count = metrics.getEventCount(evt_id);
+
+        if (count > 0)
+        {
+            writer.sample("pc_ble_driver_events_total", adapterLabel + "," + MetricsWriter::label("event", eventName(evt_id)), count);
+        }
+    }
+
+    const std::pair<const char *, const QueueMetrics *> queues[] = {
+        { "event", &metrics.eventQueue },
+        { "log", &metrics.logQueue },
+        { "status", &metrics.statusQueue }
+    };
+
+    writer.family("pc_ble_driver_queue_dropped_total", "counter", "Entries dropped because the queue to JavaScript was full.");
+
+    for (auto &queue : queues)
+    {
+        writer.sample("pc_ble_driver_queue_dropped_total", adapterLabel + "," + MetricsWriter::label("queue", queue.first), queue.second->dropped.load(std::memory_order_relaxed));
+    }
+
+    writer.family("pc_ble_driver_queue_depth", "gauge", "Entries waiting in the queue to JavaScript.");
+
+    for (auto &queue : queues)
+    {
+        writer.sample("pc_ble_driver_queue_depth", adapterLabel + "," + MetricsWriter::label("queue", queue.first), queue.second->depth());
+    }
+
+    writer.family("pc_ble_driver_queue_depth_max", "gauge", "Highest number of entries waiting in the queue to JavaScript.");
+
+    for (auto &queue : queues)
+    {
+        writer.sample("pc_ble_driver_queue_depth_max", adapterLabel + "," + MetricsWriter::label("queue", queue.first), queue.second->highWater.load(std::memory_order_relaxed));
+    }
+
+    writer.family("pc_ble_driver_commands_total", "counter", "Completed commands.");
+
+    for (auto &entry : obj->commandStatistics)
+    {
+        writer.sample("pc_ble_driver_commands_total", adapterLabel + "," + MetricsWriter::label("command", entry.first), entry.second.count);
+    }
+
+    writer.family("pc_ble_driver_command_errors_total", "counter", "Commands that returned an error.");
+
+    for (auto &entry : obj->commandStatistics)
+    {
+        writer.sample("pc_ble_driver_command_errors_total", adapterLabel + "," + MetricsWriter::label("command", entry.first), entry.second.errorCount);
+    }
+
+    writer.family("pc_ble_driver_gattc_write_bytes_total", "counter", "Bytes written as GATT client.");
+
+    for (uint16_t connHandle = 0; connHandle < METRICS_CONNECTION_COUNT; connHandle++)
+    {
+        auto bytes = metrics.getConnection(connHandle).bytesWritten.load(std::memory_order_relaxed);
+
+        if (bytes > 0)
+        {
+            writer.sample("pc_ble_driver_gattc_write_bytes_total", adapterLabel + "," + MetricsWriter::label("conn_handle", std::to_string(connHandle)), bytes);
+        }
+    }
+
+    writer.family("pc_ble_driver_gatts_hvx_bytes_total", "counter", "Bytes sent as GATT server notifications and indications.");
+
+    for (uint16_t connHandle = 0; connHandle < METRICS_CONNECTION_COUNT; connHandle++)
+    {
+        auto bytes = metrics.getConnection(connHandle).bytesNotified.load(std::memory_order_relaxed);
+
+        if (bytes > 0)
+        {
+            writer.sample("pc_ble_driver_gatts_hvx_bytes_total", adapterLabel + "," + MetricsWriter::label("conn_handle", std::to_string(connHandle)), bytes);
+        }
+    }
+
+    writer.family("pc_ble_driver_gatts_queue_wait_microseconds", "summary", "Time notifications waited in the native queue of a connection.");
+
+    for (uint16_t connHandle = 0; connHandle < METRICS_CONNECTION_COUNT; connHandle++)
+    {
+        auto &connection = metrics.getConnection(connHandle);
+        auto count = connection.notificationsQueued.load(std::memory_order_relaxed);
+
+        if (count > 0)
+        {
+            auto labels = adapterLabel + "," + MetricsWriter::label("conn_handle", std::to_string(connHandle));
+            writer.sample("pc_ble_driver_gatts_queue_wait_microseconds_sum", labels, connection.notificationQueueMicros.load(std::memory_order_relaxed));
+            writer.sample("pc_ble_driver_gatts_queue_wait_microseconds_count", labels, count);
+        }
+    }
+
+    writer.family("pc_ble_driver_gatts_queue_wait_microseconds_max", "gauge", "Longest time a notification waited in the native queue of a connection.");
+
+    for (uint16_t connHandle = 0; connHandle < METRICS_CONNECTION_COUNT; connHandle++)
+    {
+        auto &connection = metrics.getConnection(connHandle);
+
+        if (connection.notificationsQueued.load(std::memory_order_relaxed) > 0)
+        {
+            writer.sample("pc_ble_driver_gatts_queue_wait_microseconds_max", adapterLabel + "," + MetricsWriter::label("conn_handle", std::to_string(connHandle)), connection.notificationQueueMicrosMax.load(std::memory_order_relaxed));
+        }
+    }
+
+    const char *severities[] = { "trace", "debug", "info", "warning", "error", "fatal" };
+
+    writer.family("pc_ble_driver_log_lines_total", "counter", "Log lines received from pc-ble-driver.");
+
+    for (auto severity = 0; severity < METRICS_LOG_SEVERITY_COUNT; severity++)
+    {
+        writer.sample("pc_ble_driver_log_lines_total", adapterLabel + "," + MetricsWriter::label("severity", severities[severity]), metrics.getLogCount(severity));
+    }
+
+    info.GetReturnValue().Set(Nan::New(writer.str()).ToLocalChecked());
+}
+
 NAN_METHOD(Adapter::ReplyUserMemory)
 {
     auto obj = Nan::ObjectWrap::Unwrap<Adapter>(info.Holder());
@@ -1325,7 +1645,7 @@ NAN_METHOD(Adapter::ReplyUserMemory)
         return;
     }
 
-    uv_queue_work(uv_default_loop(), baton->req, ReplyUserMemory, reinterpret_cast<uv_after_work_cb>(AfterReplyUserMemory));
+    queueCommand<ReplyUserMemory, AfterReplyUserMemory>(baton, "replyUserMemory");
 }
 
 void Adapter::ReplyUserMemory(uv_work_t *req)
@@ -1399,7 +1719,7 @@ NAN_METHOD(Adapter::SetBleOption)
         return;
     }
 
-    uv_queue_work(uv_default_loop(), baton->req, SetBleOption, reinterpret_cast<uv_after_work_cb>(AfterSetBleOption));
+    queueCommand<SetBleOption, AfterSetBleOption>(baton, "setBleOption");
 }
 
 // This runs in a worker thread (not Main Thread)
@@ -1463,7 +1783,7 @@ NAN_METHOD(Adapter::GetBleOption)
     baton->opt_id = optionId;
     baton->p_opt = new ble_opt_t();
 
-    uv_queue_work(uv_default_loop(), baton->req, GetBleOption, reinterpret_cast<uv_after_work_cb>(AfterGetBleOption));
+    queueCommand<GetBleOption, AfterGetBleOption>(baton, "getBleOption");
 }
 
 // This runs in a worker thread (not Main Thread)
@@ -1553,7 +1873,7 @@ NAN_METHOD(Adapter::SetBleConfig)
         return;
     }
 
-    uv_queue_work(uv_default_loop(), baton->req, SetBleConfig, reinterpret_cast<uv_after_work_cb>(AfterSetBleConfig));
+    queueCommand<SetBleConfig, AfterSetBleConfig>(baton, "setBleConfig");
 }
 
 void Adapter::SetBleConfig(uv_work_t *req)
@@ -2459,11 +2779,16 @@ extern "C" {
         Adapter::Init(target);
 
         init_uecc(target);
+        init_tracer(target);
+        init_gatt_database(target);
+        init_gatt_server(target);
     }
 
     void init_adapter_list(Nan::ADDON_REGISTER_FUNCTION_ARGS_TYPE target)
     {
         Utility::SetMethod(target, "getAdapters", GetAdapterList);
+        Utility::SetMethod(target, "startAdapterMonitor", StartAdapterMonitor);
+        Utility::SetMethod(target, "stopAdapterMonitor", StopAdapterMonitor);
     }
 
     void init_driver(Nan::ADDON_REGISTER_FUNCTION_ARGS_TYPE target)
@@ -429,6 +429,7 @@ public:
     uint32_t response_timeout; // Duration to wait for reply on reliable packet sent to target
 
     bool enable_ble; // Enable BLE or not when connecting, if not the developer must enable the BLE when state is active
+    bool auto_confirm_indications; // Confirm indications in the binding, before the event is sent to NodeJS
 
     enable_ble_params_t *enable_ble_params; // If enable BLE is true, then use these params when enabling BLE
 
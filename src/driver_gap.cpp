@@ -1707,7 +1707,7 @@ NAN_METHOD(Adapter::GapSetAddress)
     }
     baton->adapter = obj->adapter;
 
-    uv_queue_work(uv_default_loop(), baton->req, GapSetAddress, reinterpret_cast<uv_after_work_cb>(AfterGapSetAddress));
+    queueCommand<GapSetAddress, AfterGapSetAddress>(baton, "gapSetAddress");
 }
 
 void Adapter::GapSetAddress(uv_work_t *req)
@@ -1770,7 +1770,7 @@ NAN_METHOD(Adapter::GapGetAddress)
     baton->address = address;
     baton->adapter = obj->adapter;
 
-    uv_queue_work(uv_default_loop(), baton->req, GapGetAddress, reinterpret_cast<uv_after_work_cb>(AfterGapGetAddress));
+    queueCommand<GapGetAddress, AfterGapGetAddress>(baton, "gapGetAddress");
 
     return;
 }
@@ -1855,7 +1855,7 @@ NAN_METHOD(Adapter::GapUpdateConnectionParameters)
     }
     baton->adapter = obj->adapter;
 
-    uv_queue_work(uv_default_loop(), baton->req, GapUpdateConnectionParameters, reinterpret_cast<uv_after_work_cb>(AfterGapUpdateConnectionParameters));
+    queueCommand<GapUpdateConnectionParameters, AfterGapUpdateConnectionParameters>(baton, "gapUpdateConnectionParameters");
 }
 
 // This runs in a worker thread (not Main Thread)
@@ -1924,7 +1924,7 @@ NAN_METHOD(Adapter::GapDisconnect)
     baton->hci_status_code = hci_status_code;
     baton->adapter = obj->adapter;
 
-    uv_queue_work(uv_default_loop(), baton->req, GapDisconnect, reinterpret_cast<uv_after_work_cb>(AfterGapDisconnect));
+    queueCommand<GapDisconnect, AfterGapDisconnect>(baton, "gapDisconnect");
 }
 
 // This runs in a worker thread (not Main Thread)
@@ -1987,7 +1987,7 @@ NAN_METHOD(Adapter::GapSetTXPower)
     baton->tx_power = tx_power;
     baton->adapter = obj->adapter;
 
-    uv_queue_work(uv_default_loop(), baton->req, GapSetTXPower, reinterpret_cast<uv_after_work_cb>(AfterGapSetTXPower));
+    queueCommand<GapSetTXPower, AfterGapSetTXPower>(baton, "gapSetTXPower");
 
 }
 
@@ -2073,7 +2073,7 @@ NAN_METHOD(Adapter::GapSetDeviceName)
     baton->length = (uint16_t)length;
     baton->adapter = obj->adapter;
 
-    uv_queue_work(uv_default_loop(), baton->req, GapSetDeviceName, reinterpret_cast<uv_after_work_cb>(AfterGapSetDeviceName));
+    queueCommand<GapSetDeviceName, AfterGapSetDeviceName>(baton, "gapSetDeviceName");
 }
 
 // This runs in a worker thread (not Main Thread)
@@ -2134,7 +2134,7 @@ NAN_METHOD(Adapter::GapGetDeviceName)
     baton->dev_name.resize(baton->length);
     baton->adapter = obj->adapter;
 
-    uv_queue_work(uv_default_loop(), baton->req, GapGetDeviceName, reinterpret_cast<uv_after_work_cb>(AfterGapGetDeviceName));
+    queueCommand<GapGetDeviceName, AfterGapGetDeviceName>(baton, "gapGetDeviceName");
 }
 
 // This runs in a worker thread (not Main Thread)
@@ -2213,7 +2213,7 @@ NAN_METHOD(Adapter::GapStartRSSI)
     baton->skip_count = skip_count;
     baton->adapter = obj->adapter;
 
-    uv_queue_work(uv_default_loop(), baton->req, GapStartRSSI, reinterpret_cast<uv_after_work_cb>(AfterGapStartRSSI));
+    queueCommand<GapStartRSSI, AfterGapStartRSSI>(baton, "gapStartRSSI");
 }
 
 // This runs in a worker thread (not Main Thread)
@@ -2275,7 +2275,7 @@ NAN_METHOD(Adapter::GapStopRSSI)
     baton->conn_handle = conn_handle;
     baton->adapter = obj->adapter;
 
-    uv_queue_work(uv_default_loop(), baton->req, GapStopRSSI, reinterpret_cast<uv_after_work_cb>(AfterGapStopRSSI));
+    queueCommand<GapStopRSSI, AfterGapStopRSSI>(baton, "gapStopRSSI");
 }
 
 // This runs in a worker thread (not Main Thread)
@@ -2353,7 +2353,7 @@ NAN_METHOD(Adapter::GapStartScan)
     baton->adapter = obj->adapter;
 
 
-    uv_queue_work(uv_default_loop(), baton->req, GapStartScan, reinterpret_cast<uv_after_work_cb>(AfterGapStartScan));
+    queueCommand<GapStartScan, AfterGapStartScan>(baton, "gapStartScan");
 }
 
 // This runs in a worker thread (not Main Thread)
@@ -2415,7 +2415,7 @@ NAN_METHOD(Adapter::GapStopScan)
     auto baton = new StopScanBaton(callback);
     baton->adapter = obj->adapter;
 
-    uv_queue_work(uv_default_loop(), baton->req, GapStopScan, reinterpret_cast<uv_after_work_cb>(AfterGapStopScan));
+    queueCommand<GapStopScan, AfterGapStopScan>(baton, "gapStopScan");
 }
 
 // This runs in a worker thread (not Main Thread)
@@ -2518,7 +2518,7 @@ NAN_METHOD(Adapter::GapConnect)
         return;
     }
 
-    uv_queue_work(uv_default_loop(), baton->req, GapConnect, reinterpret_cast<uv_after_work_cb>(AfterGapConnect));
+    queueCommand<GapConnect, AfterGapConnect>(baton, "gapConnect");
 }
 
 // This runs in a worker thread (not Main Thread)
@@ -2580,7 +2580,7 @@ NAN_METHOD(Adapter::GapCancelConnect)
     auto baton = new GapConnectCancelBaton(callback);
     baton->adapter = obj->adapter;
 
-    uv_queue_work(uv_default_loop(), baton->req, GapCancelConnect, reinterpret_cast<uv_after_work_cb>(AfterGapCancelConnect));
+    queueCommand<GapCancelConnect, AfterGapCancelConnect>(baton, "gapCancelConnect");
 }
 
 // This runs in a worker thread (not Main Thread)
@@ -2642,7 +2642,7 @@ NAN_METHOD(Adapter::GapGetRSSI)
     baton->rssi = 0;
     baton->adapter = obj->adapter;
 
-    uv_queue_work(uv_default_loop(), baton->req, GapGetRSSI, reinterpret_cast<uv_after_work_cb>(AfterGapGetRSSI));
+    queueCommand<GapGetRSSI, AfterGapGetRSSI>(baton, "gapGetRSSI");
 }
 
 // This runs in a worker thread (not Main Thread)
@@ -2740,7 +2740,7 @@ NAN_METHOD(Adapter::GapStartAdvertising)
 
     baton->adapter = obj->adapter;
 
-    uv_queue_work(uv_default_loop(), baton->req, GapStartAdvertising, reinterpret_cast<uv_after_work_cb>(AfterGapStartAdvertising));
+    queueCommand<GapStartAdvertising, AfterGapStartAdvertising>(baton, "gapStartAdvertising");
 }
 
 // This runs in a worker thread (not Main Thread)
@@ -2806,7 +2806,7 @@ NAN_METHOD(Adapter::GapStopAdvertising)
     auto baton = new GapStopAdvertisingBaton(callback);
     baton->adapter = obj->adapter;
 
-    uv_queue_work(uv_default_loop(), baton->req, GapStopAdvertising, reinterpret_cast<uv_after_work_cb>(AfterGapStopAdvertising));
+    queueCommand<GapStopAdvertising, AfterGapStopAdvertising>(baton, "gapStopAdvertising");
 }
 
 // This runs in a worker thread (not Main Thread)
@@ -2869,7 +2869,7 @@ NAN_METHOD(Adapter::GapGetConnectionSecurity)
     baton->conn_sec = new ble_gap_conn_sec_t();
     baton->adapter = obj->adapter;
 
-    uv_queue_work(uv_default_loop(), baton->req, GapGetConnectionSecurity, reinterpret_cast<uv_after_work_cb>(AfterGapGetConnectionSecurity));
+    queueCommand<GapGetConnectionSecurity, AfterGapGetConnectionSecurity>(baton, "gapGetConnectionSecurity");
 }
 
 // This runs in a worker thread (not Main Thread)
@@ -2963,7 +2963,7 @@ NAN_METHOD(Adapter::GapEncrypt)
     }
     baton->adapter = obj->adapter;
 
-    uv_queue_work(uv_default_loop(), baton->req, GapEncrypt, reinterpret_cast<uv_after_work_cb>(AfterGapEncrypt));
+    queueCommand<GapEncrypt, AfterGapEncrypt>(baton, "gapEncrypt");
 }
 
 void Adapter::GapEncrypt(uv_work_t *req)
@@ -3096,7 +3096,7 @@ NAN_METHOD(Adapter::GapReplySecurityParameters)
 
     baton->adapter = obj->adapter;
 
-    uv_queue_work(uv_default_loop(), baton->req, GapReplySecurityParameters, reinterpret_cast<uv_after_work_cb>(AfterGapReplySecurityParameters));
+    queueCommand<GapReplySecurityParameters, AfterGapReplySecurityParameters>(baton, "gapReplySecurityParameters");
 }
 
 // This runs in a worker thread (not Main Thread)
@@ -3218,7 +3218,7 @@ NAN_METHOD(Adapter::GapReplySecurityInfo)
     }
     baton->adapter = obj->adapter;
 
-    uv_queue_work(uv_default_loop(), baton->req, GapReplySecurityInfo, reinterpret_cast<uv_after_work_cb>(AfterGapReplySecurityInfo));
+    queueCommand<GapReplySecurityInfo, AfterGapReplySecurityInfo>(baton, "gapReplySecurityInfo");
 }
 
 void Adapter::GapReplySecurityInfo(uv_work_t *req)
@@ -3293,7 +3293,7 @@ NAN_METHOD(Adapter::GapAuthenticate)
     }
     baton->adapter = obj->adapter;
 
-    uv_queue_work(uv_default_loop(), baton->req, GapAuthenticate, reinterpret_cast<uv_after_work_cb>(AfterGapAuthenticate));
+    queueCommand<GapAuthenticate, AfterGapAuthenticate>(baton, "gapAuthenticate");
 }
 
 // This runs in a worker thread (not Main Thread)
@@ -3387,7 +3387,7 @@ NAN_METHOD(Adapter::GapSetAdvertisingData)
     baton->srdlen = scan_response_length;
     baton->adapter = obj->adapter;
 
-    uv_queue_work(uv_default_loop(), baton->req, GapSetAdvertisingData, reinterpret_cast<uv_after_work_cb>(AfterGapSetAdvertisingData));
+    queueCommand<GapSetAdvertisingData, AfterGapSetAdvertisingData>(baton, "gapSetAdvertisingData");
 }
 
 // This runs in a worker thread (not Main Thread)
@@ -3460,7 +3460,7 @@ NAN_METHOD(Adapter::GapSetPPCP)
     }
     baton->adapter = obj->adapter;
 
-    uv_queue_work(uv_default_loop(), baton->req, GapSetPPCP, reinterpret_cast<uv_after_work_cb>(AfterGapSetPPCP));
+    queueCommand<GapSetPPCP, AfterGapSetPPCP>(baton, "gapSetPPCP");
 }
 
 // This runs in a worker thread (not Main Thread)
@@ -3518,7 +3518,7 @@ NAN_METHOD(Adapter::GapGetPPCP)
     baton->p_conn_params = new ble_gap_conn_params_t();
     baton->adapter = obj->adapter;
 
-    uv_queue_work(uv_default_loop(), baton->req, GapGetPPCP, reinterpret_cast<uv_after_work_cb>(AfterGapGetPPCP));
+    queueCommand<GapGetPPCP, AfterGapGetPPCP>(baton, "gapGetPPCP");
 }
 
 // This runs in a worker thread (not Main Thread)
@@ -3582,7 +3582,7 @@ NAN_METHOD(Adapter::GapSetAppearance)
     baton->appearance = appearance;
     baton->adapter = obj->adapter;
 
-    uv_queue_work(uv_default_loop(), baton->req, GapSetAppearance, reinterpret_cast<uv_after_work_cb>(AfterGapSetAppearance));
+    queueCommand<GapSetAppearance, AfterGapSetAppearance>(baton, "gapSetAppearance");
 }
 
 // This runs in a worker thread (not Main Thread)
@@ -3637,7 +3637,7 @@ NAN_METHOD(Adapter::GapGetAppearance)
     auto baton = new GapGetAppearanceBaton(callback);
     baton->adapter = obj->adapter;
 
-    uv_queue_work(uv_default_loop(), baton->req, GapGetAppearance, reinterpret_cast<uv_after_work_cb>(AfterGapGetAppearance));
+    queueCommand<GapGetAppearance, AfterGapGetAppearance>(baton, "gapGetAppearance");
 }
 
 // This runs in a worker thread (not Main Thread)
@@ -3727,7 +3727,7 @@ NAN_METHOD(Adapter::GapReplyAuthKey)
     baton->key_type = key_type;
     baton->key = key;
 
-    uv_queue_work(uv_default_loop(), baton->req, GapReplyAuthKey, reinterpret_cast<uv_after_work_cb>(AfterGapReplyAuthKey));
+    queueCommand<GapReplyAuthKey, AfterGapReplyAuthKey>(baton, "gapReplyAuthKey");
 }
 
 // This runs in a worker thread (not Main Thread)
@@ -3797,7 +3797,7 @@ NAN_METHOD(Adapter::GapReplyDHKeyLESC)
     baton->dhkey = dhkey;
     free(key);
 
-    uv_queue_work(uv_default_loop(), baton->req, GapReplyDHKeyLESC, reinterpret_cast<uv_after_work_cb>(AfterGapReplyDHKeyLESC));
+    queueCommand<GapReplyDHKeyLESC, AfterGapReplyDHKeyLESC>(baton, "gapReplyDHKeyLESC");
 }
 
 // This runs in a worker thread (not Main Thread)
@@ -3863,7 +3863,7 @@ NAN_METHOD(Adapter::GapNotifyKeypress)
     baton->conn_handle = conn_handle;
     baton->kp_not = kp_not;
 
-    uv_queue_work(uv_default_loop(), baton->req, GapNotifyKeypress, reinterpret_cast<uv_after_work_cb>(AfterGapNotifyKeypress));
+    queueCommand<GapNotifyKeypress, AfterGapNotifyKeypress>(baton, "gapNotifyKeypress");
 }
 
 // This runs in a worker thread (not Main Thread)
@@ -3934,7 +3934,7 @@ NAN_METHOD(Adapter::GapGetLESCOOBData)
     baton->p_pk_own = p_pk_own;
     baton->p_oobd_own = new ble_gap_lesc_oob_data_t();
 
-    uv_queue_work(uv_default_loop(), baton->req, GapGetLESCOOBData, reinterpret_cast<uv_after_work_cb>(AfterGapGetLESCOOBData));
+    queueCommand<GapGetLESCOOBData, AfterGapGetLESCOOBData>(baton, "gapGetLESCOOBData");
 }
 
 // This runs in a worker thread (not Main Thread)
@@ -4027,7 +4027,7 @@ NAN_METHOD(Adapter::GapSetLESCOOBData)
         return;
     }
 
-    uv_queue_work(uv_default_loop(), baton->req, GapSetLESCOOBData, reinterpret_cast<uv_after_work_cb>(AfterGapSetLESCOOBData));
+    queueCommand<GapSetLESCOOBData, AfterGapSetLESCOOBData>(baton, "gapSetLESCOOBData");
 }
 
 // This runs in a worker thread (not Main Thread)
@@ -4107,7 +4107,7 @@ NAN_METHOD(Adapter::GapDataLengthUpdate)
 
     baton->p_dl_limitation = new ble_gap_data_length_limitation_t();
 
-    uv_queue_work(uv_default_loop(), baton->req, GapDataLengthUpdate, reinterpret_cast<uv_after_work_cb>(AfterGapDataLengthUpdate));
+    queueCommand<GapDataLengthUpdate, AfterGapDataLengthUpdate>(baton, "gapDataLengthUpdate");
 }
 
 // This runs in a worker thread (not Main Thread)
@@ -4188,7 +4188,7 @@ NAN_METHOD(Adapter::GapPhyUpdate)
         return;
     }
 
-    uv_queue_work(uv_default_loop(), baton->req, GapPhyUpdate, reinterpret_cast<uv_after_work_cb>(AfterGapPhyUpdate));
+    queueCommand<GapPhyUpdate, AfterGapPhyUpdate>(baton, "gapPhyUpdate");
 }
 
 // This runs in a worker thread (not Main Thread)
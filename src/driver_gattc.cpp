@@ -454,7 +454,9 @@ NAN_METHOD(Adapter::GattcDiscoverPrimaryServices)
         return;
     }
 
-    uv_queue_work(uv_default_loop(), baton->req, GattcDiscoverPrimaryServices, reinterpret_cast<uv_after_work_cb>(AfterGattcDiscoverPrimaryServices));
+    obj->gattClient.beginRequest(conn_handle);
+
+    queueCommand<GattcDiscoverPrimaryServices, AfterGattcDiscoverPrimaryServices>(baton, "gattcDiscoverPrimaryServices");
 }
 
 // This runs in a worker thread (not Main Thread)
@@ -475,6 +477,7 @@ void Adapter::AfterGattcDiscoverPrimaryServices(uv_work_t *req)
     if (baton->result != NRF_SUCCESS)
     {
         argv[0] = ErrorMessage::getErrorMessage(baton->result, "starting service discovery");
+        cancelGattcRequest(baton->adapter, baton->conn_handle);
     }
     else
     {
@@ -528,7 +531,9 @@ NAN_METHOD(Adapter::GattcDiscoverRelationship)
         return;
     }
 
-    uv_queue_work(uv_default_loop(), baton->req, GattcDiscoverRelationship, reinterpret_cast<uv_after_work_cb>(AfterGattcDiscoverRelationship));
+    obj->gattClient.beginRequest(conn_handle);
+
+    queueCommand<GattcDiscoverRelationship, AfterGattcDiscoverRelationship>(baton, "gattcDiscoverRelationship");
 }
 
 // This runs in a worker thread (not Main Thread)
@@ -549,6 +554,7 @@ void Adapter::AfterGattcDiscoverRelationship(uv_work_t *req)
     if (baton->result != NRF_SUCCESS)
     {
         argv[0] = ErrorMessage::getErrorMessage(baton->result, "starting relationship discovery");
+        cancelGattcRequest(baton->adapter, baton->conn_handle);
     }
     else
     {
@@ -602,7 +608,9 @@ NAN_METHOD(Adapter::GattcDiscoverCharacteristics)
         return;
     }
 
-    uv_queue_work(uv_default_loop(), baton->req, GattcDiscoverCharacteristics, reinterpret_cast<uv_after_work_cb>(AfterGattcDiscoverCharacteristics));
+    obj->gattClient.beginRequest(conn_handle);
+
+    queueCommand<GattcDiscoverCharacteristics, AfterGattcDiscoverCharacteristics>(baton, "gattcDiscoverCharacteristics");
 }
 
 // This runs in a worker thread (not Main Thread)
@@ -623,6 +631,7 @@ void Adapter::AfterGattcDiscoverCharacteristics(uv_work_t *req)
     if (baton->result != NRF_SUCCESS)
     {
         argv[0] = ErrorMessage::getErrorMessage(baton->result, "starting characteristic discovery");
+        cancelGattcRequest(baton->adapter, baton->conn_handle);
     }
     else
     {
@@ -676,7 +685,9 @@ NAN_METHOD(Adapter::GattcDiscoverDescriptors)
         return;
     }
 
-    uv_queue_work(uv_default_loop(), baton->req, GattcDiscoverDescriptors, reinterpret_cast<uv_after_work_cb>(AfterGattcDiscoverDescriptors));
+    obj->gattClient.beginRequest(conn_handle);
+
+    queueCommand<GattcDiscoverDescriptors, AfterGattcDiscoverDescriptors>(baton, "gattcDiscoverDescriptors");
 }
 
 // This runs in a worker thread (not Main Thread)
@@ -697,6 +708,7 @@ void Adapter::AfterGattcDiscoverDescriptors(uv_work_t *req)
     if (baton->result != NRF_SUCCESS)
     {
         argv[0] = ErrorMessage::getErrorMessage(baton->result, "starting descriptor discovery");
+        cancelGattcRequest(baton->adapter, baton->conn_handle);
     }
     else
     {
@@ -765,7 +777,9 @@ NAN_METHOD(Adapter::GattcReadCharacteristicValueByUUID)
         return;
     }
 
-    uv_queue_work(uv_default_loop(), baton->req, GattcReadCharacteristicValueByUUID, reinterpret_cast<uv_after_work_cb>(AfterGattcReadCharacteristicValueByUUID));
+    obj->gattClient.beginRequest(conn_handle);
+
+    queueCommand<GattcReadCharacteristicValueByUUID, AfterGattcReadCharacteristicValueByUUID>(baton, "gattcReadCharacteristicValueByUUID");
 }
 
 // This runs in a worker thread (not Main Thread)
@@ -786,6 +800,7 @@ void Adapter::AfterGattcReadCharacteristicValueByUUID(uv_work_t *req)
     if (baton->result != NRF_SUCCESS)
     {
         argv[0] = ErrorMessage::getErrorMessage(baton->result, "starting reading characteristics by UUID");
+        cancelGattcRequest(baton->adapter, baton->conn_handle);
     }
     else
     {
@@ -834,7 +849,9 @@ NAN_METHOD(Adapter::GattcRead)
     baton->handle = handle;
     baton->offset = offset;
 
-    uv_queue_work(uv_default_loop(), baton->req, GattcRead, reinterpret_cast<uv_after_work_cb>(AfterGattcRead));
+    obj->gattClient.beginRequest(conn_handle);
+
+    queueCommand<GattcRead, AfterGattcRead>(baton, "gattcRead");
 }
 
 // This runs in a worker thread (not Main Thread)
@@ -855,6 +872,7 @@ void Adapter::AfterGattcRead(uv_work_t *req)
     if (baton->result != NRF_SUCCESS)
     {
         argv[0] = ErrorMessage::getErrorMessage(baton->result, "starting reading");
+        cancelGattcRequest(baton->adapter, baton->conn_handle);
     }
     else
     {
@@ -918,7 +936,9 @@ NAN_METHOD(Adapter::GattcReadCharacteristicValues)
     baton->p_handles = p_handles;
     baton->handle_count = handle_count;
 
-    uv_queue_work(uv_default_loop(), baton->req, GattcReadCharacteristicValues, reinterpret_cast<uv_after_work_cb>(AfterGattcReadCharacteristicValues));
+    obj->gattClient.beginRequest(conn_handle);
+
+    queueCommand<GattcReadCharacteristicValues, AfterGattcReadCharacteristicValues>(baton, "gattcReadCharacteristicValues");
 }
 
 // This runs in a worker thread (not Main Thread)
@@ -939,6 +959,7 @@ void Adapter::AfterGattcReadCharacteristicValues(uv_work_t *req)
     if (baton->result != NRF_SUCCESS)
     {
         argv[0] = ErrorMessage::getErrorMessage(baton->result, "starting reading characteristics values");
+        cancelGattcRequest(baton->adapter, baton->conn_handle);
     }
     else
     {
@@ -992,7 +1013,12 @@ NAN_METHOD(Adapter::GattcWrite)
         return;
     }
 
-    uv_queue_work(uv_default_loop(), baton->req, GattcWrite, reinterpret_cast<uv_after_work_cb>(AfterGattcWrite));
+    if (baton->p_write_params->write_op != BLE_GATT_OP_WRITE_CMD)
+    {
+        obj->gattClient.beginRequest(conn_handle);
+    }
+
+    queueCommand<GattcWrite, AfterGattcWrite>(baton, "gattcWrite");
 }
 
 // This runs in a worker thread (not Main Thread)
@@ -1000,6 +1026,13 @@ void Adapter::GattcWrite(uv_work_t *req)
 {
     auto baton = static_cast<GattcWriteBaton *>(req->data);
     baton->result = sd_ble_gattc_write(baton->adapter, baton->conn_handle, baton->p_write_params);
+
+    auto jsAdapter = baton->owner;
+
+    if (baton->result == NRF_SUCCESS && jsAdapter != nullptr)
+    {
+        jsAdapter->getMetrics().countBytesWritten(baton->conn_handle, baton->p_write_params->len);
+    }
 }
 
 // This runs in Main Thread
@@ -1013,6 +1046,11 @@ void Adapter::AfterGattcWrite(uv_work_t *req)
     if (baton->result != NRF_SUCCESS)
     {
         argv[0] = ErrorMessage::getErrorMessage(baton->result, "writing");
+
+        if (baton->p_write_params->write_op != BLE_GATT_OP_WRITE_CMD)
+        {
+            cancelGattcRequest(baton->adapter, baton->conn_handle);
+        }
     }
     else
     {
@@ -1055,7 +1093,7 @@ NAN_METHOD(Adapter::GattcConfirmHandleValue)
     baton->conn_handle = conn_handle;
     baton->handle = handle;
 
-    uv_queue_work(uv_default_loop(), baton->req, GattcConfirmHandleValue, reinterpret_cast<uv_after_work_cb>(AfterGattcConfirmHandleValue));
+    queueCommand<GattcConfirmHandleValue, AfterGattcConfirmHandleValue>(baton, "gattcConfirmHandleValue");
 }
 
 // This runs in a worker thread (not Main Thread)
@@ -1119,7 +1157,9 @@ NAN_METHOD(Adapter::GattcExchangeMtuRequest)
     baton->conn_handle = conn_handle;
     baton->client_rx_mtu = client_rx_mtu;
 
-    uv_queue_work(uv_default_loop(), baton->req, GattcExchangeMtuRequest, reinterpret_cast<uv_after_work_cb>(AfterGattcExchangeMtuRequest));
+    obj->gattClient.beginRequest(conn_handle);
+
+    queueCommand<GattcExchangeMtuRequest, AfterGattcExchangeMtuRequest>(baton, "gattcExchangeMtuRequest");
 }
 
 // This runs in a worker thread (not Main Thread)
@@ -1140,6 +1180,7 @@ void Adapter::AfterGattcExchangeMtuRequest(uv_work_t *req)
     if (baton->result != NRF_SUCCESS)
     {
         argv[0] = ErrorMessage::getErrorMessage(baton->result, "requesting MTU exchange");
+        cancelGattcRequest(baton->adapter, baton->conn_handle);
     }
     else
     {
@@ -1152,6 +1193,746 @@ void Adapter::AfterGattcExchangeMtuRequest(uv_work_t *req)
 }
 #endif
 
+NAN_METHOD(Adapter::GattcDiscoverAll)
+{
+    uint16_t conn_handle;
+    v8::Local<v8::Function> callback;
+    auto argumentcount = 0;
+
+    try
+    {
+        conn_handle = ConversionUtility::getNativeUint16(info[argumentcount]);
+        argumentcount++;
+
+        callback = ConversionUtility::getCallbackFunction(info[argumentcount]);
+        argumentcount++;
+    }
+    catch (std::string error)
+    {
+        v8::Local<v8::String> message = ErrorMessage::getTypeErrorMessage(argumentcount, error);
+        Nan::ThrowTypeError(message);
+        return;
+    }
+
+    auto obj = Nan::ObjectWrap::Unwrap<Adapter>(info.Holder());
+    auto baton = new GattcDiscoverAllBaton(callback);
+    baton->adapter = obj->adapter;
+    baton->conn_handle = conn_handle;
+    baton->gattClient = &obj->gattClient;
+    baton->discoveryCallback = std::make_shared<Nan::Callback>(callback);
+
+    queueCommand<GattcDiscoverAll, AfterGattcDiscoverAll>(baton, "gattcDiscoverAll");
+}
+
+// This runs in a worker thread (not Main Thread)
+void Adapter::GattcDiscoverAll(uv_work_t *req)
+{
+    auto baton = static_cast<GattcDiscoverAllBaton *>(req->data);
+    baton->result = baton->gattClient->discoverAll(baton->adapter, baton->conn_handle, baton->discoveryCallback);
+}
+
+// This runs in Main Thread
+void Adapter::AfterGattcDiscoverAll(uv_work_t *req)
+{
+    Nan::HandleScope scope;
+
+    auto baton = static_cast<GattcDiscoverAllBaton *>(req->data);
+
+    // When started the callback is called by the GattClient once the discovery is done
+    if (baton->result != NRF_SUCCESS)
+    {
+        v8::Local<v8::Value> argv[1];
+        argv[0] = ErrorMessage::getErrorMessage(baton->result, "starting GATT database discovery");
+
+        Nan::AsyncResource resource("pc-ble-driver-js:callback");
+        baton->callback->Call(1, argv, &resource);
+    }
+
+    delete baton;
+}
+
+NAN_METHOD(Adapter::GattcQueueRead)
+{
+    uint16_t conn_handle;
+    uint16_t handle;
+    uint16_t offset;
+    v8::Local<v8::Function> callback;
+    auto argumentcount = 0;
+
+    try
+    {
+        conn_handle = ConversionUtility::getNativeUint16(info[argumentcount]);
+        argumentcount++;
+
+        handle = ConversionUtility::getNativeUint16(info[argumentcount]);
+        argumentcount++;
+
+        offset = ConversionUtility::getNativeUint16(info[argumentcount]);
+        argumentcount++;
+
+        callback = ConversionUtility::getCallbackFunction(info[argumentcount]);
+        argumentcount++;
+    }
+    catch (std::string error)
+    {
+        v8::Local<v8::String> message = ErrorMessage::getTypeErrorMessage(argumentcount, error);
+        Nan::ThrowTypeError(message);
+        return;
+    }
+
+    auto obj = Nan::ObjectWrap::Unwrap<Adapter>(info.Holder());
+    auto baton = new GattcQueueOperationBaton(callback);
+    baton->adapter = obj->adapter;
+    baton->conn_handle = conn_handle;
+    baton->gattClient = &obj->gattClient;
+    baton->operation = std::make_unique<GattOperation>(GattOperation::Type::Read, std::make_shared<Nan::Callback>(callback));
+    baton->operation->handle = handle;
+    baton->operation->offset = offset;
+
+    queueCommand<GattcQueueRead, AfterGattcQueueRead>(baton, "gattcQueueRead");
+}
+
+// This runs in a worker thread (not Main Thread)
+void Adapter::GattcQueueRead(uv_work_t *req)
+{
+    auto baton = static_cast<GattcQueueOperationBaton *>(req->data);
+    baton->gattClient->queueOperation(baton->adapter, baton->conn_handle, std::move(*baton->operation));
+    baton->result = NRF_SUCCESS;
+}
+
+// This runs in Main Thread
+void Adapter::AfterGattcQueueRead(uv_work_t *req)
+{
+    // The callback is called by the GattClient once the read is done
+    delete static_cast<GattcQueueOperationBaton *>(req->data);
+}
+
+NAN_METHOD(Adapter::GattcQueueWrite)
+{
+    uint16_t conn_handle;
+    v8::Local<v8::Object> p_write_params;
+    v8::Local<v8::Function> callback;
+    auto argumentcount = 0;
+
+    try
+    {
+        conn_handle = ConversionUtility::getNativeUint16(info[argumentcount]);
+        argumentcount++;
+
+        p_write_params = ConversionUtility::getJsObject(info[argumentcount]);
+        argumentcount++;
+
+        callback = ConversionUtility::getCallbackFunction(info[argumentcount]);
+        argumentcount++;
+    }
+    catch (std::string error)
+    {
+        v8::Local<v8::String> message = ErrorMessage::getTypeErrorMessage(argumentcount, error);
+        Nan::ThrowTypeError(message);
+        return;
+    }
+
+    std::unique_ptr<ble_gattc_write_params_t> write_params;
+
+    try
+    {
+        write_params.reset(GattcWriteParameters(p_write_params).ToNative());
+    }
+    catch (std::string error)
+    {
+        v8::Local<v8::String> message = ErrorMessage::getStructErrorMessage("write_params", error);
+        Nan::ThrowTypeError(message);
+        return;
+    }
+
+    auto obj = Nan::ObjectWrap::Unwrap<Adapter>(info.Holder());
+    auto baton = new GattcQueueOperationBaton(callback);
+    baton->adapter = obj->adapter;
+    baton->conn_handle = conn_handle;
+    baton->gattClient = &obj->gattClient;
+    baton->operation = std::make_unique<GattOperation>(GattOperation::Type::Write, std::make_shared<Nan::Callback>(callback));
+    baton->operation->handle = write_params->handle;
+    baton->operation->offset = write_params->offset;
+    baton->operation->writeOp = write_params->write_op;
+    baton->operation->flags = write_params->flags;
+    baton->operation->value.assign(write_params->p_value, write_params->p_value + write_params->len);
+
+    free((char*)(write_params->p_value));
+
+    queueCommand<GattcQueueWrite, AfterGattcQueueWrite>(baton, "gattcQueueWrite");
+}
+
+// This runs in a worker thread (not Main Thread)
+void Adapter::GattcQueueWrite(uv_work_t *req)
+{
+    auto baton = static_cast<GattcQueueOperationBaton *>(req->data);
+    baton->gattClient->queueOperation(baton->adapter, baton->conn_handle, std::move(*baton->operation));
+    baton->result = NRF_SUCCESS;
+}
+
+// This runs in Main Thread
+void Adapter::AfterGattcQueueWrite(uv_work_t *req)
+{
+    // The callback is called by the GattClient once the write is done
+    delete static_cast<GattcQueueOperationBaton *>(req->data);
+}
+
+NAN_METHOD(Adapter::GattcQueueLongRead)
+{
+    uint16_t conn_handle;
+    uint16_t handle;
+    uint16_t chunk_size;
+    v8::Local<v8::Function> callback;
+    auto argumentcount = 0;
+
+    try
+    {
+        conn_handle = ConversionUtility::getNativeUint16(info[argumentcount]);
+        argumentcount++;
+
+        handle = ConversionUtility::getNativeUint16(info[argumentcount]);
+        argumentcount++;
+
+        chunk_size = ConversionUtility::getNativeUint16(info[argumentcount]);
+
+        if (chunk_size == 0)
+        {
+            throw std::string("chunk size larger than 0");
+        }
+
+        argumentcount++;
+
+        callback = ConversionUtility::getCallbackFunction(info[argumentcount]);
+        argumentcount++;
+    }
+    catch (std::string error)
+    {
+        v8::Local<v8::String> message = ErrorMessage::getTypeErrorMessage(argumentcount, error);
+        Nan::ThrowTypeError(message);
+        return;
+    }
+
+    auto obj = Nan::ObjectWrap::Unwrap<Adapter>(info.Holder());
+    auto baton = new GattcQueueOperationBaton(callback);
+    baton->adapter = obj->adapter;
+    baton->conn_handle = conn_handle;
+    baton->gattClient = &obj->gattClient;
+    baton->operation = std::make_unique<GattOperation>(GattOperation::Type::LongRead, std::make_shared<Nan::Callback>(callback));
+    baton->operation->handle = handle;
+    baton->operation->chunkSize = chunk_size;
+
+    queueCommand<GattcQueueLongRead, AfterGattcQueueLongRead>(baton, "gattcQueueLongRead");
+}
+
+// This runs in a worker thread (not Main Thread)
+void Adapter::GattcQueueLongRead(uv_work_t *req)
+{
+    auto baton = static_cast<GattcQueueOperationBaton *>(req->data);
+    baton->gattClient->queueOperation(baton->adapter, baton->conn_handle, std::move(*baton->operation));
+    baton->result = NRF_SUCCESS;
+}
+
+// This runs in Main Thread
+void Adapter::AfterGattcQueueLongRead(uv_work_t *req)
+{
+    // The callback is called by the GattClient once the whole value is read
+    delete static_cast<GattcQueueOperationBaton *>(req->data);
+}
+
+NAN_METHOD(Adapter::GattcQueueLongWrite)
+{
+    uint16_t conn_handle;
+    uint16_t handle;
+    std::vector<uint8_t> value;
+    uint16_t chunk_size;
+    v8::Local<v8::Function> callback;
+    auto argumentcount = 0;
+
+    try
+    {
+        conn_handle = ConversionUtility::getNativeUint16(info[argumentcount]);
+        argumentcount++;
+
+        handle = ConversionUtility::getNativeUint16(info[argumentcount]);
+        argumentcount++;
+
+        value = ConversionUtility::getNativeBytes(info[argumentcount]);
+        argumentcount++;
+
+        chunk_size = ConversionUtility::getNativeUint16(info[argumentcount]);
+
+        if (chunk_size == 0)
+        {
+            throw std::string("chunk size larger than 0");
+        }
+
+        argumentcount++;
+
+        callback = ConversionUtility::getCallbackFunction(info[argumentcount]);
+        argumentcount++;
+    }
+    catch (std::string error)
+    {
+        v8::Local<v8::String> message = ErrorMessage::getTypeErrorMessage(argumentcount, error);
+        Nan::ThrowTypeError(message);
+        return;
+    }
+
+    auto obj = Nan::ObjectWrap::Unwrap<Adapter>(info.Holder());
+    auto baton = new GattcQueueOperationBaton(callback);
+    baton->adapter = obj->adapter;
+    baton->conn_handle = conn_handle;
+    baton->gattClient = &obj->gattClient;
+    baton->operation = std::make_unique<GattOperation>(GattOperation::Type::LongWrite, std::make_shared<Nan::Callback>(callback));
+    baton->operation->handle = handle;
+    baton->operation->writeOp = BLE_GATT_OP_PREP_WRITE_REQ;
+    baton->operation->flags = BLE_GATT_EXEC_WRITE_FLAG_PREPARED_WRITE;
+    baton->operation->value = std::move(value);
+    baton->operation->chunkSize = chunk_size;
+
+    queueCommand<GattcQueueLongWrite, AfterGattcQueueLongWrite>(baton, "gattcQueueLongWrite");
+}
+
+// This runs in a worker thread (not Main Thread)
+void Adapter::GattcQueueLongWrite(uv_work_t *req)
+{
+    auto baton = static_cast<GattcQueueOperationBaton *>(req->data);
+    baton->gattClient->queueOperation(baton->adapter, baton->conn_handle, std::move(*baton->operation));
+    baton->result = NRF_SUCCESS;
+}
+
+// This runs in Main Thread
+void Adapter::AfterGattcQueueLongWrite(uv_work_t *req)
+{
+    // The callback is called by the GattClient once the value is executed or cancelled
+    delete static_cast<GattcQueueOperationBaton *>(req->data);
+}
+
+NAN_METHOD(Adapter::GattcQueueReadMany)
+{
+    uint16_t conn_handle;
+    std::vector<GattReadManyAttribute> attributes;
+    uint16_t chunk_size;
+    v8::Local<v8::Function> callback;
+    auto argumentcount = 0;
+
+    try
+    {
+        conn_handle = ConversionUtility::getNativeUint16(info[argumentcount]);
+        argumentcount++;
+
+        if (!info[argumentcount]->IsArray())
+        {
+            throw std::string("array");
+        }
+
+        auto jsAttributes = v8::Local<v8::Array>::Cast(info[argumentcount]);
+
+        if (jsAttributes->Length() == 0)
+        {
+            throw std::string("array with at least one attribute");
+        }
+
+        // Attributes of unknown length go last, so that the ones of known
+        // length can be grouped into as few requests as possible
+        std::vector<GattReadManyAttribute> unknownLength;
+
+        for (uint32_t i = 0; i < jsAttributes->Length(); i++)
+        {
+            auto jsAttribute = Utility::Get(jsAttributes, i);
+
+            if (jsAttribute->IsNumber())
+            {
+                unknownLength.emplace_back(ConversionUtility::getNativeUint16(jsAttribute), 0);
+                continue;
+            }
+
+            auto jsObject = ConversionUtility::getJsObject(jsAttribute);
+            auto handle = ConversionUtility::getNativeUint16(jsObject, "handle");
+            uint16_t length = 0;
+
+            if (Utility::Has(jsObject, "length"))
+            {
+                length = ConversionUtility::getNativeUint16(jsObject, "length");
+            }
+
+            if (length == 0)
+            {
+                unknownLength.emplace_back(handle, 0);
+            }
+            else
+            {
+                attributes.emplace_back(handle, length);
+            }
+        }
+
+        attributes.insert(attributes.end(), unknownLength.begin(), unknownLength.end());
+        argumentcount++;
+
+        chunk_size = ConversionUtility::getNativeUint16(info[argumentcount]);
+
+        if (chunk_size == 0)
+        {
+            throw std::string("chunk size larger than 0");
+        }
+
+        argumentcount++;
+
+        callback = ConversionUtility::getCallbackFunction(info[argumentcount]);
+        argumentcount++;
+    }
+    catch (std::string error)
+    {
+        v8::Local<v8::String> message = ErrorMessage::getTypeErrorMessage(argumentcount, error);
+        Nan::ThrowTypeError(message);
+        return;
+    }
+
+    auto obj = Nan::ObjectWrap::Unwrap<Adapter>(info.Holder());
+    auto baton = new GattcQueueOperationBaton(callback);
+    baton->adapter = obj->adapter;
+    baton->conn_handle = conn_handle;
+    baton->gattClient = &obj->gattClient;
+    baton->operation = std::make_unique<GattOperation>(GattOperation::Type::ReadMany, std::make_shared<Nan::Callback>(callback));
+    baton->operation->attributes = std::move(attributes);
+    baton->operation->chunkSize = chunk_size;
+
+    queueCommand<GattcQueueReadMany, AfterGattcQueueReadMany>(baton, "gattcQueueReadMany");
+}
+
+// This runs in a worker thread (not Main Thread)
+void Adapter::GattcQueueReadMany(uv_work_t *req)
+{
+    auto baton = static_cast<GattcQueueOperationBaton *>(req->data);
+    baton->gattClient->queueOperation(baton->adapter, baton->conn_handle, std::move(*baton->operation));
+    baton->result = NRF_SUCCESS;
+}
+
+// This runs in Main Thread
+void Adapter::AfterGattcQueueReadMany(uv_work_t *req)
+{
+    // The callback is called by the GattClient once all the values are read
+    delete static_cast<GattcQueueOperationBaton *>(req->data);
+}
+
+NAN_METHOD(Adapter::GattcSubscribeMany)
+{
+    std::vector<std::pair<uint16_t, GattOperation>> operations;
+    v8::Local<v8::Function> callback;
+    auto argumentcount = 0;
+
+    try
+    {
+        if (!info[argumentcount]->IsArray())
+        {
+            throw std::string("array");
+        }
+
+        auto jsSubscriptions = v8::Local<v8::Array>::Cast(info[argumentcount]);
+
+        if (jsSubscriptions->Length() == 0)
+        {
+            throw std::string("array with at least one subscription");
+        }
+
+        argumentcount++;
+
+        callback = ConversionUtility::getCallbackFunction(info[argumentcount]);
+        argumentcount++;
+
+        auto group = std::make_shared<GattOperationGroup>(jsSubscriptions->Length(), std::make_shared<Nan::Callback>(callback));
+        argumentcount = 0;
+
+        for (uint32_t i = 0; i < jsSubscriptions->Length(); i++)
+        {
+            auto jsSubscription = ConversionUtility::getJsObject(Utility::Get(jsSubscriptions, i));
+            auto conn_handle = ConversionUtility::getNativeUint16(jsSubscription, "conn_handle");
+            auto mode = ConversionUtility::getNativeUint8(jsSubscription, "mode");
+
+            if (mode > (BLE_GATT_HVX_NOTIFICATION | BLE_GATT_HVX_INDICATION))
+            {
+                throw std::string("mode with notification and indication bits only");
+            }
+
+            GattOperation operation(GattOperation::Type::Write, nullptr);
+            operation.handle = ConversionUtility::getNativeUint16(jsSubscription, "cccd_handle");
+            operation.writeOp = BLE_GATT_OP_WRITE_REQ;
+            operation.value = { mode, 0 };
+            operation.group = group;
+            operation.groupIndex = i;
+
+            operations.emplace_back(conn_handle, std::move(operation));
+        }
+    }
+    catch (std::string error)
+    {
+        v8::Local<v8::String> message = ErrorMessage::getTypeErrorMessage(argumentcount, error);
+        Nan::ThrowTypeError(message);
+        return;
+    }
+
+    auto obj = Nan::ObjectWrap::Unwrap<Adapter>(info.Holder());
+    auto baton = new GattcSubscribeManyBaton(callback);
+    baton->adapter = obj->adapter;
+    baton->gattClient = &obj->gattClient;
+    baton->operations = std::move(operations);
+
+    queueCommand<GattcSubscribeMany, AfterGattcSubscribeMany>(baton, "gattcSubscribeMany");
+}
+
+// This runs in a worker thread (not Main Thread)
+void Adapter::GattcSubscribeMany(uv_work_t *req)
+{
+    auto baton = static_cast<GattcSubscribeManyBaton *>(req->data);
+
+    // Each connection has its own queue, so the writes to different peers are in flight at the same time
+    for (auto &operation : baton->operations)
+    {
+        baton->gattClient->queueOperation(baton->adapter, operation.first, std::move(operation.second));
+    }
+
+    baton->result = NRF_SUCCESS;
+}
+
+// This runs in Main Thread
+void Adapter::AfterGattcSubscribeMany(uv_work_t *req)
+{
+    // The callback is called by the GattClient once all the CCCDs are written
+    delete static_cast<GattcSubscribeManyBaton *>(req->data);
+}
+
+NAN_METHOD(Adapter::GattcWriteStream)
+{
+    uint16_t conn_handle;
+    uint16_t handle;
+    std::vector<uint8_t> data;
+    uint16_t chunk_size;
+    v8::Local<v8::Function> progress;
+    v8::Local<v8::Function> callback;
+    auto argumentcount = 0;
+
+    try
+    {
+        conn_handle = ConversionUtility::getNativeUint16(info[argumentcount]);
+        argumentcount++;
+
+        handle = ConversionUtility::getNativeUint16(info[argumentcount]);
+        argumentcount++;
+
+        data = ConversionUtility::getNativeBytes(info[argumentcount]);
+        argumentcount++;
+
+        chunk_size = ConversionUtility::getNativeUint16(info[argumentcount]);
+
+        if (chunk_size == 0)
+        {
+            throw std::string("chunk size larger than 0");
+        }
+
+        argumentcount++;
+
+        progress = ConversionUtility::getCallbackFunction(info[argumentcount]);
+        argumentcount++;
+
+        callback = ConversionUtility::getCallbackFunction(info[argumentcount]);
+        argumentcount++;
+    }
+    catch (std::string error)
+    {
+        v8::Local<v8::String> message = ErrorMessage::getTypeErrorMessage(argumentcount, error);
+        Nan::ThrowTypeError(message);
+        return;
+    }
+
+    auto obj = Nan::ObjectWrap::Unwrap<Adapter>(info.Holder());
+    auto baton = new GattcQueueOperationBaton(callback);
+    baton->adapter = obj->adapter;
+    baton->conn_handle = conn_handle;
+    baton->gattClient = &obj->gattClient;
+    baton->operation = std::make_unique<GattOperation>(GattOperation::Type::WriteStream, std::make_shared<Nan::Callback>(callback));
+    baton->operation->handle = handle;
+    baton->operation->writeOp = BLE_GATT_OP_WRITE_CMD;
+    baton->operation->value = std::move(data);
+    baton->operation->chunkSize = chunk_size;
+    baton->operation->progressCallback = std::make_shared<Nan::Callback>(progress);
+
+    queueCommand<GattcWriteStream, AfterGattcWriteStream>(baton, "gattcWriteStream");
+}
+
+// This runs in a worker thread (not Main Thread)
+void Adapter::GattcWriteStream(uv_work_t *req)
+{
+    auto baton = static_cast<GattcQueueOperationBaton *>(req->data);
+    baton->gattClient->queueOperation(baton->adapter, baton->conn_handle, std::move(*baton->operation));
+    baton->result = NRF_SUCCESS;
+}
+
+// This runs in Main Thread
+void Adapter::AfterGattcWriteStream(uv_work_t *req)
+{
+    // The callback is called by the GattClient once all data is written
+    delete static_cast<GattcQueueOperationBaton *>(req->data);
+}
+
+// This runs in Main Thread
+void Adapter::cancelGattcRequest(adapter_t *adapter, uint16_t connHandle)
+{
+    auto jsAdapter = getAdapter(adapter);
+
+    if (jsAdapter != nullptr)
+    {
+        jsAdapter->gattClient.endRequest(connHandle);
+        jsAdapter->gattClient.resume(adapter);
+    }
+}
+
+NAN_METHOD(Adapter::GattcIndexAttributes)
+{
+    uint16_t conn_handle;
+    std::vector<std::pair<uint16_t, std::string>> attributes;
+    auto argumentcount = 0;
+
+    try
+    {
+        conn_handle = ConversionUtility::getNativeUint16(info[argumentcount]);
+        argumentcount++;
+
+        if (!info[argumentcount]->IsArray())
+        {
+            throw std::string("array");
+        }
+
+        auto jsAttributes = v8::Local<v8::Array>::Cast(info[argumentcount]);
+
+        for (uint32_t i = 0; i < jsAttributes->Length(); i++)
+        {
+            auto jsAttribute = ConversionUtility::getJsObject(Utility::Get(jsAttributes, i));
+            attributes.emplace_back(
+                ConversionUtility::getNativeUint16(jsAttribute, "handle"),
+                ConversionUtility::getNativeString(jsAttribute, "instanceId"));
+        }
+
+        argumentcount++;
+    }
+    catch (std::string error)
+    {
+        v8::Local<v8::String> message = ErrorMessage::getTypeErrorMessage(argumentcount, error);
+        Nan::ThrowTypeError(message);
+        return;
+    }
+
+    auto obj = Nan::ObjectWrap::Unwrap<Adapter>(info.Holder());
+    obj->gattClient.indexAttributes(conn_handle, attributes);
+}
+
+NAN_METHOD(Adapter::GattcStartNotificationBuffer)
+{
+    uint16_t conn_handle;
+    uint16_t handle;
+    uint32_t capacity;
+    auto argumentcount = 0;
+
+    try
+    {
+        conn_handle = ConversionUtility::getNativeUint16(info[argumentcount]);
+        argumentcount++;
+
+        handle = ConversionUtility::getNativeUint16(info[argumentcount]);
+        argumentcount++;
+
+        capacity = ConversionUtility::getNativeUint32(info[argumentcount]);
+
+        if (capacity == 0)
+        {
+            throw std::string("capacity larger than 0");
+        }
+
+        argumentcount++;
+    }
+    catch (std::string error)
+    {
+        v8::Local<v8::String> message = ErrorMessage::getTypeErrorMessage(argumentcount, error);
+        Nan::ThrowTypeError(message);
+        return;
+    }
+
+    auto obj = Nan::ObjectWrap::Unwrap<Adapter>(info.Holder());
+    obj->gattClient.startNotificationBuffer(conn_handle, handle, capacity);
+}
+
+NAN_METHOD(Adapter::GattcStopNotificationBuffer)
+{
+    uint16_t conn_handle;
+    uint16_t handle;
+    auto argumentcount = 0;
+
+    try
+    {
+        conn_handle = ConversionUtility::getNativeUint16(info[argumentcount]);
+        argumentcount++;
+
+        handle = ConversionUtility::getNativeUint16(info[argumentcount]);
+        argumentcount++;
+    }
+    catch (std::string error)
+    {
+        v8::Local<v8::String> message = ErrorMessage::getTypeErrorMessage(argumentcount, error);
+        Nan::ThrowTypeError(message);
+        return;
+    }
+
+    auto obj = Nan::ObjectWrap::Unwrap<Adapter>(info.Holder());
+    obj->gattClient.stopNotificationBuffer(conn_handle, handle);
+}
+
+NAN_METHOD(Adapter::GattcDrainNotificationBuffer)
+{
+    uint16_t conn_handle;
+    uint16_t handle;
+    auto argumentcount = 0;
+
+    try
+    {
+        conn_handle = ConversionUtility::getNativeUint16(info[argumentcount]);
+        argumentcount++;
+
+        handle = ConversionUtility::getNativeUint16(info[argumentcount]);
+        argumentcount++;
+    }
+    catch (std::string error)
+    {
+        v8::Local<v8::String> message = ErrorMessage::getTypeErrorMessage(argumentcount, error);
+        Nan::ThrowTypeError(message);
+        return;
+    }
+
+    auto obj = Nan::ObjectWrap::Unwrap<Adapter>(info.Holder());
+    NotificationBatch batch;
+
+    if (!obj->gattClient.drainNotificationBuffer(conn_handle, handle, batch))
+    {
+        info.GetReturnValue().Set(Nan::Null());
+        return;
+    }
+
+    auto offsets = Nan::New<v8::Array>(static_cast<uint32_t>(batch.offsets.size()));
+    auto timestamps = Nan::New<v8::Array>(static_cast<uint32_t>(batch.timestamps.size()));
+
+    for (uint32_t i = 0; i < batch.offsets.size(); i++)
+    {
+        Nan::Set(offsets, i, Nan::New<v8::Number>(batch.offsets[i]));
+        Nan::Set(timestamps, i, Nan::New<v8::Number>(batch.timestamps[i]));
+    }
+
+    auto jsBatch = Nan::New<v8::Object>();
+    Utility::Set(jsBatch, "data", Nan::CopyBuffer(reinterpret_cast<const char *>(batch.data.data()), static_cast<uint32_t>(batch.data.size())).ToLocalChecked());
+    Utility::Set(jsBatch, "offsets", offsets);
+    Utility::Set(jsBatch, "timestamps", timestamps);
+    Utility::Set(jsBatch, "dropped", batch.dropped);
+
+    info.GetReturnValue().Set(jsBatch);
+}
+
 extern "C" {
     void init_gattc(Nan::ADDON_REGISTER_FUNCTION_ARGS_TYPE target)
     {
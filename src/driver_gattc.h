@@ -37,8 +37,11 @@
 #ifndef DRIVER_GATTC_H
 #define DRIVER_GATTC_H
 
+#include <memory>
+
 #include "common.h"
 #include "ble_gattc.h"
+#include "gatt_client.h"
 
 extern name_map_t gatt_status_map;
 
@@ -363,6 +366,34 @@ public:
     uint16_t client_rx_mtu;
 };
 
+struct GattcDiscoverAllBaton : public Baton
+{
+public:
+    BATON_CONSTRUCTOR(GattcDiscoverAllBaton);
+    uint16_t conn_handle;
+    GattClient *gattClient;
+    // Called with the attribute table when the discovery is done
+    std::shared_ptr<Nan::Callback> discoveryCallback;
+};
+
+struct GattcQueueOperationBaton : public Baton
+{
+public:
+    BATON_CONSTRUCTOR(GattcQueueOperationBaton);
+    uint16_t conn_handle;
+    GattClient *gattClient;
+    std::unique_ptr<GattOperation> operation;
+};
+
+struct GattcSubscribeManyBaton : public Baton
+{
+public:
+    BATON_CONSTRUCTOR(GattcSubscribeManyBaton);
+    GattClient *gattClient;
+    // CCCD writes by connection handle
+    std::vector<std::pair<uint16_t, GattOperation>> operations;
+};
+
 ///// End GATTC Batons //////////////////////////////////////////////////////////////////////////////////
 
 extern "C" {
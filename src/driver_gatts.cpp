@@ -41,7 +41,10 @@
 #include "driver_gap.h"
 #include "driver_gatt.h"
 
+#include <algorithm>
+#include <cstring>
 #include <iostream>
+#include <sstream>
 
 static name_map_t gatts_op_map =
 {
@@ -53,6 +56,144 @@ static name_map_t gatts_op_map =
     NAME_MAP_ENTRY(BLE_GATTS_OP_EXEC_WRITE_REQ_NOW)
 };
 
+// This compilation unit will be linked several times. So the helpers must
+// not have external linkage.
+namespace {
+    // UUIDs of gattsBuildTable are strings of 4 or 32 hex digits
+    std::vector<uint8_t> getTableUuid(v8::Local<v8::Object> js)
+    {
+        auto jsUuid = Utility::Get(js, "uuid");
+
+        if (!jsUuid->IsString())
+        {
+            throw std::string("uuid of 4 or 32 hex digits");
+        }
+
+        auto uuid = ConversionUtility::extractHex(jsUuid);
+
+        if (uuid.size() != 2 && uuid.size() != 16)
+        {
+            throw std::string("uuid of 4 or 32 hex digits");
+        }
+
+        return uuid;
+    }
+
+    void getTableAttribute(v8::Local<v8::Object> js, GattsTableAttribute &attribute)
+    {
+        attribute.uuid_le = getTableUuid(js);
+        attribute.attr_md.reset(GattsAttributeMetadata(ConversionUtility::getJsObject(js, "attr_md")).ToNative());
+        attribute.init_len = ConversionUtility::getNativeUint16(js, "init_len");
+        attribute.init_offs = ConversionUtility::getNativeUint16(js, "init_offs");
+        attribute.max_len = ConversionUtility::getNativeUint16(js, "max_len");
+        attribute.value = ConversionUtility::getNativeBytes(Utility::Get(js, "value"));
+    }
+
+    // Same as decodeUUID in JavaScript. If the base of a 128-bit UUID is not
+    // known to the SoftDevice, it is registered first.
+    uint32_t resolveTableUuid(adapter_t *adapter, const std::vector<uint8_t> &uuidLe, ble_uuid_t &uuid, std::vector<std::pair<ble_uuid128_t, uint8_t>> &vendorUuids)
+    {
+        if (uuidLe.size() == 2)
+        {
+            uuid.type = BLE_UUID_TYPE_BLE;
+            uuid.uuid = static_cast<uint16_t>(uuidLe[0] | (uuidLe[1] << 8));
+            return NRF_SUCCESS;
+        }
+
+        auto result = sd_ble_uuid_decode(adapter, 16, uuidLe.data(), &uuid);
+
+        if (result != NRF_ERROR_NOT_FOUND)
+        {
+            return result;
+        }
+
+        // Bytes 12 and 13 are the 16-bit UUID on top of the base
+        ble_uuid128_t base;
+        std::copy(uuidLe.begin(), uuidLe.end(), base.uuid128);
+        base.uuid128[12] = 0;
+        base.uuid128[13] = 0;
+
+        uint8_t type;
+        result = sd_ble_uuid_vs_add(adapter, &base, &type);
+
+        if (result != NRF_SUCCESS)
+        {
+            return result;
+        }
+
+        vendorUuids.emplace_back(base, type);
+
+        return sd_ble_uuid_decode(adapter, 16, uuidLe.data(), &uuid);
+    }
+
+    // All of the table in one go, instead of one round trip through Main Thread for each attribute
+    uint32_t buildTable(adapter_t *adapter, std::vector<GattsTableService> &services, std::vector<std::pair<ble_uuid128_t, uint8_t>> &vendorUuids)
+    {
+        for (auto &service : services)
+        {
+            auto result = resolveTableUuid(adapter, service.uuid_le, service.uuid, vendorUuids);
+
+            if (result == NRF_SUCCESS)
+            {
+                result = sd_ble_gatts_service_add(adapter, service.type, &service.uuid, &service.handle);
+            }
+
+            if (result != NRF_SUCCESS)
+            {
+                return result;
+            }
+
+            for (auto &characteristic : service.characteristics)
+            {
+                result = resolveTableUuid(adapter, characteristic->value.uuid_le, characteristic->value.uuid, vendorUuids);
+
+                if (result == NRF_SUCCESS)
+                {
+                    auto attribute = characteristic->value.toNative();
+                    result = sd_ble_gatts_characteristic_add(adapter, service.handle, characteristic->p_char_md, &attribute, &characteristic->handles);
+                }
+
+                if (result != NRF_SUCCESS)
+                {
+                    return result;
+                }
+
+                for (auto &descriptor : characteristic->descriptors)
+                {
+                    result = resolveTableUuid(adapter, descriptor.uuid_le, descriptor.uuid, vendorUuids);
+
+                    if (result == NRF_SUCCESS)
+                    {
+                        auto attribute = descriptor.toNative();
+                        result = sd_ble_gatts_descriptor_add(adapter, characteristic->handles.value_handle, &attribute, &descriptor.handle);
+                    }
+
+                    if (result != NRF_SUCCESS)
+                    {
+                        return result;
+                    }
+                }
+            }
+        }
+
+        return NRF_SUCCESS;
+    }
+
+    // Big endian, as the UUIDs in JavaScript
+    std::string uuid128ToString(const ble_uuid128_t &uuid)
+    {
+        std::ostringstream stream;
+        stream << std::hex << std::uppercase;
+
+        for (auto i = 15; i >= 0; i--)
+        {
+            stream << ((uuid.uuid128[i] >> 4) & 0xF) << (uuid.uuid128[i] & 0xF);
+        }
+
+        return stream.str();
+    }
+}
+
 #if NRF_SD_BLE_API_VERSION == 2
 v8::Local<v8::Object> GattsEnableParameters::ToJs()
 {
@@ -439,7 +580,7 @@ NAN_METHOD(Adapter::GattsAddService)
         return;
     }
 
-    uv_queue_work(uv_default_loop(), baton->req, GattsAddService, reinterpret_cast<uv_after_work_cb>(AfterGattsAddService));
+    queueCommand<GattsAddService, AfterGattsAddService>(baton, "gattsAddService");
 }
 
 // This runs in a worker thread (not Main Thread)
@@ -529,7 +670,7 @@ NAN_METHOD(Adapter::GattsAddCharacteristic)
 
     baton->p_handles = new ble_gatts_char_handles_t();
 
-    uv_queue_work(uv_default_loop(), baton->req, GattsAddCharacteristic, reinterpret_cast<uv_after_work_cb>(AfterGattsAddCharacteristic));
+    queueCommand<GattsAddCharacteristic, AfterGattsAddCharacteristic>(baton, "gattsAddCharacteristic");
 }
 
 // This runs in a worker thread (not Main Thread)
@@ -537,6 +678,20 @@ void Adapter::GattsAddCharacteristic(uv_work_t *req)
 {
     auto baton = static_cast<GattsAddCharacteristicBaton *>(req->data);
     baton->result = sd_ble_gatts_characteristic_add(baton->adapter, baton->service_handle, baton->p_char_md, baton->p_attr_char_value, baton->p_handles);
+
+    auto jsAdapter = baton->owner;
+
+    if (baton->result != NRF_SUCCESS || jsAdapter == nullptr)
+    {
+        return;
+    }
+
+    jsAdapter->gattServer.addAttribute(baton->p_handles->value_handle, baton->p_attr_char_value->max_len);
+
+    if (baton->p_handles->cccd_handle != BLE_GATT_HANDLE_INVALID)
+    {
+        jsAdapter->gattServer.addCccd(baton->p_handles->cccd_handle, baton->p_handles->value_handle);
+    }
 }
 
 // This runs in Main Thread
@@ -604,7 +759,7 @@ NAN_METHOD(Adapter::GattsAddDescriptor)
         return;
     }
 
-    uv_queue_work(uv_default_loop(), baton->req, GattsAddDescriptor, reinterpret_cast<uv_after_work_cb>(AfterGattsAddDescriptor));
+    queueCommand<GattsAddDescriptor, AfterGattsAddDescriptor>(baton, "gattsAddDescriptor");
 }
 
 // This runs in a worker thread (not Main Thread)
@@ -612,6 +767,13 @@ void Adapter::GattsAddDescriptor(uv_work_t *req)
 {
     auto baton = static_cast<GattsAddDescriptorBaton *>(req->data);
     baton->result = sd_ble_gatts_descriptor_add(baton->adapter, baton->char_handle, baton->p_attr, &baton->p_handle);
+
+    auto jsAdapter = baton->owner;
+
+    if (baton->result == NRF_SUCCESS && jsAdapter != nullptr)
+    {
+        jsAdapter->gattServer.addAttribute(baton->p_handle, baton->p_attr->max_len);
+    }
 }
 
 // This runs in Main Thread
@@ -638,20 +800,63 @@ void Adapter::AfterGattsAddDescriptor(uv_work_t *req)
     delete baton;
 }
 
-NAN_METHOD(Adapter::GattsHVX)
+GattsTableAttribute::GattsTableAttribute() :
+    init_len(0),
+    init_offs(0),
+    max_len(0),
+    handle(0)
+{
+    memset(&uuid, 0, sizeof(uuid));
+}
+
+ble_gatts_attr_t GattsTableAttribute::toNative()
+{
+    ble_gatts_attr_t attribute;
+    memset(&attribute, 0, sizeof(attribute));
+
+    attribute.p_uuid = &uuid;
+    attribute.p_attr_md = attr_md.get();
+    attribute.init_len = init_len;
+    attribute.init_offs = init_offs;
+    attribute.max_len = max_len;
+    attribute.p_value = value.empty() ? nullptr : value.data();
+
+    return attribute;
+}
+
+GattsTableCharacteristic::GattsTableCharacteristic() :
+    p_char_md(nullptr)
+{
+    memset(&handles, 0, sizeof(handles));
+}
+
+GattsTableCharacteristic::~GattsTableCharacteristic()
+{
+    if (p_char_md != nullptr)
+    {
+        delete p_char_md->p_char_pf;
+        delete p_char_md->p_user_desc_md;
+        delete p_char_md->p_cccd_md;
+        delete p_char_md->p_sccd_md;
+        delete p_char_md;
+    }
+}
+
+NAN_METHOD(Adapter::GattsBuildTable)
 {
     auto obj = Nan::ObjectWrap::Unwrap<Adapter>(info.Holder());
-    uint16_t conn_handle;
-    v8::Local<v8::Object> hvx_params;
+    v8::Local<v8::Object> services;
     v8::Local<v8::Function> callback;
     auto argumentcount = 0;
 
     try
     {
-        conn_handle = ConversionUtility::getNativeUint16(info[argumentcount]);
-        argumentcount++;
+        if (!info[argumentcount]->IsArray())
+        {
+            throw std::string("array");
+        }
 
-        hvx_params = ConversionUtility::getJsObject(info[argumentcount]);
+        services = ConversionUtility::getJsObject(info[argumentcount]);
         argumentcount++;
 
         callback = ConversionUtility::getCallbackFunction(info[argumentcount]);
@@ -664,63 +869,160 @@ NAN_METHOD(Adapter::GattsHVX)
         return;
     }
 
-    auto baton = new GattsHVXBaton(callback);
+    auto baton = new GattsBuildTableBaton(callback);
     baton->adapter = obj->adapter;
-    baton->conn_handle = conn_handle;
 
     try
     {
-        baton->p_hvx_params = GattsHVXParams(hvx_params);
+        auto jsServices = v8::Local<v8::Array>::Cast(services);
+
+        for (uint32_t i = 0; i < jsServices->Length(); i++)
+        {
+            auto jsService = ConversionUtility::getJsObject(Utility::Get(jsServices, i));
+
+            GattsTableService service;
+            service.type = ConversionUtility::getNativeUint8(jsService, "type");
+            service.uuid_le = getTableUuid(jsService);
+            service.handle = 0;
+
+            auto jsCharacteristics = v8::Local<v8::Array>::Cast(ConversionUtility::getJsObject(jsService, "characteristics"));
+
+            for (uint32_t j = 0; j < jsCharacteristics->Length(); j++)
+            {
+                auto jsCharacteristic = ConversionUtility::getJsObject(Utility::Get(jsCharacteristics, j));
+
+                std::unique_ptr<GattsTableCharacteristic> characteristic(new GattsTableCharacteristic());
+                characteristic->p_char_md = GattsCharacteristicMetadata(ConversionUtility::getJsObject(jsCharacteristic, "metadata")).ToNative();
+                getTableAttribute(ConversionUtility::getJsObject(jsCharacteristic, "attribute"), characteristic->value);
+
+                auto jsDescriptors = v8::Local<v8::Array>::Cast(ConversionUtility::getJsObject(jsCharacteristic, "descriptors"));
+
+                for (uint32_t k = 0; k < jsDescriptors->Length(); k++)
+                {
+                    GattsTableAttribute descriptor;
+                    getTableAttribute(ConversionUtility::getJsObject(Utility::Get(jsDescriptors, k)), descriptor);
+                    characteristic->descriptors.push_back(std::move(descriptor));
+                }
+
+                service.characteristics.push_back(std::move(characteristic));
+            }
+
+            baton->services.push_back(std::move(service));
+        }
     }
     catch (std::string error)
     {
-        v8::Local<v8::String> message = ErrorMessage::getStructErrorMessage("hvx_params", error);
-        Nan::ThrowTypeError(message);
+        delete baton;
+        Nan::ThrowTypeError(ErrorMessage::getStructErrorMessage("services", error));
         return;
     }
 
-    uv_queue_work(uv_default_loop(), baton->req, GattsHVX, reinterpret_cast<uv_after_work_cb>(AfterGattsHVX));
+    queueCommand<GattsBuildTable, AfterGattsBuildTable>(baton, "gattsBuildTable");
 }
 
 // This runs in a worker thread (not Main Thread)
-void Adapter::GattsHVX(uv_work_t *req)
+void Adapter::GattsBuildTable(uv_work_t *req)
 {
-    auto baton = static_cast<GattsHVXBaton *>(req->data);
-    baton->result = sd_ble_gatts_hvx(baton->adapter, baton->conn_handle, baton->p_hvx_params);
+    auto baton = static_cast<GattsBuildTableBaton *>(req->data);
+    baton->result = buildTable(baton->adapter, baton->services, baton->vendor_uuids);
+
+    auto jsAdapter = baton->owner;
+
+    if (baton->result != NRF_SUCCESS || jsAdapter == nullptr)
+    {
+        return;
+    }
+
+    for (auto &service : baton->services)
+    {
+        for (auto &characteristic : service.characteristics)
+        {
+            jsAdapter->gattServer.addAttribute(characteristic->handles.value_handle, characteristic->value.max_len);
+
+            for (auto &descriptor : characteristic->descriptors)
+            {
+                jsAdapter->gattServer.addAttribute(descriptor.handle, descriptor.max_len);
+            }
+
+            if (characteristic->handles.cccd_handle != BLE_GATT_HANDLE_INVALID)
+            {
+                jsAdapter->gattServer.addCccd(characteristic->handles.cccd_handle, characteristic->handles.value_handle);
+            }
+        }
+    }
 }
 
 // This runs in Main Thread
-void Adapter::AfterGattsHVX(uv_work_t *req)
+void Adapter::AfterGattsBuildTable(uv_work_t *req)
 {
     Nan::HandleScope scope;
 
-    auto baton = static_cast<GattsHVXBaton *>(req->data);
+    auto baton = static_cast<GattsBuildTableBaton *>(req->data);
     v8::Local<v8::Value> argv[2];
 
     if (baton->result != NRF_SUCCESS)
     {
-        argv[0] = ErrorMessage::getErrorMessage(baton->result, "hvx");
+        argv[0] = ErrorMessage::getErrorMessage(baton->result, "building GATT table");
         argv[1] = Nan::Undefined();
     }
     else
     {
+        auto services = Nan::New<v8::Array>(static_cast<uint32_t>(baton->services.size()));
+
+        for (uint32_t i = 0; i < baton->services.size(); i++)
+        {
+            auto &service = baton->services[i];
+            auto characteristics = Nan::New<v8::Array>(static_cast<uint32_t>(service.characteristics.size()));
+
+            for (uint32_t j = 0; j < service.characteristics.size(); j++)
+            {
+                auto &characteristic = *service.characteristics[j];
+                auto descriptorHandles = Nan::New<v8::Array>(static_cast<uint32_t>(characteristic.descriptors.size()));
+
+                for (uint32_t k = 0; k < characteristic.descriptors.size(); k++)
+                {
+                    Nan::Set(descriptorHandles, k, ConversionUtility::toJsNumber(characteristic.descriptors[k].handle));
+                }
+
+                auto handles = GattsCharacteristicDefinitionHandles(&characteristic.handles).ToJs();
+                Utility::Set(handles, "descriptor_handles", descriptorHandles);
+                Nan::Set(characteristics, j, handles);
+            }
+
+            auto jsService = Nan::New<v8::Object>();
+            Utility::Set(jsService, "handle", ConversionUtility::toJsNumber(service.handle));
+            Utility::Set(jsService, "characteristics", characteristics);
+            Nan::Set(services, i, jsService);
+        }
+
+        auto vendorUuids = Nan::New<v8::Array>(static_cast<uint32_t>(baton->vendor_uuids.size()));
+
+        for (uint32_t i = 0; i < baton->vendor_uuids.size(); i++)
+        {
+            auto vendorUuid = Nan::New<v8::Object>();
+            Utility::Set(vendorUuid, "uuid", uuid128ToString(baton->vendor_uuids[i].first));
+            Utility::Set(vendorUuid, "type", baton->vendor_uuids[i].second);
+            Nan::Set(vendorUuids, i, vendorUuid);
+        }
+
+        auto table = Nan::New<v8::Object>();
+        Utility::Set(table, "services", services);
+        Utility::Set(table, "vendor_uuids", vendorUuids);
+
         argv[0] = Nan::Undefined();
-        argv[1] = ConversionUtility::toJsNumber(*baton->p_hvx_params->p_len);
+        argv[1] = table;
     }
 
     Nan::AsyncResource resource("pc-ble-driver-js:callback");
-    baton->callback->Call(1, argv, &resource);
+    baton->callback->Call(2, argv, &resource);
     delete baton;
 }
 
-NAN_METHOD(Adapter::GattsSystemAttributeSet)
+NAN_METHOD(Adapter::GattsHVX)
 {
     auto obj = Nan::ObjectWrap::Unwrap<Adapter>(info.Holder());
     uint16_t conn_handle;
-    v8::Local<v8::Object> sys_attr_data;
-    auto  sys_attr_data_isNullPointer = false;
-    uint16_t len;
-    uint32_t flags;
+    v8::Local<v8::Object> hvx_params;
     v8::Local<v8::Function> callback;
     auto argumentcount = 0;
 
@@ -729,20 +1031,7 @@ NAN_METHOD(Adapter::GattsSystemAttributeSet)
         conn_handle = ConversionUtility::getNativeUint16(info[argumentcount]);
         argumentcount++;
 
-        if (info[argumentcount]->IsNull())
-        {
-            sys_attr_data_isNullPointer = true;
-        }
-        else
-        {
-            sys_attr_data = ConversionUtility::getJsObject(info[argumentcount]);
-        }
-        argumentcount++;
-
-        len = ConversionUtility::getNativeUint16(info[argumentcount]);
-        argumentcount++;
-
-        flags = ConversionUtility::getNativeUint32(info[argumentcount]);
+        hvx_params = ConversionUtility::getJsObject(info[argumentcount]);
         argumentcount++;
 
         callback = ConversionUtility::getCallbackFunction(info[argumentcount]);
@@ -755,47 +1044,71 @@ NAN_METHOD(Adapter::GattsSystemAttributeSet)
         return;
     }
 
-    auto baton = new GattsSystemAttributeSetBaton(callback);
+    auto baton = new GattsHVXBaton(callback);
     baton->adapter = obj->adapter;
     baton->conn_handle = conn_handle;
 
-    if (!sys_attr_data_isNullPointer)
+    try
     {
-        baton->p_sys_attr_data = ConversionUtility::getNativePointerToUint8(sys_attr_data);
+        baton->p_hvx_params = GattsHVXParams(hvx_params);
     }
-    else
+    catch (std::string error)
     {
-        baton->p_sys_attr_data = nullptr;
+        v8::Local<v8::String> message = ErrorMessage::getStructErrorMessage("hvx_params", error);
+        Nan::ThrowTypeError(message);
+        return;
     }
 
-    baton->len = len;
-    baton->flags = flags;
-
-    uv_queue_work(uv_default_loop(), baton->req, GattsSystemAttributeSet, reinterpret_cast<uv_after_work_cb>(AfterGattsSystemAttributeSet));
+    queueCommand<GattsHVX, AfterGattsHVX>(baton, "gattsHVX");
 }
 
 // This runs in a worker thread (not Main Thread)
-void Adapter::GattsSystemAttributeSet(uv_work_t *req)
+void Adapter::GattsHVX(uv_work_t *req)
 {
-    auto baton = static_cast<GattsSystemAttributeSetBaton *>(req->data);
-    baton->result = sd_ble_gatts_sys_attr_set(baton->adapter, baton->conn_handle, baton->p_sys_attr_data, baton->len, baton->flags);
+    auto baton = static_cast<GattsHVXBaton *>(req->data);
+    auto jsAdapter = baton->owner;
+    auto generation = (jsAdapter != nullptr) ? jsAdapter->gattServer.valueGeneration(baton->conn_handle, baton->p_hvx_params->handle) : 0;
+
+    baton->result = sd_ble_gatts_hvx(baton->adapter, baton->conn_handle, baton->p_hvx_params);
+
+    if (baton->result == NRF_SUCCESS && jsAdapter != nullptr && baton->p_hvx_params->p_len != nullptr)
+    {
+        jsAdapter->getMetrics().countBytesNotified(baton->conn_handle, *baton->p_hvx_params->p_len);
+    }
+
+    if (jsAdapter == nullptr || baton->p_hvx_params->p_data == nullptr || baton->p_hvx_params->p_len == nullptr)
+    {
+        return;
+    }
+
+    // The SoftDevice may update the value even if the packet is not sent
+    if (baton->result == NRF_SUCCESS)
+    {
+        jsAdapter->gattServer.updateValue(baton->conn_handle, baton->p_hvx_params->handle, baton->p_hvx_params->offset, baton->p_hvx_params->p_data, *baton->p_hvx_params->p_len, generation);
+    }
+    else
+    {
+        jsAdapter->gattServer.invalidateValue(baton->conn_handle, baton->p_hvx_params->handle);
+    }
 }
 
 // This runs in Main Thread
-void Adapter::AfterGattsSystemAttributeSet(uv_work_t *req)
+void Adapter::AfterGattsHVX(uv_work_t *req)
 {
     Nan::HandleScope scope;
 
-    auto baton = static_cast<GattsSystemAttributeSetBaton *>(req->data);
-    v8::Local<v8::Value> argv[1];
+    auto baton = static_cast<GattsHVXBaton *>(req->data);
+    v8::Local<v8::Value> argv[2];
 
     if (baton->result != NRF_SUCCESS)
     {
-        argv[0] = ErrorMessage::getErrorMessage(baton->result, "setting system attributes");
+        argv[0] = ErrorMessage::getErrorMessage(baton->result, "hvx");
+        argv[1] = Nan::Undefined();
     }
     else
     {
         argv[0] = Nan::Undefined();
+        argv[1] = ConversionUtility::toJsNumber(*baton->p_hvx_params->p_len);
     }
 
     Nan::AsyncResource resource("pc-ble-driver-js:callback");
@@ -803,12 +1116,11 @@ void Adapter::AfterGattsSystemAttributeSet(uv_work_t *req)
     delete baton;
 }
 
-NAN_METHOD(Adapter::GattsSetValue)
+NAN_METHOD(Adapter::GattsQueueNotification)
 {
-    auto obj = Nan::ObjectWrap::Unwrap<Adapter>(info.Holder());
     uint16_t conn_handle;
     uint16_t handle;
-    v8::Local<v8::Object> value;
+    std::vector<uint8_t> value;
     v8::Local<v8::Function> callback;
     auto argumentcount = 0;
 
@@ -820,7 +1132,7 @@ NAN_METHOD(Adapter::GattsSetValue)
         handle = ConversionUtility::getNativeUint16(info[argumentcount]);
         argumentcount++;
 
-        value = ConversionUtility::getJsObject(info[argumentcount]);
+        value = ConversionUtility::getNativeBytes(info[argumentcount]);
         argumentcount++;
 
         callback = ConversionUtility::getCallbackFunction(info[argumentcount]);
@@ -833,62 +1145,37 @@ NAN_METHOD(Adapter::GattsSetValue)
         return;
     }
 
-    auto baton = new GattsSetValueBaton(callback);
+    auto obj = Nan::ObjectWrap::Unwrap<Adapter>(info.Holder());
+    auto baton = new GattsQueueNotificationBaton(callback);
     baton->adapter = obj->adapter;
     baton->conn_handle = conn_handle;
-    baton->handle = handle;
-
-    try
-    {
-        baton->p_value = GattsValue(value);
-    }
-    catch (std::string error)
-    {
-        v8::Local<v8::String> message = ErrorMessage::getStructErrorMessage("value", error);
-        Nan::ThrowTypeError(message);
-        return;
-    }
+    baton->gattServer = &obj->gattServer;
+    baton->notification = std::make_unique<GattNotification>(handle, std::make_shared<Nan::Callback>(callback));
+    baton->notification->value.swap(value);
 
-    uv_queue_work(uv_default_loop(), baton->req, GattsSetValue, reinterpret_cast<uv_after_work_cb>(AfterGattsSetValue));
+    queueCommand<GattsQueueNotification, AfterGattsQueueNotification>(baton, "gattsQueueNotification");
 }
 
 // This runs in a worker thread (not Main Thread)
-void Adapter::GattsSetValue(uv_work_t *req)
+void Adapter::GattsQueueNotification(uv_work_t *req)
 {
-    auto baton = static_cast<GattsSetValueBaton *>(req->data);
-    baton->result = sd_ble_gatts_value_set(baton->adapter, baton->conn_handle, baton->handle, baton->p_value);
+    auto baton = static_cast<GattsQueueNotificationBaton *>(req->data);
+    baton->gattServer->queueNotification(baton->adapter, baton->conn_handle, std::move(*baton->notification));
+    baton->result = NRF_SUCCESS;
 }
 
 // This runs in Main Thread
-void Adapter::AfterGattsSetValue(uv_work_t *req)
+void Adapter::AfterGattsQueueNotification(uv_work_t *req)
 {
-    Nan::HandleScope scope;
-
-    auto baton = static_cast<GattsSetValueBaton *>(req->data);
-    v8::Local<v8::Value> argv[2];
-
-    if (baton->result != NRF_SUCCESS)
-    {
-        argv[0] = ErrorMessage::getErrorMessage(baton->result, "setting value");
-        argv[1] = Nan::Undefined();
-    }
-    else
-    {
-        argv[0] = Nan::Undefined();
-        argv[1] = GattsValue(baton->p_value);
-    }
-
-    Nan::AsyncResource resource("pc-ble-driver-js:callback");
-    baton->callback->Call(2, argv, &resource);
-    delete baton;
+    // The callback is called by the GattServer once the SoftDevice has accepted the notification
+    delete static_cast<GattsQueueNotificationBaton *>(req->data);
 }
 
-NAN_METHOD(Adapter::GattsGetValue)
+NAN_METHOD(Adapter::GattsQueueIndication)
 {
-    auto obj = Nan::ObjectWrap::Unwrap<Adapter>(info.Holder());
     uint16_t conn_handle;
     uint16_t handle;
-    v8::Local<v8::Object> value;
+    std::vector<uint8_t> value;
     v8::Local<v8::Function> callback;
     auto argumentcount = 0;
 
@@ -900,7 +1187,7 @@ NAN_METHOD(Adapter::GattsGetValue)
         handle = ConversionUtility::getNativeUint16(info[argumentcount]);
         argumentcount++;
 
-        value = ConversionUtility::getJsObject(info[argumentcount]);
+        value = ConversionUtility::getNativeBytes(info[argumentcount]);
         argumentcount++;
 
         callback = ConversionUtility::getCallbackFunction(info[argumentcount]);
@@ -913,30 +1200,517 @@ NAN_METHOD(Adapter::GattsGetValue)
         return;
     }
 
-    auto baton = new GattsSetValueBaton(callback);
+    auto obj = Nan::ObjectWrap::Unwrap<Adapter>(info.Holder());
+    auto baton = new GattsQueueIndicationBaton(callback);
     baton->adapter = obj->adapter;
     baton->conn_handle = conn_handle;
-    baton->handle = handle;
-
-    try
-    {
-        baton->p_value = GattsValue(value);
-    }
-    catch (std::string error)
-    {
-        v8::Local<v8::String> message = ErrorMessage::getStructErrorMessage("value", error);
-        Nan::ThrowTypeError(message);
-        return;
-    }
+    baton->gattServer = &obj->gattServer;
+    baton->indication = std::make_unique<GattIndication>(handle, std::make_shared<Nan::Callback>(callback));
+    baton->indication->value.swap(value);
 
-    uv_queue_work(uv_default_loop(), baton->req, GattsGetValue, reinterpret_cast<uv_after_work_cb>(AfterGattsGetValue));
+    queueCommand<GattsQueueIndication, AfterGattsQueueIndication>(baton, "gattsQueueIndication");
 }
 
 // This runs in a worker thread (not Main Thread)
-void Adapter::GattsGetValue(uv_work_t *req)
+void Adapter::GattsQueueIndication(uv_work_t *req)
 {
-    auto baton = static_cast<GattsGetValueBaton *>(req->data);
+    auto baton = static_cast<GattsQueueIndicationBaton *>(req->data);
+    baton->gattServer->queueIndication(baton->adapter, baton->conn_handle, std::move(*baton->indication));
+    baton->result = NRF_SUCCESS;
+}
+
+// This runs in Main Thread
+void Adapter::AfterGattsQueueIndication(uv_work_t *req)
+{
+    // The callback is called by the GattServer once the peer has confirmed the indication
+    delete static_cast<GattsQueueIndicationBaton *>(req->data);
+}
+
+NAN_METHOD(Adapter::GattsSetIndicationTimeout)
+{
+    uint32_t timeout;
+    auto argumentcount = 0;
+
+    try
+    {
+        timeout = ConversionUtility::getNativeUint32(info[argumentcount]);
+
+        if (timeout == 0)
+        {
+            throw std::string("timeout larger than 0");
+        }
+
+        argumentcount++;
+    }
+    catch (std::string error)
+    {
+        v8::Local<v8::String> message = ErrorMessage::getTypeErrorMessage(argumentcount, error);
+        Nan::ThrowTypeError(message);
+        return;
+    }
+
+    auto obj = Nan::ObjectWrap::Unwrap<Adapter>(info.Holder());
+    obj->gattServer.setIndicationTimeout(timeout);
+}
+
+NAN_METHOD(Adapter::GattsNotifyAll)
+{
+    uint16_t value_handle;
+    std::vector<uint8_t> value;
+    v8::Local<v8::Function> callback;
+    auto argumentcount = 0;
+
+    try
+    {
+        value_handle = ConversionUtility::getNativeUint16(info[argumentcount]);
+        argumentcount++;
+
+        value = ConversionUtility::getNativeBytes(info[argumentcount]);
+        argumentcount++;
+
+        callback = ConversionUtility::getCallbackFunction(info[argumentcount]);
+        argumentcount++;
+    }
+    catch (std::string error)
+    {
+        v8::Local<v8::String> message = ErrorMessage::getTypeErrorMessage(argumentcount, error);
+        Nan::ThrowTypeError(message);
+        return;
+    }
+
+    auto obj = Nan::ObjectWrap::Unwrap<Adapter>(info.Holder());
+    auto baton = new GattsNotifyAllBaton(callback);
+    baton->adapter = obj->adapter;
+    baton->gattServer = &obj->gattServer;
+    baton->value_handle = value_handle;
+    baton->value.swap(value);
+    baton->notify_callback = std::make_shared<Nan::Callback>(callback);
+
+    queueCommand<GattsNotifyAll, AfterGattsNotifyAll>(baton, "gattsNotifyAll");
+}
+
+// This runs in a worker thread (not Main Thread)
+void Adapter::GattsNotifyAll(uv_work_t *req)
+{
+    auto baton = static_cast<GattsNotifyAllBaton *>(req->data);
+    baton->gattServer->notifyAll(baton->adapter, baton->value_handle, baton->value, baton->notify_callback);
+    baton->result = NRF_SUCCESS;
+}
+
+// This runs in Main Thread
+void Adapter::AfterGattsNotifyAll(uv_work_t *req)
+{
+    // The callback is called by the GattServer once all connections are notified
+    delete static_cast<GattsNotifyAllBaton *>(req->data);
+}
+
+NAN_METHOD(Adapter::GattsSetAttributeStore)
+{
+    uint16_t handle;
+    v8::Local<v8::Object> options;
+    v8::Local<v8::Function> callback;
+    auto argumentcount = 0;
+
+    try
+    {
+        handle = ConversionUtility::getNativeUint16(info[argumentcount]);
+        argumentcount++;
+
+        options = ConversionUtility::getJsObject(info[argumentcount]);
+        argumentcount++;
+
+        callback = ConversionUtility::getCallbackFunction(info[argumentcount]);
+        argumentcount++;
+    }
+    catch (std::string error)
+    {
+        v8::Local<v8::String> message = ErrorMessage::getTypeErrorMessage(argumentcount, error);
+        Nan::ThrowTypeError(message);
+        return;
+    }
+
+    GattAttributeStore store;
+
+    try
+    {
+        store.value = ConversionUtility::getNativeBytes(Utility::Get(options, "value"));
+        store.serveReads = ConversionUtility::getBool(options, "serve_reads");
+        store.maxLength = ConversionUtility::getNativeUint16(options, "max_length");
+
+        auto writePolicy = ConversionUtility::getNativeString(options, "write_policy");
+
+        if (writePolicy == "pass")
+        {
+            store.writePolicy = GattAttributeStore::WritePolicy::Pass;
+        }
+        else if (writePolicy == "accept")
+        {
+            store.writePolicy = GattAttributeStore::WritePolicy::Accept;
+        }
+        else if (writePolicy == "reject")
+        {
+            store.writePolicy = GattAttributeStore::WritePolicy::Reject;
+        }
+        else
+        {
+            throw std::string("write_policy pass, accept or reject");
+        }
+
+        if (Utility::Has(options, "reject_status"))
+        {
+            store.rejectStatus = ConversionUtility::getNativeUint16(options, "reject_status");
+        }
+    }
+    catch (std::string error)
+    {
+        v8::Local<v8::String> message = ErrorMessage::getStructErrorMessage("options", error);
+        Nan::ThrowTypeError(message);
+        return;
+    }
+
+    store.callback = std::make_shared<Nan::Callback>(callback);
+
+    auto obj = Nan::ObjectWrap::Unwrap<Adapter>(info.Holder());
+    obj->gattServer.setAttributeStore(handle, std::move(store));
+}
+
+NAN_METHOD(Adapter::GattsClearAttributeStore)
+{
+    uint16_t handle;
+    auto argumentcount = 0;
+
+    try
+    {
+        handle = ConversionUtility::getNativeUint16(info[argumentcount]);
+        argumentcount++;
+    }
+    catch (std::string error)
+    {
+        v8::Local<v8::String> message = ErrorMessage::getTypeErrorMessage(argumentcount, error);
+        Nan::ThrowTypeError(message);
+        return;
+    }
+
+    auto obj = Nan::ObjectWrap::Unwrap<Adapter>(info.Holder());
+    obj->gattServer.clearAttributeStore(handle);
+}
+
+NAN_METHOD(Adapter::GattsSetSystemAttributeDirectory)
+{
+    std::string directory;
+    auto argumentcount = 0;
+
+    try
+    {
+        directory = ConversionUtility::getNativeString(info[argumentcount]);
+        argumentcount++;
+    }
+    catch (std::string error)
+    {
+        v8::Local<v8::String> message = ErrorMessage::getTypeErrorMessage(argumentcount, error);
+        Nan::ThrowTypeError(message);
+        return;
+    }
+
+    auto obj = Nan::ObjectWrap::Unwrap<Adapter>(info.Holder());
+    obj->gattServer.setSystemAttributeDirectory(directory);
+}
+
+NAN_METHOD(Adapter::GattsSetConnectionWeight)
+{
+    uint16_t conn_handle;
+    uint16_t weight;
+    auto argumentcount = 0;
+
+    try
+    {
+        conn_handle = ConversionUtility::getNativeUint16(info[argumentcount]);
+        argumentcount++;
+
+        weight = ConversionUtility::getNativeUint16(info[argumentcount]);
+
+        if (weight == 0)
+        {
+            throw std::string("weight larger than 0");
+        }
+
+        argumentcount++;
+    }
+    catch (std::string error)
+    {
+        v8::Local<v8::String> message = ErrorMessage::getTypeErrorMessage(argumentcount, error);
+        Nan::ThrowTypeError(message);
+        return;
+    }
+
+    auto obj = Nan::ObjectWrap::Unwrap<Adapter>(info.Holder());
+    obj->gattServer.setConnectionWeight(conn_handle, weight);
+}
+
+NAN_METHOD(Adapter::GattsSystemAttributeSet)
+{
+    auto obj = Nan::ObjectWrap::Unwrap<Adapter>(info.Holder());
+    uint16_t conn_handle;
+    v8::Local<v8::Object> sys_attr_data;
+    auto  sys_attr_data_isNullPointer = false;
+    uint16_t len;
+    uint32_t flags;
+    v8::Local<v8::Function> callback;
+    auto argumentcount = 0;
+
+    try
+    {
+        conn_handle = ConversionUtility::getNativeUint16(info[argumentcount]);
+        argumentcount++;
+
+        if (info[argumentcount]->IsNull())
+        {
+            sys_attr_data_isNullPointer = true;
+        }
+        else
+        {
+            sys_attr_data = ConversionUtility::getJsObject(info[argumentcount]);
+        }
+        argumentcount++;
+
+        len = ConversionUtility::getNativeUint16(info[argumentcount]);
+        argumentcount++;
+
+        flags = ConversionUtility::getNativeUint32(info[argumentcount]);
+        argumentcount++;
+
+        callback = ConversionUtility::getCallbackFunction(info[argumentcount]);
+        argumentcount++;
+    }
+    catch (std::string error)
+    {
+        v8::Local<v8::String> message = ErrorMessage::getTypeErrorMessage(argumentcount, error);
+        Nan::ThrowTypeError(message);
+        return;
+    }
+
+    auto baton = new GattsSystemAttributeSetBaton(callback);
+    baton->adapter = obj->adapter;
+    baton->conn_handle = conn_handle;
+
+    if (!sys_attr_data_isNullPointer)
+    {
+        baton->p_sys_attr_data = ConversionUtility::getNativePointerToUint8(sys_attr_data);
+    }
+    else
+    {
+        baton->p_sys_attr_data = nullptr;
+    }
+
+    baton->len = len;
+    baton->flags = flags;
+
+    queueCommand<GattsSystemAttributeSet, AfterGattsSystemAttributeSet>(baton, "gattsSystemAttributeSet");
+}
+
+// This runs in a worker thread (not Main Thread)
+void Adapter::GattsSystemAttributeSet(uv_work_t *req)
+{
+    auto baton = static_cast<GattsSystemAttributeSetBaton *>(req->data);
+    baton->result = sd_ble_gatts_sys_attr_set(baton->adapter, baton->conn_handle, baton->p_sys_attr_data, baton->len, baton->flags);
+
+    auto jsAdapter = baton->owner;
+
+    if (jsAdapter == nullptr)
+    {
+        return;
+    }
+
+    if (baton->result == NRF_SUCCESS)
+    {
+        jsAdapter->gattServer.systemAttributesSet(baton->conn_handle, baton->p_sys_attr_data, baton->len, baton->flags);
+    }
+    else
+    {
+        jsAdapter->gattServer.invalidateValues(baton->conn_handle);
+    }
+}
+
+// This runs in Main Thread
+void Adapter::AfterGattsSystemAttributeSet(uv_work_t *req)
+{
+    Nan::HandleScope scope;
+
+    auto baton = static_cast<GattsSystemAttributeSetBaton *>(req->data);
+    v8::Local<v8::Value> argv[1];
+
+    if (baton->result != NRF_SUCCESS)
+    {
+        argv[0] = ErrorMessage::getErrorMessage(baton->result, "setting system attributes");
+    }
+    else
+    {
+        argv[0] = Nan::Undefined();
+    }
+
+    Nan::AsyncResource resource("pc-ble-driver-js:callback");
+    baton->callback->Call(1, argv, &resource);
+    delete baton;
+}
+
+NAN_METHOD(Adapter::GattsSetValue)
+{
+    auto obj = Nan::ObjectWrap::Unwrap<Adapter>(info.Holder());
+    uint16_t conn_handle;
+    uint16_t handle;
+    v8::Local<v8::Object> value;
+    v8::Local<v8::Function> callback;
+    auto argumentcount = 0;
+
+    try
+    {
+        conn_handle = ConversionUtility::getNativeUint16(info[argumentcount]);
+        argumentcount++;
+
+        handle = ConversionUtility::getNativeUint16(info[argumentcount]);
+        argumentcount++;
+
+        value = ConversionUtility::getJsObject(info[argumentcount]);
+        argumentcount++;
+
+        callback = ConversionUtility::getCallbackFunction(info[argumentcount]);
+        argumentcount++;
+    }
+    catch (std::string error)
+    {
+        v8::Local<v8::String> message = ErrorMessage::getTypeErrorMessage(argumentcount, error);
+        Nan::ThrowTypeError(message);
+        return;
+    }
+
+    auto baton = new GattsSetValueBaton(callback);
+    baton->adapter = obj->adapter;
+    baton->conn_handle = conn_handle;
+    baton->handle = handle;
+
+    try
+    {
+        baton->p_value = GattsValue(value);
+    }
+    catch (std::string error)
+    {
+        v8::Local<v8::String> message = ErrorMessage::getStructErrorMessage("value", error);
+        Nan::ThrowTypeError(message);
+        return;
+    }
+
+    queueCommand<GattsSetValue, AfterGattsSetValue>(baton, "gattsSetValue");
+}
+
+// This runs in a worker thread (not Main Thread)
+void Adapter::GattsSetValue(uv_work_t *req)
+{
+    auto baton = static_cast<GattsSetValueBaton *>(req->data);
+    auto jsAdapter = baton->owner;
+    auto generation = (jsAdapter != nullptr) ? jsAdapter->gattServer.valueGeneration(baton->conn_handle, baton->handle) : 0;
+
+    baton->result = sd_ble_gatts_value_set(baton->adapter, baton->conn_handle, baton->handle, baton->p_value);
+
+    if (baton->result == NRF_SUCCESS && jsAdapter != nullptr)
+    {
+        jsAdapter->gattServer.updateValue(baton->conn_handle, baton->handle, baton->p_value->offset, baton->p_value->p_value, baton->p_value->len, generation);
+    }
+}
+
+// This runs in Main Thread
+void Adapter::AfterGattsSetValue(uv_work_t *req)
+{
+    Nan::HandleScope scope;
+
+    auto baton = static_cast<GattsSetValueBaton *>(req->data);
+    v8::Local<v8::Value> argv[2];
+
+    if (baton->result != NRF_SUCCESS)
+    {
+        argv[0] = ErrorMessage::getErrorMessage(baton->result, "setting value");
+        argv[1] = Nan::Undefined();
+    }
+    else
+    {
+        argv[0] = Nan::Undefined();
+        argv[1] = GattsValue(baton->p_value);
+    }
+
+    Nan::AsyncResource resource("pc-ble-driver-js:callback");
+    baton->callback->Call(2, argv, &resource);
+    delete baton;
+}
+
+NAN_METHOD(Adapter::GattsGetValue)
+{
+    auto obj = Nan::ObjectWrap::Unwrap<Adapter>(info.Holder());
+    uint16_t conn_handle;
+    uint16_t handle;
+    v8::Local<v8::Object> value;
+    v8::Local<v8::Function> callback;
+    auto argumentcount = 0;
+
+    try
+    {
+        conn_handle = ConversionUtility::getNativeUint16(info[argumentcount]);
+        argumentcount++;
+
+        handle = ConversionUtility::getNativeUint16(info[argumentcount]);
+        argumentcount++;
+
+        value = ConversionUtility::getJsObject(info[argumentcount]);
+        argumentcount++;
+
+        callback = ConversionUtility::getCallbackFunction(info[argumentcount]);
+        argumentcount++;
+    }
+    catch (std::string error)
+    {
+        v8::Local<v8::String> message = ErrorMessage::getTypeErrorMessage(argumentcount, error);
+        Nan::ThrowTypeError(message);
+        return;
+    }
+
+    auto baton = new GattsSetValueBaton(callback);
+    baton->adapter = obj->adapter;
+    baton->conn_handle = conn_handle;
+    baton->handle = handle;
+
+    try
+    {
+        baton->p_value = GattsValue(value);
+    }
+    catch (std::string error)
+    {
+        v8::Local<v8::String> message = ErrorMessage::getStructErrorMessage("value", error);
+        Nan::ThrowTypeError(message);
+        return;
+    }
+
+    queueCommand<GattsGetValue, AfterGattsGetValue>(baton, "gattsGetValue");
+}
+
+// This runs in a worker thread (not Main Thread)
+void Adapter::GattsGetValue(uv_work_t *req)
+{
+    auto baton = static_cast<GattsGetValueBaton *>(req->data);
+    auto jsAdapter = baton->owner;
+
+    uint32_t generation = 0;
+
+    if (jsAdapter != nullptr && jsAdapter->gattServer.readValue(baton->conn_handle, baton->handle, *baton->p_value, generation))
+    {
+        baton->result = NRF_SUCCESS;
+        return;
+    }
+
+    auto bufferLength = baton->p_value->len;
     baton->result = sd_ble_gatts_value_get(baton->adapter, baton->conn_handle, baton->handle, baton->p_value);
+
+    if (baton->result == NRF_SUCCESS && jsAdapter != nullptr)
+    {
+        jsAdapter->gattServer.mirrorValue(baton->conn_handle, baton->handle, bufferLength, *baton->p_value, generation);
+    }
 }
 
 // This runs in Main Thread
@@ -963,6 +1737,297 @@ void Adapter::AfterGattsGetValue(uv_work_t *req)
     delete baton;
 }
 
+NAN_METHOD(Adapter::GattsSetValues)
+{
+    uint16_t conn_handle;
+    v8::Local<v8::Object> values;
+    v8::Local<v8::Function> callback;
+    auto argumentcount = 0;
+
+    try
+    {
+        conn_handle = ConversionUtility::getNativeUint16(info[argumentcount]);
+        argumentcount++;
+
+        if (!info[argumentcount]->IsArray())
+        {
+            throw std::string("array");
+        }
+
+        values = ConversionUtility::getJsObject(info[argumentcount]);
+        argumentcount++;
+
+        callback = ConversionUtility::getCallbackFunction(info[argumentcount]);
+        argumentcount++;
+    }
+    catch (std::string error)
+    {
+        v8::Local<v8::String> message = ErrorMessage::getTypeErrorMessage(argumentcount, error);
+        Nan::ThrowTypeError(message);
+        return;
+    }
+
+    auto obj = Nan::ObjectWrap::Unwrap<Adapter>(info.Holder());
+    auto baton = new GattsSetValuesBaton(callback);
+    baton->adapter = obj->adapter;
+    baton->conn_handle = conn_handle;
+
+    auto count = v8::Local<v8::Array>::Cast(values)->Length();
+    baton->writes.reserve(count);
+    baton->copies.reserve(count);
+
+    try
+    {
+        for (uint32_t i = 0; i < count; i++)
+        {
+            auto value = ConversionUtility::getJsObject(Utility::Get(values, i));
+            auto data = Utility::Get(value, "value");
+
+            GattsValueWrite write;
+            write.handle = ConversionUtility::getNativeUint16(value, "handle");
+            write.offset = Utility::Has(value, "offset") ? ConversionUtility::getNativeUint16(value, "offset") : 0;
+
+            // The worker reads Buffers in place, arrays of numbers are copied
+            size_t length;
+
+            if (node::Buffer::HasInstance(data))
+            {
+                write.data = reinterpret_cast<const uint8_t *>(node::Buffer::Data(data));
+                length = node::Buffer::Length(data);
+                baton->buffers.push_back(std::make_unique<Nan::Global<v8::Object>>(data.As<v8::Object>()));
+            }
+            else
+            {
+                baton->copies.push_back(ConversionUtility::getNativeBytes(data));
+                write.data = baton->copies.back().data();
+                length = baton->copies.back().size();
+            }
+
+            // Checked before the length is narrowed, longer values would wrap around
+            if (write.offset + length > BLE_GATTS_VAR_ATTR_LEN_MAX)
+            {
+                throw std::string("values of at most BLE_GATTS_VAR_ATTR_LEN_MAX bytes");
+            }
+
+            write.length = static_cast<uint16_t>(length);
+            baton->writes.push_back(write);
+        }
+    }
+    catch (std::string error)
+    {
+        delete baton;
+        v8::Local<v8::String> message = ErrorMessage::getStructErrorMessage("values", error);
+        Nan::ThrowTypeError(message);
+        return;
+    }
+
+    queueCommand<GattsSetValues, AfterGattsSetValues>(baton, "gattsSetValues");
+}
+
+// This runs in a worker thread (not Main Thread)
+void Adapter::GattsSetValues(uv_work_t *req)
+{
+    auto baton = static_cast<GattsSetValuesBaton *>(req->data);
+    auto jsAdapter = baton->owner;
+
+    for (auto &write : baton->writes)
+    {
+        ble_gatts_value_t value;
+        value.len = write.length;
+        value.offset = write.offset;
+        value.p_value = const_cast<uint8_t *>(write.data);
+
+        auto generation = (jsAdapter != nullptr) ? jsAdapter->gattServer.valueGeneration(baton->conn_handle, write.handle) : 0;
+        auto result = sd_ble_gatts_value_set(baton->adapter, baton->conn_handle, write.handle, &value);
+        baton->results.push_back(result);
+
+        if (result == NRF_SUCCESS && jsAdapter != nullptr)
+        {
+            jsAdapter->gattServer.updateValue(baton->conn_handle, write.handle, write.offset, write.data, write.length, generation);
+        }
+    }
+
+    baton->result = NRF_SUCCESS;
+}
+
+// This runs in Main Thread
+void Adapter::AfterGattsSetValues(uv_work_t *req)
+{
+    Nan::HandleScope scope;
+
+    auto baton = static_cast<GattsSetValuesBaton *>(req->data);
+
+    // Undefined for the values that were set
+    auto results = Nan::New<v8::Array>(static_cast<uint32_t>(baton->results.size()));
+
+    for (uint32_t i = 0; i < baton->results.size(); i++)
+    {
+        if (baton->results[i] != NRF_SUCCESS)
+        {
+            Nan::Set(results, i, ErrorMessage::getErrorMessage(baton->results[i], "setting value"));
+        }
+        else
+        {
+            Nan::Set(results, i, Nan::Undefined());
+        }
+    }
+
+    v8::Local<v8::Value> argv[2] = { Nan::Undefined(), results };
+
+    Nan::AsyncResource resource("pc-ble-driver-js:callback");
+    baton->callback->Call(2, argv, &resource);
+    delete baton;
+}
+
+NAN_METHOD(Adapter::GattsGetValues)
+{
+    uint16_t conn_handle;
+    v8::Local<v8::Object> handles;
+    v8::Local<v8::Function> callback;
+    auto argumentcount = 0;
+
+    try
+    {
+        conn_handle = ConversionUtility::getNativeUint16(info[argumentcount]);
+        argumentcount++;
+
+        if (!info[argumentcount]->IsArray())
+        {
+            throw std::string("array");
+        }
+
+        handles = ConversionUtility::getJsObject(info[argumentcount]);
+        argumentcount++;
+
+        callback = ConversionUtility::getCallbackFunction(info[argumentcount]);
+        argumentcount++;
+    }
+    catch (std::string error)
+    {
+        v8::Local<v8::String> message = ErrorMessage::getTypeErrorMessage(argumentcount, error);
+        Nan::ThrowTypeError(message);
+        return;
+    }
+
+    auto obj = Nan::ObjectWrap::Unwrap<Adapter>(info.Holder());
+    auto baton = new GattsGetValuesBaton(callback);
+    baton->adapter = obj->adapter;
+    baton->conn_handle = conn_handle;
+
+    auto count = v8::Local<v8::Array>::Cast(handles)->Length();
+
+    try
+    {
+        for (uint32_t i = 0; i < count; i++)
+        {
+            baton->handles.push_back(ConversionUtility::getNativeUint16(Utility::Get(handles, i)));
+        }
+    }
+    catch (std::string error)
+    {
+        delete baton;
+        v8::Local<v8::String> message = ErrorMessage::getStructErrorMessage("handles", error);
+        Nan::ThrowTypeError(message);
+        return;
+    }
+
+    queueCommand<GattsGetValues, AfterGattsGetValues>(baton, "gattsGetValues");
+}
+
+// This runs in a worker thread (not Main Thread)
+void Adapter::GattsGetValues(uv_work_t *req)
+{
+    auto baton = static_cast<GattsGetValuesBaton *>(req->data);
+    auto jsAdapter = baton->owner;
+
+    // Room for the longest value of each handle, so that the values are read in place
+    auto capacity = std::max<size_t>(baton->handles.size(), 1) * BLE_GATTS_VAR_ATTR_LEN_MAX;
+    baton->data = static_cast<uint8_t *>(malloc(capacity));
+
+    if (baton->data == nullptr)
+    {
+        baton->result = NRF_ERROR_NO_MEM;
+        return;
+    }
+
+    baton->result = NRF_SUCCESS;
+
+    for (auto handle : baton->handles)
+    {
+        ble_gatts_value_t value;
+        value.len = BLE_GATTS_VAR_ATTR_LEN_MAX;
+        value.offset = 0;
+        value.p_value = baton->data + baton->length;
+
+        uint32_t generation = 0;
+
+        if (jsAdapter == nullptr || !jsAdapter->gattServer.readValue(baton->conn_handle, handle, value, generation))
+        {
+            baton->result = sd_ble_gatts_value_get(baton->adapter, baton->conn_handle, handle, &value);
+
+            if (baton->result != NRF_SUCCESS)
+            {
+                return;
+            }
+
+            if (jsAdapter != nullptr)
+            {
+                jsAdapter->gattServer.mirrorValue(baton->conn_handle, handle, BLE_GATTS_VAR_ATTR_LEN_MAX, value, generation);
+            }
+        }
+
+        baton->offsets.push_back(static_cast<uint32_t>(baton->length));
+        baton->length += value.len;
+    }
+
+    // The Buffer keeps the whole block alive, release the room that was not used
+    auto data = static_cast<uint8_t *>(realloc(baton->data, std::max<size_t>(baton->length, 1)));
+
+    if (data != nullptr)
+    {
+        baton->data = data;
+    }
+}
+
+// This runs in Main Thread
+void Adapter::AfterGattsGetValues(uv_work_t *req)
+{
+    Nan::HandleScope scope;
+
+    auto baton = static_cast<GattsGetValuesBaton *>(req->data);
+    v8::Local<v8::Value> argv[2];
+
+    if (baton->result != NRF_SUCCESS)
+    {
+        argv[0] = ErrorMessage::getErrorMessage(baton->result, "getting values");
+        argv[1] = Nan::Undefined();
+    }
+    else
+    {
+        auto offsets = Nan::New<v8::Array>(static_cast<uint32_t>(baton->offsets.size()));
+
+        for (uint32_t i = 0; i < baton->offsets.size(); i++)
+        {
+            Nan::Set(offsets, i, Nan::New<v8::Number>(baton->offsets[i]));
+        }
+
+        // The Buffer takes over the memory the values were read into
+        auto data = Nan::NewBuffer(reinterpret_cast<char *>(baton->data), static_cast<uint32_t>(baton->length)).ToLocalChecked();
+        baton->data = nullptr;
+
+        auto values = Nan::New<v8::Object>();
+        Utility::Set(values, "data", data);
+        Utility::Set(values, "offsets", offsets);
+
+        argv[0] = Nan::Undefined();
+        argv[1] = values;
+    }
+
+    Nan::AsyncResource resource("pc-ble-driver-js:callback");
+    baton->callback->Call(2, argv, &resource);
+    delete baton;
+}
+
 NAN_METHOD(Adapter::GattsReplyReadWriteAuthorize)
 {
     auto obj = Nan::ObjectWrap::Unwrap<Adapter>(info.Holder());
@@ -1004,7 +2069,7 @@ NAN_METHOD(Adapter::GattsReplyReadWriteAuthorize)
         return;
     }
 
-    uv_queue_work(uv_default_loop(), baton->req, GattsReplyReadWriteAuthorize, reinterpret_cast<uv_after_work_cb>(AfterGattsReplyReadWriteAuthorize));
+    queueCommand<GattsReplyReadWriteAuthorize, AfterGattsReplyReadWriteAuthorize>(baton, "gattsReplyReadWriteAuthorize");
 }
 
 // This runs in a worker thread (not Main Thread)
@@ -1012,6 +2077,13 @@ void Adapter::GattsReplyReadWriteAuthorize(uv_work_t *req)
 {
     auto baton = static_cast<GattsReplyReadWriteAuthorizeBaton *>(req->data);
     baton->result = sd_ble_gatts_rw_authorize_reply(baton->adapter, baton->conn_handle, baton->p_rw_authorize_reply_params);
+
+    auto jsAdapter = baton->owner;
+
+    if (baton->result == NRF_SUCCESS && jsAdapter != nullptr)
+    {
+        jsAdapter->gattServer.onAuthorizeReply(baton->conn_handle, *baton->p_rw_authorize_reply_params);
+    }
 }
 
 // This runs in Main Thread
@@ -1068,7 +2140,7 @@ NAN_METHOD(Adapter::GattsExchangeMtuReply)
     baton->conn_handle = conn_handle;
     baton->server_rx_mtu = server_rx_mtu;
 
-    uv_queue_work(uv_default_loop(), baton->req, GattsExchangeMtuReply, reinterpret_cast<uv_after_work_cb>(AfterGattsExchangeMtuReply));
+    queueCommand<GattsExchangeMtuReply, AfterGattsExchangeMtuReply>(baton, "gattsExchangeMtuReply");
 }
 
 // This runs in a worker thread (not Main Thread)
@@ -39,6 +39,10 @@
 
 #include "common.h"
 #include "ble_gatts.h"
+#include "gatt_server.h"
+
+#include <memory>
+#include <vector>
 
 static name_map_t gatts_event_name_map =
 {
@@ -298,6 +302,34 @@ public:
     ble_gatts_hvx_params_t *p_hvx_params;
 };
 
+struct GattsQueueNotificationBaton : public Baton
+{
+public:
+    BATON_CONSTRUCTOR(GattsQueueNotificationBaton);
+    uint16_t conn_handle;
+    GattServer *gattServer;
+    std::unique_ptr<GattNotification> notification;
+};
+
+struct GattsQueueIndicationBaton : public Baton
+{
+public:
+    BATON_CONSTRUCTOR(GattsQueueIndicationBaton);
+    uint16_t conn_handle;
+    GattServer *gattServer;
+    std::unique_ptr<GattIndication> indication;
+};
+
+struct GattsNotifyAllBaton : public Baton
+{
+public:
+    BATON_CONSTRUCTOR(GattsNotifyAllBaton);
+    GattServer *gattServer;
+    uint16_t value_handle;
+    std::vector<uint8_t> value;
+    std::shared_ptr<Nan::Callback> notify_callback;
+};
+
 struct GattsSystemAttributeSetBaton : public Baton
 {
 public:
@@ -337,6 +369,42 @@ public:
     ble_gatts_value_t *p_value;
 };
 
+// Value of gattsSetValues, pointing into a Buffer or into a copy of an array of numbers
+struct GattsValueWrite
+{
+public:
+    uint16_t handle;
+    uint16_t offset;
+    const uint8_t *data;
+    uint16_t length;
+};
+
+struct GattsSetValuesBaton : public Baton
+{
+public:
+    BATON_CONSTRUCTOR(GattsSetValuesBaton);
+    uint16_t conn_handle;
+    std::vector<GattsValueWrite> writes;
+    std::vector<std::vector<uint8_t>> copies;
+    // Keeps the Buffers the writes point into alive until the baton is deleted in Main Thread.
+    // Their contents are not copied, JavaScript must not change them before the callback.
+    std::vector<std::unique_ptr<Nan::Global<v8::Object>>> buffers;
+    std::vector<uint32_t> results;
+};
+
+struct GattsGetValuesBaton : public Baton
+{
+public:
+    GattsGetValuesBaton(v8::Local<v8::Function> callback) : Baton(callback), data(nullptr), length(0) {}
+    BATON_DESTRUCTOR(GattsGetValuesBaton) { free(data); }
+    uint16_t conn_handle;
+    std::vector<uint16_t> handles;
+    // The values one after the other, handed over to a Buffer
+    uint8_t *data;
+    size_t length;
+    std::vector<uint32_t> offsets;
+};
+
 struct GattsReplyReadWriteAuthorizeBaton : public Baton
 {
 public:
@@ -346,6 +414,58 @@ public:
     ble_gatts_rw_authorize_reply_params_t *p_rw_authorize_reply_params;
 };
 
+// Attribute of gattsBuildTable. The UUID is resolved in the worker thread,
+// where the bases of vendor specific UUIDs are registered as needed.
+struct GattsTableAttribute
+{
+public:
+    GattsTableAttribute();
+
+    // Points into the members, valid as long as the attribute is
+    ble_gatts_attr_t toNative();
+
+    std::vector<uint8_t> uuid_le;
+    ble_uuid_t uuid;
+    std::unique_ptr<ble_gatts_attr_md_t> attr_md;
+    uint16_t init_len;
+    uint16_t init_offs;
+    uint16_t max_len;
+    std::vector<uint8_t> value;
+    // Descriptors only, the handle given by the SoftDevice
+    uint16_t handle;
+};
+
+struct GattsTableCharacteristic
+{
+public:
+    GattsTableCharacteristic();
+    ~GattsTableCharacteristic();
+
+    ble_gatts_char_md_t *p_char_md;
+    GattsTableAttribute value;
+    std::vector<GattsTableAttribute> descriptors;
+    ble_gatts_char_handles_t handles;
+};
+
+struct GattsTableService
+{
+public:
+    uint8_t type;
+    std::vector<uint8_t> uuid_le;
+    ble_uuid_t uuid;
+    uint16_t handle;
+    std::vector<std::unique_ptr<GattsTableCharacteristic>> characteristics;
+};
+
+struct GattsBuildTableBaton : public Baton
+{
+public:
+    BATON_CONSTRUCTOR(GattsBuildTableBaton);
+    std::vector<GattsTableService> services;
+    // Bases of vendor specific UUIDs registered while building the table, and their UUID types
+    std::vector<std::pair<ble_uuid128_t, uint8_t>> vendor_uuids;
+};
+
 #if NRF_SD_BLE_API_VERSION >= 5
 struct GattsExchangeMtuReplyBaton : public Baton
 {
@@ -0,0 +1,1635 @@
+/* Copyright (c) 2010 - 2017, Nordic Semiconductor ASA
+ *
+ * All rights reserved.
+ *
+ * Use in source and binary forms, redistribution in binary form only, with
+ * or without modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions in binary form, except as embedded into a Nordic
+ *    Semiconductor ASA integrated circuit in a product or a software update for
+ *    such product, must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other
+ *    materials provided with the distribution.
+ *
+ * 2. Neither the name of Nordic Semiconductor ASA nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * 3. This software, with or without modification, must only be used with a Nordic
+ *    Semiconductor ASA integrated circuit.
+ *
+ * 4. Any software provided in binary form under this license must not be reverse
+ *    engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY NORDIC SEMICONDUCTOR ASA "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NORDIC SEMICONDUCTOR ASA OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+ * TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "gatt_client.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <type_traits>
+
+#include "ble_err.h"
+#include "driver_gattc.h"
+
+// This compilation unit will be linked several times. So the helpers must
+// not have external linkage.
+namespace {
+    const uint16_t UUID_PRIMARY_SERVICE = 0x2800;
+    const uint16_t UUID_SECONDARY_SERVICE = 0x2801;
+    const uint16_t UUID_CHARACTERISTIC = 0x2803;
+
+    const size_t NO_CHARACTERISTIC = static_cast<size_t>(-1);
+
+    // Returned for write commands when the SoftDevice has no room for more packets
+#if NRF_SD_BLE_API_VERSION <= 3
+    const uint32_t TX_QUEUE_FULL = BLE_ERROR_NO_TX_PACKETS;
+#else
+    const uint32_t TX_QUEUE_FULL = NRF_ERROR_RESOURCES;
+#endif
+
+    std::string uuid16ToString(uint16_t uuid)
+    {
+        std::ostringstream stream;
+        stream.width(4);
+        stream.fill('0');
+        stream << std::hex << std::uppercase << uuid;
+        return stream.str();
+    }
+
+    // Same format as HexConv.arrayTo128BitUuid in JavaScript
+    std::string uuidLeToString(const uint8_t *uuid, size_t length)
+    {
+        static const char digits[] = "0123456789ABCDEF";
+        std::string uuidString;
+
+        for (auto i = length; i > 0; i--)
+        {
+            uuidString.push_back(digits[uuid[i - 1] >> 4]);
+            uuidString.push_back(digits[uuid[i - 1] & 0x0F]);
+        }
+
+        return uuidString;
+    }
+
+    v8::Local<v8::Value> gattErrorToJs(uint32_t result, uint16_t gattStatus, const std::string &operation)
+    {
+        Nan::EscapableHandleScope scope;
+
+        if (result != NRF_SUCCESS)
+        {
+            return scope.Escape(ErrorMessage::getErrorMessage(result, operation));
+        }
+
+        auto statusName = ConversionUtility::valueToString(gattStatus, gatt_status_map, "Unknown GATT status");
+
+        std::ostringstream errorStringStream;
+        errorStringStream << "Error occured when " << operation << ". "
+            << "GATT status: " << statusName << " (0x" << std::hex << gattStatus << ")";
+
+        v8::Local<v8::Value> error = Nan::Error(errorStringStream.str().c_str());
+        v8::Local<v8::Object> errorObject = error.As<v8::Object>();
+
+        Utility::Set(errorObject, "gatt_status", gattStatus);
+        Utility::Set(errorObject, "gatt_status_name", statusName);
+        Utility::Set(errorObject, "erroperation", ConversionUtility::toJsString(operation));
+        Utility::Set(errorObject, "errmsg", ConversionUtility::toJsString(errorStringStream.str()));
+
+        return scope.Escape(error);
+    }
+
+    struct ResumeWork
+    {
+        uv_work_t req;
+        GattClient *gattClient;
+        adapter_t *adapter;
+    };
+
+    // This runs in a worker thread (not Main Thread)
+    void resume_work(uv_work_t *req)
+    {
+        auto work = static_cast<ResumeWork *>(req->data);
+        work->gattClient->issuePendingOperations(work->adapter);
+    }
+
+    // This runs in Main Thread
+    void resume_after(uv_work_t *req, int status)
+    {
+        delete static_cast<ResumeWork *>(req->data);
+    }
+
+    std::remove_pointer<uv_async_cb>::type completion_handler;
+    void completion_handler(uv_async_t *handle)
+    {
+        auto gattClient = static_cast<GattClient *>(handle->data);
+
+        if (gattClient != nullptr)
+        {
+            gattClient->onCompletion();
+        }
+    }
+}
+
+GattDiscovery::GattDiscovery(std::shared_ptr<Nan::Callback> callback) :
+    callback(callback),
+    database(std::make_shared<GattDatabase>()),
+    stage(Stage::Services),
+    expectedEvent(BLE_GATTC_EVT_PRIM_SRVC_DISC_RSP),
+    nextHandle(1),
+    serviceIndex(0),
+    characteristicIndex(0)
+{
+    database->hashHandle = 0;
+}
+
+GattReadManyAttribute::GattReadManyAttribute(uint16_t handle, uint16_t length) :
+    handle(handle),
+    length(length)
+{
+}
+
+GattOperationGroup::GattOperationGroup(size_t count, std::shared_ptr<Nan::Callback> callback) :
+    results(count, NRF_SUCCESS),
+    gattStatuses(count, BLE_GATT_STATUS_SUCCESS),
+    remaining(count),
+    callback(callback)
+{
+}
+
+GattOperation::GattOperation(Type type, std::shared_ptr<Nan::Callback> callback) :
+    type(type),
+    handle(0),
+    offset(0),
+    writeOp(BLE_GATT_OP_INVALID),
+    flags(0),
+    gattStatus(BLE_GATT_STATUS_SUCCESS),
+    chunkSize(0),
+    bytesQueued(0),
+    nextAttribute(0),
+    readCount(0),
+    groupIndex(0),
+    callback(callback)
+{
+}
+
+bool GattOperation::isCommand() const
+{
+    return type == Type::WriteStream || (type == Type::Write && writeOp == BLE_GATT_OP_WRITE_CMD);
+}
+
+GattRequest::GattRequest() :
+    type(Type::Read),
+    handle(0),
+    offset(0)
+{
+    memset(&writeParams, 0, sizeof(writeParams));
+}
+
+GattOperationQueue::GattOperationQueue() :
+    otherRequests(0),
+    txQueueFull(false),
+    txCompleteCount(0),
+    issuing(false)
+{
+}
+
+NotificationBatch::NotificationBatch() :
+    dropped(0)
+{
+}
+
+NotificationBuffer::NotificationBuffer(size_t capacity) :
+    ring(capacity),
+    head(0),
+    size(0),
+    dropped(0)
+{
+}
+
+void NotificationBuffer::push(const uint8_t *data, uint16_t length, double timestamp)
+{
+    auto capacity = ring.size();
+
+    if (length > capacity)
+    {
+        dropped++;
+        return;
+    }
+
+    while (size + length > capacity)
+    {
+        auto &oldest = entries.front();
+        head = (head + oldest.length) % capacity;
+        size -= oldest.length;
+        entries.pop_front();
+        dropped++;
+    }
+
+    auto tail = (head + size) % capacity;
+    auto firstPart = std::min<size_t>(length, capacity - tail);
+
+    std::copy(data, data + firstPart, ring.begin() + tail);
+    std::copy(data + firstPart, data + length, ring.begin());
+
+    size += length;
+    entries.push_back({ length, timestamp });
+}
+
+void NotificationBuffer::drain(NotificationBatch &batch)
+{
+    auto capacity = ring.size();
+    auto firstPart = std::min<size_t>(size, capacity - head);
+
+    batch.data.assign(ring.begin() + head, ring.begin() + head + firstPart);
+    batch.data.insert(batch.data.end(), ring.begin(), ring.begin() + (size - firstPart));
+
+    batch.offsets.clear();
+    batch.timestamps.clear();
+
+    uint32_t offset = 0;
+
+    for (auto &entry : entries)
+    {
+        batch.offsets.push_back(offset);
+        batch.timestamps.push_back(entry.timestamp);
+        offset += entry.length;
+    }
+
+    batch.dropped = dropped;
+
+    head = 0;
+    size = 0;
+    entries.clear();
+    dropped = 0;
+}
+
+void AttributeIndex::set(uint16_t handle, const std::string &instanceId)
+{
+    auto entry = std::lower_bound(entries.begin(), entries.end(), handle,
+        [](const std::pair<uint16_t, std::string> &entry, uint16_t handle) { return entry.first < handle; });
+
+    if (entry != entries.end() && entry->first == handle)
+    {
+        entry->second = instanceId;
+    }
+    else
+    {
+        entries.insert(entry, std::make_pair(handle, instanceId));
+    }
+}
+
+const std::string *AttributeIndex::find(uint16_t handle) const
+{
+    auto entry = std::lower_bound(entries.begin(), entries.end(), handle,
+        [](const std::pair<uint16_t, std::string> &entry, uint16_t handle) { return entry.first < handle; });
+
+    if (entry == entries.end() || entry->first != handle)
+    {
+        return nullptr;
+    }
+
+    return &entry->second;
+}
+
+GattClient::GattClient() : resumeNeeded(false), autoConfirmIndications(false), asyncCompletion(nullptr)
+{
+}
+
+GattClient::~GattClient()
+{
+}
+
+// This runs in Main Thread
+void GattClient::initCompletionHandling()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        // Vendor specific UUID types are assigned again when BLE is enabled
+        vendorUuidBases.clear();
+        resumeNeeded = false;
+    }
+
+    std::lock_guard<std::mutex> lock(completionMutex);
+
+    if (asyncCompletion != nullptr)
+    {
+        return;
+    }
+
+    asyncCompletion = new uv_async_t();
+    asyncCompletion->data = static_cast<void *>(this);
+
+    if (uv_async_init(uv_default_loop(), asyncCompletion, completion_handler) != 0)
+    {
+        std::cerr << "Not able to create a new GATT client completion handler." << std::endl;
+        std::terminate();
+    }
+}
+
+// This runs in Main Thread
+void GattClient::cleanUpV8Resources()
+{
+    std::map<uint16_t, std::unique_ptr<GattDiscovery>> abortedDiscoveries;
+    std::map<uint16_t, GattOperationQueue> abortedOperations;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        abortedDiscoveries.swap(discoveries);
+        abortedOperations.swap(operationQueues);
+        notificationBuffers.clear();
+    }
+
+    for (auto &discovery : abortedDiscoveries)
+    {
+        completeDiscovery(*discovery.second, NRF_ERROR_INVALID_STATE, BLE_GATT_STATUS_SUCCESS);
+    }
+
+    for (auto &queue : abortedOperations)
+    {
+        failOperations(queue.second, NRF_ERROR_INVALID_STATE);
+    }
+
+    // Call the completions that are queued, including the aborted procedures
+    onCompletion();
+
+    std::lock_guard<std::mutex> lock(completionMutex);
+
+    if (asyncCompletion != nullptr)
+    {
+        uv_close(reinterpret_cast<uv_handle_t *>(asyncCompletion), [](uv_handle_t *handle) {
+            delete reinterpret_cast<uv_async_t *>(handle);
+        });
+
+        asyncCompletion = nullptr;
+    }
+}
+
+// This runs in Main Thread
+void GattClient::indexAttributes(uint16_t connHandle, const std::vector<std::pair<uint16_t, std::string>> &attributes)
+{
+    auto &index = attributeIndexes[connHandle];
+
+    for (auto &attribute : attributes)
+    {
+        index.set(attribute.first, attribute.second);
+    }
+}
+
+// This runs in Main Thread
+void GattClient::clearAttributeIndex(uint16_t connHandle)
+{
+    attributeIndexes.erase(connHandle);
+}
+
+// This runs in Main Thread
+const std::string *GattClient::findAttribute(uint16_t connHandle, uint16_t handle) const
+{
+    auto index = attributeIndexes.find(connHandle);
+
+    if (index == attributeIndexes.end())
+    {
+        return nullptr;
+    }
+
+    return index->second.find(handle);
+}
+
+void GattClient::post(GattClientCompletion completion)
+{
+    std::lock_guard<std::mutex> lock(completionMutex);
+    completions.push_back(std::move(completion));
+
+    if (asyncCompletion != nullptr)
+    {
+        uv_async_send(asyncCompletion);
+    }
+}
+
+// This runs in Main Thread
+void GattClient::onCompletion()
+{
+    std::vector<GattClientCompletion> pending;
+
+    {
+        std::lock_guard<std::mutex> lock(completionMutex);
+        pending.swap(completions);
+    }
+
+    for (auto &completion : pending)
+    {
+        Nan::HandleScope scope;
+        completion();
+    }
+}
+
+bool GattClient::onEvent(adapter_t *adapter, const ble_evt_t *event)
+{
+    auto eventId = event->header.evt_id;
+
+    if (eventId == BLE_GAP_EVT_DISCONNECTED)
+    {
+        auto connHandle = event->evt.gap_evt.conn_handle;
+
+        std::lock_guard<std::mutex> lock(mutex);
+        auto discovery = discoveries.find(connHandle);
+
+        if (discovery != discoveries.end())
+        {
+            completeDiscovery(*discovery->second, BLE_ERROR_INVALID_CONN_HANDLE, BLE_GATT_STATUS_SUCCESS);
+            discoveries.erase(discovery);
+        }
+
+        auto queue = operationQueues.find(connHandle);
+
+        if (queue != operationQueues.end())
+        {
+            failOperations(queue->second, BLE_ERROR_INVALID_CONN_HANDLE);
+            operationQueues.erase(queue);
+        }
+
+        // The buffers must not collect the notifications of the next connection with the handle
+        auto first = std::make_pair(connHandle, static_cast<uint16_t>(0));
+        auto last = std::make_pair(connHandle, static_cast<uint16_t>(0xFFFF));
+        notificationBuffers.erase(notificationBuffers.lower_bound(first), notificationBuffers.upper_bound(last));
+
+        // JavaScript handles the disconnect as well
+        return false;
+    }
+
+#if NRF_SD_BLE_API_VERSION <= 3
+    if (eventId == BLE_EVT_TX_COMPLETE)
+    {
+        auto connHandle = event->evt.common_evt.conn_handle;
+
+        std::unique_lock<std::mutex> lock(mutex);
+        auto queue = operationQueues.find(connHandle);
+
+        if (queue != operationQueues.end())
+        {
+            queue->second.txQueueFull = false;
+            queue->second.txCompleteCount++;
+            issueOperations(adapter, connHandle, lock);
+        }
+
+        // JavaScript handles the event as well
+        return false;
+    }
+#endif
+
+    if (eventId < BLE_GATTC_EVT_BASE || eventId > BLE_GATTC_EVT_LAST)
+    {
+        return false;
+    }
+
+    auto gattcEvent = &event->evt.gattc_evt;
+
+    std::unique_lock<std::mutex> lock(mutex);
+
+    if (eventId == BLE_GATTC_EVT_HVX)
+    {
+        auto &hvx = gattcEvent->params.hvx;
+
+        if (hvx.type == BLE_GATT_HVX_INDICATION)
+        {
+            // The peer can send the next indication as soon as this one is confirmed
+            if (autoConfirmIndications)
+            {
+                lock.unlock();
+                auto result = sd_ble_gattc_hv_confirm(adapter, gattcEvent->conn_handle, hvx.handle);
+
+                if (result != NRF_SUCCESS)
+                {
+                    std::cerr << "Failed to confirm indication of handle " << hvx.handle << ", error code " << result << "." << std::endl;
+                }
+            }
+
+            // Indications are not buffered, JavaScript gets them as events
+            return false;
+        }
+
+        auto buffer = notificationBuffers.find(std::make_pair(gattcEvent->conn_handle, hvx.handle));
+
+        if (buffer == notificationBuffers.end())
+        {
+            return false;
+        }
+
+        auto now = std::chrono::steady_clock::now().time_since_epoch();
+        buffer->second.push(hvx.data, hvx.len, std::chrono::duration<double, std::milli>(now).count());
+
+        return true;
+    }
+
+    auto discovery = discoveries.find(gattcEvent->conn_handle);
+
+    if (eventId == BLE_GATTC_EVT_TIMEOUT)
+    {
+        if (discovery != discoveries.end())
+        {
+            completeDiscovery(*discovery->second, NRF_ERROR_TIMEOUT, BLE_GATT_STATUS_SUCCESS);
+            discoveries.erase(discovery);
+        }
+
+        // No more requests can be made on the connection
+        auto queue = operationQueues.find(gattcEvent->conn_handle);
+
+        if (queue != operationQueues.end())
+        {
+            failOperations(queue->second, NRF_ERROR_TIMEOUT);
+            operationQueues.erase(queue);
+        }
+
+        return false;
+    }
+
+    // Responses to requests made by others, i.e. from JavaScript while the
+    // procedure is waiting for the SoftDevice to accept its next request.
+    if (discovery == discoveries.end() || eventId != discovery->second->expectedEvent)
+    {
+        return onOperationEvent(adapter, gattcEvent, eventId, lock);
+    }
+
+    uint16_t gattStatus = BLE_GATT_STATUS_SUCCESS;
+    auto result = onDiscoveryEvent(adapter, gattcEvent, eventId, *discovery->second, gattStatus);
+
+    if (result != NRF_SUCCESS || gattStatus != BLE_GATT_STATUS_SUCCESS)
+    {
+        completeDiscovery(*discovery->second, result, gattStatus);
+        discoveries.erase(discovery);
+    }
+    else if (discovery->second->expectedEvent == 0)
+    {
+        completeDiscovery(*discovery->second, NRF_SUCCESS, BLE_GATT_STATUS_SUCCESS);
+        discoveries.erase(discovery);
+    }
+
+    // Operations queued during the discovery
+    if (discoveries.count(gattcEvent->conn_handle) == 0)
+    {
+        issueOperations(adapter, gattcEvent->conn_handle, lock);
+    }
+
+    return true;
+}
+
+// Called with the mutex held, it is released while the SoftDevice is called
+bool GattClient::onOperationEvent(adapter_t *adapter, const ble_gattc_evt_t *event, uint16_t eventId, std::unique_lock<std::mutex> &lock)
+{
+    auto connHandle = event->conn_handle;
+    auto queue = operationQueues.find(connHandle);
+
+    if (queue == operationQueues.end())
+    {
+        return false;
+    }
+
+#if NRF_SD_BLE_API_VERSION >= 5
+    if (eventId == BLE_GATTC_EVT_WRITE_CMD_TX_COMPLETE)
+    {
+        queue->second.txQueueFull = false;
+        queue->second.txCompleteCount++;
+        issueOperations(adapter, connHandle, lock);
+
+        // JavaScript handles the event as well
+        return false;
+    }
+#endif
+
+    // Responses to requests from JavaScript are handled by endRequest
+    if (!queue->second.outstanding || !isResponse(eventId, event))
+    {
+        return false;
+    }
+
+    auto operation = queue->second.outstanding;
+    auto result = NRF_SUCCESS;
+
+    // Long reads and writes keep the bearer until their last request is answered
+    if (continueOperation(*operation, eventId, event))
+    {
+        auto request = prepareRequest(*operation);
+
+        lock.unlock();
+        result = issueRequest(adapter, connHandle, request);
+        lock.lock();
+
+        if (result == NRF_SUCCESS)
+        {
+            return true;
+        }
+
+        queue = operationQueues.find(connHandle);
+
+        // Failed by a disconnect or a timeout meanwhile
+        if (queue == operationQueues.end() || queue->second.outstanding != operation)
+        {
+            return true;
+        }
+    }
+
+    queue->second.outstanding.reset();
+
+    std::vector<uint8_t> data;
+
+    if (operation->type == GattOperation::Type::Read || operation->type == GattOperation::Type::LongRead)
+    {
+        data.swap(operation->value);
+    }
+
+    completeOperation(*operation, result, operation->gattStatus, std::move(data));
+    issueOperations(adapter, connHandle, lock);
+
+    return true;
+}
+
+// Update an operation with the response to its request. Returns true if
+// the operation needs another request.
+bool GattClient::continueOperation(GattOperation &operation, uint16_t eventId, const ble_gattc_evt_t *event)
+{
+    auto failed = event->gatt_status != BLE_GATT_STATUS_SUCCESS;
+
+    switch (operation.type)
+    {
+        case GattOperation::Type::Read:
+        case GattOperation::Type::LongRead:
+        {
+            operation.gattStatus = event->gatt_status;
+
+            if (failed || eventId != BLE_GATTC_EVT_READ_RSP)
+            {
+                return false;
+            }
+
+            auto &response = event->params.read_rsp;
+            operation.value.insert(operation.value.end(), response.data, response.data + response.len);
+
+            // A full response means that the value may continue
+            return operation.type == GattOperation::Type::LongRead && response.len == operation.chunkSize;
+        }
+        case GattOperation::Type::LongWrite:
+            if (operation.writeOp == BLE_GATT_OP_PREP_WRITE_REQ)
+            {
+                if (failed)
+                {
+                    // Discard what the peer has prepared, the error is reported after that
+                    operation.gattStatus = event->gatt_status;
+                    operation.writeOp = BLE_GATT_OP_EXEC_WRITE_REQ;
+                    operation.flags = BLE_GATT_EXEC_WRITE_FLAG_PREPARED_CANCEL;
+                    return true;
+                }
+
+                operation.bytesQueued += std::min<size_t>(operation.chunkSize, operation.value.size() - operation.bytesQueued);
+
+                if (operation.bytesQueued >= operation.value.size())
+                {
+                    operation.writeOp = BLE_GATT_OP_EXEC_WRITE_REQ;
+                    operation.flags = BLE_GATT_EXEC_WRITE_FLAG_PREPARED_WRITE;
+                }
+
+                return true;
+            }
+
+            if (operation.flags == BLE_GATT_EXEC_WRITE_FLAG_PREPARED_WRITE)
+            {
+                operation.gattStatus = event->gatt_status;
+            }
+
+            return false;
+        case GattOperation::Type::ReadMany:
+            return continueReadMany(operation, eventId, event);
+        default:
+            operation.gattStatus = event->gatt_status;
+            return false;
+    }
+}
+
+bool GattClient::continueReadMany(GattOperation &operation, uint16_t eventId, const ble_gattc_evt_t *event)
+{
+    auto failed = event->gatt_status != BLE_GATT_STATUS_SUCCESS;
+    auto &attributes = operation.attributes;
+    auto first = attributes.begin() + operation.nextAttribute;
+    auto last = first + operation.readCount;
+
+    if (eventId == BLE_GATTC_EVT_CHAR_VALS_READ_RSP)
+    {
+        auto &response = event->params.char_vals_read_rsp;
+        size_t length = 0;
+
+        for (auto attribute = first; attribute != last; ++attribute)
+        {
+            length += attribute->length;
+        }
+
+        if (failed || response.len != length)
+        {
+            // The peer does not support Read Multiple, one of the attributes
+            // can not be read, or the lengths are wrong. Read the attributes
+            // one at a time to find out.
+            for (auto attribute = first; attribute != last; ++attribute)
+            {
+                attribute->length = 0;
+            }
+
+            return true;
+        }
+
+        // The values are concatenated, each of them as long as the caller said
+        auto values = response.values;
+
+        for (auto attribute = first; attribute != last; ++attribute)
+        {
+            attribute->value.assign(values, values + attribute->length);
+            values += attribute->length;
+        }
+
+        operation.nextAttribute += operation.readCount;
+        return operation.nextAttribute < attributes.size();
+    }
+
+    if (failed || eventId != BLE_GATTC_EVT_READ_RSP)
+    {
+        operation.gattStatus = event->gatt_status;
+        return false;
+    }
+
+    auto &response = event->params.read_rsp;
+    first->value.insert(first->value.end(), response.data, response.data + response.len);
+
+    // A full response means that the value may continue
+    if (response.len == operation.chunkSize && (first->length == 0 || first->value.size() < first->length))
+    {
+        return true;
+    }
+
+    operation.nextAttribute++;
+    return operation.nextAttribute < attributes.size();
+}
+
+// This runs in a worker thread (not Main Thread)
+void GattClient::queueOperation(adapter_t *adapter, uint16_t connHandle, GattOperation operation)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+
+    operationQueues[connHandle].pending.push_back(std::move(operation));
+    issueOperations(adapter, connHandle, lock);
+}
+
+// This runs in Main Thread
+void GattClient::beginRequest(uint16_t connHandle)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    operationQueues[connHandle].otherRequests++;
+}
+
+// This runs in Main Thread
+void GattClient::endRequest(uint16_t connHandle)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto queue = operationQueues.find(connHandle);
+
+    if (queue == operationQueues.end())
+    {
+        return;
+    }
+
+    if (queue->second.otherRequests > 0)
+    {
+        queue->second.otherRequests--;
+    }
+
+    resumeNeeded = true;
+}
+
+bool GattClient::isResponse(uint16_t eventId, const ble_gattc_evt_t *event)
+{
+    switch (eventId)
+    {
+        case BLE_GATTC_EVT_PRIM_SRVC_DISC_RSP:
+        case BLE_GATTC_EVT_REL_DISC_RSP:
+        case BLE_GATTC_EVT_CHAR_DISC_RSP:
+        case BLE_GATTC_EVT_DESC_DISC_RSP:
+        case BLE_GATTC_EVT_CHAR_VAL_BY_UUID_READ_RSP:
+        case BLE_GATTC_EVT_READ_RSP:
+        case BLE_GATTC_EVT_CHAR_VALS_READ_RSP:
+#if NRF_SD_BLE_API_VERSION >= 5
+        case BLE_GATTC_EVT_EXCHANGE_MTU_RSP:
+#endif
+            return true;
+        case BLE_GATTC_EVT_WRITE_RSP:
+            return event->params.write_rsp.write_op != BLE_GATT_OP_WRITE_CMD;
+        default:
+            return false;
+    }
+}
+
+// This runs in Main Thread
+void GattClient::resume(adapter_t *adapter)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        if (!resumeNeeded)
+        {
+            return;
+        }
+
+        resumeNeeded = false;
+    }
+
+    // The SoftDevice is not called in Main Thread
+    auto work = new ResumeWork();
+    work->req.data = static_cast<void *>(work);
+    work->gattClient = this;
+    work->adapter = adapter;
+
+    uv_queue_work(uv_default_loop(), &work->req, resume_work, resume_after);
+}
+
+// This runs in a worker thread (not Main Thread)
+void GattClient::issuePendingOperations(adapter_t *adapter)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+
+    // Queues are erased on disconnect while the mutex is released
+    std::vector<uint16_t> connHandles;
+
+    for (auto &queue : operationQueues)
+    {
+        connHandles.push_back(queue.first);
+    }
+
+    for (auto connHandle : connHandles)
+    {
+        issueOperations(adapter, connHandle, lock);
+    }
+}
+
+// Called with the mutex held. It is released while the SoftDevice is called.
+// The operation being issued is taken out of the queue meanwhile. Requests
+// are made outstanding before they are issued, so that their response is
+// recognized even if it arrives before the call returns. Queues are looked
+// up by connection handle, as they are erased on disconnect.
+void GattClient::issueOperations(adapter_t *adapter, uint16_t connHandle, std::unique_lock<std::mutex> &lock)
+{
+    auto queue = operationQueues.find(connHandle);
+
+    if (queue == operationQueues.end() || queue->second.issuing)
+    {
+        return;
+    }
+
+    queue->second.issuing = true;
+
+    while (!queue->second.pending.empty())
+    {
+        auto &front = queue->second.pending.front();
+
+        if (front.isCommand())
+        {
+            if (queue->second.txQueueFull)
+            {
+                break;
+            }
+        }
+        else if (queue->second.outstanding || queue->second.otherRequests > 0 || discoveries.count(connHandle) > 0)
+        {
+            break;
+        }
+
+        auto operation = std::make_shared<GattOperation>(std::move(front));
+        queue->second.pending.pop_front();
+
+        auto stream = operation->type == GattOperation::Type::WriteStream;
+        GattRequest request;
+
+        if (!stream)
+        {
+            request = prepareRequest(*operation);
+        }
+
+        if (!operation->isCommand())
+        {
+            queue->second.outstanding = operation;
+        }
+
+        auto txCompleteCount = queue->second.txCompleteCount;
+
+        // The call only uses the request, or the stream that is out of the queue meanwhile
+        lock.unlock();
+        auto result = stream ? issueStreamChunks(adapter, connHandle, *operation) : issueRequest(adapter, connHandle, request);
+        lock.lock();
+
+        queue = operationQueues.find(connHandle);
+
+        if (queue == operationQueues.end())
+        {
+            // Disconnected meanwhile, the queue failed the operations waiting in it
+            if (operation->isCommand())
+            {
+                completeOperation(*operation, (result == NRF_SUCCESS) ? NRF_SUCCESS : BLE_ERROR_INVALID_CONN_HANDLE, BLE_GATT_STATUS_SUCCESS, std::vector<uint8_t>());
+            }
+
+            return;
+        }
+
+        if (result == NRF_SUCCESS && !operation->isCommand())
+        {
+            // Answered by the response
+            continue;
+        }
+
+        if (!operation->isCommand())
+        {
+            if (queue->second.outstanding != operation)
+            {
+                // Already completed meanwhile
+                continue;
+            }
+
+            queue->second.outstanding.reset();
+        }
+
+        if (result == NRF_ERROR_BUSY)
+        {
+            // Request unknown to the queue, tried again when it is answered
+            queue->second.pending.push_front(std::move(*operation));
+            break;
+        }
+
+        if (result == TX_QUEUE_FULL && operation->isCommand())
+        {
+            queue->second.pending.push_front(std::move(*operation));
+
+            // Tried again right away if packets were sent while the mutex was released
+            if (queue->second.txCompleteCount == txCompleteCount)
+            {
+                // Issued again when the SoftDevice reports that packets are sent
+                queue->second.txQueueFull = true;
+                break;
+            }
+
+            continue;
+        }
+
+        completeOperation(*operation, result, BLE_GATT_STATUS_SUCCESS, std::vector<uint8_t>());
+    }
+
+    queue->second.issuing = false;
+}
+
+// Called with the mutex held
+GattRequest GattClient::prepareRequest(GattOperation &operation)
+{
+    GattRequest request;
+
+    if (operation.type == GattOperation::Type::Read)
+    {
+        request.type = GattRequest::Type::Read;
+        request.handle = operation.handle;
+        request.offset = operation.offset;
+        return request;
+    }
+
+    if (operation.type == GattOperation::Type::LongRead)
+    {
+        // Continue after what is read so far
+        request.type = GattRequest::Type::Read;
+        request.handle = operation.handle;
+        request.offset = static_cast<uint16_t>(operation.value.size());
+        return request;
+    }
+
+    if (operation.type == GattOperation::Type::ReadMany)
+    {
+        return prepareReadMany(operation);
+    }
+
+    request.type = GattRequest::Type::Write;
+
+    auto &writeParams = request.writeParams;
+    writeParams.write_op = operation.writeOp;
+    writeParams.flags = operation.flags;
+    writeParams.handle = operation.handle;
+
+    if (operation.type == GattOperation::Type::LongWrite)
+    {
+        if (operation.writeOp == BLE_GATT_OP_PREP_WRITE_REQ)
+        {
+            auto first = operation.value.begin() + operation.bytesQueued;
+            writeParams.offset = static_cast<uint16_t>(operation.bytesQueued);
+            request.value.assign(first, first + std::min<size_t>(operation.chunkSize, operation.value.size() - operation.bytesQueued));
+        }
+    }
+    else
+    {
+        writeParams.offset = operation.offset;
+        request.value = operation.value;
+    }
+
+    return request;
+}
+
+// Read Multiple the attributes of known length that fit in the response,
+// starting with the next attribute. If less than two fit, read the next
+// attribute on its own. Called with the mutex held.
+GattRequest GattClient::prepareReadMany(GattOperation &operation)
+{
+    auto &attributes = operation.attributes;
+    GattRequest request;
+    size_t length = 0;
+
+    // Each handle takes two bytes of the request
+    auto maxHandles = static_cast<size_t>(operation.chunkSize / 2);
+
+    for (auto i = operation.nextAttribute; i < attributes.size() && request.handles.size() < maxHandles; ++i)
+    {
+        auto &attribute = attributes[i];
+
+        if (attribute.length == 0 || length + attribute.length > operation.chunkSize)
+        {
+            break;
+        }
+
+        request.handles.push_back(attribute.handle);
+        length += attribute.length;
+    }
+
+    if (request.handles.size() < 2)
+    {
+        auto &attribute = attributes[operation.nextAttribute];
+        operation.readCount = 1;
+
+        // Continue after what is read so far
+        request.type = GattRequest::Type::Read;
+        request.handle = attribute.handle;
+        request.offset = static_cast<uint16_t>(attribute.value.size());
+        return request;
+    }
+
+    operation.readCount = request.handles.size();
+    request.type = GattRequest::Type::ReadMany;
+    return request;
+}
+
+// Called without the mutex held
+uint32_t GattClient::issueRequest(adapter_t *adapter, uint16_t connHandle, GattRequest &request)
+{
+    switch (request.type)
+    {
+        case GattRequest::Type::Read:
+            return sd_ble_gattc_read(adapter, connHandle, request.handle, request.offset);
+        case GattRequest::Type::ReadMany:
+            return sd_ble_gattc_char_values_read(adapter, connHandle, request.handles.data(), static_cast<uint16_t>(request.handles.size()));
+        default:
+            request.writeParams.len = static_cast<uint16_t>(request.value.size());
+            request.writeParams.p_value = request.value.data();
+            return sd_ble_gattc_write(adapter, connHandle, &request.writeParams);
+    }
+}
+
+// Returns TX_QUEUE_FULL or NRF_ERROR_BUSY if the stream has to wait before
+// it can continue. Called without the mutex held.
+uint32_t GattClient::issueStreamChunks(adapter_t *adapter, uint16_t connHandle, GattOperation &stream)
+{
+    auto bytesQueuedBefore = stream.bytesQueued;
+    uint32_t result = NRF_SUCCESS;
+
+    ble_gattc_write_params_t writeParams;
+    memset(&writeParams, 0, sizeof(writeParams));
+
+    writeParams.write_op = BLE_GATT_OP_WRITE_CMD;
+    writeParams.handle = stream.handle;
+
+    // Fill the TX queue of the SoftDevice, each write command sent frees up room for one more
+    while (stream.bytesQueued < stream.value.size())
+    {
+        auto length = std::min<size_t>(stream.chunkSize, stream.value.size() - stream.bytesQueued);
+
+        writeParams.len = static_cast<uint16_t>(length);
+        writeParams.p_value = stream.value.data() + stream.bytesQueued;
+
+        result = sd_ble_gattc_write(adapter, connHandle, &writeParams);
+
+        if (result != NRF_SUCCESS)
+        {
+            break;
+        }
+
+        stream.bytesQueued += length;
+    }
+
+    if (stream.bytesQueued != bytesQueuedBefore && stream.progressCallback)
+    {
+        auto progressCallback = stream.progressCallback;
+        auto bytesQueued = stream.bytesQueued;
+        auto bytesTotal = stream.value.size();
+
+        post([progressCallback, bytesQueued, bytesTotal]() {
+            v8::Local<v8::Value> argv[2];
+            argv[0] = Nan::New<v8::Number>(static_cast<double>(bytesQueued));
+            argv[1] = Nan::New<v8::Number>(static_cast<double>(bytesTotal));
+
+            Nan::AsyncResource resource("pc-ble-driver-js:callback");
+            progressCallback->Call(2, argv, &resource);
+        });
+    }
+
+    return result;
+}
+
+void GattClient::completeOperation(GattOperation &operation, uint32_t result, uint16_t gattStatus, std::vector<uint8_t> data)
+{
+    auto callback = operation.callback;
+    auto type = operation.type;
+    auto bytesQueued = operation.bytesQueued;
+    std::vector<GattReadManyAttribute> attributes;
+    attributes.swap(operation.attributes);
+    auto group = operation.group;
+    auto groupIndex = operation.groupIndex;
+
+    // The callbacks must be released in Main Thread
+    operation.callback.reset();
+    operation.progressCallback.reset();
+    operation.group.reset();
+
+    post([callback, type, result, gattStatus, data, bytesQueued, attributes, group, groupIndex]() {
+        v8::Local<v8::Value> argv[2];
+
+        if (group)
+        {
+            group->results[groupIndex] = result;
+            group->gattStatuses[groupIndex] = gattStatus;
+
+            if (--group->remaining > 0)
+            {
+                return;
+            }
+
+            // Undefined for the operations that succeeded
+            auto results = Nan::New<v8::Array>(static_cast<uint32_t>(group->results.size()));
+
+            for (uint32_t i = 0; i < group->results.size(); i++)
+            {
+                if (group->results[i] != NRF_SUCCESS || group->gattStatuses[i] != BLE_GATT_STATUS_SUCCESS)
+                {
+                    Nan::Set(results, i, gattErrorToJs(group->results[i], group->gattStatuses[i], "writing"));
+                }
+                else
+                {
+                    Nan::Set(results, i, Nan::Undefined());
+                }
+            }
+
+            argv[0] = Nan::Undefined();
+            argv[1] = results;
+
+            Nan::AsyncResource resource("pc-ble-driver-js:callback");
+            group->callback->Call(2, argv, &resource);
+            return;
+        }
+
+        if (result != NRF_SUCCESS || gattStatus != BLE_GATT_STATUS_SUCCESS)
+        {
+            auto reading = type != GattOperation::Type::Write && type != GattOperation::Type::WriteStream && type != GattOperation::Type::LongWrite;
+            argv[0] = gattErrorToJs(result, gattStatus, reading ? "reading" : "writing");
+            argv[1] = Nan::Undefined();
+        }
+        else if (type == GattOperation::Type::WriteStream)
+        {
+            argv[0] = Nan::Undefined();
+            argv[1] = Nan::New<v8::Number>(static_cast<double>(bytesQueued));
+        }
+        else if (type == GattOperation::Type::Read || type == GattOperation::Type::LongRead)
+        {
+            argv[0] = Nan::Undefined();
+            argv[1] = ConversionUtility::toJsValueArray(data.data(), static_cast<uint16_t>(data.size()));
+        }
+        else if (type == GattOperation::Type::ReadMany)
+        {
+            auto values = Nan::New<v8::Object>();
+
+            for (auto &attribute : attributes)
+            {
+                Nan::Set(values, Nan::New<v8::Number>(attribute.handle), ConversionUtility::toJsValueArray(attribute.value.data(), static_cast<uint16_t>(attribute.value.size())));
+            }
+
+            argv[0] = Nan::Undefined();
+            argv[1] = values;
+        }
+        else
+        {
+            argv[0] = Nan::Undefined();
+            argv[1] = Nan::Undefined();
+        }
+
+        Nan::AsyncResource resource("pc-ble-driver-js:callback");
+        callback->Call(2, argv, &resource);
+    });
+}
+
+void GattClient::failOperations(GattOperationQueue &queue, uint32_t result)
+{
+    if (queue.outstanding)
+    {
+        completeOperation(*queue.outstanding, result, BLE_GATT_STATUS_SUCCESS, std::vector<uint8_t>());
+        queue.outstanding.reset();
+    }
+
+    for (auto &operation : queue.pending)
+    {
+        completeOperation(operation, result, BLE_GATT_STATUS_SUCCESS, std::vector<uint8_t>());
+    }
+
+    queue.pending.clear();
+}
+
+// This runs in a worker thread (not Main Thread)
+void GattClient::setAutoConfirmIndications(bool enabled)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    autoConfirmIndications = enabled;
+}
+
+// This runs in Main Thread
+void GattClient::startNotificationBuffer(uint16_t connHandle, uint16_t handle, size_t capacity)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto key = std::make_pair(connHandle, handle);
+    notificationBuffers.erase(key);
+    notificationBuffers.emplace(key, NotificationBuffer(capacity));
+}
+
+// This runs in Main Thread
+void GattClient::stopNotificationBuffer(uint16_t connHandle, uint16_t handle)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    notificationBuffers.erase(std::make_pair(connHandle, handle));
+}
+
+// This runs in Main Thread
+bool GattClient::drainNotificationBuffer(uint16_t connHandle, uint16_t handle, NotificationBatch &batch)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto buffer = notificationBuffers.find(std::make_pair(connHandle, handle));
+
+    if (buffer == notificationBuffers.end())
+    {
+        return false;
+    }
+
+    buffer->second.drain(batch);
+    return true;
+}
+
+// This runs in a worker thread (not Main Thread)
+uint32_t GattClient::discoverAll(adapter_t *adapter, uint16_t connHandle, std::shared_ptr<Nan::Callback> callback)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (discoveries.find(connHandle) != discoveries.end())
+    {
+        return NRF_ERROR_BUSY;
+    }
+
+    std::unique_ptr<GattDiscovery> discovery(new GattDiscovery(callback));
+    auto result = continueDiscovery(adapter, connHandle, *discovery);
+
+    if (result == NRF_SUCCESS)
+    {
+        discoveries[connHandle] = std::move(discovery);
+    }
+
+    return result;
+}
+
+// Issue the next request of the discovery. Sets expectedEvent to 0 when
+// the whole attribute table has been discovered.
+uint32_t GattClient::continueDiscovery(adapter_t *adapter, uint16_t connHandle, GattDiscovery &discovery)
+{
+    auto &services = discovery.database->services;
+
+    if (!discovery.unknownUuids.empty())
+    {
+        discovery.expectedEvent = BLE_GATTC_EVT_READ_RSP;
+        return sd_ble_gattc_read(adapter, connHandle, discovery.unknownUuids.front().handle, 0);
+    }
+
+    if (discovery.stage == GattDiscovery::Stage::Services)
+    {
+        discovery.expectedEvent = BLE_GATTC_EVT_PRIM_SRVC_DISC_RSP;
+        return sd_ble_gattc_primary_services_discover(adapter, connHandle, static_cast<uint16_t>(discovery.nextHandle), nullptr);
+    }
+
+    if (discovery.stage == GattDiscovery::Stage::Characteristics)
+    {
+        while (discovery.serviceIndex < services.size())
+        {
+            auto &service = services[discovery.serviceIndex];
+
+            if (discovery.nextHandle == 0)
+            {
+                discovery.nextHandle = service.startHandle;
+            }
+
+            if (discovery.nextHandle <= service.endHandle)
+            {
+                ble_gattc_handle_range_t range;
+                range.start_handle = static_cast<uint16_t>(discovery.nextHandle);
+                range.end_handle = service.endHandle;
+
+                discovery.expectedEvent = BLE_GATTC_EVT_CHAR_DISC_RSP;
+                return sd_ble_gattc_characteristics_discover(adapter, connHandle, &range);
+            }
+
+            service.characteristicsDiscovered = true;
+            discovery.serviceIndex++;
+            discovery.nextHandle = 0;
+        }
+
+        discovery.stage = GattDiscovery::Stage::Descriptors;
+        discovery.serviceIndex = 0;
+        discovery.characteristicIndex = 0;
+        discovery.nextHandle = 0;
+    }
+
+    while (discovery.serviceIndex < services.size())
+    {
+        auto &service = services[discovery.serviceIndex];
+        auto &characteristics = service.characteristics;
+
+        while (discovery.characteristicIndex < characteristics.size())
+        {
+            auto &characteristic = characteristics[discovery.characteristicIndex];
+
+            // Descriptors are found between the value and the next characteristic declaration
+            uint32_t endHandle = service.endHandle;
+
+            if (discovery.characteristicIndex + 1 < characteristics.size())
+            {
+                endHandle = characteristics[discovery.characteristicIndex + 1].declarationHandle - 1u;
+            }
+
+            if (discovery.nextHandle == 0)
+            {
+                discovery.nextHandle = characteristic.valueHandle + 1u;
+            }
+
+            if (discovery.nextHandle <= endHandle)
+            {
+                ble_gattc_handle_range_t range;
+                range.start_handle = static_cast<uint16_t>(discovery.nextHandle);
+                range.end_handle = static_cast<uint16_t>(endHandle);
+
+                discovery.expectedEvent = BLE_GATTC_EVT_DESC_DISC_RSP;
+                return sd_ble_gattc_descriptors_discover(adapter, connHandle, &range);
+            }
+
+            characteristic.descriptorsDiscovered = true;
+            discovery.characteristicIndex++;
+            discovery.nextHandle = 0;
+        }
+
+        discovery.serviceIndex++;
+        discovery.characteristicIndex = 0;
+    }
+
+    discovery.expectedEvent = 0;
+    return NRF_SUCCESS;
+}
+
+// Store the attributes of a response and continue with the next request.
+// Attribute Not Found ends a discovery step, other GATT errors are returned
+// in gattStatus.
+uint32_t GattClient::onDiscoveryEvent(adapter_t *adapter, const ble_gattc_evt_t *event, uint16_t eventId, GattDiscovery &discovery, uint16_t &gattStatus)
+{
+    auto &services = discovery.database->services;
+    auto notFound = event->gatt_status == BLE_GATT_STATUS_ATTERR_ATTRIBUTE_NOT_FOUND;
+
+    if (eventId != BLE_GATTC_EVT_READ_RSP && !notFound && event->gatt_status != BLE_GATT_STATUS_SUCCESS)
+    {
+        gattStatus = event->gatt_status;
+        return NRF_SUCCESS;
+    }
+
+    switch (eventId)
+    {
+        case BLE_GATTC_EVT_PRIM_SRVC_DISC_RSP:
+        {
+            auto response = &event->params.prim_srvc_disc_rsp;
+
+            if (notFound || response->count == 0)
+            {
+                discovery.stage = GattDiscovery::Stage::Characteristics;
+                discovery.nextHandle = 0;
+                break;
+            }
+
+            for (auto i = 0; i < response->count; i++)
+            {
+                GattDbService service;
+                service.startHandle = response->services[i].handle_range.start_handle;
+                service.endHandle = response->services[i].handle_range.end_handle;
+                service.characteristicsDiscovered = false;
+
+                if (!uuidToString(adapter, response->services[i].uuid, service.uuid))
+                {
+                    discovery.unknownUuids.push_back({ service.startHandle, services.size(), NO_CHARACTERISTIC });
+                }
+
+                services.push_back(service);
+            }
+
+            uint32_t lastEndHandle = response->services[response->count - 1].handle_range.end_handle;
+            discovery.nextHandle = lastEndHandle + 1;
+
+            if (discovery.nextHandle > 0xFFFF)
+            {
+                discovery.stage = GattDiscovery::Stage::Characteristics;
+                discovery.nextHandle = 0;
+            }
+
+            break;
+        }
+
+        case BLE_GATTC_EVT_CHAR_DISC_RSP:
+        {
+            auto response = &event->params.char_disc_rsp;
+            auto &service = services[discovery.serviceIndex];
+
+            if (notFound || response->count == 0)
+            {
+                discovery.nextHandle = service.endHandle + 1u;
+                break;
+            }
+
+            for (auto i = 0; i < response->count; i++)
+            {
+                GattDbCharacteristic characteristic;
+                characteristic.declarationHandle = response->chars[i].handle_decl;
+                characteristic.valueHandle = response->chars[i].handle_value;
+                characteristic.properties = response->chars[i].char_props;
+                characteristic.descriptorsDiscovered = false;
+
+                if (!uuidToString(adapter, response->chars[i].uuid, characteristic.uuid))
+                {
+                    discovery.unknownUuids.push_back({ characteristic.declarationHandle, discovery.serviceIndex, service.characteristics.size() });
+                }
+
+                service.characteristics.push_back(characteristic);
+            }
+
+            discovery.nextHandle = response->chars[response->count - 1].handle_decl + 1u;
+            break;
+        }
+
+        case BLE_GATTC_EVT_DESC_DISC_RSP:
+        {
+            auto response = &event->params.desc_disc_rsp;
+            auto &characteristic = services[discovery.serviceIndex].characteristics[discovery.characteristicIndex];
+
+            if (notFound || response->count == 0)
+            {
+                discovery.nextHandle = 0x10000;
+                break;
+            }
+
+            for (auto i = 0; i < response->count; i++)
+            {
+                auto &uuid = response->descs[i].uuid;
+
+                if (uuid.type == BLE_UUID_TYPE_BLE &&
+                    (uuid.uuid == UUID_PRIMARY_SERVICE || uuid.uuid == UUID_SECONDARY_SERVICE || uuid.uuid == UUID_CHARACTERISTIC))
+                {
+                    // Reached the next characteristic or service
+                    discovery.nextHandle = 0x10000;
+                    break;
+                }
+
+                GattDbDescriptor descriptor;
+                descriptor.handle = response->descs[i].handle;
+
+                // 128-bit descriptor UUIDs can not be read, they are left empty
+                uuidToString(adapter, uuid, descriptor.uuid);
+
+                characteristic.descriptors.push_back(descriptor);
+                discovery.nextHandle = descriptor.handle + 1u;
+            }
+
+            break;
+        }
+
+        case BLE_GATTC_EVT_READ_RSP:
+        {
+            auto response = &event->params.read_rsp;
+            auto unknownUuid = discovery.unknownUuids.front();
+            discovery.unknownUuids.erase(discovery.unknownUuids.begin());
+
+            // A failed read leaves the UUID empty
+            if (event->gatt_status != BLE_GATT_STATUS_SUCCESS)
+            {
+                break;
+            }
+
+            auto &service = services[unknownUuid.serviceIndex];
+
+            if (unknownUuid.characteristicIndex == NO_CHARACTERISTIC)
+            {
+                // Service declaration value is the service UUID
+                service.uuid = uuidLeToString(response->data, response->len);
+            }
+            else if (response->len > 3)
+            {
+                // Characteristic declaration value is properties, value handle and UUID
+                service.characteristics[unknownUuid.characteristicIndex].uuid = uuidLeToString(response->data + 3, response->len - 3);
+            }
+
+            break;
+        }
+
+        default:
+            break;
+    }
+
+    return continueDiscovery(adapter, event->conn_handle, discovery);
+}
+
+void GattClient::completeDiscovery(GattDiscovery &discovery, uint32_t result, uint16_t gattStatus)
+{
+    auto callback = discovery.callback;
+    auto database = discovery.database;
+
+    // The callback must be released in Main Thread
+    discovery.callback.reset();
+
+    post([callback, database, result, gattStatus]() {
+        v8::Local<v8::Value> argv[2];
+
+        if (result != NRF_SUCCESS || gattStatus != BLE_GATT_STATUS_SUCCESS)
+        {
+            argv[0] = gattErrorToJs(result, gattStatus, "discovering GATT database");
+            argv[1] = Nan::Undefined();
+        }
+        else
+        {
+            argv[0] = Nan::Undefined();
+            argv[1] = GattDb(database.get()).ToJs();
+        }
+
+        Nan::AsyncResource resource("pc-ble-driver-js:callback");
+        callback->Call(2, argv, &resource);
+    });
+}
+
+bool GattClient::uuidToString(adapter_t *adapter, const ble_uuid_t &uuid, std::string &uuidString)
+{
+    if (uuid.type == BLE_UUID_TYPE_BLE)
+    {
+        uuidString = uuid16ToString(uuid.uuid);
+        return true;
+    }
+
+    if (uuid.type < BLE_UUID_TYPE_VENDOR_BEGIN)
+    {
+        return false;
+    }
+
+    auto base = vendorUuidBases.find(uuid.type);
+
+    if (base == vendorUuidBases.end())
+    {
+        std::array<uint8_t, 16> uuidLe;
+        uint8_t length = 0;
+        ble_uuid_t encode = uuid;
+
+        if (sd_ble_uuid_encode(adapter, &encode, &length, uuidLe.data()) != NRF_SUCCESS || length != 16)
+        {
+            return false;
+        }
+
+        base = vendorUuidBases.insert(std::make_pair(uuid.type, uuidLe)).first;
+    }
+
+    // The 16-bit UUID is stored in octets 12 and 13 of the base
+    auto uuidLe = base->second;
+    uuidLe[12] = static_cast<uint8_t>(uuid.uuid & 0xFF);
+    uuidLe[13] = static_cast<uint8_t>(uuid.uuid >> 8);
+
+    uuidString = uuidLeToString(uuidLe.data(), uuidLe.size());
+    return true;
+}
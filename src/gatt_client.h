@@ -0,0 +1,371 @@
+/* Copyright (c) 2010 - 2017, Nordic Semiconductor ASA
+ *
+ * All rights reserved.
+ *
+ * Use in source and binary forms, redistribution in binary form only, with
+ * or without modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions in binary form, except as embedded into a Nordic
+ *    Semiconductor ASA integrated circuit in a product or a software update for
+ *    such product, must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other
+ *    materials provided with the distribution.
+ *
+ * 2. Neither the name of Nordic Semiconductor ASA nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * 3. This software, with or without modification, must only be used with a Nordic
+ *    Semiconductor ASA integrated circuit.
+ *
+ * 4. Any software provided in binary form under this license must not be reverse
+ *    engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY NORDIC SEMICONDUCTOR ASA "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NORDIC SEMICONDUCTOR ASA OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+ * TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef GATT_CLIENT_H
+#define GATT_CLIENT_H
+
+#include <nan.h>
+
+#include <array>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "sd_rpc.h"
+
+#include "common.h"
+#include "gatt_database.h"
+
+// Result of a native GATT client procedure, called in Main Thread
+typedef std::function<void()> GattClientCompletion;
+
+// Full discovery of the attribute table of a peer, see GattClient::discoverAll
+struct GattDiscovery
+{
+public:
+    enum class Stage { Services, Characteristics, Descriptors };
+
+    // Attribute with a UUID unknown to the SoftDevice, resolved by reading its declaration
+    struct UnknownUuid
+    {
+        uint16_t handle;
+        size_t serviceIndex;
+        // Index of the characteristic, or -1 for the service declaration
+        size_t characteristicIndex;
+    };
+
+    GattDiscovery(std::shared_ptr<Nan::Callback> callback);
+
+    std::shared_ptr<Nan::Callback> callback;
+    std::shared_ptr<GattDatabase> database;
+
+    Stage stage;
+    // Event the outstanding request is answered with
+    uint16_t expectedEvent;
+    // Start of the next handle range to discover, 0 for the start of the current service or characteristic
+    uint32_t nextHandle;
+    size_t serviceIndex;
+    size_t characteristicIndex;
+    std::vector<UnknownUuid> unknownUuids;
+};
+
+// Attribute of a read many operation. A length of 0 means that the length
+// of the value is not known, and the attribute is read on its own.
+struct GattReadManyAttribute
+{
+public:
+    GattReadManyAttribute(uint16_t handle, uint16_t length);
+
+    uint16_t handle;
+    uint16_t length;
+    std::vector<uint8_t> value;
+};
+
+// Operations queued together, on one or more connections, that call one
+// callback when all of them are done. The callback gets the result of each
+// operation, in the order of the operations. Only used in Main Thread.
+struct GattOperationGroup
+{
+public:
+    GattOperationGroup(size_t count, std::shared_ptr<Nan::Callback> callback);
+
+    std::vector<uint32_t> results;
+    std::vector<uint16_t> gattStatuses;
+    size_t remaining;
+    std::shared_ptr<Nan::Callback> callback;
+};
+
+// Read or write queued with GattClient::queueOperation
+struct GattOperation
+{
+public:
+    enum class Type { Read, Write, WriteStream, LongRead, LongWrite, ReadMany };
+
+    GattOperation(Type type, std::shared_ptr<Nan::Callback> callback);
+
+    // Write commands do not get a response and are not limited to one at a time
+    bool isCommand() const;
+
+    Type type;
+    uint16_t handle;
+    uint16_t offset;
+    // Write only, see ble_gattc_write_params_t. For long writes the ATT
+    // operation of the current request.
+    uint8_t writeOp;
+    uint8_t flags;
+    // Value to write, all data of a write stream, or the value read
+    std::vector<uint8_t> value;
+
+    // GATT status the operation completes with
+    uint16_t gattStatus;
+
+    // Write stream, long read and long write only. A write stream sends
+    // write commands of chunkSize bytes and reports progress once for each
+    // batch. A long read continues as long as the responses are chunkSize
+    // bytes, a long write prepares chunkSize bytes at a time. bytesQueued is
+    // the number of bytes accepted by the SoftDevice or prepared by the peer.
+    uint16_t chunkSize;
+    size_t bytesQueued;
+    std::shared_ptr<Nan::Callback> progressCallback;
+
+    // Read many only. Attributes of known length are read together with Read
+    // Multiple requests of up to chunkSize bytes, the others one at a time.
+    // nextAttribute is the first attribute not read yet, readCount the
+    // number of attributes in the outstanding request.
+    std::vector<GattReadManyAttribute> attributes;
+    size_t nextAttribute;
+    size_t readCount;
+
+    // Set for operations of a group, which report to the group instead of
+    // calling their own callback
+    std::shared_ptr<GattOperationGroup> group;
+    size_t groupIndex;
+
+    std::shared_ptr<Nan::Callback> callback;
+};
+
+// SoftDevice call making the next request of an operation. It is prepared
+// with the mutex held and issued without it, as the operation can be
+// completed by another thread meanwhile.
+struct GattRequest
+{
+public:
+    enum class Type { Read, ReadMany, Write };
+
+    GattRequest();
+
+    Type type;
+    // Read only
+    uint16_t handle;
+    uint16_t offset;
+    // Read many only
+    std::vector<uint16_t> handles;
+    // Write only, p_value points to value when the request is issued
+    ble_gattc_write_params_t writeParams;
+    std::vector<uint8_t> value;
+};
+
+// Operations of a connection waiting to be issued
+struct GattOperationQueue
+{
+public:
+    GattOperationQueue();
+
+    std::deque<GattOperation> pending;
+    // Request waiting for its response. It is shared with the thread calling
+    // the SoftDevice, as the response can arrive before the call returns.
+    std::shared_ptr<GattOperation> outstanding;
+    // Requests from JavaScript, issued outside of the queue, waiting for their response
+    uint32_t otherRequests;
+    // Write commands wait for the SoftDevice to report that packets are sent
+    bool txQueueFull;
+    // Packets reported sent, tells a thread that found the TX queue full
+    // while the mutex was released if room was made meanwhile
+    uint32_t txCompleteCount;
+    // A thread is issuing the operations, with the mutex released while it
+    // calls the SoftDevice. Others leave the queue to it to keep the order.
+    bool issuing;
+};
+
+// Attribute instance ids of a connection, sorted by attribute handle
+class AttributeIndex
+{
+public:
+    // Adds the instance id of a handle, or replaces the one already there
+    void set(uint16_t handle, const std::string &instanceId);
+
+    // Returns nullptr if the handle is not in the index
+    const std::string *find(uint16_t handle) const;
+
+private:
+    std::vector<std::pair<uint16_t, std::string>> entries;
+};
+
+// Notifications drained from a NotificationBuffer. The payloads are
+// concatenated in data, offsets has the start of each of them.
+struct NotificationBatch
+{
+public:
+    NotificationBatch();
+
+    std::vector<uint8_t> data;
+    std::vector<uint32_t> offsets;
+    // Milliseconds of a monotonic clock, when the notification was received
+    std::vector<double> timestamps;
+    // Notifications dropped since the previous drain, as the buffer was full
+    uint32_t dropped;
+};
+
+// Ring buffer of the notifications of a characteristic. When there is no
+// room for a notification, the oldest ones are dropped.
+class NotificationBuffer
+{
+public:
+    explicit NotificationBuffer(size_t capacity);
+
+    void push(const uint8_t *data, uint16_t length, double timestamp);
+
+    // Moves the buffered notifications to the batch and empties the buffer
+    void drain(NotificationBatch &batch);
+
+private:
+    struct Entry
+    {
+        uint16_t length;
+        double timestamp;
+    };
+
+    std::vector<uint8_t> ring;
+    // Index of the oldest byte and the number of bytes in the ring
+    size_t head;
+    size_t size;
+    std::deque<Entry> entries;
+    uint32_t dropped;
+};
+
+// Native GATT client procedures of an adapter. The procedures are driven
+// from the thread the driver delivers events on. Each response is answered
+// with the next request right away, without the round trip through the
+// event queue and JavaScript. Results are posted to Main Thread. The mutex
+// is released while operations are issued to the SoftDevice, so that event
+// delivery does not wait for the calls.
+class GattClient
+{
+public:
+    GattClient();
+    ~GattClient();
+
+    // Called in Main Thread when the adapter is opened and closed
+    void initCompletionHandling();
+    void cleanUpV8Resources();
+
+    // Called for every event from the driver before it is queued to JavaScript.
+    // Returns true if the event was consumed by a native procedure.
+    bool onEvent(adapter_t *adapter, const ble_evt_t *event);
+
+    // Discover all primary services, characteristics and descriptors of a
+    // peer. The callback gets the attribute table in the same format as the
+    // GATT cache (see GattDb). Runs in a worker thread.
+    uint32_t discoverAll(adapter_t *adapter, uint16_t connHandle, std::shared_ptr<Nan::Callback> callback);
+
+    // Queue a read, write, write stream or read many on a connection. The operations are
+    // issued in order. Requests wait for the response to the previous request,
+    // as ATT allows only one at a time, while write commands are issued as
+    // long as the SoftDevice has room for them. Each operation calls its own
+    // callback when done. Runs in a worker thread.
+    void queueOperation(adapter_t *adapter, uint16_t connHandle, GattOperation operation);
+
+    // Requests issued by JavaScript with the GATTC functions of the adapter.
+    // The queue holds back its requests from when a request is made until
+    // JavaScript has handled the response, or the SoftDevice did not accept
+    // the request. This gives procedures in JavaScript the chance to issue
+    // their next request first. Called in Main Thread, followed by resume.
+    void beginRequest(uint16_t connHandle);
+    void endRequest(uint16_t connHandle);
+
+    // Issue the operations held back by requests from JavaScript. Called in Main Thread.
+    void resume(adapter_t *adapter);
+    void issuePendingOperations(adapter_t *adapter);
+
+    // True for events answering a request, only one request can be outstanding on a connection
+    static bool isResponse(uint16_t eventId, const ble_gattc_evt_t *event);
+
+    // Index of the attributes JavaScript has discovered on a connection. The
+    // index is used to annotate GATTC events with the instance id of the
+    // attribute they are about. Called in Main Thread.
+    void indexAttributes(uint16_t connHandle, const std::vector<std::pair<uint16_t, std::string>> &attributes);
+    void clearAttributeIndex(uint16_t connHandle);
+    const std::string *findAttribute(uint16_t connHandle, uint16_t handle) const;
+
+    // Confirm indications as soon as they are received, instead of waiting
+    // for JavaScript to do it. JavaScript still gets the HVX events.
+    void setAutoConfirmIndications(bool enabled);
+
+    // Buffer the notifications of a characteristic value handle instead of
+    // passing each of them to JavaScript as an event. JavaScript drains the
+    // buffer in batches. Called in Main Thread.
+    void startNotificationBuffer(uint16_t connHandle, uint16_t handle, size_t capacity);
+    void stopNotificationBuffer(uint16_t connHandle, uint16_t handle);
+    bool drainNotificationBuffer(uint16_t connHandle, uint16_t handle, NotificationBatch &batch);
+
+    // Queue a completion to be called in Main Thread. Can be called from any thread.
+    void post(GattClientCompletion completion);
+
+    void onCompletion();
+
+private:
+    uint32_t continueDiscovery(adapter_t *adapter, uint16_t connHandle, GattDiscovery &discovery);
+    uint32_t onDiscoveryEvent(adapter_t *adapter, const ble_gattc_evt_t *event, uint16_t eventId, GattDiscovery &discovery, uint16_t &gattStatus);
+    void completeDiscovery(GattDiscovery &discovery, uint32_t result, uint16_t gattStatus);
+
+    bool onOperationEvent(adapter_t *adapter, const ble_gattc_evt_t *event, uint16_t eventId, std::unique_lock<std::mutex> &lock);
+    void issueOperations(adapter_t *adapter, uint16_t connHandle, std::unique_lock<std::mutex> &lock);
+    GattRequest prepareRequest(GattOperation &operation);
+    GattRequest prepareReadMany(GattOperation &operation);
+    uint32_t issueRequest(adapter_t *adapter, uint16_t connHandle, GattRequest &request);
+    bool continueOperation(GattOperation &operation, uint16_t eventId, const ble_gattc_evt_t *event);
+    bool continueReadMany(GattOperation &operation, uint16_t eventId, const ble_gattc_evt_t *event);
+    uint32_t issueStreamChunks(adapter_t *adapter, uint16_t connHandle, GattOperation &stream);
+    void completeOperation(GattOperation &operation, uint32_t result, uint16_t gattStatus, std::vector<uint8_t> data);
+    void failOperations(GattOperationQueue &queue, uint32_t result);
+
+    bool uuidToString(adapter_t *adapter, const ble_uuid_t &uuid, std::string &uuidString);
+
+    std::mutex mutex;
+    std::map<uint16_t, std::unique_ptr<GattDiscovery>> discoveries;
+    std::map<uint16_t, GattOperationQueue> operationQueues;
+    bool resumeNeeded;
+    // By connection handle and value handle
+    std::map<std::pair<uint16_t, uint16_t>, NotificationBuffer> notificationBuffers;
+    bool autoConfirmIndications;
+
+    // 128-bit bases of vendor specific UUID types, little endian
+    std::map<uint8_t, std::array<uint8_t, 16>> vendorUuidBases;
+
+    // Only used in Main Thread
+    std::map<uint16_t, AttributeIndex> attributeIndexes;
+
+    std::mutex completionMutex;
+    std::vector<GattClientCompletion> completions;
+    uv_async_t *asyncCompletion;
+};
+
+#endif // GATT_CLIENT_H
@@ -0,0 +1,818 @@
+/* Copyright (c) 2010 - 2017, Nordic Semiconductor ASA
+ *
+ * All rights reserved.
+ *
+ * Use in source and binary forms, redistribution in binary form only, with
+ * or without modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions in binary form, except as embedded into a Nordic
+ *    Semiconductor ASA integrated circuit in a product or a software update for
+ *    such product, must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other
+ *    materials provided with the distribution.
+ *
+ * 2. Neither the name of Nordic Semiconductor ASA nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * 3. This software, with or without modification, must only be used with a Nordic
+ *    Semiconductor ASA integrated circuit.
+ *
+ * 4. Any software provided in binary form under this license must not be reverse
+ *    engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY NORDIC SEMICONDUCTOR ASA "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NORDIC SEMICONDUCTOR ASA OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+ * TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "gatt_database.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <mutex>
+
+// This compilation unit will be linked several times. So the cache and the
+// helpers must not have external linkage.
+namespace {
+    const uint8_t GATT_CACHE_MAGIC[] = { 'G', 'A', 'T', 'T' };
+    const uint8_t GATT_CACHE_VERSION = 1;
+
+    const uint8_t UUID_ENCODING_STRING = 0;
+    const uint8_t UUID_ENCODING_16BIT = 2;
+    const uint8_t UUID_ENCODING_128BIT = 16;
+
+    const uint8_t FLAG_DISCOVERED = 0x01;
+
+    // Peers kept in memory, the least recently used is evicted beyond this
+    const size_t MAX_CACHED_DATABASES = 64;
+
+    struct CachedDatabase
+    {
+        std::shared_ptr<GattDatabase> database;
+        uint64_t lastUsed;
+    };
+
+    std::map<std::string, CachedDatabase> cachedDatabases;
+    uint64_t cachedDatabasesUseCount = 0;
+    std::mutex cachedDatabasesMutex;
+
+    // Must be called with cachedDatabasesMutex held
+    void cacheDatabase(const std::string &path, const std::shared_ptr<GattDatabase> &database)
+    {
+        cachedDatabases[path] = CachedDatabase{ database, ++cachedDatabasesUseCount };
+
+        if (cachedDatabases.size() <= MAX_CACHED_DATABASES)
+        {
+            return;
+        }
+
+        auto leastRecentlyUsed = std::min_element(cachedDatabases.begin(), cachedDatabases.end(),
+            [](const std::pair<const std::string, CachedDatabase> &a, const std::pair<const std::string, CachedDatabase> &b) {
+                return a.second.lastUsed < b.second.lastUsed;
+            });
+
+        cachedDatabases.erase(leastRecentlyUsed);
+    }
+
+    std::string cachePath(const std::string &directory, const std::string &address)
+    {
+        std::string name;
+
+        for (auto c : address)
+        {
+            if (std::isalnum(static_cast<unsigned char>(c)))
+            {
+                name.push_back(static_cast<char>(std::toupper(static_cast<unsigned char>(c))));
+            }
+        }
+
+        return directory + "/" + name + GATT_CACHE_FILE_EXTENSION;
+    }
+
+    int hexValue(char c)
+    {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    }
+
+    bool isHexUuid(const std::string &uuid)
+    {
+        if (uuid.size() != 4 && uuid.size() != 32)
+        {
+            return false;
+        }
+
+        for (auto c : uuid)
+        {
+            if (hexValue(c) < 0)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    class Writer
+    {
+    public:
+        void u8(uint8_t value)
+        {
+            data.push_back(value);
+        }
+
+        void u16(uint16_t value)
+        {
+            data.push_back(static_cast<uint8_t>(value & 0xFF));
+            data.push_back(static_cast<uint8_t>(value >> 8));
+        }
+
+        // UUIDs are stored in binary when they are 16 or 128 bit hex
+        // strings, other strings (i.e. unresolved UUIDs) are stored as is.
+        void uuid(const std::string &uuid)
+        {
+            if (isHexUuid(uuid))
+            {
+                u8(static_cast<uint8_t>(uuid.size() / 2));
+
+                for (size_t i = 0; i < uuid.size(); i += 2)
+                {
+                    u8(static_cast<uint8_t>((hexValue(uuid[i]) << 4) | hexValue(uuid[i + 1])));
+                }
+            }
+            else
+            {
+                auto length = std::min<size_t>(uuid.size(), 0xFF);
+                u8(UUID_ENCODING_STRING);
+                u8(static_cast<uint8_t>(length));
+                data.insert(data.end(), uuid.begin(), uuid.begin() + length);
+            }
+        }
+
+        std::vector<uint8_t> data;
+    };
+
+    class Reader
+    {
+    public:
+        explicit Reader(const std::vector<uint8_t> &data) : data(data), position(0), valid(true) {}
+
+        uint8_t u8()
+        {
+            if (!ensure(1)) return 0;
+            return data[position++];
+        }
+
+        uint16_t u16()
+        {
+            if (!ensure(2)) return 0;
+            auto value = static_cast<uint16_t>(data[position] | (data[position + 1] << 8));
+            position += 2;
+            return value;
+        }
+
+        std::string uuid()
+        {
+            static const char digits[] = "0123456789ABCDEF";
+            auto encoding = u8();
+            std::string uuid;
+
+            if (encoding == UUID_ENCODING_16BIT || encoding == UUID_ENCODING_128BIT)
+            {
+                if (!ensure(encoding)) return uuid;
+
+                for (auto i = 0; i < encoding; i++)
+                {
+                    auto value = data[position++];
+                    uuid.push_back(digits[value >> 4]);
+                    uuid.push_back(digits[value & 0x0F]);
+                }
+            }
+            else if (encoding == UUID_ENCODING_STRING)
+            {
+                auto length = u8();
+                if (!ensure(length)) return uuid;
+
+                uuid.assign(data.begin() + position, data.begin() + position + length);
+                position += length;
+            }
+            else
+            {
+                valid = false;
+            }
+
+            return uuid;
+        }
+
+        bool ensure(size_t length)
+        {
+            valid = valid && (data.size() - position) >= length;
+            return valid;
+        }
+
+        const std::vector<uint8_t> &data;
+        size_t position;
+        bool valid;
+    };
+
+    uint8_t propertiesToByte(const ble_gatt_char_props_t &properties)
+    {
+        return static_cast<uint8_t>(
+            (properties.broadcast ? 0x01 : 0) |
+            (properties.read ? 0x02 : 0) |
+            (properties.write_wo_resp ? 0x04 : 0) |
+            (properties.write ? 0x08 : 0) |
+            (properties.notify ? 0x10 : 0) |
+            (properties.indicate ? 0x20 : 0) |
+            (properties.auth_signed_wr ? 0x40 : 0));
+    }
+
+    ble_gatt_char_props_t byteToProperties(uint8_t value)
+    {
+        ble_gatt_char_props_t properties = {};
+        properties.broadcast = (value & 0x01) ? 1 : 0;
+        properties.read = (value & 0x02) ? 1 : 0;
+        properties.write_wo_resp = (value & 0x04) ? 1 : 0;
+        properties.write = (value & 0x08) ? 1 : 0;
+        properties.notify = (value & 0x10) ? 1 : 0;
+        properties.indicate = (value & 0x20) ? 1 : 0;
+        properties.auth_signed_wr = (value & 0x40) ? 1 : 0;
+        return properties;
+    }
+
+    v8::Local<v8::Array> getJsArray(v8::Local<v8::Value> js)
+    {
+        if (!js->IsArray())
+        {
+            throw std::string("array");
+        }
+
+        return v8::Local<v8::Array>::Cast(js);
+    }
+}
+
+//
+// GattDatabase -- START --
+//
+
+std::vector<uint8_t> GattDatabase::serialize() const
+{
+    Writer writer;
+
+    writer.data.insert(writer.data.end(), std::begin(GATT_CACHE_MAGIC), std::end(GATT_CACHE_MAGIC));
+    writer.u8(GATT_CACHE_VERSION);
+
+    auto hashLength = std::min<size_t>(hash.size(), 0xFF);
+    writer.u8(static_cast<uint8_t>(hashLength));
+    writer.data.insert(writer.data.end(), hash.begin(), hash.begin() + hashLength);
+    writer.u16(hashHandle);
+
+    writer.u16(static_cast<uint16_t>(services.size()));
+
+    for (auto &service : services)
+    {
+        writer.u16(service.startHandle);
+        writer.u16(service.endHandle);
+        writer.u8(service.characteristicsDiscovered ? FLAG_DISCOVERED : 0);
+        writer.uuid(service.uuid);
+        writer.u16(static_cast<uint16_t>(service.characteristics.size()));
+
+        for (auto &characteristic : service.characteristics)
+        {
+            writer.u16(characteristic.declarationHandle);
+            writer.u16(characteristic.valueHandle);
+            writer.u8(propertiesToByte(characteristic.properties));
+            writer.u8(characteristic.descriptorsDiscovered ? FLAG_DISCOVERED : 0);
+            writer.uuid(characteristic.uuid);
+            writer.u16(static_cast<uint16_t>(characteristic.descriptors.size()));
+
+            for (auto &descriptor : characteristic.descriptors)
+            {
+                writer.u16(descriptor.handle);
+                writer.uuid(descriptor.uuid);
+            }
+        }
+    }
+
+    return writer.data;
+}
+
+bool GattDatabase::deserialize(const std::vector<uint8_t> &data)
+{
+    Reader reader(data);
+
+    for (auto magic : GATT_CACHE_MAGIC)
+    {
+        if (reader.u8() != magic)
+        {
+            return false;
+        }
+    }
+
+    if (reader.u8() != GATT_CACHE_VERSION)
+    {
+        return false;
+    }
+
+    auto hashLength = reader.u8();
+    hash.clear();
+
+    for (auto i = 0; i < hashLength; i++)
+    {
+        hash.push_back(reader.u8());
+    }
+
+    hashHandle = reader.u16();
+
+    auto serviceCount = reader.u16();
+    services.clear();
+
+    for (auto i = 0; i < serviceCount && reader.valid; i++)
+    {
+        GattDbService service;
+        service.startHandle = reader.u16();
+        service.endHandle = reader.u16();
+        service.characteristicsDiscovered = (reader.u8() & FLAG_DISCOVERED) != 0;
+        service.uuid = reader.uuid();
+
+        auto characteristicCount = reader.u16();
+
+        for (auto j = 0; j < characteristicCount && reader.valid; j++)
+        {
+            GattDbCharacteristic characteristic;
+            characteristic.declarationHandle = reader.u16();
+            characteristic.valueHandle = reader.u16();
+            characteristic.properties = byteToProperties(reader.u8());
+            characteristic.descriptorsDiscovered = (reader.u8() & FLAG_DISCOVERED) != 0;
+            characteristic.uuid = reader.uuid();
+
+            auto descriptorCount = reader.u16();
+
+            for (auto k = 0; k < descriptorCount && reader.valid; k++)
+            {
+                GattDbDescriptor descriptor;
+                descriptor.handle = reader.u16();
+                descriptor.uuid = reader.uuid();
+                characteristic.descriptors.push_back(descriptor);
+            }
+
+            service.characteristics.push_back(characteristic);
+        }
+
+        services.push_back(service);
+    }
+
+    return reader.valid && reader.position == data.size();
+}
+
+//
+// GattDatabase -- END --
+//
+
+//
+// GattDb -- START --
+//
+
+v8::Local<v8::Object> GattDb::ToJs()
+{
+    Nan::EscapableHandleScope scope;
+    v8::Local<v8::Object> obj = Nan::New<v8::Object>();
+
+    if (native->hash.empty())
+    {
+        Utility::Set(obj, "hash", Nan::Null());
+    }
+    else
+    {
+        Utility::Set(obj, "hash", ConversionUtility::toJsValueArray(native->hash.data(), static_cast<uint16_t>(native->hash.size())));
+    }
+
+    Utility::Set(obj, "hashHandle", native->hashHandle);
+
+    v8::Local<v8::Array> services = Nan::New<v8::Array>();
+    uint32_t serviceIndex = 0;
+
+    for (auto &service : native->services)
+    {
+        v8::Local<v8::Object> jsService = Nan::New<v8::Object>();
+        Utility::Set(jsService, "startHandle", service.startHandle);
+        Utility::Set(jsService, "endHandle", service.endHandle);
+        Utility::Set(jsService, "uuid", service.uuid);
+
+        if (!service.characteristicsDiscovered)
+        {
+            Utility::Set(jsService, "characteristics", Nan::Null());
+        }
+        else
+        {
+            v8::Local<v8::Array> characteristics = Nan::New<v8::Array>();
+            uint32_t characteristicIndex = 0;
+
+            for (auto &characteristic : service.characteristics)
+            {
+                v8::Local<v8::Object> jsCharacteristic = Nan::New<v8::Object>();
+                auto properties = characteristic.properties;
+                Utility::Set(jsCharacteristic, "declarationHandle", characteristic.declarationHandle);
+                Utility::Set(jsCharacteristic, "valueHandle", characteristic.valueHandle);
+                Utility::Set(jsCharacteristic, "uuid", characteristic.uuid);
+                Utility::Set(jsCharacteristic, "properties", GattCharProps(&properties).ToJs());
+
+                if (!characteristic.descriptorsDiscovered)
+                {
+                    Utility::Set(jsCharacteristic, "descriptors", Nan::Null());
+                }
+                else
+                {
+                    v8::Local<v8::Array> descriptors = Nan::New<v8::Array>();
+                    uint32_t descriptorIndex = 0;
+
+                    for (auto &descriptor : characteristic.descriptors)
+                    {
+                        v8::Local<v8::Object> jsDescriptor = Nan::New<v8::Object>();
+                        Utility::Set(jsDescriptor, "handle", descriptor.handle);
+                        Utility::Set(jsDescriptor, "uuid", descriptor.uuid);
+                        Nan::Set(descriptors, descriptorIndex++, jsDescriptor);
+                    }
+
+                    Utility::Set(jsCharacteristic, "descriptors", descriptors);
+                }
+
+                Nan::Set(characteristics, characteristicIndex++, jsCharacteristic);
+            }
+
+            Utility::Set(jsService, "characteristics", characteristics);
+        }
+
+        Nan::Set(services, serviceIndex++, jsService);
+    }
+
+    Utility::Set(obj, "services", services);
+
+    return scope.Escape(obj);
+}
+
+GattDatabase *GattDb::ToNative()
+{
+    std::unique_ptr<GattDatabase> database(new GattDatabase());
+    database->hashHandle = 0;
+
+    if (Utility::Has(jsobj, "hash") && !Utility::IsNull(jsobj, "hash"))
+    {
+        auto hash = getJsArray(Utility::Get(jsobj, "hash"));
+
+        for (uint32_t i = 0; i < hash->Length(); i++)
+        {
+            database->hash.push_back(ConversionUtility::getNativeUint8(Utility::Get(hash, i)));
+        }
+    }
+
+    if (Utility::Has(jsobj, "hashHandle"))
+    {
+        database->hashHandle = ConversionUtility::getNativeUint16(jsobj, "hashHandle");
+    }
+
+    auto services = getJsArray(Utility::Get(jsobj, "services"));
+
+    for (uint32_t i = 0; i < services->Length(); i++)
+    {
+        auto jsService = ConversionUtility::getJsObject(Utility::Get(services, i));
+
+        GattDbService service;
+        service.startHandle = ConversionUtility::getNativeUint16(jsService, "startHandle");
+        service.endHandle = ConversionUtility::getNativeUint16(jsService, "endHandle");
+        service.uuid = ConversionUtility::getNativeString(jsService, "uuid");
+        service.characteristicsDiscovered = !Utility::IsNull(jsService, "characteristics");
+
+        if (service.characteristicsDiscovered)
+        {
+            auto characteristics = getJsArray(Utility::Get(jsService, "characteristics"));
+
+            for (uint32_t j = 0; j < characteristics->Length(); j++)
+            {
+                auto jsCharacteristic = ConversionUtility::getJsObject(Utility::Get(characteristics, j));
+
+                GattDbCharacteristic characteristic;
+                characteristic.declarationHandle = ConversionUtility::getNativeUint16(jsCharacteristic, "declarationHandle");
+                characteristic.valueHandle = ConversionUtility::getNativeUint16(jsCharacteristic, "valueHandle");
+                characteristic.uuid = ConversionUtility::getNativeString(jsCharacteristic, "uuid");
+
+                std::unique_ptr<ble_gatt_char_props_t> properties(GattCharProps(ConversionUtility::getJsObject(jsCharacteristic, "properties")).ToNative());
+                characteristic.properties = *properties;
+
+                characteristic.descriptorsDiscovered = !Utility::IsNull(jsCharacteristic, "descriptors");
+
+                if (characteristic.descriptorsDiscovered)
+                {
+                    auto descriptors = getJsArray(Utility::Get(jsCharacteristic, "descriptors"));
+
+                    for (uint32_t k = 0; k < descriptors->Length(); k++)
+                    {
+                        auto jsDescriptor = ConversionUtility::getJsObject(Utility::Get(descriptors, k));
+
+                        GattDbDescriptor descriptor;
+                        descriptor.handle = ConversionUtility::getNativeUint16(jsDescriptor, "handle");
+                        descriptor.uuid = ConversionUtility::getNativeString(jsDescriptor, "uuid");
+                        characteristic.descriptors.push_back(descriptor);
+                    }
+                }
+
+                service.characteristics.push_back(characteristic);
+            }
+        }
+
+        database->services.push_back(service);
+    }
+
+    return database.release();
+}
+
+//
+// GattDb -- END --
+//
+
+//
+// GattDatabaseCache -- START --
+//
+
+std::shared_ptr<GattDatabase> GattDatabaseCache::load(const std::string &directory, const std::string &address)
+{
+    auto path = cachePath(directory, address);
+
+    std::lock_guard<std::mutex> lock(cachedDatabasesMutex);
+
+    auto cached = cachedDatabases.find(path);
+
+    if (cached != cachedDatabases.end())
+    {
+        cached->second.lastUsed = ++cachedDatabasesUseCount;
+        return cached->second.database;
+    }
+
+    std::ifstream in(path, std::ios::in | std::ios::binary);
+
+    if (!in.is_open())
+    {
+        return nullptr;
+    }
+
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+    auto database = std::make_shared<GattDatabase>();
+
+    // A corrupt or outdated file is treated as a cache miss, it is
+    // overwritten when the peer has been discovered again.
+    if (in.bad() || !database->deserialize(data))
+    {
+        return nullptr;
+    }
+
+    cacheDatabase(path, database);
+    return database;
+}
+
+bool GattDatabaseCache::store(const std::string &directory, const std::string &address, const GattDatabase &database)
+{
+    auto path = cachePath(directory, address);
+    auto data = database.serialize();
+
+    std::lock_guard<std::mutex> lock(cachedDatabasesMutex);
+
+    cacheDatabase(path, std::make_shared<GattDatabase>(database));
+
+    return writeFileAtomically(path, data, false);
+}
+
+bool GattDatabaseCache::remove(const std::string &directory, const std::string &address)
+{
+    auto path = cachePath(directory, address);
+
+    std::lock_guard<std::mutex> lock(cachedDatabasesMutex);
+
+    cachedDatabases.erase(path);
+
+    if (!std::ifstream(path).is_open())
+    {
+        return true;
+    }
+
+    return std::remove(path.c_str()) == 0;
+}
+
+//
+// GattDatabaseCache -- END --
+//
+
+NAN_METHOD(GattCacheLoad)
+{
+    std::string directory;
+    std::string address;
+    v8::Local<v8::Function> callback;
+    auto argumentcount = 0;
+
+    try
+    {
+        directory = ConversionUtility::getNativeString(info[argumentcount]);
+        argumentcount++;
+
+        address = ConversionUtility::getNativeString(info[argumentcount]);
+        argumentcount++;
+
+        callback = ConversionUtility::getCallbackFunction(info[argumentcount]);
+        argumentcount++;
+    }
+    catch (std::string error)
+    {
+        auto message = ErrorMessage::getTypeErrorMessage(argumentcount, error);
+        Nan::ThrowTypeError(message);
+        return;
+    }
+
+    auto baton = new GattCacheLoadBaton(callback);
+    baton->directory = directory;
+    baton->address = address;
+
+    uv_queue_work(uv_default_loop(), baton->req, GattCacheLoad, reinterpret_cast<uv_after_work_cb>(AfterGattCacheLoad));
+}
+
+// This runs in a worker thread (not Main Thread)
+void GattCacheLoad(uv_work_t *req)
+{
+    auto baton = static_cast<GattCacheLoadBaton *>(req->data);
+    baton->database = GattDatabaseCache::load(baton->directory, baton->address);
+    baton->result = NRF_SUCCESS;
+}
+
+// This runs in Main Thread
+void AfterGattCacheLoad(uv_work_t *req)
+{
+    Nan::HandleScope scope;
+    auto baton = static_cast<GattCacheLoadBaton *>(req->data);
+    v8::Local<v8::Value> argv[2];
+
+    argv[0] = Nan::Undefined();
+
+    if (baton->database)
+    {
+        argv[1] = GattDb(baton->database.get()).ToJs();
+    }
+    else
+    {
+        argv[1] = Nan::Null();
+    }
+
+    Nan::AsyncResource resource("pc-ble-driver-js:callback");
+    baton->callback->Call(2, argv, &resource);
+    delete baton;
+}
+
+NAN_METHOD(GattCacheStore)
+{
+    std::string directory;
+    std::string address;
+    std::unique_ptr<GattDatabase> database;
+    v8::Local<v8::Function> callback;
+    auto argumentcount = 0;
+
+    try
+    {
+        directory = ConversionUtility::getNativeString(info[argumentcount]);
+        argumentcount++;
+
+        address = ConversionUtility::getNativeString(info[argumentcount]);
+        argumentcount++;
+
+        auto databaseObject = ConversionUtility::getJsObject(info[argumentcount]);
+        database.reset(GattDb(databaseObject).ToNative());
+        argumentcount++;
+
+        callback = ConversionUtility::getCallbackFunction(info[argumentcount]);
+        argumentcount++;
+    }
+    catch (std::string error)
+    {
+        auto message = ErrorMessage::getTypeErrorMessage(argumentcount, error);
+        Nan::ThrowTypeError(message);
+        return;
+    }
+
+    auto baton = new GattCacheStoreBaton(callback);
+    baton->directory = directory;
+    baton->address = address;
+    baton->database = std::move(database);
+
+    uv_queue_work(uv_default_loop(), baton->req, GattCacheStore, reinterpret_cast<uv_after_work_cb>(AfterGattCacheStore));
+}
+
+// This runs in a worker thread (not Main Thread)
+void GattCacheStore(uv_work_t *req)
+{
+    auto baton = static_cast<GattCacheStoreBaton *>(req->data);
+    auto stored = GattDatabaseCache::store(baton->directory, baton->address, *baton->database);
+    baton->result = stored ? NRF_SUCCESS : NRF_ERROR_INTERNAL;
+}
+
+// This runs in Main Thread
+void AfterGattCacheStore(uv_work_t *req)
+{
+    Nan::HandleScope scope;
+    auto baton = static_cast<GattCacheStoreBaton *>(req->data);
+    v8::Local<v8::Value> argv[1];
+
+    if (baton->result != NRF_SUCCESS)
+    {
+        argv[0] = ErrorMessage::getErrorMessage(baton->result, "writing GATT cache file");
+    }
+    else
+    {
+        argv[0] = Nan::Undefined();
+    }
+
+    Nan::AsyncResource resource("pc-ble-driver-js:callback");
+    baton->callback->Call(1, argv, &resource);
+    delete baton;
+}
+
+NAN_METHOD(GattCacheRemove)
+{
+    std::string directory;
+    std::string address;
+    v8::Local<v8::Function> callback;
+    auto argumentcount = 0;
+
+    try
+    {
+        directory = ConversionUtility::getNativeString(info[argumentcount]);
+        argumentcount++;
+
+        address = ConversionUtility::getNativeString(info[argumentcount]);
+        argumentcount++;
+
+        callback = ConversionUtility::getCallbackFunction(info[argumentcount]);
+        argumentcount++;
+    }
+    catch (std::string error)
+    {
+        auto message = ErrorMessage::getTypeErrorMessage(argumentcount, error);
+        Nan::ThrowTypeError(message);
+        return;
+    }
+
+    auto baton = new GattCacheRemoveBaton(callback);
+    baton->directory = directory;
+    baton->address = address;
+
+    uv_queue_work(uv_default_loop(), baton->req, GattCacheRemove, reinterpret_cast<uv_after_work_cb>(AfterGattCacheRemove));
+}
+
+// This runs in a worker thread (not Main Thread)
+void GattCacheRemove(uv_work_t *req)
+{
+    auto baton = static_cast<GattCacheRemoveBaton *>(req->data);
+    auto removed = GattDatabaseCache::remove(baton->directory, baton->address);
+    baton->result = removed ? NRF_SUCCESS : NRF_ERROR_INTERNAL;
+}
+
+// This runs in Main Thread
+void AfterGattCacheRemove(uv_work_t *req)
+{
+    Nan::HandleScope scope;
+    auto baton = static_cast<GattCacheRemoveBaton *>(req->data);
+    v8::Local<v8::Value> argv[1];
+
+    if (baton->result != NRF_SUCCESS)
+    {
+        argv[0] = ErrorMessage::getErrorMessage(baton->result, "removing GATT cache file");
+    }
+    else
+    {
+        argv[0] = Nan::Undefined();
+    }
+
+    Nan::AsyncResource resource("pc-ble-driver-js:callback");
+    baton->callback->Call(1, argv, &resource);
+    delete baton;
+}
+
+extern "C" {
+    void init_gatt_database(Nan::ADDON_REGISTER_FUNCTION_ARGS_TYPE target)
+    {
+        Utility::SetMethod(target, "gattCacheLoad", GattCacheLoad);
+        Utility::SetMethod(target, "gattCacheStore", GattCacheStore);
+        Utility::SetMethod(target, "gattCacheRemove", GattCacheRemove);
+    }
+}
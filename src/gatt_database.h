@@ -0,0 +1,152 @@
+/* Copyright (c) 2010 - 2017, Nordic Semiconductor ASA
+ *
+ * All rights reserved.
+ *
+ * Use in source and binary forms, redistribution in binary form only, with
+ * or without modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions in binary form, except as embedded into a Nordic
+ *    Semiconductor ASA integrated circuit in a product or a software update for
+ *    such product, must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other
+ *    materials provided with the distribution.
+ *
+ * 2. Neither the name of Nordic Semiconductor ASA nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * 3. This software, with or without modification, must only be used with a Nordic
+ *    Semiconductor ASA integrated circuit.
+ *
+ * 4. Any software provided in binary form under this license must not be reverse
+ *    engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY NORDIC SEMICONDUCTOR ASA "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NORDIC SEMICONDUCTOR ASA OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+ * TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef GATT_DATABASE_H
+#define GATT_DATABASE_H
+
+#include <nan.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "common.h"
+#include "driver_gatt.h"
+
+// File name extension of the cached GATT databases, one file per peer
+#define GATT_CACHE_FILE_EXTENSION ".gattdb"
+
+struct GattDbDescriptor
+{
+public:
+    uint16_t handle;
+    std::string uuid;
+};
+
+struct GattDbCharacteristic
+{
+public:
+    uint16_t declarationHandle;
+    uint16_t valueHandle;
+    ble_gatt_char_props_t properties;
+    std::string uuid;
+    // False until the descriptors of the characteristic have been discovered
+    bool descriptorsDiscovered;
+    std::vector<GattDbDescriptor> descriptors;
+};
+
+struct GattDbService
+{
+public:
+    uint16_t startHandle;
+    uint16_t endHandle;
+    std::string uuid;
+    // False until the characteristics of the service have been discovered
+    bool characteristicsDiscovered;
+    std::vector<GattDbCharacteristic> characteristics;
+};
+
+// Attribute table of a peer as found by service discovery, together with
+// the peer's Database Hash (GATT 5.1) if it exposes one.
+struct GattDatabase
+{
+public:
+    std::vector<uint8_t> hash;
+    uint16_t hashHandle;
+    std::vector<GattDbService> services;
+
+    std::vector<uint8_t> serialize() const;
+    // Returns false if the data is not a valid serialized database
+    bool deserialize(const std::vector<uint8_t> &data);
+};
+
+class GattDb : public BleToJs<GattDatabase>
+{
+public:
+    GattDb(GattDatabase *database) : BleToJs<GattDatabase>(database) {}
+    GattDb(v8::Local<v8::Object> js) : BleToJs<GattDatabase>(js) {}
+    v8::Local<v8::Object> ToJs();
+    GattDatabase *ToNative();
+};
+
+// Cache of peer GATT databases, persisted as a compact binary file per peer
+// address in a given directory. Recently used databases are kept in memory so
+// that later connections to the same peer do not touch the disk.
+class GattDatabaseCache
+{
+public:
+    // Returns nullptr if there is no cached database for the peer
+    static std::shared_ptr<GattDatabase> load(const std::string &directory, const std::string &address);
+    static bool store(const std::string &directory, const std::string &address, const GattDatabase &database);
+    static bool remove(const std::string &directory, const std::string &address);
+};
+
+METHOD_DEFINITIONS(GattCacheLoad);
+METHOD_DEFINITIONS(GattCacheStore);
+METHOD_DEFINITIONS(GattCacheRemove);
+
+struct GattCacheLoadBaton : Baton
+{
+public:
+    BATON_CONSTRUCTOR(GattCacheLoadBaton)
+    std::string directory;
+    std::string address;
+    std::shared_ptr<GattDatabase> database;
+};
+
+struct GattCacheStoreBaton : Baton
+{
+public:
+    BATON_CONSTRUCTOR(GattCacheStoreBaton)
+    std::string directory;
+    std::string address;
+    std::unique_ptr<GattDatabase> database;
+};
+
+struct GattCacheRemoveBaton : Baton
+{
+public:
+    BATON_CONSTRUCTOR(GattCacheRemoveBaton)
+    std::string directory;
+    std::string address;
+};
+
+extern "C" {
+    void init_gatt_database(Nan::ADDON_REGISTER_FUNCTION_ARGS_TYPE target);
+}
+
+#endif // GATT_DATABASE_H
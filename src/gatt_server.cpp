@@ -0,0 +1,2371 @@
+/* Copyright (c) 2010 - 2017, Nordic Semiconductor ASA
+ *
+ * All rights reserved.
+ *
+ * Use in source and binary forms, redistribution in binary form only, with
+ * or without modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions in binary form, except as embedded into a Nordic
+ *    Semiconductor ASA integrated circuit in a product or a software update for
+ *    such product, must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other
+ *    materials provided with the distribution.
+ *
+ * 2. Neither the name of Nordic Semiconductor ASA nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * 3. This software, with or without modification, must only be used with a Nordic
+ *    Semiconductor ASA integrated circuit.
+ *
+ * 4. Any software provided in binary form under this license must not be reverse
+ *    engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY NORDIC SEMICONDUCTOR ASA "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NORDIC SEMICONDUCTOR ASA OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+ * TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "gatt_server.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <type_traits>
+
+#include "ble_err.h"
+
+// This compilation unit will be linked several times. So the helpers must
+// not have external linkage.
+namespace {
+    // Returned for notifications when the SoftDevice has no room for more packets
+#if NRF_SD_BLE_API_VERSION <= 3
+    const uint32_t TX_QUEUE_FULL = BLE_ERROR_NO_TX_PACKETS;
+#else
+    const uint32_t TX_QUEUE_FULL = NRF_ERROR_RESOURCES;
+#endif
+
+    // Bit of the CCCD value that enables notifications
+    const uint16_t CCCD_NOTIFICATION = 0x0001;
+
+    // Bytes a connection may issue for each unit of weight in a round of the
+    // notification scheduler, the payload of a notification with the default ATT MTU
+    const uint32_t SCHEDULER_QUANTUM = 20;
+
+    // Notifications a connection may have waiting in the SoftDevice for each unit of weight
+    const uint32_t NOTIFICATIONS_IN_FLIGHT = 4;
+
+    // Time the peer has to confirm an indication by default, the ATT transaction timeout
+    const uint32_t INDICATION_TIMEOUT = 30000;
+
+    // Bytes of prepared writes a connection can queue before they are executed
+    const size_t PREPARED_WRITE_QUEUE_SIZE = 4096;
+
+    // Writes data at offset, the value ends with the data written as for variable length attributes
+    void applyWrite(std::vector<uint8_t> &value, uint16_t offset, const uint8_t *data, size_t length)
+    {
+        value.resize(offset);
+        value.insert(value.end(), data, data + length);
+    }
+
+    bool notificationsReady(const GattNotificationQueue &queue)
+    {
+        return !queue.txQueueFull && !queue.pending.empty() && queue.inFlight < queue.weight * NOTIFICATIONS_IN_FLIGHT;
+    }
+
+    // Deficit round robin: in each round a connection is credited its weight
+    // in quanta, and issues the notifications that fit in its credit. Credit
+    // that is not used is kept while the connection has notifications waiting.
+    // Rounds start at the connection after the one that started the last
+    // round, so that no connection is always first on the link. The issue
+    // function takes the front of the queue of a connection and charges its
+    // credit, unless the SoftDevice had no room.
+    template <typename Issue>
+    void runNotificationRounds(std::map<uint16_t, GattNotificationQueue> &queues, uint16_t &start, Issue issue)
+    {
+        auto anyReady = [&queues]() {
+            return std::any_of(queues.begin(), queues.end(), [](const std::pair<const uint16_t, GattNotificationQueue> &entry) {
+                return notificationsReady(entry.second);
+            });
+        };
+
+        while (anyReady())
+        {
+            auto first = queues.upper_bound(start);
+
+            if (first == queues.end())
+            {
+                first = queues.begin();
+            }
+
+            start = first->first;
+
+            // Queues are looked up by connection handle, as issue may release
+            // the mutex, and queues are erased on disconnect meanwhile
+            std::vector<uint16_t> round;
+
+            for (auto entry = first; entry != queues.end(); entry++)
+            {
+                round.push_back(entry->first);
+            }
+
+            for (auto entry = queues.begin(); entry != first; entry++)
+            {
+                round.push_back(entry->first);
+            }
+
+            for (auto connHandle : round)
+            {
+                auto queue = queues.find(connHandle);
+
+                if (queue == queues.end())
+                {
+                    continue;
+                }
+
+                if (notificationsReady(queue->second))
+                {
+                    queue->second.deficit += SCHEDULER_QUANTUM * queue->second.weight;
+
+                    while (notificationsReady(queue->second) && queue->second.pending.front().value.size() <= queue->second.deficit)
+                    {
+                        issue(connHandle);
+                        queue = queues.find(connHandle);
+
+                        if (queue == queues.end())
+                        {
+                            break;
+                        }
+                    }
+                }
+
+                if (queue != queues.end() && queue->second.pending.empty())
+                {
+                    queue->second.deficit = 0;
+                }
+            }
+        }
+    }
+
+    // AES-128 encryption of one block, as needed to resolve private addresses
+    // with the random address hash function ah of the Bluetooth Core Specification
+    const uint8_t AES_SBOX[256] = {
+        0x63, 0x7C, 0x77, 0x7B, 0xF2, 0x6B, 0x6F, 0xC5, 0x30, 0x01, 0x67, 0x2B, 0xFE, 0xD7, 0xAB, 0x76,
+        0xCA, 0x82, 0xC9, 0x7D, 0xFA, 0x59, 0x47, 0xF0, 0xAD, 0xD4, 0xA2, 0xAF, 0x9C, 0xA4, 0x72, 0xC0,
+        0xB7, 0xFD, 0x93, 0x26, 0x36, 0x3F, 0xF7, 0xCC, 0x34, 0xA5, 0xE5, 0xF1, 0x71, 0xD8, 0x31, 0x15,
+        0x04, 0xC7, 0x23, 0xC3, 0x18, 0x96, 0x05, 0x9A, 0x07, 0x12, 0x80, 0xE2, 0xEB, 0x27, 0xB2, 0x75,
+        0x09, 0x83, 0x2C, 0x1A, 0x1B, 0x6E, 0x5A, 0xA0, 0x52, 0x3B, 0xD6, 0xB3, 0x29, 0xE3, 0x2F, 0x84,
+        0x53, 0xD1, 0x00, 0xED, 0x20, 0xFC, 0xB1, 0x5B, 0x6A, 0xCB, 0xBE, 0x39, 0x4A, 0x4C, 0x58, 0xCF,
+        0xD0, 0xEF, 0xAA, 0xFB, 0x43, 0x4D, 0x33, 0x85, 0x45, 0xF9, 0x02, 0x7F, 0x50, 0x3C, 0x9F, 0xA8,
+        0x51, 0xA3, 0x40, 0x8F, 0x92, 0x9D, 0x38, 0xF5, 0xBC, 0xB6, 0xDA, 0x21, 0x10, 0xFF, 0xF3, 0xD2,
+        0xCD, 0x0C, 0x13, 0xEC, 0x5F, 0x97, 0x44, 0x17, 0xC4, 0xA7, 0x7E, 0x3D, 0x64, 0x5D, 0x19, 0x73,
+        0x60, 0x81, 0x4F, 0xDC, 0x22, 0x2A, 0x90, 0x88, 0x46, 0xEE, 0xB8, 0x14, 0xDE, 0x5E, 0x0B, 0xDB,
+        0xE0, 0x32, 0x3A, 0x0A, 0x49, 0x06, 0x24, 0x5C, 0xC2, 0xD3, 0xAC, 0x62, 0x91, 0x95, 0xE4, 0x79,
+        0xE7, 0xC8, 0x37, 0x6D, 0x8D, 0xD5, 0x4E, 0xA9, 0x6C, 0x56, 0xF4, 0xEA, 0x65, 0x7A, 0xAE, 0x08,
+        0xBA, 0x78, 0x25, 0x2E, 0x1C, 0xA6, 0xB4, 0xC6, 0xE8, 0xDD, 0x74, 0x1F, 0x4B, 0xBD, 0x8B, 0x8A,
+        0x70, 0x3E, 0xB5, 0x66, 0x48, 0x03, 0xF6, 0x0E, 0x61, 0x35, 0x57, 0xB9, 0x86, 0xC1, 0x1D, 0x9E,
+        0xE1, 0xF8, 0x98, 0x11, 0x69, 0xD9, 0x8E, 0x94, 0x9B, 0x1E, 0x87, 0xE9, 0xCE, 0x55, 0x28, 0xDF,
+        0x8C, 0xA1, 0x89, 0x0D, 0xBF, 0xE6, 0x42, 0x68, 0x41, 0x99, 0x2D, 0x0F, 0xB0, 0x54, 0xBB, 0x16
+    };
+
+    uint8_t aesMultiplyByTwo(uint8_t value)
+    {
+        return static_cast<uint8_t>((value << 1) ^ ((value & 0x80) != 0 ? 0x1B : 0x00));
+    }
+
+    // Key and block most significant byte first, the block is encrypted in place
+    void aes128Encrypt(const uint8_t key[16], uint8_t block[16])
+    {
+        uint8_t roundKey[16];
+        uint8_t roundConstant = 0x01;
+        std::memcpy(roundKey, key, sizeof(roundKey));
+
+        for (auto i = 0; i < 16; i++)
+        {
+            block[i] ^= roundKey[i];
+        }
+
+        for (auto round = 1; round <= 10; round++)
+        {
+            // Next round key
+            uint8_t rotated[4] = { roundKey[13], roundKey[14], roundKey[15], roundKey[12] };
+
+            for (auto i = 0; i < 4; i++)
+            {
+                roundKey[i] ^= AES_SBOX[rotated[i]];
+            }
+
+            roundKey[0] ^= roundConstant;
+            roundConstant = aesMultiplyByTwo(roundConstant);
+
+            for (auto i = 4; i < 16; i++)
+            {
+                roundKey[i] ^= roundKey[i - 4];
+            }
+
+            // SubBytes and ShiftRows, the block is stored column by column
+            uint8_t state[16];
+
+            for (auto i = 0; i < 16; i++)
+            {
+                auto row = i % 4;
+                auto column = i / 4;
+                state[i] = AES_SBOX[block[((column + row) % 4) * 4 + row]];
+            }
+
+            // MixColumns, except in the last round
+            for (auto column = 0; column < 4 && round < 10; column++)
+            {
+                auto c = state + column * 4;
+                auto all = static_cast<uint8_t>(c[0] ^ c[1] ^ c[2] ^ c[3]);
+                auto first = c[0];
+
+                c[0] ^= all ^ aesMultiplyByTwo(static_cast<uint8_t>(c[0] ^ c[1]));
+                c[1] ^= all ^ aesMultiplyByTwo(static_cast<uint8_t>(c[1] ^ c[2]));
+                c[2] ^= all ^ aesMultiplyByTwo(static_cast<uint8_t>(c[2] ^ c[3]));
+                c[3] ^= all ^ aesMultiplyByTwo(static_cast<uint8_t>(c[3] ^ first));
+            }
+
+            for (auto i = 0; i < 16; i++)
+            {
+                block[i] = state[i] ^ roundKey[i];
+            }
+        }
+    }
+
+    // Whether a resolvable private address was generated from the IRK, the
+    // hash in the lower half of the address is ah(irk, prand) of the upper half
+    bool resolvesAddress(const uint8_t irk[BLE_GAP_SEC_KEY_LEN], const ble_gap_addr_t &address)
+    {
+        // The IRK and the address are least significant byte first
+        uint8_t key[16];
+
+        for (auto i = 0; i < 16; i++)
+        {
+            key[i] = irk[15 - i];
+        }
+
+        uint8_t block[16] = { 0 };
+        block[13] = address.addr[5];
+        block[14] = address.addr[4];
+        block[15] = address.addr[3];
+
+        aes128Encrypt(key, block);
+
+        return block[15] == address.addr[0] && block[14] == address.addr[1] && block[13] == address.addr[2];
+    }
+
+    bool sameAddress(const ble_gap_addr_t &a, const ble_gap_addr_t &b)
+    {
+        return a.addr_type == b.addr_type && std::memcmp(a.addr, b.addr, BLE_GAP_ADDR_LEN) == 0;
+    }
+
+    // Name of the file the identities of the bonded peers are saved in, each
+    // as the address type, the address and the IRK
+    const char *IDENTITY_FILE = "identities";
+    const size_t IDENTITY_RECORD_SIZE = 1 + BLE_GAP_ADDR_LEN + BLE_GAP_SEC_KEY_LEN;
+
+    // Extension of the files the system attributes of the peers are saved in
+    const char *SYSTEM_ATTRIBUTE_SUFFIX = ".sysattr";
+
+    std::remove_pointer<uv_async_cb>::type completion_handler;
+    void completion_handler(uv_async_t *handle)
+    {
+        auto gattServer = static_cast<GattServer *>(handle->data);
+
+        if (gattServer != nullptr)
+        {
+            gattServer->onCompletion();
+        }
+    }
+
+    std::remove_pointer<uv_timer_cb>::type indication_timeout_handler;
+    void indication_timeout_handler(uv_timer_t *handle)
+    {
+        auto gattServer = static_cast<GattServer *>(handle->data);
+
+        if (gattServer != nullptr)
+        {
+            gattServer->onIndicationTimeout();
+        }
+    }
+
+    // Work queued with GattServer::queueWork
+    struct GattServerWork
+    {
+        GattServer *gattServer;
+        GattServerCompletion work;
+    };
+
+    void server_work(uv_work_t *req)
+    {
+        auto work = static_cast<GattServerWork *>(req->data);
+        work->work();
+        work->gattServer->onWorkDone();
+    }
+
+    void server_work_done(uv_work_t *req, int status)
+    {
+        delete static_cast<GattServerWork *>(req->data);
+        delete req;
+    }
+}
+
+GattNotificationGroup::GattNotificationGroup(size_t count, std::shared_ptr<Nan::Callback> callback)
+    : remaining(count), callback(callback)
+{
+}
+
+GattNotification::GattNotification(uint16_t handle, std::shared_ptr<Nan::Callback> callback)
+    : handle(handle), queued(std::chrono::steady_clock::now()), callback(callback)
+{
+}
+
+GattNotificationQueue::GattNotificationQueue() : txQueueFull(false), inFlight(0), txCompleteCount(0), weight(1), deficit(0)
+{
+}
+
+GattIndication::GattIndication(uint16_t handle, std::shared_ptr<Nan::Callback> callback)
+    : handle(handle), callback(callback)
+{
+}
+
+GattIndicationQueue::GattIndicationQueue() : state(State::Idle)
+{
+}
+
+GattAttributeStore::GattAttributeStore()
+    : serveReads(false), writePolicy(WritePolicy::Pass), maxLength(0), rejectStatus(BLE_GATT_STATUS_ATTERR_WRITE_NOT_PERMITTED), unreportedReads(0)
+{
+}
+
+GattPreparedWriteQueue::GattPreparedWriteQueue()
+{
+    data.reserve(PREPARED_WRITE_QUEUE_SIZE);
+}
+
+GattPeer::GattPeer() : bonded(false), identified(false)
+{
+    std::memset(&address, 0, sizeof(address));
+    std::memset(&identity, 0, sizeof(identity));
+}
+
+GattServer::GattServer(AdapterMetrics &metrics)
+    : metrics(metrics), scheduleStart(0), scheduling(false), scheduleRequested(false), indicationsRequested(false), senderAdapter(nullptr),
+      senderStop(false), indicationTimeout(INDICATION_TIMEOUT),
+      asyncCompletion(nullptr), indicationTimer(nullptr), workersRunning(0), fileWritesQueued(false)
+{
+}
+
+GattServer::~GattServer()
+{
+    stopSender();
+
+    // The workers must be done with this
+    std::unique_lock<std::mutex> lock(workerMutex);
+    workersDone.wait(lock, [this]() { return workersRunning == 0; });
+}
+
+// This runs in Main Thread
+void GattServer::initCompletionHandling()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        // The attribute table is built again when BLE is enabled
+        cccdValueHandles.clear();
+        cccdValues.clear();
+        attributeMaxLengths.clear();
+        attributeStores.clear();
+        peers.clear();
+        preparedWrites.clear();
+        executedWrites.clear();
+        valueMirror.clear();
+        pendingAuthorizations.clear();
+    }
+
+    startSender();
+
+    std::lock_guard<std::mutex> lock(completionMutex);
+
+    if (asyncCompletion != nullptr)
+    {
+        return;
+    }
+
+    asyncCompletion = new uv_async_t();
+    asyncCompletion->data = static_cast<void *>(this);
+
+    if (uv_async_init(uv_default_loop(), asyncCompletion, completion_handler) != 0)
+    {
+        std::cerr << "Not able to create a new GATT server completion handler." << std::endl;
+        std::terminate();
+    }
+
+    indicationTimer = new uv_timer_t();
+    indicationTimer->data = static_cast<void *>(this);
+
+    if (uv_timer_init(uv_default_loop(), indicationTimer) != 0)
+    {
+        std::cerr << "Not able to create a new GATT server indication timer." << std::endl;
+        std::terminate();
+    }
+}
+
+// This runs in Main Thread
+void GattServer::cleanUpV8Resources()
+{
+    std::map<uint16_t, GattNotificationQueue> abortedNotifications;
+
+    {
+        std::lock_guard<std::mutex> lock(indicationMutex);
+
+        for (auto &queue : indicationQueues)
+        {
+            failIndications(queue.second, NRF_ERROR_INVALID_STATE);
+        }
+
+        indicationQueues.clear();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        abortedNotifications.swap(notificationQueues);
+        attributeStores.clear();
+    }
+
+    for (auto &queue : abortedNotifications)
+    {
+        failNotifications(queue.second, queue.first, NRF_ERROR_INVALID_STATE);
+    }
+
+    // The adapter the sender was given is closed
+    stopSender();
+
+    // Call the completions that are queued, including the aborted procedures
+    onCompletion();
+
+    std::lock_guard<std::mutex> lock(completionMutex);
+
+    if (asyncCompletion != nullptr)
+    {
+        uv_close(reinterpret_cast<uv_handle_t *>(asyncCompletion), [](uv_handle_t *handle) {
+            delete reinterpret_cast<uv_async_t *>(handle);
+        });
+
+        asyncCompletion = nullptr;
+    }
+
+    if (indicationTimer != nullptr)
+    {
+        uv_timer_stop(indicationTimer);
+        uv_close(reinterpret_cast<uv_handle_t *>(indicationTimer), [](uv_handle_t *handle) {
+            delete reinterpret_cast<uv_timer_t *>(handle);
+        });
+
+        indicationTimer = nullptr;
+    }
+}
+
+void GattServer::post(GattServerCompletion completion)
+{
+    std::lock_guard<std::mutex> lock(completionMutex);
+    completions.push_back(std::move(completion));
+
+    if (asyncCompletion != nullptr)
+    {
+        uv_async_send(asyncCompletion);
+    }
+}
+
+// This runs in Main Thread
+void GattServer::startSender()
+{
+    if (sender.joinable())
+    {
+        return;
+    }
+
+    sender = std::thread([this]() { runSender(); });
+}
+
+// This runs in Main Thread
+void GattServer::stopSender()
+{
+    if (!sender.joinable())
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        senderStop = true;
+    }
+
+    senderWake.notify_all();
+    sender.join();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    senderStop = false;
+    scheduleRequested = false;
+    indicationsRequested = false;
+    senderAdapter = nullptr;
+}
+
+// This runs in the sender thread (not Main Thread)
+void GattServer::runSender()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+
+    while (true)
+    {
+        senderWake.wait(lock, [this]() { return senderStop || scheduleRequested || indicationsRequested; });
+
+        if (senderStop)
+        {
+            return;
+        }
+
+        if (indicationsRequested)
+        {
+            // The indication mutex is taken before the mutex, never after it
+            indicationsRequested = false;
+            auto adapter = senderAdapter;
+
+            lock.unlock();
+            issueWaitingIndications(adapter);
+            lock.lock();
+        }
+
+        if (scheduleRequested)
+        {
+            scheduleRequested = false;
+            scheduleNotifications(senderAdapter, lock);
+        }
+    }
+}
+
+// Can be called from any thread
+void GattServer::queueWork(GattServerCompletion work)
+{
+    post([this, work]() {
+        {
+            std::lock_guard<std::mutex> lock(workerMutex);
+            workersRunning++;
+        }
+
+        auto req = new uv_work_t();
+        req->data = new GattServerWork{ this, work };
+        uv_queue_work(uv_default_loop(), req, server_work, server_work_done);
+    });
+}
+
+// This runs in a worker thread (not Main Thread), the worker does not use this afterwards
+void GattServer::onWorkDone()
+{
+    std::lock_guard<std::mutex> lock(workerMutex);
+    workersRunning--;
+    workersDone.notify_all();
+}
+
+// This runs in Main Thread
+void GattServer::onCompletion()
+{
+    std::vector<GattServerCompletion> pending;
+
+    {
+        std::lock_guard<std::mutex> lock(completionMutex);
+        pending.swap(completions);
+    }
+
+    for (auto &completion : pending)
+    {
+        Nan::HandleScope scope;
+        completion();
+    }
+}
+
+bool GattServer::onEvent(adapter_t *adapter, const ble_evt_t *event)
+{
+    auto eventId = event->header.evt_id;
+    uint16_t connHandle;
+
+    if (eventId == BLE_GAP_EVT_DISCONNECTED)
+    {
+        connHandle = event->evt.gap_evt.conn_handle;
+
+        {
+            std::lock_guard<std::mutex> lock(indicationMutex);
+            auto indications = indicationQueues.find(connHandle);
+
+            if (indications != indicationQueues.end())
+            {
+                failIndications(indications->second, BLE_ERROR_INVALID_CONN_HANDLE);
+                indicationQueues.erase(indications);
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        auto queue = notificationQueues.find(connHandle);
+
+        if (queue != notificationQueues.end())
+        {
+            failNotifications(queue->second, connHandle, BLE_ERROR_INVALID_CONN_HANDLE);
+            notificationQueues.erase(queue);
+        }
+
+        // The handle is reused by the next connection
+        metrics.resetQueuedNotifications(connHandle);
+
+        // The SoftDevice may already have released the connection, the
+        // system attributes are saved on bonding and CCCD writes as well
+        auto peer = peers.find(connHandle);
+
+        if (peer != peers.end() && peer->second.bonded)
+        {
+            saveSystemAttributes(adapter, connHandle);
+        }
+
+        cccdValues.erase(connHandle);
+        peers.erase(connHandle);
+        preparedWrites.erase(connHandle);
+        pendingAuthorizations.erase(connHandle);
+        invalidateConnectionValues(connHandle);
+
+        // JavaScript handles the disconnect as well
+        return false;
+    }
+
+    if (eventId == BLE_GAP_EVT_CONNECTED)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto &peer = peers[event->evt.gap_evt.conn_handle];
+        peer.address = event->evt.gap_evt.params.connected.peer_addr;
+        identifyPeer(peer);
+        return false;
+    }
+
+    if (eventId == BLE_GAP_EVT_AUTH_STATUS)
+    {
+        auto &authStatus = event->evt.gap_evt.params.auth_status;
+
+        if (authStatus.auth_status == BLE_GAP_SEC_STATUS_SUCCESS && authStatus.bonded)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto &peer = peers[event->evt.gap_evt.conn_handle];
+            peer.bonded = true;
+
+            // The identity the peer distributed is taken in Main Thread with
+            // the keyset, the system attributes are kept until then
+            if (authStatus.kdist_peer.id)
+            {
+                peer.identified = false;
+            }
+
+            saveSystemAttributes(adapter, event->evt.gap_evt.conn_handle);
+        }
+
+        return false;
+    }
+
+    if (eventId == BLE_GATTS_EVT_WRITE)
+    {
+        connHandle = event->evt.gatts_evt.conn_handle;
+        auto &write = event->evt.gatts_evt.params.write;
+
+        std::lock_guard<std::mutex> lock(mutex);
+
+        if (write.op == BLE_GATTS_OP_WRITE_REQ || write.op == BLE_GATTS_OP_WRITE_CMD || write.op == BLE_GATTS_OP_SIGN_WRITE_CMD)
+        {
+            valueChanged(connHandle, write.handle, write.offset, write.data, write.len);
+        }
+        else if (write.op == BLE_GATTS_OP_EXEC_WRITE_REQ_NOW)
+        {
+            // The writes executed from the queue in user memory are not reported
+            invalidateConnectionValues(BLE_CONN_HANDLE_INVALID);
+        }
+
+        if (write.uuid.type == BLE_UUID_TYPE_BLE && write.uuid.uuid == BLE_UUID_DESCRIPTOR_CLIENT_CHAR_CONFIG)
+        {
+            onCccdWrite(connHandle, write);
+
+            auto peer = peers.find(connHandle);
+
+            if (peer != peers.end() && peer->second.bonded)
+            {
+                saveSystemAttributes(adapter, connHandle);
+            }
+        }
+
+        // JavaScript handles the write as well
+        return false;
+    }
+
+    if (eventId == BLE_GATTS_EVT_SYS_ATTR_MISSING)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        invalidateConnectionValues(event->evt.gatts_evt.conn_handle);
+
+        // JavaScript sets the system attributes of peers that are not known
+        return restoreSystemAttributes(adapter, event->evt.gatts_evt.conn_handle);
+    }
+
+    if (eventId == BLE_GATTS_EVT_RW_AUTHORIZE_REQUEST)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return onAuthorizeRequest(adapter, event->evt.gatts_evt.conn_handle, event->evt.gatts_evt.params.authorize_request);
+    }
+
+    if (eventId == BLE_GATTS_EVT_HVC)
+    {
+        std::lock_guard<std::mutex> lock(indicationMutex);
+
+        // JavaScript handles the confirmations of the indications it issued
+        return onIndicationConfirmed(adapter, event->evt.gatts_evt.conn_handle);
+    }
+
+    if (eventId == BLE_GATTS_EVT_TIMEOUT)
+    {
+        connHandle = event->evt.gatts_evt.conn_handle;
+
+        // No more ATT traffic is possible on the connection
+        std::lock_guard<std::mutex> lock(indicationMutex);
+        auto indications = indicationQueues.find(connHandle);
+
+        if (indications != indicationQueues.end())
+        {
+            failIndications(indications->second, NRF_ERROR_TIMEOUT);
+            indicationQueues.erase(indications);
+        }
+
+        // JavaScript handles the timeout as well
+        return false;
+    }
+
+#if NRF_SD_BLE_API_VERSION <= 3
+    if (eventId != BLE_EVT_TX_COMPLETE)
+    {
+        return false;
+    }
+
+    connHandle = event->evt.common_evt.conn_handle;
+    uint32_t sent = event->evt.common_evt.params.tx_complete.count;
+#else
+    if (eventId != BLE_GATTS_EVT_HVN_TX_COMPLETE)
+    {
+        return false;
+    }
+
+    connHandle = event->evt.gatts_evt.conn_handle;
+    uint32_t sent = event->evt.gatts_evt.params.hvn_tx_complete.count;
+#endif
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto queue = notificationQueues.find(connHandle);
+
+    if (queue != notificationQueues.end())
+    {
+        // The count includes packets not issued from the queue
+        queue->second.txQueueFull = false;
+        queue->second.txCompleteCount++;
+        queue->second.inFlight -= std::min(sent, queue->second.inFlight);
+
+        // The SoftDevice is not called on the thread that delivers the events
+        if (!queue->second.pending.empty())
+        {
+            scheduleRequested = true;
+            senderAdapter = adapter;
+            senderWake.notify_one();
+        }
+    }
+
+    // JavaScript handles the event as well
+    return false;
+}
+
+// This runs in a worker thread (not Main Thread)
+void GattServer::queueNotification(adapter_t *adapter, uint16_t connHandle, GattNotification notification)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    notificationQueues[connHandle].pending.push_back(std::move(notification));
+    scheduleNotifications(adapter, lock);
+}
+
+// This runs in Main Thread
+void GattServer::setConnectionWeight(uint16_t connHandle, uint16_t weight)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    notificationQueues[connHandle].weight = weight;
+}
+
+// Called with the mutex held. It is released while the SoftDevice is called.
+// One thread issues notifications at a time, so that the notifications of a
+// connection are issued in order. The other threads leave theirs to it, as
+// it issues notifications until none of the queues is ready.
+void GattServer::scheduleNotifications(adapter_t *adapter, std::unique_lock<std::mutex> &lock)
+{
+    if (scheduling)
+    {
+        return;
+    }
+
+    scheduling = true;
+
+    runNotificationRounds(notificationQueues, scheduleStart, [this, adapter, &lock](uint16_t connHandle) {
+        issueNotification(adapter, connHandle, lock);
+    });
+
+    scheduling = false;
+}
+
+// Called with the mutex held, it is released while the SoftDevice is called.
+// The notification is taken from the queue meanwhile, and put back if the
+// SoftDevice had no room for it.
+void GattServer::issueNotification(adapter_t *adapter, uint16_t connHandle, std::unique_lock<std::mutex> &lock)
+{
+    auto &issuing = notificationQueues[connHandle];
+    auto notification = std::move(issuing.pending.front());
+    issuing.pending.pop_front();
+
+    // Counted in flight before the SoftDevice is called, as it may report the
+    // packet sent before the mutex is taken again
+    auto txCompleteCount = issuing.txCompleteCount;
+    issuing.inFlight++;
+
+    auto length = static_cast<uint16_t>(notification.value.size());
+    auto key = mirrorKey(connHandle, notification.handle);
+    auto generation = valueGenerations[key];
+
+    ble_gatts_hvx_params_t hvxParams;
+    hvxParams.handle = notification.handle;
+    hvxParams.type = BLE_GATT_HVX_NOTIFICATION;
+    hvxParams.offset = 0;
+    hvxParams.p_len = &length;
+    hvxParams.p_data = notification.value.data();
+
+    lock.unlock();
+    auto result = sd_ble_gatts_hvx(adapter, connHandle, &hvxParams);
+    lock.lock();
+
+    if (result == NRF_SUCCESS)
+    {
+        // Another change may have reached the SoftDevice before or after this one
+        if (valueGenerations[key] != generation)
+        {
+            dropValue(key);
+        }
+
+        valueChanged(connHandle, notification.handle, 0, notification.value.data(), length);
+
+        auto waited = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - notification.queued);
+        metrics.countQueuedNotification(connHandle, length, static_cast<uint64_t>(waited.count()));
+    }
+    else
+    {
+        // The SoftDevice may update the value even if the notification is not sent
+        dropValue(key);
+    }
+
+    auto queue = notificationQueues.find(connHandle);
+
+    if (queue == notificationQueues.end())
+    {
+        // Disconnected meanwhile, the queue failed the notifications waiting in it
+        completeNotification(notification, connHandle, (result == TX_QUEUE_FULL) ? BLE_ERROR_INVALID_CONN_HANDLE : result, 0);
+        return;
+    }
+
+    if (result != NRF_SUCCESS)
+    {
+        queue->second.inFlight -= std::min<uint32_t>(1, queue->second.inFlight);
+    }
+
+    if (result == TX_QUEUE_FULL)
+    {
+        // Issued again when the SoftDevice reports that packets are sent, or
+        // right away if it did so while it was called
+        queue->second.txQueueFull = (queue->second.txCompleteCount == txCompleteCount);
+        queue->second.pending.push_front(std::move(notification));
+        return;
+    }
+
+    queue->second.deficit -= std::min<uint32_t>(length, queue->second.deficit);
+    completeNotification(notification, connHandle, result, queue->second.pending.size());
+}
+
+void GattServer::completeNotification(GattNotification &notification, uint16_t connHandle, uint32_t result, size_t queued)
+{
+    auto callback = notification.callback;
+    auto group = notification.group;
+
+    // The callbacks must be released in Main Thread
+    notification.callback.reset();
+    notification.group.reset();
+
+    post([callback, group, connHandle, result, queued]() {
+        v8::Local<v8::Value> argv[2];
+
+        if (group)
+        {
+            group->results[connHandle] = result;
+
+            if (--group->remaining > 0)
+            {
+                return;
+            }
+
+            // Undefined for the connections that were notified
+            auto results = Nan::New<v8::Object>();
+
+            for (auto &connectionResult : group->results)
+            {
+                if (connectionResult.second != NRF_SUCCESS)
+                {
+                    Nan::Set(results, Nan::New<v8::Number>(connectionResult.first), ErrorMessage::getErrorMessage(connectionResult.second, "hvx"));
+                }
+                else
+                {
+                    Nan::Set(results, Nan::New<v8::Number>(connectionResult.first), Nan::Undefined());
+                }
+            }
+
+            argv[0] = Nan::Undefined();
+            argv[1] = results;
+
+            Nan::AsyncResource resource("pc-ble-driver-js:callback");
+            group->callback->Call(2, argv, &resource);
+            return;
+        }
+
+        if (result != NRF_SUCCESS)
+        {
+            argv[0] = ErrorMessage::getErrorMessage(result, "hvx");
+            argv[1] = Nan::Undefined();
+        }
+        else
+        {
+            argv[0] = Nan::Undefined();
+            argv[1] = Nan::New<v8::Number>(static_cast<double>(queued));
+        }
+
+        Nan::AsyncResource resource("pc-ble-driver-js:callback");
+        callback->Call(2, argv, &resource);
+    });
+}
+
+void GattServer::failNotifications(GattNotificationQueue &queue, uint16_t connHandle, uint32_t result)
+{
+    for (auto &notification : queue.pending)
+    {
+        completeNotification(notification, connHandle, result, 0);
+    }
+
+    queue.pending.clear();
+}
+
+// This runs in a worker thread (not Main Thread)
+void GattServer::queueIndication(adapter_t *adapter, uint16_t connHandle, GattIndication indication)
+{
+    std::lock_guard<std::mutex> lock(indicationMutex);
+    auto &queue = indicationQueues[connHandle];
+    queue.pending.push_back(std::move(indication));
+    issueIndications(adapter, connHandle, queue);
+}
+
+// This runs in Main Thread
+void GattServer::setIndicationTimeout(uint32_t milliseconds)
+{
+    std::lock_guard<std::mutex> lock(indicationMutex);
+    indicationTimeout = std::chrono::milliseconds(milliseconds);
+}
+
+// This runs in the sender thread (not Main Thread)
+void GattServer::issueWaitingIndications(adapter_t *adapter)
+{
+    std::lock_guard<std::mutex> lock(indicationMutex);
+
+    for (auto &queue : indicationQueues)
+    {
+        issueIndications(adapter, queue.first, queue.second);
+    }
+}
+
+// Called with the indication mutex held, not the mutex. Never called in the
+// thread that delivers the events, as it waits for the SoftDevice.
+void GattServer::issueIndications(adapter_t *adapter, uint16_t connHandle, GattIndicationQueue &queue)
+{
+    while (queue.state == GattIndicationQueue::State::Idle && !queue.pending.empty())
+    {
+        auto &indication = queue.pending.front();
+        auto length = static_cast<uint16_t>(indication.value.size());
+        std::pair<uint16_t, uint16_t> key;
+        uint32_t generation;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            key = mirrorKey(connHandle, indication.handle);
+            generation = valueGenerations[key];
+        }
+
+        ble_gatts_hvx_params_t hvxParams;
+        hvxParams.handle = indication.handle;
+        hvxParams.type = BLE_GATT_HVX_INDICATION;
+        hvxParams.offset = 0;
+        hvxParams.p_len = &length;
+        hvxParams.p_data = indication.value.data();
+
+        auto result = sd_ble_gatts_hvx(adapter, connHandle, &hvxParams);
+
+        if (result == NRF_SUCCESS)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+
+                // Another change may have reached the SoftDevice before or after this one
+                if (valueGenerations[key] != generation)
+                {
+                    dropValue(key);
+                }
+
+                valueChanged(connHandle, indication.handle, 0, indication.value.data(), length);
+            }
+
+            metrics.countBytesNotified(connHandle, length);
+
+            queue.state = GattIndicationQueue::State::Issued;
+            queue.deadline = std::chrono::steady_clock::now() + indicationTimeout;
+            post([this]() { startIndicationTimer(); });
+            return;
+        }
+
+        {
+            // The SoftDevice may update the value even if the indication is not sent
+            std::lock_guard<std::mutex> lock(mutex);
+            dropValue(key);
+        }
+
+        if (result == NRF_ERROR_BUSY)
+        {
+            // Issued when the indication JavaScript issued is confirmed
+            queue.state = GattIndicationQueue::State::Blocked;
+            return;
+        }
+
+        completeIndication(indication, result);
+        queue.pending.pop_front();
+    }
+}
+
+// Called with the indication mutex held. Returns true if the indication confirmed was issued by the binding.
+bool GattServer::onIndicationConfirmed(adapter_t *adapter, uint16_t connHandle)
+{
+    auto queue = indicationQueues.find(connHandle);
+
+    if (queue == indicationQueues.end() || queue->second.state == GattIndicationQueue::State::Idle)
+    {
+        return false;
+    }
+
+    auto state = queue->second.state;
+
+    if (state == GattIndicationQueue::State::Issued)
+    {
+        completeIndication(queue->second.pending.front(), NRF_SUCCESS);
+        queue->second.pending.pop_front();
+    }
+
+    queue->second.state = GattIndicationQueue::State::Idle;
+
+    // The SoftDevice is not called on the thread that delivers the events
+    if (!queue->second.pending.empty())
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        indicationsRequested = true;
+        senderAdapter = adapter;
+        senderWake.notify_one();
+    }
+
+    return state != GattIndicationQueue::State::Blocked;
+}
+
+// Called with the indication mutex held
+void GattServer::completeIndication(GattIndication &indication, uint32_t result)
+{
+    // The callback must be released in Main Thread
+    GattIndicationResult indicationResult;
+    indicationResult.callback.swap(indication.callback);
+    indicationResult.result = result;
+    indicationResults.push_back(std::move(indicationResult));
+
+    // Results are reported in batches, one report is outstanding at a time
+    if (indicationResults.size() == 1)
+    {
+        post([this]() { reportIndications(); });
+    }
+}
+
+// Called with the indication mutex held
+void GattServer::failIndications(GattIndicationQueue &queue, uint32_t result)
+{
+    for (auto &indication : queue.pending)
+    {
+        completeIndication(indication, result);
+    }
+
+    queue.pending.clear();
+}
+
+// This runs in Main Thread
+void GattServer::reportIndications()
+{
+    std::vector<GattIndicationResult> results;
+
+    {
+        std::lock_guard<std::mutex> lock(indicationMutex);
+        results.swap(indicationResults);
+    }
+
+    for (auto &indicationResult : results)
+    {
+        v8::Local<v8::Value> argv[1];
+
+        if (indicationResult.result == NRF_SUCCESS)
+        {
+            argv[0] = Nan::Undefined();
+        }
+        else if (indicationResult.result == NRF_ERROR_TIMEOUT)
+        {
+            argv[0] = ErrorMessage::getErrorMessage(indicationResult.result, "indication confirmation");
+        }
+        else
+        {
+            argv[0] = ErrorMessage::getErrorMessage(indicationResult.result, "hvx");
+        }
+
+        Nan::AsyncResource resource("pc-ble-driver-js:callback");
+        indicationResult.callback->Call(1, argv, &resource);
+    }
+}
+
+// This runs in Main Thread
+void GattServer::startIndicationTimer()
+{
+    if (indicationTimer == nullptr)
+    {
+        return;
+    }
+
+    auto issued = false;
+    std::chrono::steady_clock::time_point deadline;
+
+    {
+        std::lock_guard<std::mutex> lock(indicationMutex);
+
+        for (auto &queue : indicationQueues)
+        {
+            if (queue.second.state == GattIndicationQueue::State::Issued && (!issued || queue.second.deadline < deadline))
+            {
+                deadline = queue.second.deadline;
+                issued = true;
+            }
+        }
+    }
+
+    if (!issued)
+    {
+        uv_timer_stop(indicationTimer);
+        return;
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    uint64_t timeout = 0;
+
+    if (deadline > now)
+    {
+        // Rounded up, so that the deadline has passed when the timer fires
+        timeout = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now).count() + 1;
+    }
+
+    uv_timer_start(indicationTimer, indication_timeout_handler, timeout, 0);
+}
+
+// This runs in Main Thread
+void GattServer::onIndicationTimeout()
+{
+    {
+        std::lock_guard<std::mutex> lock(indicationMutex);
+        auto now = std::chrono::steady_clock::now();
+
+        for (auto &queue : indicationQueues)
+        {
+            if (queue.second.state == GattIndicationQueue::State::Issued && queue.second.deadline <= now)
+            {
+                completeIndication(queue.second.pending.front(), NRF_ERROR_TIMEOUT);
+                queue.second.pending.pop_front();
+
+                // The SoftDevice issues no other indication until this one is confirmed
+                queue.second.state = GattIndicationQueue::State::TimedOut;
+            }
+        }
+    }
+
+    startIndicationTimer();
+}
+
+// This runs in a worker thread (not Main Thread)
+void GattServer::notifyAll(adapter_t *adapter, uint16_t valueHandle, const std::vector<uint8_t> &value, std::shared_ptr<Nan::Callback> callback)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    std::vector<uint16_t> connHandles;
+
+    for (auto &connection : cccdValues)
+    {
+        auto cccdValue = connection.second.find(valueHandle);
+
+        if (cccdValue != connection.second.end() && (cccdValue->second & CCCD_NOTIFICATION) != 0)
+        {
+            connHandles.push_back(connection.first);
+        }
+    }
+
+    auto group = std::make_shared<GattNotificationGroup>(connHandles.size(), callback);
+
+    if (connHandles.empty())
+    {
+        post([group]() {
+            v8::Local<v8::Value> argv[2] = { Nan::Undefined(), Nan::New<v8::Object>() };
+
+            Nan::AsyncResource resource("pc-ble-driver-js:callback");
+            group->callback->Call(2, argv, &resource);
+        });
+
+        return;
+    }
+
+    for (auto connHandle : connHandles)
+    {
+        GattNotification notification(valueHandle, nullptr);
+        notification.value = value;
+        notification.group = group;
+
+        notificationQueues[connHandle].pending.push_back(std::move(notification));
+    }
+
+    scheduleNotifications(adapter, lock);
+}
+
+// This runs in a worker thread (not Main Thread)
+void GattServer::addCccd(uint16_t cccdHandle, uint16_t valueHandle)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    cccdValueHandles[cccdHandle] = valueHandle;
+}
+
+// This runs in a worker thread (not Main Thread)
+void GattServer::addAttribute(uint16_t handle, uint16_t maxLength)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    attributeMaxLengths[handle] = maxLength;
+}
+
+// Called with the mutex held
+void GattServer::onCccdWrite(uint16_t connHandle, const ble_gatts_evt_write_t &write)
+{
+    auto valueHandle = cccdValueHandles.find(write.handle);
+
+    if (valueHandle == cccdValueHandles.end() || write.offset != 0 || write.len < 2)
+    {
+        return;
+    }
+
+    cccdValues[connHandle][valueHandle->second] = static_cast<uint16_t>(write.data[0] | (write.data[1] << 8));
+}
+
+// This runs in Main Thread
+void GattServer::setAttributeStore(uint16_t handle, GattAttributeStore store)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    attributeStores[handle] = std::move(store);
+}
+
+// This runs in Main Thread
+void GattServer::clearAttributeStore(uint16_t handle)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    attributeStores.erase(handle);
+}
+
+// This runs in a worker thread (not Main Thread)
+uint32_t GattServer::valueGeneration(uint16_t connHandle, uint16_t handle)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return valueGenerations[mirrorKey(connHandle, handle)];
+}
+
+// This runs in a worker thread (not Main Thread)
+void GattServer::updateValue(uint16_t connHandle, uint16_t handle, uint16_t offset, const uint8_t *data, uint16_t length, uint32_t generation)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto key = mirrorKey(connHandle, handle);
+
+    // Another change may have reached the SoftDevice before or after this one
+    if (valueGenerations[key] != generation)
+    {
+        dropValue(key);
+    }
+
+    valueChanged(connHandle, handle, offset, data, length);
+}
+
+// Called with the mutex held
+void GattServer::dropValue(const std::pair<uint16_t, uint16_t> &key)
+{
+    valueGenerations[key]++;
+    valueMirror.erase(key);
+}
+
+// Called with the mutex held
+void GattServer::valueChanged(uint16_t connHandle, uint16_t handle, uint16_t offset, const uint8_t *data, uint16_t length)
+{
+    auto key = mirrorKey(connHandle, handle);
+    auto store = attributeStores.find(handle);
+
+    valueGenerations[key]++;
+
+    if (key.first == BLE_CONN_HANDLE_INVALID && store != attributeStores.end() && offset <= store->second.value.size())
+    {
+        applyWrite(store->second.value, offset, data, length);
+    }
+
+    auto mirrored = valueMirror.find(key);
+
+    if (mirrored == valueMirror.end())
+    {
+        return;
+    }
+
+    auto &value = mirrored->second;
+
+    // A write that ends before the value does shortens variable length
+    // values only, which one the attribute is is not known here
+    if (offset + length < value.size() || offset > value.size())
+    {
+        valueMirror.erase(mirrored);
+        return;
+    }
+
+    applyWrite(value, offset, data, length);
+}
+
+// Called with the mutex held
+std::pair<uint16_t, uint16_t> GattServer::mirrorKey(uint16_t connHandle, uint16_t handle) const
+{
+    // CCCDs are the only attributes with a value for each connection
+    if (cccdValueHandles.find(handle) == cccdValueHandles.end())
+    {
+        return std::make_pair(BLE_CONN_HANDLE_INVALID, handle);
+    }
+
+    return std::make_pair(connHandle, handle);
+}
+
+// This runs in a worker thread (not Main Thread)
+bool GattServer::readValue(uint16_t connHandle, uint16_t handle, ble_gatts_value_t &value, uint32_t &generation)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto key = mirrorKey(connHandle, handle);
+    auto mirrored = valueMirror.find(key);
+
+    if (mirrored == valueMirror.end() || value.offset > mirrored->second.size())
+    {
+        generation = valueGenerations[key];
+        return false;
+    }
+
+    auto available = static_cast<uint16_t>(mirrored->second.size() - value.offset);
+
+    // As the SoftDevice, only report the length when there is no buffer
+    if (value.p_value != nullptr)
+    {
+        available = std::min(available, value.len);
+        std::memcpy(value.p_value, mirrored->second.data() + value.offset, available);
+    }
+
+    value.len = available;
+    return true;
+}
+
+// This runs in a worker thread (not Main Thread)
+void GattServer::mirrorValue(uint16_t connHandle, uint16_t handle, uint16_t bufferLength, const ble_gatts_value_t &value, uint32_t generation)
+{
+    // Only a read of the whole value can be mirrored
+    if (value.offset != 0 || value.p_value == nullptr || (value.len >= bufferLength && bufferLength < BLE_GATTS_VAR_ATTR_LEN_MAX))
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto key = mirrorKey(connHandle, handle);
+
+    // The value read may be older than a change made while it was read
+    if (valueGenerations[key] != generation)
+    {
+        return;
+    }
+
+    valueMirror[key].assign(value.p_value, value.p_value + value.len);
+}
+
+// This runs in a worker thread (not Main Thread)
+void GattServer::invalidateValue(uint16_t connHandle, uint16_t handle)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    dropValue(mirrorKey(connHandle, handle));
+}
+
+// This runs in a worker thread (not Main Thread)
+void GattServer::invalidateValues(uint16_t connHandle)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    invalidateConnectionValues(connHandle);
+}
+
+// This runs in a worker thread (not Main Thread)
+void GattServer::systemAttributesSet(uint16_t connHandle, const uint8_t *data, uint16_t length, uint32_t flags)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    invalidateConnectionValues(connHandle);
+
+    // The CCCDs of the services in the attribute table are not set
+    if ((flags & (BLE_GATTS_SYS_ATTR_FLAG_SYS_SRVCS | BLE_GATTS_SYS_ATTR_FLAG_USR_SRVCS)) == BLE_GATTS_SYS_ATTR_FLAG_SYS_SRVCS)
+    {
+        return;
+    }
+
+    // Without data the CCCDs are cleared
+    loadCccdValues(connHandle, data, length);
+}
+
+// Called with the mutex held
+void GattServer::invalidateConnectionValues(uint16_t connHandle)
+{
+    auto first = std::make_pair(connHandle, static_cast<uint16_t>(0));
+    auto last = std::make_pair(connHandle, static_cast<uint16_t>(0xFFFF));
+
+    valueMirror.erase(valueMirror.lower_bound(first), valueMirror.upper_bound(last));
+
+    for (auto generation = valueGenerations.lower_bound(first); generation != valueGenerations.upper_bound(last); ++generation)
+    {
+        generation->second++;
+    }
+}
+
+// This runs in a worker thread (not Main Thread)
+void GattServer::onAuthorizeReply(uint16_t connHandle, const ble_gatts_rw_authorize_reply_params_t &reply)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto pending = pendingAuthorizations.find(connHandle);
+
+    if (pending == pendingAuthorizations.end())
+    {
+        return;
+    }
+
+    auto handle = pending->second;
+    pendingAuthorizations.erase(pending);
+
+    auto &params = reply.type == BLE_GATTS_AUTHORIZE_TYPE_READ ? reply.params.read : reply.params.write;
+
+    // The reply is not ordered against changes made while it was sent
+    if (params.gatt_status == BLE_GATT_STATUS_SUCCESS && params.update)
+    {
+        dropValue(mirrorKey(connHandle, handle));
+    }
+}
+
+// Called with the mutex held
+bool GattServer::onAuthorizeRequest(adapter_t *adapter, uint16_t connHandle, const ble_gatts_evt_rw_authorize_request_t &request)
+{
+    ble_gatts_rw_authorize_reply_params_t reply;
+    std::memset(&reply, 0, sizeof(reply));
+    reply.type = request.type;
+
+    if (request.type == BLE_GATTS_AUTHORIZE_TYPE_READ)
+    {
+        auto &read = request.request.read;
+        auto store = attributeStores.find(read.handle);
+
+        if (store == attributeStores.end() || !store->second.serveReads)
+        {
+            pendingAuthorizations[connHandle] = read.handle;
+            return false;
+        }
+
+        auto &value = store->second.value;
+
+        if (read.offset > value.size())
+        {
+            reply.params.read.gatt_status = BLE_GATT_STATUS_ATTERR_INVALID_OFFSET;
+        }
+        else
+        {
+            reply.params.read.gatt_status = BLE_GATT_STATUS_SUCCESS;
+            reply.params.read.update = 1;
+            reply.params.read.offset = read.offset;
+            reply.params.read.len = static_cast<uint16_t>(value.size() - read.offset);
+            reply.params.read.p_data = value.data() + read.offset;
+        }
+
+        // The reply updates the SoftDevice with the value it already has, the
+        // store is written through by every change of the value
+        auto result = sd_ble_gatts_rw_authorize_reply(adapter, connHandle, &reply);
+
+        if (result != NRF_SUCCESS)
+        {
+            std::cerr << "Failed to reply to read of handle " << read.handle << ", error code " << result << "." << std::endl;
+        }
+
+        // Reads are reported in batches, one report is outstanding at a time
+        if (store->second.unreportedReads++ == 0)
+        {
+            auto handle = read.handle;
+            post([this, handle]() { reportReads(handle); });
+        }
+
+        return true;
+    }
+
+    if (request.type != BLE_GATTS_AUTHORIZE_TYPE_WRITE)
+    {
+        return false;
+    }
+
+    if (request.request.write.op != BLE_GATTS_OP_WRITE_REQ)
+    {
+        return onPreparedWrite(adapter, connHandle, request.request.write);
+    }
+
+    auto &write = request.request.write;
+    auto store = attributeStores.find(write.handle);
+
+    if (store == attributeStores.end() || store->second.writePolicy == GattAttributeStore::WritePolicy::Pass)
+    {
+        pendingAuthorizations[connHandle] = write.handle;
+        return false;
+    }
+
+    auto &value = store->second.value;
+
+    if (store->second.writePolicy == GattAttributeStore::WritePolicy::Reject)
+    {
+        reply.params.write.gatt_status = store->second.rejectStatus;
+    }
+    else if (write.offset > value.size())
+    {
+        reply.params.write.gatt_status = BLE_GATT_STATUS_ATTERR_INVALID_OFFSET;
+    }
+    else if (write.offset + write.len > store->second.maxLength)
+    {
+        reply.params.write.gatt_status = BLE_GATT_STATUS_ATTERR_INVALID_ATT_VAL_LENGTH;
+    }
+    else
+    {
+        reply.params.write.gatt_status = BLE_GATT_STATUS_SUCCESS;
+        reply.params.write.update = 1;
+        reply.params.write.offset = write.offset;
+        reply.params.write.len = write.len;
+        reply.params.write.p_data = write.data;
+    }
+
+    auto result = sd_ble_gatts_rw_authorize_reply(adapter, connHandle, &reply);
+
+    if (result != NRF_SUCCESS)
+    {
+        std::cerr << "Failed to reply to write of handle " << write.handle << ", error code " << result << "." << std::endl;
+        return true;
+    }
+
+    if (reply.params.write.gatt_status != BLE_GATT_STATUS_SUCCESS)
+    {
+        return true;
+    }
+
+    // Updates the value of the store as well
+    valueChanged(BLE_CONN_HANDLE_INVALID, write.handle, write.offset, write.data, write.len);
+
+    auto callback = store->second.callback;
+    auto handle = write.handle;
+    auto offset = write.offset;
+    std::vector<uint8_t> written(value);
+
+    post([callback, connHandle, handle, offset, written]() {
+        auto summary = Nan::New<v8::Object>();
+        Utility::Set(summary, "conn_handle", connHandle);
+        Utility::Set(summary, "handle", handle);
+        Utility::Set(summary, "offset", offset);
+        Utility::Set(summary, "value", ConversionUtility::toJsValueArray(written.data(), static_cast<uint16_t>(written.size())));
+
+        v8::Local<v8::Value> argv[1] = { summary };
+
+        Nan::AsyncResource resource("pc-ble-driver-js:callback");
+        callback->Call(1, argv, &resource);
+    });
+
+    return true;
+}
+
+// This runs in Main Thread
+void GattServer::reportReads(uint16_t handle)
+{
+    std::shared_ptr<Nan::Callback> callback;
+    uint32_t reads;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto store = attributeStores.find(handle);
+
+        if (store == attributeStores.end())
+        {
+            return;
+        }
+
+        callback = store->second.callback;
+        reads = store->second.unreportedReads;
+        store->second.unreportedReads = 0;
+    }
+
+    if (reads == 0)
+    {
+        return;
+    }
+
+    auto summary = Nan::New<v8::Object>();
+    Utility::Set(summary, "handle", handle);
+    Utility::Set(summary, "reads", reads);
+
+    v8::Local<v8::Value> argv[1] = { summary };
+
+    Nan::AsyncResource resource("pc-ble-driver-js:callback");
+    callback->Call(1, argv, &resource);
+}
+
+// This runs in Main Thread. The files are read before the connections
+// need them, so that the events are never kept waiting for the disk.
+void GattServer::setSystemAttributeDirectory(const std::string &directory)
+{
+    std::vector<GattPeerIdentity> loadedIdentities;
+    std::map<std::string, std::vector<uint8_t>> loadedSystemAttributes;
+    std::vector<uint8_t> data;
+
+    if (!directory.empty() && readFile(directory + "/" + IDENTITY_FILE, data))
+    {
+        for (size_t index = 0; index + IDENTITY_RECORD_SIZE <= data.size(); index += IDENTITY_RECORD_SIZE)
+        {
+            GattPeerIdentity identity;
+            std::memset(&identity.address, 0, sizeof(identity.address));
+            identity.address.addr_type = data[index];
+            std::memcpy(identity.address.addr, &data[index + 1], BLE_GAP_ADDR_LEN);
+            std::memcpy(identity.irk, &data[index + 1 + BLE_GAP_ADDR_LEN], BLE_GAP_SEC_KEY_LEN);
+            loadedIdentities.push_back(identity);
+        }
+    }
+
+    std::vector<std::string> names;
+
+    if (!directory.empty())
+    {
+        listDirectory(directory, SYSTEM_ATTRIBUTE_SUFFIX, names);
+    }
+
+    for (const auto &name : names)
+    {
+        auto path = directory + "/" + name;
+
+        if (readFile(path, data) && !data.empty())
+        {
+            loadedSystemAttributes[path] = std::move(data);
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    systemAttributeDirectory = directory;
+    identities.swap(loadedIdentities);
+    systemAttributes.swap(loadedSystemAttributes);
+}
+
+// This runs in Main Thread
+void GattServer::setPeerIdentity(uint16_t connHandle, const ble_gap_id_key_t &idKey)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto peer = peers.find(connHandle);
+
+    if (peer == peers.end())
+    {
+        return;
+    }
+
+    peer->second.identified = true;
+    peer->second.identity = idKey.id_addr_info;
+
+    auto known = std::find_if(identities.begin(), identities.end(), [&idKey](const GattPeerIdentity &identity) {
+        return sameAddress(identity.address, idKey.id_addr_info);
+    });
+
+    if (known == identities.end())
+    {
+        identities.emplace_back();
+        known = identities.end() - 1;
+        known->address = idKey.id_addr_info;
+    }
+
+    std::memcpy(known->irk, idKey.id_info.irk, BLE_GAP_SEC_KEY_LEN);
+
+    if (systemAttributeDirectory.empty())
+    {
+        return;
+    }
+
+    saveIdentities();
+
+    if (!peer->second.unsavedSystemAttributes.empty())
+    {
+        auto path = systemAttributeFile(peer->second.identity);
+        systemAttributes[path] = std::move(peer->second.unsavedSystemAttributes);
+        peer->second.unsavedSystemAttributes.clear();
+        queueFileWrite(path, systemAttributes[path]);
+    }
+}
+
+// Called with the mutex held
+std::string GattServer::systemAttributeFile(const ble_gap_addr_t &address) const
+{
+    std::ostringstream name;
+    name << systemAttributeDirectory << "/" << std::hex << std::uppercase << std::setfill('0');
+
+    // Most significant byte first, as addresses are written
+    for (auto i = BLE_GAP_ADDR_LEN; i > 0; i--)
+    {
+        name << std::setw(2) << static_cast<int>(address.addr[i - 1]);
+    }
+
+    name << "_" << static_cast<int>(address.addr_type) << SYSTEM_ATTRIBUTE_SUFFIX;
+    return name.str();
+}
+
+// Called with the mutex held
+void GattServer::identifyPeer(GattPeer &peer)
+{
+    const auto &address = peer.address;
+    peer.identified = true;
+
+#if NRF_SD_BLE_API_VERSION >= 5
+    // Resolved by the SoftDevice from its identity list
+    if (address.addr_id_peer)
+    {
+        peer.identity = address;
+        return;
+    }
+#endif
+
+    if (address.addr_type != BLE_GAP_ADDR_TYPE_RANDOM_PRIVATE_RESOLVABLE)
+    {
+        peer.identity = address;
+        return;
+    }
+
+    for (const auto &identity : identities)
+    {
+        if (resolvesAddress(identity.irk, address))
+        {
+            peer.identity = identity.address;
+            return;
+        }
+    }
+
+    peer.identified = false;
+}
+
+// Called with the mutex held
+void GattServer::saveIdentities()
+{
+    std::vector<uint8_t> data;
+    data.reserve(identities.size() * IDENTITY_RECORD_SIZE);
+
+    for (const auto &identity : identities)
+    {
+        data.push_back(identity.address.addr_type);
+        data.insert(data.end(), identity.address.addr, identity.address.addr + BLE_GAP_ADDR_LEN);
+        data.insert(data.end(), identity.irk, identity.irk + BLE_GAP_SEC_KEY_LEN);
+    }
+
+    queueFileWrite(systemAttributeDirectory + "/" + IDENTITY_FILE, std::move(data));
+}
+
+// Called with the mutex held. The SoftDevice is asked for the system
+// attributes right away, the file is written in a worker thread.
+void GattServer::saveSystemAttributes(adapter_t *adapter, uint16_t connHandle)
+{
+    auto peer = peers.find(connHandle);
+
+    if (systemAttributeDirectory.empty() || peer == peers.end())
+    {
+        return;
+    }
+
+    uint16_t length = 0;
+    auto result = sd_ble_gatts_sys_attr_get(adapter, connHandle, nullptr, &length, 0);
+
+    if (result != NRF_SUCCESS)
+    {
+        if (result != BLE_ERROR_INVALID_CONN_HANDLE)
+        {
+            std::cerr << "Failed to get system attributes of connection " << connHandle << ", error code " << result << "." << std::endl;
+        }
+
+        return;
+    }
+
+    std::vector<uint8_t> data(length);
+    result = sd_ble_gatts_sys_attr_get(adapter, connHandle, data.data(), &length, 0);
+
+    if (result != NRF_SUCCESS)
+    {
+        return;
+    }
+
+    data.resize(length);
+
+    if (!peer->second.identified)
+    {
+        peer->second.unsavedSystemAttributes = std::move(data);
+        return;
+    }
+
+    auto path = systemAttributeFile(peer->second.identity);
+    queueFileWrite(path, data);
+    systemAttributes[path] = std::move(data);
+}
+
+// Called with the mutex held
+bool GattServer::restoreSystemAttributes(adapter_t *adapter, uint16_t connHandle)
+{
+    auto peer = peers.find(connHandle);
+
+    if (systemAttributeDirectory.empty() || peer == peers.end() || !peer->second.identified)
+    {
+        return false;
+    }
+
+    auto saved = systemAttributes.find(systemAttributeFile(peer->second.identity));
+
+    if (saved == systemAttributes.end())
+    {
+        return false;
+    }
+
+    const auto &data = saved->second;
+    auto result = sd_ble_gatts_sys_attr_set(adapter, connHandle, data.data(), static_cast<uint16_t>(data.size()), 0);
+
+    if (result != NRF_SUCCESS)
+    {
+        std::cerr << "Failed to restore system attributes of connection " << connHandle << ", error code " << result << "." << std::endl;
+        return false;
+    }
+
+    // The peer bonded before, its CCCDs are saved as it changes them
+    peer->second.bonded = true;
+    loadCccdValues(connHandle, data.data(), data.size());
+
+    return true;
+}
+
+// Called with the mutex held. The CCCD values of the connection are
+// replaced by the ones in the system attributes.
+void GattServer::loadCccdValues(uint16_t connHandle, const uint8_t *data, size_t size)
+{
+    auto &values = cccdValues[connHandle];
+    values.clear();
+
+    // Entries of handle, length and value, followed by a CRC
+    size_t index = 0;
+
+    while (data != nullptr && index + 6 <= size)
+    {
+        uint16_t handle = data[index] | (data[index + 1] << 8);
+        uint16_t length = data[index + 2] | (data[index + 3] << 8);
+        index += 4;
+
+        if (index + length > size)
+        {
+            break;
+        }
+
+        auto valueHandle = cccdValueHandles.find(handle);
+
+        if (valueHandle != cccdValueHandles.end() && length >= 2)
+        {
+            values[valueHandle->second] = static_cast<uint16_t>(data[index] | (data[index + 1] << 8));
+        }
+
+        index += length;
+    }
+}
+
+// This runs in Main Thread. Files waiting to be written are read from
+// memory, as the file may still have older contents.
+bool GattServer::readFile(const std::string &path, std::vector<uint8_t> &data)
+{
+    {
+        std::lock_guard<std::mutex> lock(fileMutex);
+        auto pending = pendingFiles.find(path);
+
+        if (pending != pendingFiles.end())
+        {
+            data = pending->second;
+            return true;
+        }
+
+        auto writing = writingFiles.find(path);
+
+        if (writing != writingFiles.end())
+        {
+            data = writing->second;
+            return true;
+        }
+    }
+
+    std::ifstream file(path, std::ios::binary);
+
+    if (!file)
+    {
+        return false;
+    }
+
+    data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return true;
+}
+
+// Can be called from any thread. A later write of the same file replaces
+// the contents of one that is not taken by the worker yet.
+void GattServer::queueFileWrite(const std::string &path, std::vector<uint8_t> data)
+{
+    std::lock_guard<std::mutex> lock(fileMutex);
+    pendingFiles[path] = std::move(data);
+
+    if (!fileWritesQueued)
+    {
+        fileWritesQueued = true;
+        queueWork([this]() { writeFiles(); });
+    }
+}
+
+// This runs in a worker thread (not Main Thread)
+void GattServer::writeFiles()
+{
+    while (true)
+    {
+        {
+            std::lock_guard<std::mutex> lock(fileMutex);
+            writingFiles.clear();
+
+            if (pendingFiles.empty())
+            {
+                fileWritesQueued = false;
+                return;
+            }
+
+            writingFiles.swap(pendingFiles);
+        }
+
+        // Only this thread changes the files taken, until it takes the next
+        // ones. The IRKs and CCCDs of the bonded peers are for this user only.
+        for (const auto &file : writingFiles)
+        {
+            if (!writeFileAtomically(file.first, file.second, true))
+            {
+                std::cerr << "Failed to write " << file.first << "." << std::endl;
+            }
+        }
+    }
+}
+
+// Called with the mutex held
+bool GattServer::onPreparedWrite(adapter_t *adapter, uint16_t connHandle, const ble_gatts_evt_write_t &write)
+{
+    if (write.op != BLE_GATTS_OP_PREP_WRITE_REQ &&
+        write.op != BLE_GATTS_OP_EXEC_WRITE_REQ_NOW &&
+        write.op != BLE_GATTS_OP_EXEC_WRITE_REQ_CANCEL)
+    {
+        return false;
+    }
+
+    ble_gatts_rw_authorize_reply_params_t reply;
+    std::memset(&reply, 0, sizeof(reply));
+    reply.type = BLE_GATTS_AUTHORIZE_TYPE_WRITE;
+
+    auto &queue = preparedWrites[connHandle];
+
+    if (write.op == BLE_GATTS_OP_PREP_WRITE_REQ)
+    {
+        auto store = attributeStores.find(write.handle);
+
+        if (store != attributeStores.end() && store->second.writePolicy == GattAttributeStore::WritePolicy::Reject)
+        {
+            reply.params.write.gatt_status = store->second.rejectStatus;
+        }
+        else if (store != attributeStores.end() && store->second.writePolicy == GattAttributeStore::WritePolicy::Accept &&
+                 write.offset + write.len > store->second.maxLength)
+        {
+            // The value would not fit in the store when the write is executed
+            reply.params.write.gatt_status = BLE_GATT_STATUS_ATTERR_INVALID_ATT_VAL_LENGTH;
+        }
+        else if (queue.data.size() + write.len > PREPARED_WRITE_QUEUE_SIZE)
+        {
+            reply.params.write.gatt_status = BLE_GATT_STATUS_ATTERR_PREPARE_QUEUE_FULL;
+        }
+        else
+        {
+            GattPreparedWriteQueue::Entry entry;
+            entry.handle = write.handle;
+            entry.offset = write.offset;
+            entry.start = queue.data.size();
+            entry.length = write.len;
+
+            queue.entries.push_back(entry);
+            queue.data.insert(queue.data.end(), write.data, write.data + write.len);
+
+            // The peer checks that the value is echoed back
+            reply.params.write.gatt_status = BLE_GATT_STATUS_SUCCESS;
+            reply.params.write.update = 1;
+            reply.params.write.offset = write.offset;
+            reply.params.write.len = write.len;
+            reply.params.write.p_data = write.data;
+        }
+    }
+    else if (write.op == BLE_GATTS_OP_EXEC_WRITE_REQ_NOW)
+    {
+        GattExecutedWrites executed;
+        executed.gattStatus = executePreparedWrites(adapter, queue, executed.writes);
+
+        if (executed.gattStatus != BLE_GATT_STATUS_SUCCESS)
+        {
+            executed.writes.clear();
+        }
+
+        reply.params.write.gatt_status = executed.gattStatus;
+        executedWrites[connHandle].push_back(std::move(executed));
+    }
+    else
+    {
+        reply.params.write.gatt_status = BLE_GATT_STATUS_SUCCESS;
+    }
+
+    auto result = sd_ble_gatts_rw_authorize_reply(adapter, connHandle, &reply);
+
+    if (result != NRF_SUCCESS)
+    {
+        std::cerr << "Failed to reply to prepared write of connection " << connHandle << ", error code " << result << "." << std::endl;
+    }
+
+    if (write.op != BLE_GATTS_OP_PREP_WRITE_REQ)
+    {
+        // The buffer is kept for the next queue
+        queue.entries.clear();
+        queue.data.clear();
+    }
+
+    // JavaScript gets the result of an execution with the execute request
+    return write.op != BLE_GATTS_OP_EXEC_WRITE_REQ_NOW;
+}
+
+// Called with the mutex held. The offsets and lengths of all writes are
+// checked before any of them is applied. Should the SoftDevice still fail a
+// write, the attributes written are set back to their values before.
+uint16_t GattServer::executePreparedWrites(adapter_t *adapter, GattPreparedWriteQueue &queue, std::vector<GattPreparedWrite> &writes)
+{
+    for (auto &entry : queue.entries)
+    {
+        auto data = queue.data.begin() + entry.start;
+
+        if (!writes.empty() && writes.back().handle == entry.handle && writes.back().offset + writes.back().value.size() == entry.offset)
+        {
+            writes.back().value.insert(writes.back().value.end(), data, data + entry.length);
+            continue;
+        }
+
+        GattPreparedWrite write;
+        write.handle = entry.handle;
+        write.offset = entry.offset;
+        write.value.assign(data, data + entry.length);
+        writes.push_back(std::move(write));
+    }
+
+    // Values of the attributes before the writes, and their lengths as the writes before have left them
+    std::map<uint16_t, std::vector<uint8_t>> values;
+    std::map<uint16_t, size_t> lengths;
+
+    for (auto &write : writes)
+    {
+        auto length = lengths.find(write.handle);
+
+        if (length == lengths.end())
+        {
+            std::vector<uint8_t> data(BLE_GATTS_VAR_ATTR_LEN_MAX);
+            ble_gatts_value_t value;
+            value.len = static_cast<uint16_t>(data.size());
+            value.offset = 0;
+            value.p_value = data.data();
+
+            if (sd_ble_gatts_value_get(adapter, BLE_CONN_HANDLE_INVALID, write.handle, &value) != NRF_SUCCESS)
+            {
+                return BLE_GATT_STATUS_ATTERR_INVALID_HANDLE;
+            }
+
+            data.resize(std::min<size_t>(value.len, data.size()));
+            length = lengths.insert(std::make_pair(write.handle, data.size())).first;
+            values[write.handle] = std::move(data);
+        }
+
+        if (write.offset > length->second)
+        {
+            return BLE_GATT_STATUS_ATTERR_INVALID_OFFSET;
+        }
+
+        length->second = write.offset + write.value.size();
+        auto maxLength = attributeMaxLengths.find(write.handle);
+
+        if (length->second > BLE_GATTS_VAR_ATTR_LEN_MAX || (maxLength != attributeMaxLengths.end() && length->second > maxLength->second))
+        {
+            return BLE_GATT_STATUS_ATTERR_INVALID_ATT_VAL_LENGTH;
+        }
+    }
+
+    for (auto applied = writes.begin(); applied != writes.end(); applied++)
+    {
+        ble_gatts_value_t value;
+        value.len = static_cast<uint16_t>(applied->value.size());
+        value.offset = applied->offset;
+        value.p_value = applied->value.data();
+
+        auto result = sd_ble_gatts_value_set(adapter, BLE_CONN_HANDLE_INVALID, applied->handle, &value);
+
+        if (result == NRF_SUCCESS)
+        {
+            continue;
+        }
+
+        std::cerr << "Failed to execute prepared write of handle " << applied->handle << ", error code " << result << "." << std::endl;
+
+        for (auto &original : values)
+        {
+            auto written = std::find_if(writes.begin(), applied, [&original](const GattPreparedWrite &write) {
+                return write.handle == original.first;
+            });
+
+            if (written == applied)
+            {
+                continue;
+            }
+
+            value.len = static_cast<uint16_t>(original.second.size());
+            value.offset = 0;
+            value.p_value = original.second.data();
+
+            if (sd_ble_gatts_value_set(adapter, BLE_CONN_HANDLE_INVALID, original.first, &value) != NRF_SUCCESS)
+            {
+                // The value is not known anymore
+                dropValue(mirrorKey(BLE_CONN_HANDLE_INVALID, original.first));
+            }
+        }
+
+        return BLE_GATT_STATUS_ATTERR_UNLIKELY_ERROR;
+    }
+
+    for (auto &write : writes)
+    {
+        valueChanged(BLE_CONN_HANDLE_INVALID, write.handle, write.offset, write.value.data(), static_cast<uint16_t>(write.value.size()));
+    }
+
+    return BLE_GATT_STATUS_SUCCESS;
+}
+
+// This runs in Main Thread
+bool GattServer::takeExecutedWrites(uint16_t connHandle, GattExecutedWrites &executed)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto connection = executedWrites.find(connHandle);
+
+    if (connection == executedWrites.end() || connection->second.empty())
+    {
+        return false;
+    }
+
+    executed = std::move(connection->second.front());
+    connection->second.pop_front();
+
+    if (connection->second.empty())
+    {
+        executedWrites.erase(connection);
+    }
+
+    return true;
+}
+
+// The cryptographic functions are exported to be tested without a device
+
+NAN_METHOD(Aes128Encrypt)
+{
+    std::vector<uint8_t> key;
+    std::vector<uint8_t> block;
+    auto argumentcount = 0;
+
+    try
+    {
+        key = ConversionUtility::getNativeBytes(info[argumentcount]);
+        argumentcount++;
+
+        block = ConversionUtility::getNativeBytes(info[argumentcount]);
+        argumentcount++;
+    }
+    catch (std::string error)
+    {
+        auto message = ErrorMessage::getTypeErrorMessage(argumentcount, error);
+        Nan::ThrowTypeError(message);
+        return;
+    }
+
+    if (key.size() != 16 || block.size() != 16)
+    {
+        Nan::ThrowTypeError("The key and the block must be 16 bytes.");
+        return;
+    }
+
+    aes128Encrypt(key.data(), block.data());
+    info.GetReturnValue().Set(ConversionUtility::toJsValueArray(block.data(), static_cast<uint16_t>(block.size())));
+}
+
+NAN_METHOD(ResolvesPrivateAddress)
+{
+    std::vector<uint8_t> irk;
+    std::vector<uint8_t> address;
+    auto argumentcount = 0;
+
+    try
+    {
+        irk = ConversionUtility::getNativeBytes(info[argumentcount]);
+        argumentcount++;
+
+        address = ConversionUtility::getNativeBytes(info[argumentcount]);
+        argumentcount++;
+    }
+    catch (std::string error)
+    {
+        auto message = ErrorMessage::getTypeErrorMessage(argumentcount, error);
+        Nan::ThrowTypeError(message);
+        return;
+    }
+
+    if (irk.size() != BLE_GAP_SEC_KEY_LEN || address.size() != BLE_GAP_ADDR_LEN)
+    {
+        Nan::ThrowTypeError("The IRK must be 16 bytes and the address 6 bytes.");
+        return;
+    }
+
+    ble_gap_addr_t resolvable;
+    std::memset(&resolvable, 0, sizeof(resolvable));
+    resolvable.addr_type = BLE_GAP_ADDR_TYPE_RANDOM_PRIVATE_RESOLVABLE;
+    std::memcpy(resolvable.addr, address.data(), BLE_GAP_ADDR_LEN);
+
+    info.GetReturnValue().Set(resolvesAddress(irk.data(), resolvable));
+}
+
+// Issues the notifications of connections with the given weights and
+// lengths of notifications, with a SoftDevice that always has room. Returns
+// the connection of each notification in the order they were issued.
+NAN_METHOD(SimulateNotificationSchedule)
+{
+    std::map<uint16_t, GattNotificationQueue> queues;
+    auto argumentcount = 0;
+
+    try
+    {
+        if (!info[argumentcount]->IsArray())
+        {
+            throw std::string("array");
+        }
+
+        auto connections = v8::Local<v8::Array>::Cast(info[argumentcount]);
+
+        for (uint32_t i = 0; i < connections->Length(); i++)
+        {
+            auto connection = ConversionUtility::getJsObject(Utility::Get(connections, i));
+            auto lengthsValue = Utility::Get(connection, "lengths");
+
+            if (!lengthsValue->IsArray())
+            {
+                throw std::string("array of lengths");
+            }
+
+            auto lengths = v8::Local<v8::Array>::Cast(lengthsValue);
+            auto &queue = queues[static_cast<uint16_t>(i)];
+            queue.weight = ConversionUtility::getNativeUint16(connection, "weight");
+
+            for (uint32_t j = 0; j < lengths->Length(); j++)
+            {
+                GattNotification notification(0, nullptr);
+                notification.value.resize(ConversionUtility::getNativeUint16(Utility::Get(lengths, j)));
+                queue.pending.push_back(std::move(notification));
+            }
+        }
+
+        argumentcount++;
+    }
+    catch (std::string error)
+    {
+        auto message = ErrorMessage::getTypeErrorMessage(argumentcount, error);
+        Nan::ThrowTypeError(message);
+        return;
+    }
+
+    std::vector<uint16_t> issued;
+    uint16_t start = 0;
+
+    runNotificationRounds(queues, start, [&queues, &issued](uint16_t connHandle) {
+        auto &queue = queues[connHandle];
+        auto length = static_cast<uint32_t>(queue.pending.front().value.size());
+
+        queue.deficit -= std::min(length, queue.deficit);
+        queue.pending.pop_front();
+        issued.push_back(connHandle);
+    });
+
+    auto result = Nan::New<v8::Array>(static_cast<uint32_t>(issued.size()));
+
+    for (uint32_t i = 0; i < issued.size(); i++)
+    {
+        Nan::Set(result, i, Nan::New<v8::Number>(issued[i]));
+    }
+
+    info.GetReturnValue().Set(result);
+}
+
+extern "C" {
+    void init_gatt_server(Nan::ADDON_REGISTER_FUNCTION_ARGS_TYPE target)
+    {
+        Utility::SetMethod(target, "aes128Encrypt", Aes128Encrypt);
+        Utility::SetMethod(target, "resolvesPrivateAddress", ResolvesPrivateAddress);
+        Utility::SetMethod(target, "simulateNotificationSchedule", SimulateNotificationSchedule);
+    }
+}
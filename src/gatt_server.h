@@ -0,0 +1,479 @@
+/* Copyright (c) 2010 - 2017, Nordic Semiconductor ASA
+ *
+ * All rights reserved.
+ *
+ * Use in source and binary forms, redistribution in binary form only, with
+ * or without modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions in binary form, except as embedded into a Nordic
+ *    Semiconductor ASA integrated circuit in a product or a software update for
+ *    such product, must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other
+ *    materials provided with the distribution.
+ *
+ * 2. Neither the name of Nordic Semiconductor ASA nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * 3. This software, with or without modification, must only be used with a Nordic
+ *    Semiconductor ASA integrated circuit.
+ *
+ * 4. Any software provided in binary form under this license must not be reverse
+ *    engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY NORDIC SEMICONDUCTOR ASA "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NORDIC SEMICONDUCTOR ASA OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+ * TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef GATT_SERVER_H
+#define GATT_SERVER_H
+
+#include <nan.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "sd_rpc.h"
+
+#include "common.h"
+#include "metrics.h"
+
+// Result of a native GATT server procedure, called in Main Thread
+typedef std::function<void()> GattServerCompletion;
+
+// Notifications of one value to all subscribed connections, that call one
+// callback when all of them are done. The callback gets the result for each
+// connection. Only used in Main Thread.
+struct GattNotificationGroup
+{
+public:
+    GattNotificationGroup(size_t count, std::shared_ptr<Nan::Callback> callback);
+
+    std::map<uint16_t, uint32_t> results;
+    size_t remaining;
+    std::shared_ptr<Nan::Callback> callback;
+};
+
+// Notification queued with GattServer::queueNotification
+struct GattNotification
+{
+public:
+    GattNotification(uint16_t handle, std::shared_ptr<Nan::Callback> callback);
+
+    uint16_t handle;
+    std::vector<uint8_t> value;
+
+    // When the notification was queued
+    std::chrono::steady_clock::time_point queued;
+
+    // Set for notifications of a group, which report to the group instead of
+    // calling their own callback
+    std::shared_ptr<GattNotificationGroup> group;
+
+    std::shared_ptr<Nan::Callback> callback;
+};
+
+// Notifications of a connection waiting for the SoftDevice to accept them
+struct GattNotificationQueue
+{
+public:
+    GattNotificationQueue();
+
+    std::deque<GattNotification> pending;
+    // The SoftDevice has no room for more notifications until packets are sent
+    bool txQueueFull;
+    // Notifications issued that the SoftDevice has not reported sent,
+    // including the one being issued
+    uint32_t inFlight;
+    // Reports of packets sent, to tell if the SoftDevice made room while it was called
+    uint32_t txCompleteCount;
+
+    // Share of the notifications issued, relative to the other connections
+    uint16_t weight;
+    // Bytes the connection may still issue, see GattServer::scheduleNotifications
+    uint32_t deficit;
+};
+
+// Indication queued with GattServer::queueIndication
+struct GattIndication
+{
+public:
+    GattIndication(uint16_t handle, std::shared_ptr<Nan::Callback> callback);
+
+    uint16_t handle;
+    std::vector<uint8_t> value;
+    std::shared_ptr<Nan::Callback> callback;
+};
+
+// Indications of a connection, issued one at a time as the peer confirms them
+struct GattIndicationQueue
+{
+public:
+    enum class State
+    {
+        // No indication waits for confirmation
+        Idle,
+        // The front of pending is issued and waits for confirmation
+        Issued,
+        // An indication that timed out may still be confirmed
+        TimedOut,
+        // An indication issued by JavaScript waits for confirmation
+        Blocked
+    };
+
+    GattIndicationQueue();
+
+    std::deque<GattIndication> pending;
+    State state;
+    // When the issued indication times out
+    std::chrono::steady_clock::time_point deadline;
+};
+
+// Result of an indication, reported to JavaScript in batches
+struct GattIndicationResult
+{
+public:
+    std::shared_ptr<Nan::Callback> callback;
+    uint32_t result;
+};
+
+// Value of a local attribute kept in the binding, see GattServer::setAttributeStore
+struct GattAttributeStore
+{
+public:
+    enum class WritePolicy { Pass, Accept, Reject };
+
+    GattAttributeStore();
+
+    std::vector<uint8_t> value;
+    // Reply to read requests with the value, instead of passing them to JavaScript
+    bool serveReads;
+    // Write requests are passed to JavaScript, accepted into the value, or rejected
+    WritePolicy writePolicy;
+    // Accepted writes that do not fit in maxLength are rejected
+    uint16_t maxLength;
+    // GATT status of rejected writes
+    uint16_t rejectStatus;
+
+    // Reads served since they were last reported
+    uint32_t unreportedReads;
+
+    // Called in Main Thread with a summary of the requests served
+    std::shared_ptr<Nan::Callback> callback;
+};
+
+// Write of a prepared write queue, with the consecutive writes to an attribute coalesced
+struct GattPreparedWrite
+{
+public:
+    uint16_t handle;
+    uint16_t offset;
+    std::vector<uint8_t> value;
+};
+
+// Prepared writes of a connection waiting for the peer to execute them. The
+// values are kept in one buffer that is reused for the next queue.
+struct GattPreparedWriteQueue
+{
+public:
+    struct Entry
+    {
+        uint16_t handle;
+        uint16_t offset;
+        size_t start;
+        uint16_t length;
+    };
+
+    GattPreparedWriteQueue();
+
+    std::vector<uint8_t> data;
+    std::vector<Entry> entries;
+};
+
+// Result of an executed prepared write queue, passed to JavaScript with the execute request
+struct GattExecutedWrites
+{
+public:
+    uint16_t gattStatus;
+    std::vector<GattPreparedWrite> writes;
+};
+
+// Connected peer. Its system attributes are kept by its identity address,
+// which is the address it connected with unless that is resolvable private.
+struct GattPeer
+{
+public:
+    GattPeer();
+
+    ble_gap_addr_t address;
+    bool bonded;
+    bool identified;
+    ble_gap_addr_t identity;
+    // System attributes saved before the identity of the peer is known
+    std::vector<uint8_t> unsavedSystemAttributes;
+};
+
+// Identity of a bonded peer, to resolve the private addresses it connects with
+struct GattPeerIdentity
+{
+public:
+    ble_gap_addr_t address;
+    uint8_t irk[BLE_GAP_SEC_KEY_LEN];
+};
+
+// Native GATT server procedures of an adapter. The procedures are driven
+// from the thread the driver delivers events on, results are posted to
+// Main Thread.
+class GattServer
+{
+public:
+    explicit GattServer(AdapterMetrics &metrics);
+    ~GattServer();
+
+    // Called in Main Thread when the adapter is opened and closed. The
+    // attribute table is cleared when the adapter is opened.
+    void initCompletionHandling();
+    void cleanUpV8Resources();
+
+    // Called for every event from the driver before it is queued to JavaScript.
+    // Returns true if the event was consumed by a native procedure.
+    bool onEvent(adapter_t *adapter, const ble_evt_t *event);
+
+    // Queue a notification on a connection. The notifications are issued in
+    // order, as long as the SoftDevice has room for them. When it has not,
+    // the queue waits for the SoftDevice to report that packets are sent.
+    // Each notification calls its callback when the SoftDevice has accepted
+    // it, with the number of notifications still waiting on the connection.
+    // Runs in a worker thread.
+    void queueNotification(adapter_t *adapter, uint16_t connHandle, GattNotification notification);
+
+    // The queues of the connections share the link to the SoftDevice by
+    // weight, a connection with weight 2 issues twice the bytes of one with
+    // weight 1 in each round while both have notifications waiting, and may
+    // have twice the notifications waiting in the SoftDevice. The weight is
+    // kept until the connection is disconnected. Called in Main Thread.
+    void setConnectionWeight(uint16_t connHandle, uint16_t weight);
+
+    // Queue an indication on a connection. The indications are issued one at
+    // a time, the next one as soon as the peer confirms the previous one.
+    // The callback is called when the peer has confirmed the indication, or
+    // with an error if it failed or was not confirmed within the timeout.
+    // Runs in a worker thread.
+    void queueIndication(adapter_t *adapter, uint16_t connHandle, GattIndication indication);
+
+    // Time the peer has to confirm an indication. Called in Main Thread.
+    void setIndicationTimeout(uint32_t milliseconds);
+
+    // Queue a notification of the value to each connection that has enabled
+    // notifications of the characteristic. The callback gets the result of
+    // each connection when all of them are done. Runs in a worker thread.
+    void notifyAll(adapter_t *adapter, uint16_t valueHandle, const std::vector<uint8_t> &value, std::shared_ptr<Nan::Callback> callback);
+
+    // CCCD of a characteristic value in the local attribute table. The CCCD
+    // writes of the peers are tracked, to know which connections to notify.
+    // Runs in a worker thread.
+    void addCccd(uint16_t cccdHandle, uint16_t valueHandle);
+
+    // Maximum length of an attribute in the local attribute table. Prepared
+    // writes are checked against it before any of them is executed. Runs in
+    // a worker thread.
+    void addAttribute(uint16_t handle, uint16_t maxLength);
+
+    // Reply to the authorize requests of an attribute from a value kept in
+    // the binding, right on the event path. The callback of the store gets
+    // each accepted write, and the number of reads served, after the reply
+    // is sent. Called in Main Thread.
+    void setAttributeStore(uint16_t handle, GattAttributeStore store);
+    void clearAttributeStore(uint16_t handle);
+
+    // Values of the local attributes are mirrored in the binding, so that
+    // reads do not have to ask the SoftDevice. The mirror is written through
+    // by the values set by JavaScript and the writes of the peers, and an
+    // entry is dropped when the value it would end up with is not known.
+    // CCCD values are mirrored for each connection.
+    //
+    // Each value has a generation that every change of it increments. A
+    // worker takes the generation before it calls the SoftDevice, and passes
+    // it along with the result. If the value changed in between, the order
+    // of the changes is not known and the entry is dropped. Run in a worker thread.
+    uint32_t valueGeneration(uint16_t connHandle, uint16_t handle);
+    void updateValue(uint16_t connHandle, uint16_t handle, uint16_t offset, const uint8_t *data, uint16_t length, uint32_t generation);
+
+    // Read a value from the mirror, returns false if the value must be read
+    // from the SoftDevice. Then mirrorValue is called with the value read,
+    // the length of the buffer it was read into and the generation readValue returned.
+    bool readValue(uint16_t connHandle, uint16_t handle, ble_gatts_value_t &value, uint32_t &generation);
+    void mirrorValue(uint16_t connHandle, uint16_t handle, uint16_t bufferLength, const ble_gatts_value_t &value, uint32_t generation);
+
+    // Drop the mirrored value of an attribute, or of the system attributes
+    // of a connection, when the SoftDevice may have changed them. Run in a worker thread.
+    void invalidateValue(uint16_t connHandle, uint16_t handle);
+    void invalidateValues(uint16_t connHandle);
+
+    // System attributes set by JavaScript, after the SoftDevice accepted
+    // them. The CCCD values in them are tracked. Runs in a worker thread.
+    void systemAttributesSet(uint16_t connHandle, const uint8_t *data, uint16_t length, uint32_t flags);
+
+    // Authorize replies of JavaScript that update the value of the attribute
+    // of the request drop its mirrored value. Runs in a worker thread.
+    void onAuthorizeReply(uint16_t connHandle, const ble_gatts_rw_authorize_reply_params_t &reply);
+
+    // Persist the system attributes (CCCD values) of bonded peers in a file
+    // for each peer identity address in the directory. They are saved when a
+    // peer bonds, writes a CCCD and disconnects, and restored when the
+    // SoftDevice reports them missing. The files in the directory are read
+    // when it is set and served from memory, they are written in a worker
+    // thread. An empty directory disables this. Called in Main Thread.
+    void setSystemAttributeDirectory(const std::string &directory);
+
+    // Identity a peer distributed when it bonded. The identity resolving key
+    // is kept with the system attributes, to recognize the peer when it
+    // connects with a resolvable private address. Called in Main Thread.
+    void setPeerIdentity(uint16_t connHandle, const ble_gap_id_key_t &idKey);
+
+    // Prepared writes of attributes with write authorization are queued and
+    // executed in the binding. The execute request is still passed to
+    // JavaScript, which takes the result of the execution with this. Called
+    // in Main Thread, for each execute request in the order of the events.
+    bool takeExecutedWrites(uint16_t connHandle, GattExecutedWrites &executed);
+
+    // Queue a completion to be called in Main Thread. Can be called from any thread.
+    void post(GattServerCompletion completion);
+
+    // Queue work to run in a worker thread. Can be called from any thread.
+    void queueWork(GattServerCompletion work);
+    void onWorkDone();
+
+    void onCompletion();
+    void onIndicationTimeout();
+    void writeFiles();
+
+private:
+    void startSender();
+    void stopSender();
+    void runSender();
+    void scheduleNotifications(adapter_t *adapter, std::unique_lock<std::mutex> &lock);
+    void issueNotification(adapter_t *adapter, uint16_t connHandle, std::unique_lock<std::mutex> &lock);
+    void completeNotification(GattNotification &notification, uint16_t connHandle, uint32_t result, size_t queued);
+    void failNotifications(GattNotificationQueue &queue, uint16_t connHandle, uint32_t result);
+    void issueWaitingIndications(adapter_t *adapter);
+    void issueIndications(adapter_t *adapter, uint16_t connHandle, GattIndicationQueue &queue);
+    void completeIndication(GattIndication &indication, uint32_t result);
+    void failIndications(GattIndicationQueue &queue, uint32_t result);
+    bool onIndicationConfirmed(adapter_t *adapter, uint16_t connHandle);
+    void reportIndications();
+    void startIndicationTimer();
+    void onCccdWrite(uint16_t connHandle, const ble_gatts_evt_write_t &write);
+    bool onAuthorizeRequest(adapter_t *adapter, uint16_t connHandle, const ble_gatts_evt_rw_authorize_request_t &request);
+    bool onPreparedWrite(adapter_t *adapter, uint16_t connHandle, const ble_gatts_evt_write_t &write);
+    uint16_t executePreparedWrites(adapter_t *adapter, GattPreparedWriteQueue &queue, std::vector<GattPreparedWrite> &writes);
+    void reportReads(uint16_t handle);
+    void valueChanged(uint16_t connHandle, uint16_t handle, uint16_t offset, const uint8_t *data, uint16_t length);
+    void invalidateConnectionValues(uint16_t connHandle);
+    void dropValue(const std::pair<uint16_t, uint16_t> &key);
+    std::pair<uint16_t, uint16_t> mirrorKey(uint16_t connHandle, uint16_t handle) const;
+    void saveSystemAttributes(adapter_t *adapter, uint16_t connHandle);
+    bool restoreSystemAttributes(adapter_t *adapter, uint16_t connHandle);
+    void loadCccdValues(uint16_t connHandle, const uint8_t *data, size_t size);
+    std::string systemAttributeFile(const ble_gap_addr_t &address) const;
+    void identifyPeer(GattPeer &peer);
+    void saveIdentities();
+    bool readFile(const std::string &path, std::vector<uint8_t> &data);
+    void queueFileWrite(const std::string &path, std::vector<uint8_t> data);
+
+    AdapterMetrics &metrics;
+
+    std::mutex mutex;
+    std::map<uint16_t, GattNotificationQueue> notificationQueues;
+    // Connection handle of the queue served first in the last round
+    uint16_t scheduleStart;
+    // A thread is issuing notifications, the others leave theirs to it
+    bool scheduling;
+    // Issues notifications after packets are sent, as the SoftDevice is not
+    // called on the thread that delivers the events. Does not depend on the
+    // event loop of Main Thread, which may be busy with JavaScript.
+    std::thread sender;
+    std::condition_variable senderWake;
+    // The sender is asked to issue notifications or indications with this adapter
+    bool scheduleRequested;
+    bool indicationsRequested;
+    adapter_t *senderAdapter;
+    bool senderStop;
+    // Guards the indications. Held while the SoftDevice is called, so that a
+    // confirmation is matched to the indication it confirms. Taken before the
+    // mutex when both are held, never after it.
+    std::mutex indicationMutex;
+    std::map<uint16_t, GattIndicationQueue> indicationQueues;
+    std::vector<GattIndicationResult> indicationResults;
+    std::chrono::milliseconds indicationTimeout;
+    // Value handles by CCCD handle
+    std::map<uint16_t, uint16_t> cccdValueHandles;
+    // CCCD values by connection handle and value handle
+    std::map<uint16_t, std::map<uint16_t, uint16_t>> cccdValues;
+    // Maximum value lengths by attribute handle
+    std::map<uint16_t, uint16_t> attributeMaxLengths;
+    // By attribute handle
+    std::map<uint16_t, GattAttributeStore> attributeStores;
+    // By connection handle
+    std::map<uint16_t, GattPeer> peers;
+    std::map<uint16_t, GattPreparedWriteQueue> preparedWrites;
+    std::map<uint16_t, std::deque<GattExecutedWrites>> executedWrites;
+    std::string systemAttributeDirectory;
+    // Identities of the peers that bonded, saved in the directory
+    std::vector<GattPeerIdentity> identities;
+    // System attributes of the peers saved in the directory, by file path
+    std::map<std::string, std::vector<uint8_t>> systemAttributes;
+    // By connection handle and attribute handle, the connection handle is
+    // BLE_CONN_HANDLE_INVALID for values that are not per connection
+    std::map<std::pair<uint16_t, uint16_t>, std::vector<uint8_t>> valueMirror;
+    // Generations of the mirrored values, by the same key. Kept when entries
+    // are dropped, so that a generation taken before is never seen again.
+    std::map<std::pair<uint16_t, uint16_t>, uint32_t> valueGenerations;
+    // Handle of the authorize request passed to JavaScript, by connection handle
+    std::map<uint16_t, uint16_t> pendingAuthorizations;
+
+    std::mutex completionMutex;
+    std::vector<GattServerCompletion> completions;
+    uv_async_t *asyncCompletion;
+    uv_timer_t *indicationTimer;
+
+    // Workers queued with queueWork that are not done yet
+    std::mutex workerMutex;
+    size_t workersRunning;
+    std::condition_variable workersDone;
+
+    // Contents of the files to write, by path. The files taken by the
+    // worker are kept until they are written, for reads in between.
+    std::mutex fileMutex;
+    std::map<std::string, std::vector<uint8_t>> pendingFiles;
+    std::map<std::string, std::vector<uint8_t>> writingFiles;
+    bool fileWritesQueued;
+};
+
+// Exports AES-128 and the resolution of private addresses, both with the
+// byte order of the SoftDevice: keys and blocks most significant byte
+// first, IRKs and addresses least significant byte first. Also exports a
+// simulation of the notification scheduler, to test the weights.
+extern "C" {
+    void init_gatt_server(Nan::ADDON_REGISTER_FUNCTION_ARGS_TYPE target);
+}
+
+#endif // GATT_SERVER_H
@@ -0,0 +1,178 @@
+/* Copyright (c) 2010 - 2017, Nordic Semiconductor ASA
+ *
+ * All rights reserved.
+ *
+ * Use in source and binary forms, redistribution in binary form only, with
+ * or without modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions in binary form, except as embedded into a Nordic
+ *    Semiconductor ASA integrated circuit in a product or a software update for
+ *    such product, must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other
+ *    materials provided with the distribution.
+ *
+ * 2. Neither the name of Nordic Semiconductor ASA nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * 3. This software, with or without modification, must only be used with a Nordic
+ *    Semiconductor ASA integrated circuit.
+ *
+ * 4. Any software provided in binary form under this license must not be reverse
+ *    engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY NORDIC SEMICONDUCTOR ASA "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NORDIC SEMICONDUCTOR ASA OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+ * TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "metrics.h"
+
+AdapterMetrics::AdapterMetrics()
+{
+    for (auto &counter : events)
+    {
+        counter.store(0, std::memory_order_relaxed);
+    }
+
+    for (auto &counter : logs)
+    {
+        counter.store(0, std::memory_order_relaxed);
+    }
+}
+
+void AdapterMetrics::countEvent(uint16_t evt_id)
+{
+    if (evt_id < METRICS_EVENT_ID_COUNT)
+    {
+        events[evt_id].fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void AdapterMetrics::countLog(int severity)
+{
+    if (severity >= 0 && severity < METRICS_LOG_SEVERITY_COUNT)
+    {
+        logs[severity].fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void AdapterMetrics::countBytesWritten(uint16_t connHandle, uint32_t length)
+{
+    if (connHandle < METRICS_CONNECTION_COUNT)
+    {
+        connections[connHandle].bytesWritten.fetch_add(length, std::memory_order_relaxed);
+    }
+}
+
+void AdapterMetrics::countBytesNotified(uint16_t connHandle, uint32_t length)
+{
+    if (connHandle < METRICS_CONNECTION_COUNT)
+    {
+        connections[connHandle].bytesNotified.fetch_add(length, std::memory_order_relaxed);
+    }
+}
+
+// Called with the queues of the GATT server locked, by one thread at a time
+void AdapterMetrics::countQueuedNotification(uint16_t connHandle, uint32_t length, uint64_t queueMicros)
+{
+    if (connHandle >= METRICS_CONNECTION_COUNT)
+    {
+        return;
+    }
+
+    auto &connection = connections[connHandle];
+    connection.bytesNotified.fetch_add(length, std::memory_order_relaxed);
+    connection.notificationsQueued.fetch_add(1, std::memory_order_relaxed);
+    connection.notificationQueueMicros.fetch_add(queueMicros, std::memory_order_relaxed);
+
+    if (queueMicros > connection.notificationQueueMicrosMax.load(std::memory_order_relaxed))
+    {
+        connection.notificationQueueMicrosMax.store(queueMicros, std::memory_order_relaxed);
+    }
+}
+
+// Called with the queues of the GATT server locked, when the connection is disconnected
+void AdapterMetrics::resetQueuedNotifications(uint16_t connHandle)
+{
+    if (connHandle >= METRICS_CONNECTION_COUNT)
+    {
+        return;
+    }
+
+    auto &connection = connections[connHandle];
+    connection.notificationsQueued.store(0, std::memory_order_relaxed);
+    connection.notificationQueueMicros.store(0, std::memory_order_relaxed);
+    connection.notificationQueueMicrosMax.store(0, std::memory_order_relaxed);
+}
+
+uint64_t AdapterMetrics::getEventCount(uint16_t evt_id) const
+{
+    if (evt_id >= METRICS_EVENT_ID_COUNT)
+    {
+        return 0;
+    }
+
+    return events[evt_id].load(std::memory_order_relaxed);
+}
+
+uint64_t AdapterMetrics::getLogCount(int severity) const
+{
+    if (severity < 0 || severity >= METRICS_LOG_SEVERITY_COUNT)
+    {
+        return 0;
+    }
+
+    return logs[severity].load(std::memory_order_relaxed);
+}
+
+const ConnectionMetrics &AdapterMetrics::getConnection(uint16_t connHandle) const
+{
+    return connections[connHandle % METRICS_CONNECTION_COUNT];
+}
+
+void MetricsWriter::family(const char *name, const char *type, const char *help)
+{
+    out << "# HELP " << name << " " << help << "\n";
+    out << "# TYPE " << name << " " << type << "\n";
+}
+
+void MetricsWriter::sample(const char *name, const std::string &labels, uint64_t value)
+{
+    out << name << "{" << labels << "} " << value << "\n";
+}
+
+std::string MetricsWriter::label(const char *name, const std::string &value)
+{
+    std::string escaped;
+
+    for (auto c : value)
+    {
+        if (c == '\\' || c == '"')
+        {
+            escaped += '\\';
+        }
+        else if (c == '\n')
+        {
+            escaped += "\\n";
+            continue;
+        }
+
+        escaped += c;
+    }
+
+    return std::string(name) + "=\"" + escaped + "\"";
+}
+
+std::string MetricsWriter::str() const
+{
+    return out.str();
+}
@@ -0,0 +1,156 @@
+/* Copyright (c) 2010 - 2017, Nordic Semiconductor ASA
+ *
+ * All rights reserved.
+ *
+ * Use in source and binary forms, redistribution in binary form only, with
+ * or without modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions in binary form, except as embedded into a Nordic
+ *    Semiconductor ASA integrated circuit in a product or a software update for
+ *    such product, must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other
+ *    materials provided with the distribution.
+ *
+ * 2. Neither the name of Nordic Semiconductor ASA nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * 3. This software, with or without modification, must only be used with a Nordic
+ *    Semiconductor ASA integrated circuit.
+ *
+ * 4. Any software provided in binary form under this license must not be reverse
+ *    engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY NORDIC SEMICONDUCTOR ASA "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NORDIC SEMICONDUCTOR ASA OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+ * TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <sstream>
+#include <string>
+
+// Number of event ids counted, covers all SoftDevice event ranges
+const auto METRICS_EVENT_ID_COUNT = 256;
+
+// Number of connection handles bytes are counted for
+const auto METRICS_CONNECTION_COUNT = 64;
+
+// Number of log severities, SD_RPC_LOG_TRACE to SD_RPC_LOG_FATAL
+const auto METRICS_LOG_SEVERITY_COUNT = 6;
+
+// Depth of a single producer/single consumer queue
+struct QueueMetrics
+{
+public:
+    QueueMetrics() : pushed(0), popped(0), highWater(0), dropped(0) {}
+
+    // Called by the producer thread
+    void push()
+    {
+        auto count = pushed.fetch_add(1, std::memory_order_relaxed) + 1;
+        auto depth = count - popped.load(std::memory_order_relaxed);
+
+        // Only the producer updates highWater
+        if (depth > highWater.load(std::memory_order_relaxed))
+        {
+            highWater.store(depth, std::memory_order_relaxed);
+        }
+    }
+
+    // Called by the consumer thread
+    void pop()
+    {
+        popped.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void drop()
+    {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    uint64_t depth() const
+    {
+        auto count = pushed.load(std::memory_order_relaxed);
+        auto removed = popped.load(std::memory_order_relaxed);
+        return count > removed ? count - removed : 0;
+    }
+
+    std::atomic<uint64_t> pushed;
+    std::atomic<uint64_t> popped;
+    std::atomic<uint64_t> highWater;
+    std::atomic<uint64_t> dropped;
+};
+
+struct ConnectionMetrics
+{
+public:
+    ConnectionMetrics()
+        : bytesWritten(0), bytesNotified(0), notificationsQueued(0), notificationQueueMicros(0), notificationQueueMicrosMax(0) {}
+
+    std::atomic<uint64_t> bytesWritten;
+    std::atomic<uint64_t> bytesNotified;
+
+    // Notifications issued from the native queues, and the time they waited in them
+    std::atomic<uint64_t> notificationsQueued;
+    std::atomic<uint64_t> notificationQueueMicros;
+    std::atomic<uint64_t> notificationQueueMicrosMax;
+};
+
+// Counters and gauges for one adapter. Updated with relaxed atomics from the
+// transport, worker and main threads, read when creating a metrics snapshot.
+class AdapterMetrics
+{
+public:
+    AdapterMetrics();
+
+    void countEvent(uint16_t evt_id);
+    void countLog(int severity);
+    void countBytesWritten(uint16_t connHandle, uint32_t length);
+    void countBytesNotified(uint16_t connHandle, uint32_t length);
+    void countQueuedNotification(uint16_t connHandle, uint32_t length, uint64_t queueMicros);
+    void resetQueuedNotifications(uint16_t connHandle);
+
+    uint64_t getEventCount(uint16_t evt_id) const;
+    uint64_t getLogCount(int severity) const;
+    const ConnectionMetrics &getConnection(uint16_t connHandle) const;
+
+    QueueMetrics eventQueue;
+    QueueMetrics logQueue;
+    QueueMetrics statusQueue;
+
+private:
+    std::array<std::atomic<uint64_t>, METRICS_EVENT_ID_COUNT> events;
+    std::array<std::atomic<uint64_t>, METRICS_LOG_SEVERITY_COUNT> logs;
+    std::array<ConnectionMetrics, METRICS_CONNECTION_COUNT> connections;
+};
+
+// Writes metrics in the Prometheus text exposition format
+class MetricsWriter
+{
+public:
+    void family(const char *name, const char *type, const char *help);
+    void sample(const char *name, const std::string &labels, uint64_t value);
+
+    static std::string label(const char *name, const std::string &value);
+
+    std::string str() const;
+
+private:
+    std::ostringstream out;
+};
+
+#endif // METRICS_H
@@ -32,12 +32,37 @@
 #include <nan.h>
 #include <sd_rpc.h>
 
-#include <vector>
+#include <algorithm>
 #include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#ifdef __linux__
+#include <libudev.h>
+#include <strings.h>
+#endif
 
 // Maximum of adapters allowed on a system before GetAdapterList fails
 constexpr size_t max_adapter_count = 64;
 
+// This compilation unit will be linked several times. Helpers and the
+// adapter monitor state must therefore not have external linkage.
+namespace {
+    v8::Local<v8::Object> adapterToJs(const sd_rpc_serial_port_desc_t &adapterItem)
+    {
+        v8::Local<v8::Object> item = Nan::New<v8::Object>();
+        Utility::Set(item, "path", adapterItem.port);
+        Utility::Set(item, "manufacturer", adapterItem.manufacturer);
+        Utility::Set(item, "serialNumber", adapterItem.serialNumber);
+        Utility::Set(item, "pnpId", adapterItem.pnpId);
+        Utility::Set(item, "locationId", adapterItem.locationId);
+        Utility::Set(item, "vendorId", adapterItem.vendorId);
+        Utility::Set(item, "productId", adapterItem.productId);
+        return item;
+    }
+}
+
 NAN_METHOD(GetAdapterList)
 {
     if(!info[0]->IsFunction())
@@ -78,15 +103,7 @@ void AfterGetAdapterList(uv_work_t* req)
 
         for(auto adapterItem : baton->results)
         {
-            v8::Local<v8::Object> item = Nan::New<v8::Object>();
-            Utility::Set(item, "path", adapterItem.port);
-            Utility::Set(item, "manufacturer", adapterItem.manufacturer);
-            Utility::Set(item, "serialNumber", adapterItem.serialNumber);
-            Utility::Set(item, "pnpId", adapterItem.pnpId);
-            Utility::Set(item, "locationId", adapterItem.locationId);
-            Utility::Set(item, "vendorId", adapterItem.vendorId);
-            Utility::Set(item, "productId", adapterItem.productId);
-            Nan::Set(results, i++, item);
+            Nan::Set(results, i++, adapterToJs(adapterItem));
         }
 
         argv[0] = Nan::Undefined();
@@ -101,3 +118,316 @@ void AfterGetAdapterList(uv_work_t* req)
 
     delete baton;
 }
+
+namespace {
+#ifdef __linux__
+    const char *SEGGER_VENDOR_ID = "1366";
+    const char *NXP_VENDOR_ID = "0d28";
+
+    struct AdapterMonitor
+    {
+        struct udev *udevContext = nullptr;
+        struct udev_monitor *udevMonitor = nullptr;
+        uv_poll_t *pollHandle = nullptr;
+        std::unique_ptr<Nan::Callback> callback;
+
+        // Cached list of adapters, only accessed from the main thread
+        std::vector<sd_rpc_serial_port_desc_t> adapters;
+        bool ready = false;
+    };
+
+    std::unique_ptr<AdapterMonitor> adapterMonitor;
+
+    // Manufacturers of the adapters sd_rpc_serial_port_enum lists
+    bool isAdapterManufacturer(const char *manufacturer)
+    {
+        return manufacturer != nullptr &&
+               (strcmp(manufacturer, "SEGGER") == 0 || strcasecmp(manufacturer, "arm") == 0 || strcasecmp(manufacturer, "mbed") == 0);
+    }
+
+    template <size_t N>
+    void copyString(char (&destination)[N], const char *source)
+    {
+        if (source == nullptr)
+        {
+            destination[0] = '\0';
+            return;
+        }
+
+        strncpy(destination, source, N - 1);
+        destination[N - 1] = '\0';
+    }
+
+    // Fills in the adapter as sd_rpc_serial_port_enum does, so that adapters
+    // added later look the same as the ones found by the initial scan
+    bool adapterFromUdevDevice(struct udev_device *ttyDevice, sd_rpc_serial_port_desc_t *adapterItem)
+    {
+        auto devnode = udev_device_get_devnode(ttyDevice);
+
+        if (devnode == nullptr)
+        {
+            return false;
+        }
+
+        // The parent is owned by the tty device and must not be unreferenced
+        auto usbDevice = udev_device_get_parent_with_subsystem_devtype(ttyDevice, "usb", "usb_device");
+
+        if (usbDevice == nullptr)
+        {
+            return false;
+        }
+
+        auto idVendor = udev_device_get_sysattr_value(usbDevice, "idVendor");
+
+        if (idVendor == nullptr || (strcmp(idVendor, SEGGER_VENDOR_ID) != 0 && strcmp(idVendor, NXP_VENDOR_ID) != 0))
+        {
+            return false;
+        }
+
+        auto manufacturer = udev_device_get_sysattr_value(usbDevice, "manufacturer");
+
+        if (!isAdapterManufacturer(manufacturer))
+        {
+            return false;
+        }
+
+        // The pnpId is left empty and the location is the sysfs path of the tty device
+        memset(adapterItem, 0, sizeof(sd_rpc_serial_port_desc_t));
+        copyString(adapterItem->port, devnode);
+        copyString(adapterItem->manufacturer, manufacturer);
+        copyString(adapterItem->serialNumber, udev_device_get_sysattr_value(usbDevice, "serial"));
+        copyString(adapterItem->locationId, udev_device_get_syspath(ttyDevice));
+        copyString(adapterItem->vendorId, idVendor);
+        copyString(adapterItem->productId, udev_device_get_sysattr_value(usbDevice, "idProduct"));
+
+        return true;
+    }
+
+    void emitAdapterEvent(const char *action, const sd_rpc_serial_port_desc_t &adapterItem)
+    {
+        Nan::HandleScope scope;
+
+        v8::Local<v8::Value> argv[3];
+        argv[0] = Nan::Undefined();
+        argv[1] = Nan::New(action).ToLocalChecked();
+        argv[2] = adapterToJs(adapterItem);
+
+        Nan::AsyncResource resource("pc-ble-driver-js:callback");
+        adapterMonitor->callback->Call(3, argv, &resource);
+    }
+
+    void close_monitor(AdapterMonitor *monitor)
+    {
+        if (monitor->pollHandle != nullptr)
+        {
+            uv_poll_stop(monitor->pollHandle);
+            uv_close(reinterpret_cast<uv_handle_t *>(monitor->pollHandle), [](uv_handle_t *handle) {
+                delete reinterpret_cast<uv_poll_t *>(handle);
+            });
+            monitor->pollHandle = nullptr;
+        }
+
+        if (monitor->udevMonitor != nullptr)
+        {
+            udev_monitor_unref(monitor->udevMonitor);
+            monitor->udevMonitor = nullptr;
+        }
+
+        if (monitor->udevContext != nullptr)
+        {
+            udev_unref(monitor->udevContext);
+            monitor->udevContext = nullptr;
+        }
+    }
+
+    // This runs in Main Thread
+    void on_udev_event(uv_poll_t *handle, int status, int events)
+    {
+        if (adapterMonitor == nullptr || status < 0)
+        {
+            return;
+        }
+
+        struct udev_device *ttyDevice;
+
+        // The monitor socket is non-blocking, drain all pending events
+        while ((ttyDevice = udev_monitor_receive_device(adapterMonitor->udevMonitor)) != nullptr)
+        {
+            auto action = udev_device_get_action(ttyDevice);
+            auto devnode = udev_device_get_devnode(ttyDevice);
+
+            if (action != nullptr && devnode != nullptr)
+            {
+                auto &adapters = adapterMonitor->adapters;
+                auto existing = std::find_if(adapters.begin(), adapters.end(), [devnode](const sd_rpc_serial_port_desc_t &item) {
+                    return strcmp(item.port, devnode) == 0;
+                });
+
+                if (strcmp(action, "add") == 0 && existing == adapters.end())
+                {
+                    sd_rpc_serial_port_desc_t adapterItem;
+
+                    if (adapterFromUdevDevice(ttyDevice, &adapterItem))
+                    {
+                        adapters.push_back(adapterItem);
+                        emitAdapterEvent("added", adapterItem);
+                    }
+                }
+                else if (strcmp(action, "remove") == 0 && existing != adapters.end())
+                {
+                    auto adapterItem = *existing;
+                    adapters.erase(existing);
+                    emitAdapterEvent("removed", adapterItem);
+                }
+            }
+
+            udev_device_unref(ttyDevice);
+
+            // The callback may have stopped the monitor
+            if (adapterMonitor == nullptr || adapterMonitor->udevMonitor == nullptr)
+            {
+                return;
+            }
+        }
+    }
+
+    // This runs in a worker thread (not Main Thread)
+    void InitialAdapterScan(uv_work_t *req)
+    {
+        GetAdapterList(req);
+    }
+
+    // This runs in Main Thread
+    void AfterInitialAdapterScan(uv_work_t *req)
+    {
+        Nan::HandleScope scope;
+        auto baton = static_cast<AdapterListBaton*>(req->data);
+
+        // Monitor stopped or restarted while scanning
+        if (adapterMonitor == nullptr || adapterMonitor->udevMonitor == nullptr || adapterMonitor->ready)
+        {
+            delete baton;
+            return;
+        }
+
+        if (baton->result != NRF_SUCCESS)
+        {
+            v8::Local<v8::Value> argv[1];
+            argv[0] = ErrorMessage::getErrorMessage(baton->result, "getting adapter list");
+
+            Nan::AsyncResource resource("pc-ble-driver-js:callback");
+            baton->callback->Call(1, argv, &resource);
+
+            close_monitor(adapterMonitor.get());
+            adapterMonitor.reset();
+            delete baton;
+            return;
+        }
+
+        adapterMonitor->adapters = baton->results;
+        adapterMonitor->ready = true;
+        delete baton;
+
+        // Events received during the scan are buffered by the monitor socket,
+        // start polling only now so that they are applied on top of the scan.
+        adapterMonitor->pollHandle = new uv_poll_t();
+        uv_poll_init(uv_default_loop(), adapterMonitor->pollHandle, udev_monitor_get_fd(adapterMonitor->udevMonitor));
+        uv_poll_start(adapterMonitor->pollHandle, UV_READABLE, on_udev_event);
+
+        // The monitor shall not keep the event loop alive
+        uv_unref(reinterpret_cast<uv_handle_t *>(adapterMonitor->pollHandle));
+
+        // Copy, the callback may stop the monitor
+        auto adapters = adapterMonitor->adapters;
+
+        for (auto adapterItem : adapters)
+        {
+            if (adapterMonitor == nullptr)
+            {
+                break;
+            }
+
+            emitAdapterEvent("added", adapterItem);
+        }
+
+        if (adapterMonitor != nullptr)
+        {
+            v8::Local<v8::Value> argv[2];
+            argv[0] = Nan::Undefined();
+            argv[1] = Nan::New("ready").ToLocalChecked();
+
+            Nan::AsyncResource resource("pc-ble-driver-js:callback");
+            adapterMonitor->callback->Call(2, argv, &resource);
+        }
+    }
+#endif
+}
+
+// Starts monitoring for added and removed adapters. Returns false if hotplug
+// monitoring is not supported on this platform, the caller must then poll
+// with getAdapters.
+//
+// The callback is called with (err, action, adapter) where action is 'added',
+// 'removed' or 'ready'. 'ready' is sent once after the initial adapter scan.
+NAN_METHOD(StartAdapterMonitor)
+{
+    v8::Local<v8::Function> callback;
+
+    try
+    {
+        callback = ConversionUtility::getCallbackFunction(info[0]);
+    }
+    catch (std::string error)
+    {
+        auto message = ErrorMessage::getTypeErrorMessage(0, error);
+        Nan::ThrowTypeError(message);
+        return;
+    }
+
+#ifdef __linux__
+    if (adapterMonitor != nullptr)
+    {
+        close_monitor(adapterMonitor.get());
+        adapterMonitor.reset();
+    }
+
+    auto monitor = std::make_unique<AdapterMonitor>();
+    monitor->udevContext = udev_new();
+
+    if (monitor->udevContext != nullptr)
+    {
+        monitor->udevMonitor = udev_monitor_new_from_netlink(monitor->udevContext, "udev");
+    }
+
+    if (monitor->udevMonitor == nullptr
+        || udev_monitor_filter_add_match_subsystem_devtype(monitor->udevMonitor, "tty", nullptr) < 0
+        || udev_monitor_enable_receiving(monitor->udevMonitor) < 0)
+    {
+        close_monitor(monitor.get());
+        info.GetReturnValue().Set(Nan::False());
+        return;
+    }
+
+    monitor->callback = std::make_unique<Nan::Callback>(callback);
+    adapterMonitor = std::move(monitor);
+
+    // Monitor is receiving, do one full scan to populate the cache
+    auto baton = new AdapterListBaton(callback);
+    uv_queue_work(uv_default_loop(), baton->req, InitialAdapterScan, reinterpret_cast<uv_after_work_cb>(AfterInitialAdapterScan));
+
+    info.GetReturnValue().Set(Nan::True());
+#else
+    info.GetReturnValue().Set(Nan::False());
+#endif
+}
+
+NAN_METHOD(StopAdapterMonitor)
+{
+#ifdef __linux__
+    if (adapterMonitor != nullptr)
+    {
+        close_monitor(adapterMonitor.get());
+        adapterMonitor.reset();
+    }
+#endif
+}
@@ -40,6 +40,11 @@
 
 METHOD_DEFINITIONS(GetAdapterList);
 
+// Hotplug based adapter monitoring. Keeps a cached list of adapters that is
+// updated from udev events instead of enumerating all serial ports.
+NAN_METHOD(StartAdapterMonitor);
+NAN_METHOD(StopAdapterMonitor);
+
 struct AdapterListBaton : Baton
 {
 public:
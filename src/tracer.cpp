@@ -0,0 +1,461 @@
+/* Copyright (c) 2010 - 2017, Nordic Semiconductor ASA
+ *
+ * All rights reserved.
+ *
+ * Use in source and binary forms, redistribution in binary form only, with
+ * or without modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions in binary form, except as embedded into a Nordic
+ *    Semiconductor ASA integrated circuit in a product or a software update for
+ *    such product, must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other
+ *    materials provided with the distribution.
+ *
+ * 2. Neither the name of Nordic Semiconductor ASA nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * 3. This software, with or without modification, must only be used with a Nordic
+ *    Semiconductor ASA integrated circuit.
+ *
+ * 4. Any software provided in binary form under this license must not be reverse
+ *    engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY NORDIC SEMICONDUCTOR ASA "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NORDIC SEMICONDUCTOR ASA OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+ * TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "tracer.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <vector>
+
+std::atomic<bool> Tracer::enabled(false);
+
+// This compilation unit will be linked several times. So the trace
+// buffers must not have external linkage.
+namespace {
+    // Slot of a ring buffer. The sequence is odd while the owning thread
+    // writes the slot, so that readers can tell a span they copied is torn.
+    // The fields are atomic for readers to copy them while they are written.
+    struct TraceSlot
+    {
+        TraceSlot() : sequence(0) {}
+
+        std::atomic<uint64_t> sequence;
+        std::atomic<const char *> name;
+        std::atomic<const char *> category;
+        std::atomic<uint64_t> start;
+        std::atomic<uint64_t> duration;
+        std::atomic<uint64_t> asyncId;
+        std::atomic<uint32_t> adapterId;
+        std::atomic<uint16_t> connHandle;
+    };
+
+    // Ring buffer owned by one thread. Only the owning thread writes spans,
+    // readers use the write count to find the valid part of the buffer.
+    // When the thread exits the buffer is handed to the next thread that
+    // starts tracing, so threads of closed adapters do not leave buffers behind.
+    struct ThreadBuffer
+    {
+        ThreadBuffer(uint32_t tid, uint32_t size) : tid(tid), slots(size), written(0), owned(true) {}
+
+        uint32_t tid;
+        std::vector<TraceSlot> slots;
+        std::atomic<uint64_t> written;
+        // Guarded by bufferListMutex
+        bool owned;
+    };
+
+    typedef std::vector<std::shared_ptr<ThreadBuffer>> ThreadBufferList;
+
+    // Copy the span written at index, returns false if it is being written
+    // or was overwritten by a later span
+    bool readSpan(const ThreadBuffer &buffer, uint64_t index, TraceSpan &span)
+    {
+        const auto &slot = buffer.slots[index % buffer.slots.size()];
+        auto expected = 2 * index + 2;
+
+        if (slot.sequence.load(std::memory_order_acquire) != expected)
+        {
+            return false;
+        }
+
+        span.name = slot.name.load(std::memory_order_relaxed);
+        span.category = slot.category.load(std::memory_order_relaxed);
+        span.start = slot.start.load(std::memory_order_relaxed);
+        span.duration = slot.duration.load(std::memory_order_relaxed);
+        span.asyncId = slot.asyncId.load(std::memory_order_relaxed);
+        span.adapterId = slot.adapterId.load(std::memory_order_relaxed);
+        span.connHandle = slot.connHandle.load(std::memory_order_relaxed);
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return slot.sequence.load(std::memory_order_relaxed) == expected;
+    }
+
+    std::mutex bufferListMutex;
+    // Buffers of the running trace
+    ThreadBufferList bufferList;
+    // Buffers of stopped traces, until they are written
+    ThreadBufferList stoppedBufferList;
+    uint32_t bufferSize = TRACE_BUFFER_SIZE;
+    // Changed when a trace starts or stops, threads then take a buffer of the new trace
+    std::atomic<uint32_t> traceGeneration(0);
+
+    std::atomic<uint64_t> asyncIdCounter(0);
+    // Start of the trace, timestamps are written relative to this
+    std::atomic<std::chrono::steady_clock::rep> epoch(0);
+
+    // The buffer list owns the buffers. A thread only keeps a reference to its
+    // buffer while it writes a span, so that stopping the trace releases them.
+    struct ThreadBufferOwner
+    {
+        ~ThreadBufferOwner()
+        {
+            auto owned = buffer.lock();
+
+            if (owned)
+            {
+                std::lock_guard<std::mutex> lock(bufferListMutex);
+                owned->owned = false;
+            }
+        }
+
+        std::weak_ptr<ThreadBuffer> buffer;
+        uint32_t generation = 0;
+    };
+
+    thread_local ThreadBufferOwner threadBufferOwner;
+
+    std::shared_ptr<ThreadBuffer> getThreadBuffer()
+    {
+        auto buffer = threadBufferOwner.buffer.lock();
+
+        if (buffer && threadBufferOwner.generation == traceGeneration.load(std::memory_order_acquire))
+        {
+            return buffer;
+        }
+
+        std::lock_guard<std::mutex> lock(bufferListMutex);
+
+        // Stopped while the span was recorded
+        if (!Tracer::isEnabled())
+        {
+            return nullptr;
+        }
+
+        // Continue in the buffer of a thread that has exited
+        auto unowned = std::find_if(bufferList.begin(), bufferList.end(), [](const std::shared_ptr<ThreadBuffer> &listed) {
+            return !listed->owned;
+        });
+
+        if (unowned != bufferList.end())
+        {
+            buffer = *unowned;
+            buffer->owned = true;
+        }
+        else
+        {
+            auto tid = static_cast<uint32_t>(bufferList.size() + 1);
+            buffer = std::make_shared<ThreadBuffer>(tid, bufferSize);
+            bufferList.push_back(buffer);
+        }
+
+        threadBufferOwner.buffer = buffer;
+        threadBufferOwner.generation = traceGeneration.load(std::memory_order_relaxed);
+
+        return buffer;
+    }
+
+    uint64_t toMicroseconds(std::chrono::steady_clock::time_point time)
+    {
+        auto start = std::chrono::steady_clock::time_point(std::chrono::steady_clock::duration(epoch.load(std::memory_order_relaxed)));
+
+        if (time < start)
+        {
+            return 0;
+        }
+
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(time - start).count());
+    }
+
+    void writeString(std::ofstream &out, const char *value)
+    {
+        out << '"';
+
+        for (auto c = value; *c != '\0'; c++)
+        {
+            if (*c == '"' || *c == '\\')
+            {
+                out << '\\';
+            }
+
+            out << *c;
+        }
+
+        out << '"';
+    }
+
+    void writeEvent(std::ofstream &out, const TraceSpan &span, uint32_t tid, const char *phase, uint64_t timestamp, bool &first)
+    {
+        out << (first ? "\n" : ",\n") << "{\"name\":";
+        writeString(out, span.name);
+        out << ",\"cat\":";
+        writeString(out, span.category);
+        out << ",\"ph\":\"" << phase << "\",\"ts\":" << timestamp
+            << ",\"pid\":" << span.adapterId << ",\"tid\":" << tid;
+
+        if (phase[0] == 'X')
+        {
+            out << ",\"dur\":" << span.duration;
+        }
+        else
+        {
+            out << ",\"id\":" << span.asyncId;
+        }
+
+        if (span.connHandle != TRACE_NO_CONN_HANDLE)
+        {
+            out << ",\"args\":{\"conn_handle\":" << span.connHandle << "}";
+        }
+
+        out << "}";
+        first = false;
+    }
+}
+
+void Tracer::start(uint32_t size)
+{
+    std::lock_guard<std::mutex> lock(bufferListMutex);
+
+    // Threads take new buffers of this size, spans of an earlier running trace are dropped
+    bufferList.clear();
+    bufferSize = size;
+    traceGeneration.fetch_add(1, std::memory_order_release);
+
+    epoch.store(std::chrono::steady_clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+    enabled.store(true, std::memory_order_relaxed);
+}
+
+void Tracer::stop()
+{
+    std::lock_guard<std::mutex> lock(bufferListMutex);
+
+    enabled.store(false, std::memory_order_relaxed);
+
+    // Kept until written. A thread still adding a span keeps its buffer alive until it is done.
+    std::move(bufferList.begin(), bufferList.end(), std::back_inserter(stoppedBufferList));
+    bufferList.clear();
+    traceGeneration.fetch_add(1, std::memory_order_release);
+}
+
+uint64_t Tracer::nextAsyncId()
+{
+    return asyncIdCounter.fetch_add(1, std::memory_order_relaxed) + 1;
+}
+
+void Tracer::addSpan(const char *category, const char *name, uint32_t adapterId, uint16_t connHandle,
+                     std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end,
+                     uint64_t asyncId)
+{
+    if (!isEnabled() || name == nullptr)
+    {
+        return;
+    }
+
+    auto buffer = getThreadBuffer();
+
+    if (buffer == nullptr)
+    {
+        return;
+    }
+
+    auto index = buffer->written.load(std::memory_order_relaxed);
+    auto &slot = buffer->slots[index % buffer->slots.size()];
+    auto spanStart = toMicroseconds(start);
+
+    slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot.name.store(name, std::memory_order_relaxed);
+    slot.category.store(category, std::memory_order_relaxed);
+    slot.start.store(spanStart, std::memory_order_relaxed);
+    slot.duration.store((end > start) ? toMicroseconds(end) - spanStart : 0, std::memory_order_relaxed);
+    slot.asyncId.store(asyncId, std::memory_order_relaxed);
+    slot.adapterId.store(adapterId, std::memory_order_relaxed);
+    slot.connHandle.store(connHandle, std::memory_order_relaxed);
+
+    slot.sequence.store(2 * index + 2, std::memory_order_release);
+    buffer->written.store(index + 1, std::memory_order_release);
+}
+
+bool Tracer::write(const std::string &path)
+{
+    // The buffers are released when they have been written, or if writing fails
+    ThreadBufferList buffers;
+
+    {
+        std::lock_guard<std::mutex> lock(bufferListMutex);
+        buffers.swap(stoppedBufferList);
+    }
+
+    std::ofstream out(path, std::ios::out | std::ios::trunc);
+
+    if (!out.is_open())
+    {
+        return false;
+    }
+
+    std::set<uint32_t> adapterIds;
+    auto first = true;
+
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+    for (auto &buffer : buffers)
+    {
+        auto written = buffer->written.load(std::memory_order_acquire);
+        auto size = static_cast<uint64_t>(buffer->slots.size());
+        auto begin = (written > size) ? written - size : 0;
+
+        for (auto index = begin; index < written; index++)
+        {
+            TraceSpan span;
+
+            // Overwritten while the trace is written, the thread is still tracing
+            if (!readSpan(*buffer, index, span))
+            {
+                continue;
+            }
+
+            adapterIds.insert(span.adapterId);
+
+            if (span.asyncId == 0)
+            {
+                writeEvent(out, span, buffer->tid, "X", span.start, first);
+            }
+            else
+            {
+                writeEvent(out, span, buffer->tid, "b", span.start, first);
+                writeEvent(out, span, buffer->tid, "e", span.start + span.duration, first);
+            }
+        }
+    }
+
+    for (auto adapterId : adapterIds)
+    {
+        out << (first ? "\n" : ",\n")
+            << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << adapterId
+            << ",\"args\":{\"name\":\"adapter " << adapterId << "\"}}";
+        first = false;
+    }
+
+    out << "\n]}\n";
+    out.close();
+
+    return !out.fail();
+}
+
+NAN_METHOD(StartTracing)
+{
+    uint32_t size = TRACE_BUFFER_SIZE;
+
+    try
+    {
+        if (info.Length() > 0 && !info[0]->IsUndefined())
+        {
+            auto options = ConversionUtility::getJsObject(info[0]);
+
+            if (Utility::Has(options, "bufferSize"))
+            {
+                size = ConversionUtility::getNativeUint32(options, "bufferSize");
+            }
+        }
+    }
+    catch (std::string error)
+    {
+        auto message = ErrorMessage::getTypeErrorMessage(0, error);
+        Nan::ThrowTypeError(message);
+        return;
+    }
+
+    Tracer::start(std::max<uint32_t>(size, 1));
+}
+
+NAN_METHOD(StopTracing)
+{
+    std::string path;
+    v8::Local<v8::Function> callback;
+    auto argumentcount = 0;
+
+    try
+    {
+        path = ConversionUtility::getNativeString(info[argumentcount]);
+        argumentcount++;
+
+        callback = ConversionUtility::getCallbackFunction(info[argumentcount]);
+        argumentcount++;
+    }
+    catch (std::string error)
+    {
+        auto message = ErrorMessage::getTypeErrorMessage(argumentcount, error);
+        Nan::ThrowTypeError(message);
+        return;
+    }
+
+    Tracer::stop();
+
+    auto baton = new StopTracingBaton(callback);
+    baton->path = path;
+
+    uv_queue_work(uv_default_loop(), baton->req, StopTracing, reinterpret_cast<uv_after_work_cb>(AfterStopTracing));
+}
+
+// This runs in a worker thread (not Main Thread)
+void StopTracing(uv_work_t *req)
+{
+    auto baton = static_cast<StopTracingBaton *>(req->data);
+    baton->result = Tracer::write(baton->path) ? NRF_SUCCESS : NRF_ERROR_INTERNAL;
+}
+
+// This runs in Main Thread
+void AfterStopTracing(uv_work_t *req)
+{
+    Nan::HandleScope scope;
+    auto baton = static_cast<StopTracingBaton *>(req->data);
+    v8::Local<v8::Value> argv[1];
+
+    if (baton->result != NRF_SUCCESS)
+    {
+        argv[0] = ErrorMessage::getErrorMessage(baton->result, "writing trace file");
+    }
+    else
+    {
+        argv[0] = Nan::Undefined();
+    }
+
+    Nan::AsyncResource resource("pc-ble-driver-js:callback");
+    baton->callback->Call(1, argv, &resource);
+    delete baton;
+}
+
+extern "C" {
+    void init_tracer(Nan::ADDON_REGISTER_FUNCTION_ARGS_TYPE target)
+    {
+        Utility::SetMethod(target, "startTracing", StartTracing);
+        Utility::SetMethod(target, "stopTracing", StopTracing);
+    }
+}
@@ -0,0 +1,112 @@
+/* Copyright (c) 2010 - 2017, Nordic Semiconductor ASA
+ *
+ * All rights reserved.
+ *
+ * Use in source and binary forms, redistribution in binary form only, with
+ * or without modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions in binary form, except as embedded into a Nordic
+ *    Semiconductor ASA integrated circuit in a product or a software update for
+ *    such product, must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other
+ *    materials provided with the distribution.
+ *
+ * 2. Neither the name of Nordic Semiconductor ASA nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * 3. This software, with or without modification, must only be used with a Nordic
+ *    Semiconductor ASA integrated circuit.
+ *
+ * 4. Any software provided in binary form under this license must not be reverse
+ *    engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY NORDIC SEMICONDUCTOR ASA "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NORDIC SEMICONDUCTOR ASA OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+ * TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef TRACER_H
+#define TRACER_H
+
+#include <nan.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+#include "common.h"
+
+// Default number of spans kept per thread while tracing
+const auto TRACE_BUFFER_SIZE = 65536;
+
+// Connection handle used for spans that are not related to a connection
+const uint16_t TRACE_NO_CONN_HANDLE = 0xFFFF;
+
+struct TraceSpan
+{
+public:
+    // Name and category must be string literals, they are not copied
+    const char *name;
+    const char *category;
+    uint64_t start;
+    uint64_t duration;
+    // If not 0 the span is written as an async span with this id
+    uint64_t asyncId;
+    uint32_t adapterId;
+    uint16_t connHandle;
+};
+
+// Opt-in tracer for the command and event lifecycle. Spans are recorded
+// into a lock free ring buffer per thread and written as Chrome Trace Event
+// JSON, which can be loaded into chrome://tracing or Perfetto. Spans that
+// are overwritten while the trace is written are left out of it. The
+// buffers of a trace are released once it has been written.
+class Tracer
+{
+public:
+    static bool isEnabled()
+    {
+        return enabled.load(std::memory_order_relaxed);
+    }
+
+    static void start(uint32_t bufferSize);
+    static void stop();
+
+    static uint64_t nextAsyncId();
+
+    static void addSpan(const char *category, const char *name, uint32_t adapterId, uint16_t connHandle,
+                        std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end,
+                        uint64_t asyncId = 0);
+
+    // Write the spans recorded until stop as Chrome Trace Event JSON. Returns false on failure.
+    static bool write(const std::string &path);
+
+private:
+    static std::atomic<bool> enabled;
+};
+
+NAN_METHOD(StartTracing);
+METHOD_DEFINITIONS(StopTracing);
+
+struct StopTracingBaton : Baton
+{
+public:
+    BATON_CONSTRUCTOR(StopTracingBaton)
+    std::string path;
+};
+
+extern "C" {
+    void init_tracer(Nan::ADDON_REGISTER_FUNCTION_ARGS_TYPE target);
+}
+
+#endif // TRACER_H
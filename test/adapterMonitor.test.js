@@ -0,0 +1,123 @@
+/* Copyright (c) 2010 - 2017, Nordic Semiconductor ASA
+ *
+ * All rights reserved.
+ *
+ * Use in source and binary forms, redistribution in binary form only, with
+ * or without modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions in binary form, except as embedded into a Nordic
+ *    Semiconductor ASA integrated circuit in a product or a software update for
+ *    such product, must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other
+ *    materials provided with the distribution.
+ *
+ * 2. Neither the name of Nordic Semiconductor ASA nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * 3. This software, with or without modification, must only be used with a Nordic
+ *    Semiconductor ASA integrated circuit.
+ *
+ * 4. Any software provided in binary form under this license must not be reverse
+ *    engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY NORDIC SEMICONDUCTOR ASA "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NORDIC SEMICONDUCTOR ASA OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+ * TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+'use strict';
+
+const api = require('../index');
+const debug = require('debug')('ble-driver:test:adapter-monitor');
+
+const LIST_WAIT_TIME = 5000;
+
+const serialNumberA = process.env.DEVICE_A_SERIAL_NUMBER;
+if (!serialNumberA) {
+    console.log('Missing env DEVICE_A_SERIAL_NUMBER=<SN e.g. from nrf-device-lister>');
+    process.exit(1);
+}
+
+const serialNumberB = process.env.DEVICE_B_SERIAL_NUMBER;
+if (!serialNumberB) {
+    console.log('Missing env DEVICE_B_SERIAL_NUMBER=<SN e.g. from nrf-device-lister>');
+    process.exit(1);
+}
+
+// Serial numbers are reported with or without leading zeros
+const withoutLeadingZeros = serialNumber => String(serialNumber).replace(/^0+/, '');
+
+function getAdapters(adapterFactory) {
+    return new Promise((resolve, reject) => {
+        adapterFactory.getAdapters((err, adapters) => {
+            if (err) {
+                reject(err);
+                return;
+            }
+
+            const described = {};
+            Object.keys(adapters).forEach(instanceId => {
+                const { state } = adapters[instanceId];
+                described[withoutLeadingZeros(state.serialNumber)] = state.port;
+            });
+
+            resolve(described);
+        });
+    });
+}
+
+async function waitForAdapters(adapterFactory, serialNumbers) {
+    const deadline = Date.now() + LIST_WAIT_TIME;
+
+    for (;;) {
+        // eslint-disable-next-line no-await-in-loop
+        const adapters = await getAdapters(adapterFactory);
+
+        if (serialNumbers.every(serialNumber => adapters[withoutLeadingZeros(serialNumber)])) {
+            return adapters;
+        }
+
+        if (Date.now() > deadline) {
+            throw new Error(`Adapters ${serialNumbers.join(', ')} not listed after ${LIST_WAIT_TIME} ms.`);
+        }
+
+        // eslint-disable-next-line no-await-in-loop
+        await new Promise(resolve => setTimeout(resolve, 100));
+    }
+}
+
+describe('the API', () => {
+    // Watches for adapters with the hotplug monitor where the AddOn supports it
+    const adapterFactory = api.AdapterFactory.getInstance();
+
+    afterAll(() => {
+        adapterFactory.stopMonitoring();
+    });
+
+    it('shall list the same adapters from the monitor as from enumerating serial ports', async () => {
+        const monitored = await waitForAdapters(adapterFactory, [serialNumberA, serialNumberB]);
+        debug(`Monitored adapters: ${JSON.stringify(monitored)}`);
+
+        const removed = jest.fn();
+        adapterFactory.on('removed', removed);
+
+        adapterFactory.stopMonitoring();
+
+        const enumerated = await getAdapters(adapterFactory);
+        debug(`Enumerated adapters: ${JSON.stringify(enumerated)}`);
+
+        expect(enumerated).toEqual(monitored);
+        expect(removed).not.toHaveBeenCalled();
+
+        adapterFactory.removeListener('removed', removed);
+    });
+});
@@ -0,0 +1,95 @@
+/* Copyright (c) 2010 - 2017, Nordic Semiconductor ASA
+ *
+ * All rights reserved.
+ *
+ * Use in source and binary forms, redistribution in binary form only, with
+ * or without modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions in binary form, except as embedded into a Nordic
+ *    Semiconductor ASA integrated circuit in a product or a software update for
+ *    such product, must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other
+ *    materials provided with the distribution.
+ *
+ * 2. Neither the name of Nordic Semiconductor ASA nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * 3. This software, with or without modification, must only be used with a Nordic
+ *    Semiconductor ASA integrated circuit.
+ *
+ * 4. Any software provided in binary form under this license must not be reverse
+ *    engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY NORDIC SEMICONDUCTOR ASA "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NORDIC SEMICONDUCTOR ASA OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+ * TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+'use strict';
+
+// Needs no devices, the functions are tested with the vectors of the specifications
+const drivers = {
+    v2: require('bindings')('pc-ble-driver-js-sd_api_v2'),
+    v5: require('bindings')('pc-ble-driver-js-sd_api_v5'),
+};
+
+function bytes(hex) {
+    return hex.match(/../g).map(byte => parseInt(byte, 16));
+}
+
+// IRK of the sample data of the random address hash function ah in the Bluetooth
+// Core Specification, most significant byte first as written there
+const IRK = bytes('ec0234a357c8ad05341010a60a397d9b');
+
+// Resolvable private address with prand 708194 and hash 0dfbaa
+const ADDRESS = bytes('708194' + '0dfbaa');
+
+// The SoftDevice has IRKs and addresses least significant byte first
+function softDeviceOrder(value) {
+    return value.slice().reverse();
+}
+
+Object.keys(drivers).forEach(version => {
+    const driver = drivers[version];
+
+    describe(`the ${version} driver`, () => {
+        it('shall encrypt with AES-128 as in FIPS-197', () => {
+            const key = bytes('000102030405060708090a0b0c0d0e0f');
+            const plaintext = bytes('00112233445566778899aabbccddeeff');
+
+            expect(driver.aes128Encrypt(key, plaintext)).toEqual(bytes('69c4e0d86a7b0430d8cdb78070b4c55a'));
+        });
+
+        it('shall resolve a private address generated from the IRK', () => {
+            expect(driver.resolvesPrivateAddress(softDeviceOrder(IRK), softDeviceOrder(ADDRESS))).toBe(true);
+        });
+
+        it('shall not resolve a private address with another hash', () => {
+            const address = ADDRESS.slice();
+            address[5] ^= 0x01;
+
+            expect(driver.resolvesPrivateAddress(softDeviceOrder(IRK), softDeviceOrder(address))).toBe(false);
+        });
+
+        it('shall not resolve a private address with another IRK', () => {
+            const irk = IRK.slice();
+            irk[0] ^= 0x01;
+
+            expect(driver.resolvesPrivateAddress(softDeviceOrder(irk), softDeviceOrder(ADDRESS))).toBe(false);
+        });
+
+        it('shall refuse keys of the wrong length', () => {
+            expect(() => driver.aes128Encrypt(bytes('0001'), bytes('00112233445566778899aabbccddeeff'))).toThrow();
+            expect(() => driver.resolvesPrivateAddress(softDeviceOrder(IRK), bytes('0001'))).toThrow();
+        });
+    });
+});
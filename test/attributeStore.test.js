@@ -0,0 +1,225 @@
+/* Copyright (c) 2010 - 2017, Nordic Semiconductor ASA
+ *
+ * All rights reserved.
+ *
+ * Use in source and binary forms, redistribution in binary form only, with
+ * or without modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions in binary form, except as embedded into a Nordic
+ *    Semiconductor ASA integrated circuit in a product or a software update for
+ *    such product, must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other
+ *    materials provided with the distribution.
+ *
+ * 2. Neither the name of Nordic Semiconductor ASA nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * 3. This software, with or without modification, must only be used with a Nordic
+ *    Semiconductor ASA integrated circuit.
+ *
+ * 4. Any software provided in binary form under this license must not be reverse
+ *    engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY NORDIC SEMICONDUCTOR ASA "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NORDIC SEMICONDUCTOR ASA OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+ * TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+'use strict';
+
+const { grabAdapter, releaseAdapter, setupAdapter, outcome } = require('./setup');
+const common = require('./common');
+
+const api = require('../index');
+const debug = require('debug')('ble-driver:test:attributeStore');
+
+const serviceFactory = new api.ServiceFactory();
+
+const PERIPHERAL_DEVICE_ADDRESS = 'FF:11:22:33:AA:CE';
+const PERIPHERAL_DEVICE_ADDRESS_TYPE = 'BLE_GAP_ADDR_TYPE_RANDOM_STATIC';
+
+const CENTRAL_DEVICE_ADDRESS = 'FF:11:22:33:AA:CF';
+const CENTRAL_DEVICE_ADDRESS_TYPE = 'BLE_GAP_ADDR_TYPE_RANDOM_STATIC';
+
+const SERVICE_UUID = 'F006F000AAAAAAAAAAAAAAAAAAAAAAAA';
+const CHAR_ACCEPT_UUID = 'F006F001AAAAAAAAAAAAAAAAAAAAAAAA';
+const CHAR_REJECT_UUID = 'F006F002AAAAAAAAAAAAAAAAAAAAAAAA';
+
+const MAX_LENGTH = 10;
+const STORE_MAX_LENGTH = 4;
+
+const serialNumberA = process.env.DEVICE_A_SERIAL_NUMBER;
+if (!serialNumberA) {
+    console.log('Missing env DEVICE_A_SERIAL_NUMBER=<SN e.g. from nrf-device-lister>');
+    process.exit(1);
+}
+
+const serialNumberB = process.env.DEVICE_B_SERIAL_NUMBER;
+if (!serialNumberB) {
+    console.log('Missing env DEVICE_B_SERIAL_NUMBER=<SN e.g. from nrf-device-lister>');
+    process.exit(1);
+}
+
+function servicesInit(adapter) {
+    const service = serviceFactory.createService(SERVICE_UUID);
+
+    const authorizedCharacteristic = uuid => serviceFactory.createCharacteristic(
+        service,
+        uuid,
+        [1, 2, 3],
+        {
+            broadcast: false,
+            read: true,
+            write: true,
+            writeWoResp: false,
+            reliableWrite: false,
+            notify: false,
+            indicate: false,
+        },
+        {
+            maxLength: MAX_LENGTH,
+            variableLength: true,
+            readPerm: ['open'],
+            writePerm: ['open'],
+            readAuth: true,
+            writeAuth: true,
+        });
+
+    const acceptCharacteristic = authorizedCharacteristic(CHAR_ACCEPT_UUID);
+    const rejectCharacteristic = authorizedCharacteristic(CHAR_REJECT_UUID);
+
+    return new Promise((resolve, reject) => {
+        adapter.setServices([service], err => {
+            if (err) {
+                return reject(new Error(`Error initializing services: ${JSON.stringify(err, null, 1)}'.`));
+            }
+
+            return resolve({
+                accept: acceptCharacteristic.instanceId,
+                reject: rejectCharacteristic.instanceId,
+            });
+        });
+    });
+}
+
+function readsServed(adapter, characteristicId, count) {
+    return new Promise(resolve => {
+        let reads = 0;
+
+        const onReadsServed = (attribute, served) => {
+            if (attribute.instanceId !== characteristicId) {
+                return;
+            }
+
+            reads += served;
+
+            if (reads >= count) {
+                adapter.removeListener('attributeReadsServed', onReadsServed);
+                resolve(reads);
+            }
+        };
+
+        adapter.on('attributeReadsServed', onReadsServed);
+    });
+}
+
+describe('the API', () => {
+    let centralAdapter;
+    let peripheralAdapter;
+    let peripheralDevice;
+    let localCharacteristics;
+    let remoteCharacteristics;
+
+    beforeAll(async () => {
+        // Errors here will not stop the tests from running.
+        // Issue filed regarding this: https://github.com/facebook/jest/issues/2713
+
+        centralAdapter = await grabAdapter(serialNumberA);
+        peripheralAdapter = await grabAdapter(serialNumberB);
+
+        await Promise.all([
+            setupAdapter(centralAdapter, '#CENTRAL', 'central', CENTRAL_DEVICE_ADDRESS, CENTRAL_DEVICE_ADDRESS_TYPE),
+            setupAdapter(peripheralAdapter, '#PERIPH', 'peripheral', PERIPHERAL_DEVICE_ADDRESS, PERIPHERAL_DEVICE_ADDRESS_TYPE)]);
+
+        localCharacteristics = await servicesInit(peripheralAdapter);
+
+        peripheralAdapter.startLocalAttributeStore(localCharacteristics.accept, { maxLength: STORE_MAX_LENGTH });
+        peripheralAdapter.startLocalAttributeStore(localCharacteristics.reject, { writes: 'reject' });
+
+        const [connection] = await outcome([
+            common.connectAndDiscover(centralAdapter, peripheralAdapter, {
+                address: PERIPHERAL_DEVICE_ADDRESS,
+                type: PERIPHERAL_DEVICE_ADDRESS_TYPE,
+            }),
+        ], 10000);
+
+        ({ peripheralDevice } = connection);
+        remoteCharacteristics = common.findCharacteristics(connection.attributes, {
+            accept: CHAR_ACCEPT_UUID,
+            reject: CHAR_REJECT_UUID,
+        });
+    });
+
+    afterAll(async () => {
+        await common.disconnect(centralAdapter, peripheralAdapter, peripheralDevice);
+
+        debug('releasing adapters');
+        await Promise.all([
+            releaseAdapter(centralAdapter.state.serialNumber),
+            releaseAdapter(peripheralAdapter.state.serialNumber)]);
+    });
+
+    it('shall serve reads from the store and report them', async () => {
+        const [first, second, reads] = await outcome([
+            common.readValue(centralAdapter, remoteCharacteristics.accept),
+            common.readValue(centralAdapter, remoteCharacteristics.accept),
+            readsServed(peripheralAdapter, localCharacteristics.accept, 2),
+        ]);
+
+        // Serving a read does not change the value
+        expect(first).toEqual([1, 2, 3]);
+        expect(second).toEqual([1, 2, 3]);
+        expect(reads).toBe(2);
+    });
+
+    it('shall accept writes into the store and serve them', async () => {
+        const [, changed] = await outcome([
+            common.writeValue(centralAdapter, remoteCharacteristics.accept, [4, 5], true),
+
+            new Promise(resolve => {
+                peripheralAdapter.once('characteristicValueChanged', characteristic => resolve(characteristic));
+            }),
+        ]);
+
+        expect(changed.instanceId).toBe(localCharacteristics.accept);
+        expect(Array.from(changed.value)).toEqual([4, 5]);
+
+        const [value] = await outcome([common.readValue(centralAdapter, remoteCharacteristics.accept)]);
+        expect(value).toEqual([4, 5]);
+    });
+
+    it('shall reject writes longer than the maximum length of the store', async () => {
+        await expect(common.writeValue(centralAdapter, remoteCharacteristics.accept, [1, 2, 3, 4, 5], true))
+            .rejects.toBeDefined();
+
+        const [value] = await outcome([common.readValue(centralAdapter, remoteCharacteristics.accept)]);
+        expect(value).toEqual([4, 5]);
+    });
+
+    it('shall reject writes to a store that rejects them and still serve reads', async () => {
+        await expect(common.writeValue(centralAdapter, remoteCharacteristics.reject, [9], true))
+            .rejects.toBeDefined();
+
+        const [value] = await outcome([common.readValue(centralAdapter, remoteCharacteristics.reject)]);
+        expect(value).toEqual([1, 2, 3]);
+    });
+});
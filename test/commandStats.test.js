@@ -0,0 +1,122 @@
+/* Copyright (c) 2010 - 2017, Nordic Semiconductor ASA
+ *
+ * All rights reserved.
+ *
+ * Use in source and binary forms, redistribution in binary form only, with
+ * or without modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions in binary form, except as embedded into a Nordic
+ *    Semiconductor ASA integrated circuit in a product or a software update for
+ *    such product, must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other
+ *    materials provided with the distribution.
+ *
+ * 2. Neither the name of Nordic Semiconductor ASA nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * 3. This software, with or without modification, must only be used with a Nordic
+ *    Semiconductor ASA integrated circuit.
+ *
+ * 4. Any software provided in binary form under this license must not be reverse
+ *    engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY NORDIC SEMICONDUCTOR ASA "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NORDIC SEMICONDUCTOR ASA OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+ * TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+'use strict';
+
+const { grabAdapter, releaseAdapter, setupAdapter } = require('./setup');
+
+const debug = require('debug')('ble-driver:test:command-stats');
+
+const CENTRAL_DEVICE_ADDRESS = 'FF:11:22:33:AA:CF';
+const CENTRAL_DEVICE_ADDRESS_TYPE = 'BLE_GAP_ADDR_TYPE_RANDOM_STATIC';
+
+const NUMBER_OF_CALLS = 10;
+
+const serialNumberA = process.env.DEVICE_A_SERIAL_NUMBER;
+if (!serialNumberA) {
+    console.log('Missing env DEVICE_A_SERIAL_NUMBER=<SN e.g. from nrf-device-lister>');
+    process.exit(1);
+}
+
+function commandStats(adapter, command) {
+    return adapter.getCommandStats()[command] || { count: 0, errorCount: 0 };
+}
+
+function expectLatency(latency, count) {
+    expect(latency.count).toBe(count);
+    expect(latency.min).toBeLessThanOrEqual(latency.avg);
+    expect(latency.avg).toBeLessThanOrEqual(latency.max);
+    expect(latency.total).toBeGreaterThanOrEqual(latency.max);
+
+    const bucketCounts = Object.keys(latency.buckets).map(bucket => latency.buckets[bucket]);
+    expect(bucketCounts.reduce((sum, bucketCount) => sum + bucketCount, 0)).toBe(count);
+}
+
+describe('the API', () => {
+    let adapter;
+
+    beforeAll(async () => {
+        // Errors here will not stop the tests from running.
+        // Issue filed regarding this: https://github.com/facebook/jest/issues/2713
+        adapter = await grabAdapter(serialNumberA);
+        await setupAdapter(adapter, '#CENTRAL', 'central', CENTRAL_DEVICE_ADDRESS, CENTRAL_DEVICE_ADDRESS_TYPE);
+    });
+
+    afterAll(async () => {
+        await releaseAdapter(adapter.state.serialNumber);
+    });
+
+    it('shall count the calls of each command and their latencies', async () => {
+        const before = commandStats(adapter, 'gapSetDeviceName');
+
+        for (let i = 0; i < NUMBER_OF_CALLS; i += 1) {
+            // eslint-disable-next-line no-await-in-loop
+            await new Promise((resolve, reject) => {
+                adapter.setName(`central${i}`, err => (err ? reject(err) : resolve()));
+            });
+        }
+
+        const after = commandStats(adapter, 'gapSetDeviceName');
+        debug(`gapSetDeviceName: ${JSON.stringify(after)}`);
+
+        expect(after.count).toBe(before.count + NUMBER_OF_CALLS);
+        expect(after.errorCount).toBe(before.errorCount);
+
+        expectLatency(after.queueWait, after.count);
+        expectLatency(after.call, after.count);
+        expectLatency(after.callbackDelay, after.count);
+
+        // The serialized call to the connectivity chip takes some time
+        expect(after.call.min).toBeGreaterThan(0);
+    });
+
+    it('shall count the calls of a command that fail', async () => {
+        const before = commandStats(adapter, 'gapStopAdvertising');
+
+        // The adapter is not advertising
+        await new Promise(resolve => {
+            adapter.stopAdvertising(err => {
+                expect(err).toBeDefined();
+                resolve();
+            });
+        });
+
+        const after = commandStats(adapter, 'gapStopAdvertising');
+
+        expect(after.count).toBe(before.count + 1);
+        expect(after.errorCount).toBe(before.errorCount + 1);
+    });
+});
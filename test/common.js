@@ -148,9 +148,195 @@ function addRandomServicesAndCharacteristicsToAdapter(serviceFactory, adapter, s
     });
 }
 
+function addCharacteristicWithCccd(serviceFactory, service, uuid, properties, options = {}) {
+    const value = options.value || [0];
+
+    const characteristic = serviceFactory.createCharacteristic(
+        service,
+        uuid,
+        value,
+        {
+            broadcast: false,
+            read: properties.read || false,
+            write: properties.write || false,
+            writeWoResp: false,
+            reliableWrite: false,
+            notify: properties.notify || false,
+            indicate: properties.indicate || false,
+        },
+        {
+            maxLength: options.maxLength || value.length,
+            variableLength: options.variableLength || false,
+            readPerm: ['open'],
+            writePerm: ['open'],
+        });
+
+    serviceFactory.createDescriptor(
+        characteristic,
+        '2902',
+        [0, 0],
+        {
+            maxLength: 2,
+            readPerm: ['open'],
+            writePerm: ['open'],
+            variableLength: false,
+        });
+
+    return characteristic;
+}
+
+/**
+ * Connect the central to the advertising peripheral, and discover the
+ * attributes of the peripheral.
+ *
+ * @param {Adapter} centralAdapter Adapter connecting.
+ * @param {Adapter} peripheralAdapter Adapter advertising.
+ * @param {Object} peripheralAddress Address and type of the peripheral.
+ * @returns {Promise} Resolves with the centralDevice and peripheralDevice of the
+ *                    connection, and the attributes from discoverAll.
+ */
+function connectAndDiscover(centralAdapter, peripheralAdapter, peripheralAddress) {
+    const connection = {};
+
+    return Promise.all([
+        startAdvertising(peripheralAdapter),
+        connect(centralAdapter, peripheralAddress),
+
+        new Promise(resolve => {
+            centralAdapter.once('deviceConnected', device => {
+                connection.peripheralDevice = device;
+                resolve();
+            });
+        }),
+
+        new Promise(resolve => {
+            peripheralAdapter.once('deviceConnected', device => {
+                connection.centralDevice = device;
+                resolve();
+            });
+        }),
+    ])
+    .then(() => new Promise((resolve, reject) => {
+        centralAdapter.discoverAll(connection.peripheralDevice.instanceId, (err, attributes) => {
+            if (err) {
+                reject(err);
+                return;
+            }
+
+            connection.attributes = attributes;
+            resolve(connection);
+        });
+    }));
+}
+
+/**
+ * Find the instance ids of discovered characteristics by UUID.
+ *
+ * @param {Object} attributes Attributes from discoverAll.
+ * @param {Object} uuids UUID of each characteristic to find, by name.
+ * @returns {Object} Instance id of each characteristic found, by name.
+ */
+function findCharacteristics(attributes, uuids) {
+    const found = {};
+
+    Object.keys(attributes.services).forEach(serviceId => {
+        const { characteristics } = attributes.services[serviceId];
+
+        Object.keys(characteristics || {}).forEach(characteristicId => {
+            Object.keys(uuids).forEach(name => {
+                if (characteristics[characteristicId].uuid === uuids[name]) {
+                    found[name] = characteristicId;
+                }
+            });
+        });
+    });
+
+    return found;
+}
+
+function readValue(adapter, characteristicId) {
+    return new Promise((resolve, reject) => {
+        adapter.readCharacteristicValue(characteristicId, (err, readBytes) => (
+            err ? reject(err) : resolve(Array.from(readBytes))
+        ));
+    });
+}
+
+function writeValue(adapter, characteristicId, value, ack) {
+    return new Promise((resolve, reject) => {
+        adapter.writeCharacteristicValue(characteristicId, value, ack, err => (
+            err ? reject(err) : resolve()
+        ));
+    });
+}
+
+/**
+ * Enable notifications or indications, and wait until the peripheral has
+ * seen the CCCD write.
+ */
+function subscribe(centralAdapter, peripheralAdapter, characteristicId, requireAck) {
+    return Promise.all([
+        new Promise((resolve, reject) => {
+            centralAdapter.startCharacteristicsNotifications(characteristicId, requireAck, err => (
+                err ? reject(err) : resolve()
+            ));
+        }),
+
+        new Promise(resolve => {
+            peripheralAdapter.once('descriptorValueChanged', () => resolve());
+        }),
+    ]);
+}
+
+/**
+ * Collect the next count values of a characteristic, from its notifications,
+ * indications or writes.
+ */
+function receiveValues(adapter, characteristicId, count) {
+    return new Promise(resolve => {
+        const values = [];
+
+        const onValueChanged = characteristic => {
+            if (characteristic.instanceId !== characteristicId) {
+                return;
+            }
+
+            values.push(Array.from(characteristic.value));
+
+            if (values.length === count) {
+                adapter.removeListener('characteristicValueChanged', onValueChanged);
+                resolve(values);
+            }
+        };
+
+        adapter.on('characteristicValueChanged', onValueChanged);
+    });
+}
+
+function disconnect(centralAdapter, peripheralAdapter, peripheralDevice) {
+    return Promise.all([
+        new Promise((resolve, reject) => {
+            centralAdapter.disconnect(peripheralDevice.instanceId, err => (
+                err ? reject(err) : resolve()
+            ));
+        }),
+
+        new Promise(resolve => {
+            peripheralAdapter.once('deviceDisconnected', () => resolve());
+        }),
+    ]);
+}
 
 module.exports = {
     startAdvertising,
     connect,
     addRandomServicesAndCharacteristicsToAdapter,
+    addCharacteristicWithCccd,
+    connectAndDiscover,
+    findCharacteristics,
+    readValue,
+    writeValue,
+    subscribe,
+    receiveValues,
+    disconnect,
 };
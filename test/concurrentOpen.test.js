@@ -0,0 +1,158 @@
+/* Copyright (c) 2010 - 2017, Nordic Semiconductor ASA
+ *
+ * All rights reserved.
+ *
+ * Use in source and binary forms, redistribution in binary form only, with
+ * or without modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions in binary form, except as embedded into a Nordic
+ *    Semiconductor ASA integrated circuit in a product or a software update for
+ *    such product, must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other
+ *    materials provided with the distribution.
+ *
+ * 2. Neither the name of Nordic Semiconductor ASA nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * 3. This software, with or without modification, must only be used with a Nordic
+ *    Semiconductor ASA integrated circuit.
+ *
+ * 4. Any software provided in binary form under this license must not be reverse
+ *    engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY NORDIC SEMICONDUCTOR ASA "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NORDIC SEMICONDUCTOR ASA OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+ * TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+'use strict';
+
+const { grabAdapter, releaseAdapter, setupAdapter, outcome } = require('./setup');
+const common = require('./common');
+
+const debug = require('debug')('ble-driver:test:concurrent-open');
+
+const PERIPHERAL_DEVICE_ADDRESS = 'FF:11:22:33:AA:CE';
+const PERIPHERAL_DEVICE_ADDRESS_TYPE = 'BLE_GAP_ADDR_TYPE_RANDOM_STATIC';
+
+const CENTRAL_DEVICE_ADDRESS = 'FF:11:22:33:AA:CF';
+const CENTRAL_DEVICE_ADDRESS_TYPE = 'BLE_GAP_ADDR_TYPE_RANDOM_STATIC';
+
+const SCAN_DURATION_WAIT_TIME = 5000;
+
+const serialNumberA = process.env.DEVICE_A_SERIAL_NUMBER;
+if (!serialNumberA) {
+    console.log('Missing env DEVICE_A_SERIAL_NUMBER=<SN e.g. from nrf-device-lister>');
+    process.exit(1);
+}
+
+const serialNumberB = process.env.DEVICE_B_SERIAL_NUMBER;
+if (!serialNumberB) {
+    console.log('Missing env DEVICE_B_SERIAL_NUMBER=<SN e.g. from nrf-device-lister>');
+    process.exit(1);
+}
+
+function close(adapter) {
+    return new Promise((resolve, reject) => {
+        adapter.close(err => (err ? reject(err) : resolve()));
+    });
+}
+
+function open(adapter) {
+    return new Promise((resolve, reject) => {
+        adapter.open({ baudRate: adapter.state.baudRate, logLevel: 'info' }, err => (
+            err ? reject(err) : resolve()
+        ));
+    });
+}
+
+describe('the API', () => {
+    let centralAdapter;
+    let peripheralAdapter;
+
+    beforeAll(async () => {
+        // Errors here will not stop the tests from running.
+        // Issue filed regarding this: https://github.com/facebook/jest/issues/2713
+
+        // Devices are programmed one at a time
+        centralAdapter = await grabAdapter(serialNumberA);
+        peripheralAdapter = await grabAdapter(serialNumberB);
+    });
+
+    afterAll(async () => {
+        await Promise.all([
+            releaseAdapter(centralAdapter.state.serialNumber),
+            releaseAdapter(peripheralAdapter.state.serialNumber)]);
+    });
+
+    it('shall support opening several adapters at the same time', async () => {
+        expect(centralAdapter).toBeDefined();
+        expect(peripheralAdapter).toBeDefined();
+
+        await Promise.all([close(centralAdapter), close(peripheralAdapter)]);
+
+        debug('Opening both adapters in parallel');
+        await outcome([open(centralAdapter), open(peripheralAdapter)], 10000);
+
+        expect(centralAdapter.state.available).toBe(true);
+        expect(peripheralAdapter.state.available).toBe(true);
+
+        await Promise.all([
+            setupAdapter(centralAdapter, '#CENTRAL', 'central', CENTRAL_DEVICE_ADDRESS, CENTRAL_DEVICE_ADDRESS_TYPE),
+            setupAdapter(peripheralAdapter, '#PERIPH', 'peripheral', PERIPHERAL_DEVICE_ADDRESS, PERIPHERAL_DEVICE_ADDRESS_TYPE)]);
+
+        expect(centralAdapter.state.address).toBe(CENTRAL_DEVICE_ADDRESS);
+        expect(peripheralAdapter.state.address).toBe(PERIPHERAL_DEVICE_ADDRESS);
+    });
+
+    it('shall route the events of each adapter to that adapter', async () => {
+        const peripheralDiscovered = jest.fn();
+        peripheralAdapter.on('deviceDiscovered', peripheralDiscovered);
+
+        const centralDiscovered = new Promise(resolve => {
+            const onDeviceDiscovered = device => {
+                if (device.address === PERIPHERAL_DEVICE_ADDRESS) {
+                    centralAdapter.removeListener('deviceDiscovered', onDeviceDiscovered);
+                    resolve();
+                }
+            };
+
+            centralAdapter.on('deviceDiscovered', onDeviceDiscovered);
+        });
+
+        await common.startAdvertising(peripheralAdapter);
+
+        await new Promise((resolve, reject) => {
+            centralAdapter.startScan({
+                active: true,
+                interval: 100,
+                window: 50,
+                timeout: 5,
+            }, err => (err ? reject(err) : resolve()));
+        });
+
+        await outcome([centralDiscovered], SCAN_DURATION_WAIT_TIME);
+
+        await Promise.all([
+            new Promise((resolve, reject) => {
+                centralAdapter.stopScan(err => (err ? reject(err) : resolve()));
+            }),
+            new Promise((resolve, reject) => {
+                peripheralAdapter.stopAdvertising(err => (err ? reject(err) : resolve()));
+            }),
+        ]);
+
+        // Only the scanning adapter gets advertising reports
+        expect(peripheralDiscovered).not.toHaveBeenCalled();
+        peripheralAdapter.removeListener('deviceDiscovered', peripheralDiscovered);
+    });
+});
@@ -0,0 +1,203 @@
+/* Copyright (c) 2010 - 2017, Nordic Semiconductor ASA
+ *
+ * All rights reserved.
+ *
+ * Use in source and binary forms, redistribution in binary form only, with
+ * or without modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions in binary form, except as embedded into a Nordic
+ *    Semiconductor ASA integrated circuit in a product or a software update for
+ *    such product, must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other
+ *    materials provided with the distribution.
+ *
+ * 2. Neither the name of Nordic Semiconductor ASA nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * 3. This software, with or without modification, must only be used with a Nordic
+ *    Semiconductor ASA integrated circuit.
+ *
+ * 4. Any software provided in binary form under this license must not be reverse
+ *    engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY NORDIC SEMICONDUCTOR ASA "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NORDIC SEMICONDUCTOR ASA OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+ * TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+'use strict';
+
+const { grabAdapter, releaseAdapter, setupAdapter, outcome } = require('./setup');
+const common = require('./common');
+
+const api = require('../index');
+const debug = require('debug')('ble-driver:test:gattQueues');
+
+const serviceFactory = new api.ServiceFactory();
+
+const PERIPHERAL_DEVICE_ADDRESS = 'FF:11:22:33:AA:CE';
+const PERIPHERAL_DEVICE_ADDRESS_TYPE = 'BLE_GAP_ADDR_TYPE_RANDOM_STATIC';
+
+const CENTRAL_DEVICE_ADDRESS = 'FF:11:22:33:AA:CF';
+const CENTRAL_DEVICE_ADDRESS_TYPE = 'BLE_GAP_ADDR_TYPE_RANDOM_STATIC';
+
+const SERVICE_UUID = 'F003F000AAAAAAAAAAAAAAAAAAAAAAAA';
+const CHAR_VALUE_UUID = 'F003F001AAAAAAAAAAAAAAAAAAAAAAAA';
+
+// Longer than the payload of a single ATT request with the default MTU of 23
+const LONG_VALUE_LENGTH = 100;
+
+const serialNumberA = process.env.DEVICE_A_SERIAL_NUMBER;
+if (!serialNumberA) {
+    console.log('Missing env DEVICE_A_SERIAL_NUMBER=<SN e.g. from nrf-device-lister>');
+    process.exit(1);
+}
+
+const serialNumberB = process.env.DEVICE_B_SERIAL_NUMBER;
+if (!serialNumberB) {
+    console.log('Missing env DEVICE_B_SERIAL_NUMBER=<SN e.g. from nrf-device-lister>');
+    process.exit(1);
+}
+
+function servicesInit(adapter) {
+    const service = serviceFactory.createService(SERVICE_UUID);
+
+    const valueCharacteristic = serviceFactory.createCharacteristic(
+        service,
+        CHAR_VALUE_UUID,
+        [0],
+        {
+            broadcast: false,
+            read: true,
+            write: true,
+            writeWoResp: true,
+            reliableWrite: false,
+            notify: false,
+            indicate: false,
+        },
+        {
+            maxLength: LONG_VALUE_LENGTH,
+            variableLength: true,
+            readPerm: ['open'],
+            writePerm: ['open'],
+        });
+
+    return new Promise((resolve, reject) => {
+        debug('Adding services');
+
+        adapter.setServices([service], err => {
+            if (err) {
+                return reject(new Error(`Error initializing services: ${JSON.stringify(err, null, 1)}'.`));
+            }
+
+            return resolve({ value: valueCharacteristic.instanceId });
+        });
+    });
+}
+
+describe('the API', () => {
+    let centralAdapter;
+    let peripheralAdapter;
+    let peripheralDevice;
+    let localCharacteristics;
+    let remoteCharacteristics;
+
+    beforeAll(async () => {
+        // Errors here will not stop the tests from running.
+        // Issue filed regarding this: https://github.com/facebook/jest/issues/2713
+
+        centralAdapter = await grabAdapter(serialNumberA);
+        peripheralAdapter = await grabAdapter(serialNumberB);
+
+        await Promise.all([
+            setupAdapter(centralAdapter, '#CENTRAL', 'central', CENTRAL_DEVICE_ADDRESS, CENTRAL_DEVICE_ADDRESS_TYPE),
+            setupAdapter(peripheralAdapter, '#PERIPH', 'peripheral', PERIPHERAL_DEVICE_ADDRESS, PERIPHERAL_DEVICE_ADDRESS_TYPE)]);
+
+        localCharacteristics = await servicesInit(peripheralAdapter);
+    });
+
+    afterAll(async () => {
+        debug('releasing adapters');
+        await Promise.all([
+            releaseAdapter(centralAdapter.state.serialNumber),
+            releaseAdapter(peripheralAdapter.state.serialNumber)]);
+    });
+
+    it('shall support setting up a connection and discovering the peripheral', async () => {
+        expect(centralAdapter).toBeDefined();
+        expect(peripheralAdapter).toBeDefined();
+
+        const [connection] = await outcome([
+            common.connectAndDiscover(centralAdapter, peripheralAdapter, {
+                address: PERIPHERAL_DEVICE_ADDRESS,
+                type: PERIPHERAL_DEVICE_ADDRESS_TYPE,
+            }),
+        ], 10000);
+
+        ({ peripheralDevice } = connection);
+        remoteCharacteristics = common.findCharacteristics(connection.attributes, { value: CHAR_VALUE_UUID });
+
+        expect(remoteCharacteristics.value).toBeDefined();
+    });
+
+    it('shall queue reads and writes issued without waiting for each other', async () => {
+        // Each operation completes with its own callback, none fails with a GATT operation in progress
+        const [, , , firstRead, secondRead] = await outcome([
+            common.writeValue(centralAdapter, remoteCharacteristics.value, [1], true),
+            common.writeValue(centralAdapter, remoteCharacteristics.value, [2], false),
+            common.writeValue(centralAdapter, remoteCharacteristics.value, [3], false),
+            common.readValue(centralAdapter, remoteCharacteristics.value),
+            common.readValue(centralAdapter, remoteCharacteristics.value),
+        ]);
+
+        // The peer handles the operations in the order they were queued
+        expect(firstRead).toEqual([3]);
+        expect(secondRead).toEqual([3]);
+    });
+
+    it('shall support long writes and reads', async () => {
+        const value = [];
+        for (let i = 0; i < LONG_VALUE_LENGTH; i += 1) {
+            value.push(i);
+        }
+
+        await outcome([
+            common.writeValue(centralAdapter, remoteCharacteristics.value, value, true),
+
+            new Promise(resolve => {
+                const onValueChanged = characteristic => {
+                    if (characteristic.instanceId === localCharacteristics.value &&
+                        characteristic.value.length === LONG_VALUE_LENGTH) {
+                        peripheralAdapter.removeListener('characteristicValueChanged', onValueChanged);
+                        resolve();
+                    }
+                };
+
+                peripheralAdapter.on('characteristicValueChanged', onValueChanged);
+            }),
+        ]);
+
+        const [readBytes] = await outcome([
+            common.readValue(centralAdapter, remoteCharacteristics.value),
+        ]);
+
+        expect(readBytes).toEqual(value);
+
+        // Prepared writes beyond the maximum length of the attribute are rejected as a whole
+        await expect(common.writeValue(centralAdapter, remoteCharacteristics.value, value.concat([0]), true))
+            .rejects.toBeDefined();
+    });
+
+    it('shall support disconnecting', async () => {
+        await outcome([common.disconnect(centralAdapter, peripheralAdapter, peripheralDevice)]);
+    });
+});
@@ -0,0 +1,214 @@
+/* Copyright (c) 2010 - 2017, Nordic Semiconductor ASA
+ *
+ * All rights reserved.
+ *
+ * Use in source and binary forms, redistribution in binary form only, with
+ * or without modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions in binary form, except as embedded into a Nordic
+ *    Semiconductor ASA integrated circuit in a product or a software update for
+ *    such product, must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other
+ *    materials provided with the distribution.
+ *
+ * 2. Neither the name of Nordic Semiconductor ASA nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * 3. This software, with or without modification, must only be used with a Nordic
+ *    Semiconductor ASA integrated circuit.
+ *
+ * 4. Any software provided in binary form under this license must not be reverse
+ *    engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY NORDIC SEMICONDUCTOR ASA "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NORDIC SEMICONDUCTOR ASA OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+ * TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+'use strict';
+const { grabAdapter, releaseAdapter, setupAdapter, outcome } = require('./setup');
+const common = require('./common');
+
+const api = require('../index');
+const debug = require('debug')('ble-driver:test:indicationQueue');
+
+const serviceFactory = new api.ServiceFactory();
+
+const PERIPHERAL_DEVICE_ADDRESS = 'FF:11:22:33:AA:CE';
+const PERIPHERAL_DEVICE_ADDRESS_TYPE = 'BLE_GAP_ADDR_TYPE_RANDOM_STATIC';
+
+const CENTRAL_DEVICE_ADDRESS = 'FF:11:22:33:AA:CF';
+const CENTRAL_DEVICE_ADDRESS_TYPE = 'BLE_GAP_ADDR_TYPE_RANDOM_STATIC';
+
+const SERVICE_UUID = 'F00BF000AAAAAAAAAAAAAAAAAAAAAAAA';
+const CHAR_INDICATE_UUID = 'F00BF001AAAAAAAAAAAAAAAAAAAAAAAA';
+const CHAR_NOTIFY_UUID = 'F00BF002AAAAAAAAAAAAAAAAAAAAAAAA';
+
+const INDICATION_COUNT = 5;
+
+// Fewer than the queue of a device takes before queueNotification asks the caller to wait
+const NOTIFICATION_COUNT = 20;
+
+const serialNumberA = process.env.DEVICE_A_SERIAL_NUMBER;
+if (!serialNumberA) {
+    console.log('Missing env DEVICE_A_SERIAL_NUMBER=<SN e.g. from nrf-device-lister>');
+    process.exit(1);
+}
+
+const serialNumberB = process.env.DEVICE_B_SERIAL_NUMBER;
+if (!serialNumberB) {
+    console.log('Missing env DEVICE_B_SERIAL_NUMBER=<SN e.g. from nrf-device-lister>');
+    process.exit(1);
+}
+
+function servicesInit(adapter) {
+    const service = serviceFactory.createService(SERVICE_UUID);
+    const indicateCharacteristic = common.addCharacteristicWithCccd(serviceFactory, service, CHAR_INDICATE_UUID, { indicate: true });
+    const notifyCharacteristic = common.addCharacteristicWithCccd(serviceFactory, service, CHAR_NOTIFY_UUID, { notify: true });
+
+    return new Promise((resolve, reject) => {
+        adapter.setServices([service], err => {
+            if (err) {
+                return reject(new Error(`Error initializing services: ${JSON.stringify(err, null, 1)}'.`));
+            }
+
+            return resolve({
+                indicate: indicateCharacteristic.instanceId,
+                notify: notifyCharacteristic.instanceId,
+            });
+        });
+    });
+}
+
+// Resolves with the values in the order their indications were confirmed
+function queueIndications(adapter, device, characteristicId, count) {
+    const confirmed = [];
+    const indications = [];
+
+    for (let i = 0; i < count; i += 1) {
+        indications.push(new Promise((resolve, reject) => {
+            adapter.queueIndication(device.instanceId, characteristicId, [i], err => {
+                if (err) {
+                    reject(err);
+                    return;
+                }
+
+                confirmed.push(i);
+                resolve();
+            });
+        }));
+    }
+
+    return Promise.all(indications).then(() => confirmed);
+}
+
+function queueNotifications(adapter, device, characteristicId, count) {
+    const notifications = [];
+
+    for (let i = 0; i < count; i += 1) {
+        notifications.push(new Promise((resolve, reject) => {
+            adapter.queueNotification(device.instanceId, characteristicId, [i], err => (
+                err ? reject(err) : resolve()
+            ));
+        }));
+    }
+
+    return Promise.all(notifications);
+}
+
+function valuesUpTo(count) {
+    const values = [];
+    for (let i = 0; i < count; i += 1) {
+        values.push([i]);
+    }
+
+    return values;
+}
+
+describe('the API', () => {
+    let centralAdapter;
+    let peripheralAdapter;
+    let centralDevice;
+    let peripheralDevice;
+    let localCharacteristics;
+    let remoteCharacteristics;
+
+    beforeAll(async () => {
+        // Errors here will not stop the tests from running.
+        // Issue filed regarding this: https://github.com/facebook/jest/issues/2713
+
+        centralAdapter = await grabAdapter(serialNumberA);
+        peripheralAdapter = await grabAdapter(serialNumberB);
+
+        await Promise.all([
+            setupAdapter(centralAdapter, '#CENTRAL', 'central', CENTRAL_DEVICE_ADDRESS, CENTRAL_DEVICE_ADDRESS_TYPE),
+            setupAdapter(peripheralAdapter, '#PERIPH', 'peripheral', PERIPHERAL_DEVICE_ADDRESS, PERIPHERAL_DEVICE_ADDRESS_TYPE)]);
+
+        localCharacteristics = await servicesInit(peripheralAdapter);
+
+        const [connection] = await outcome([
+            common.connectAndDiscover(centralAdapter, peripheralAdapter, {
+                address: PERIPHERAL_DEVICE_ADDRESS,
+                type: PERIPHERAL_DEVICE_ADDRESS_TYPE,
+            }),
+        ], 10000);
+
+        ({ centralDevice, peripheralDevice } = connection);
+        remoteCharacteristics = common.findCharacteristics(connection.attributes, {
+            indicate: CHAR_INDICATE_UUID,
+            notify: CHAR_NOTIFY_UUID,
+        });
+    });
+
+    afterAll(async () => {
+        await common.disconnect(centralAdapter, peripheralAdapter, peripheralDevice);
+
+        debug('releasing adapters');
+        await Promise.all([
+            releaseAdapter(centralAdapter.state.serialNumber),
+            releaseAdapter(peripheralAdapter.state.serialNumber)]);
+    });
+
+    it('shall fail an indication the device has not enabled', async () => {
+        await expect(queueIndications(peripheralAdapter, centralDevice, localCharacteristics.indicate, 1)).rejects.toBeDefined();
+    });
+
+    it('shall send queued indications in order once each is confirmed', async () => {
+        await outcome([common.subscribe(centralAdapter, peripheralAdapter, remoteCharacteristics.indicate, true)]);
+
+        const [confirmed, values] = await outcome([
+            queueIndications(peripheralAdapter, centralDevice, localCharacteristics.indicate, INDICATION_COUNT),
+            common.receiveValues(centralAdapter, remoteCharacteristics.indicate, INDICATION_COUNT),
+        ], 10000);
+
+        expect(values).toEqual(valuesUpTo(INDICATION_COUNT));
+        expect(confirmed).toEqual(valuesUpTo(INDICATION_COUNT).map(value => value[0]));
+    });
+
+    it('shall send indications while notifications are queued to the device', async () => {
+        await outcome([common.subscribe(centralAdapter, peripheralAdapter, remoteCharacteristics.notify, false)]);
+
+        // Indications are not counted in the turns the weights share
+        peripheralAdapter.setNotificationWeight(centralDevice.instanceId, 1);
+
+        const [, confirmed, notified, indicated] = await outcome([
+            queueNotifications(peripheralAdapter, centralDevice, localCharacteristics.notify, NOTIFICATION_COUNT),
+            queueIndications(peripheralAdapter, centralDevice, localCharacteristics.indicate, INDICATION_COUNT),
+            common.receiveValues(centralAdapter, remoteCharacteristics.notify, NOTIFICATION_COUNT),
+            common.receiveValues(centralAdapter, remoteCharacteristics.indicate, INDICATION_COUNT),
+        ], 10000);
+
+        expect(notified).toEqual(valuesUpTo(NOTIFICATION_COUNT));
+        expect(indicated).toEqual(valuesUpTo(INDICATION_COUNT));
+        expect(confirmed).toHaveLength(INDICATION_COUNT);
+    });
+});
@@ -0,0 +1,238 @@
+/* Copyright (c) 2010 - 2017, Nordic Semiconductor ASA
+ *
+ * All rights reserved.
+ *
+ * Use in source and binary forms, redistribution in binary form only, with
+ * or without modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions in binary form, except as embedded into a Nordic
+ *    Semiconductor ASA integrated circuit in a product or a software update for
+ *    such product, must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other
+ *    materials provided with the distribution.
+ *
+ * 2. Neither the name of Nordic Semiconductor ASA nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * 3. This software, with or without modification, must only be used with a Nordic
+ *    Semiconductor ASA integrated circuit.
+ *
+ * 4. Any software provided in binary form under this license must not be reverse
+ *    engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY NORDIC SEMICONDUCTOR ASA "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NORDIC SEMICONDUCTOR ASA OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+ * TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+'use strict';
+
+const { grabAdapter, releaseAdapter, setupAdapter, outcome } = require('./setup');
+
+const api = require('../index');
+const debug = require('debug')('ble-driver:test:localValues');
+
+const serviceFactory = new api.ServiceFactory();
+
+const PERIPHERAL_DEVICE_ADDRESS = 'FF:11:22:33:AA:CE';
+const PERIPHERAL_DEVICE_ADDRESS_TYPE = 'BLE_GAP_ADDR_TYPE_RANDOM_STATIC';
+
+const SERVICE_UUID = 'F009F000AAAAAAAAAAAAAAAAAAAAAAAA';
+const CHAR_FIRST_UUID = 'F009F001AAAAAAAAAAAAAAAAAAAAAAAA';
+const CHAR_SECOND_UUID = 'F009F002AAAAAAAAAAAAAAAAAAAAAAAA';
+const DESCRIPTOR_UUID = 'F009F003AAAAAAAAAAAAAAAAAAAAAAAA';
+
+const MAX_LENGTH = 20;
+
+// Longest value of an attribute, BLE_GATTS_VAR_ATTR_LEN_MAX
+const VAR_ATTR_LEN_MAX = 512;
+
+const serialNumberA = process.env.DEVICE_A_SERIAL_NUMBER;
+if (!serialNumberA) {
+    console.log('Missing env DEVICE_A_SERIAL_NUMBER=<SN e.g. from nrf-device-lister>');
+    process.exit(1);
+}
+
+function servicesInit(adapter) {
+    const service = serviceFactory.createService(SERVICE_UUID);
+
+    const characteristic = uuid => serviceFactory.createCharacteristic(
+        service,
+        uuid,
+        [0],
+        {
+            broadcast: false,
+            read: true,
+            write: true,
+            writeWoResp: false,
+            reliableWrite: false,
+            notify: false,
+            indicate: false,
+        },
+        {
+            maxLength: MAX_LENGTH,
+            variableLength: true,
+            readPerm: ['open'],
+            writePerm: ['open'],
+        });
+
+    const first = characteristic(CHAR_FIRST_UUID);
+    const second = characteristic(CHAR_SECOND_UUID);
+    const descriptor = serviceFactory.createDescriptor(
+        first,
+        DESCRIPTOR_UUID,
+        [0],
+        {
+            maxLength: MAX_LENGTH,
+            variableLength: true,
+            readPerm: ['open'],
+            writePerm: ['open'],
+        });
+
+    return new Promise((resolve, reject) => {
+        adapter.setServices([service], err => {
+            if (err) {
+                return reject(new Error(`Error initializing services: ${JSON.stringify(err, null, 1)}'.`));
+            }
+
+            return resolve({
+                first: first.instanceId,
+                second: second.instanceId,
+                descriptor: descriptor.instanceId,
+            });
+        });
+    });
+}
+
+function setLocalValues(adapter, values) {
+    return new Promise((resolve, reject) => {
+        adapter.setLocalValues(values, (err, errors) => (
+            err ? reject(err) : resolve(errors)
+        ));
+    });
+}
+
+function getLocalValues(adapter, attributeIds) {
+    return new Promise((resolve, reject) => {
+        adapter.getLocalValues(attributeIds, (err, values) => {
+            if (err) {
+                reject(err);
+                return;
+            }
+
+            // Copied out of the memory the values share
+            const copies = {};
+            Object.keys(values).forEach(attributeId => {
+                copies[attributeId] = Array.from(values[attributeId]);
+            });
+
+            resolve(copies);
+        });
+    });
+}
+
+describe('the API', () => {
+    let adapter;
+    let attributes;
+
+    beforeAll(async () => {
+        // Errors here will not stop the tests from running.
+        // Issue filed regarding this: https://github.com/facebook/jest/issues/2713
+
+        adapter = await grabAdapter(serialNumberA);
+        await setupAdapter(adapter, '#PERIPH', 'peripheral', PERIPHERAL_DEVICE_ADDRESS, PERIPHERAL_DEVICE_ADDRESS_TYPE);
+
+        attributes = await servicesInit(adapter);
+    });
+
+    afterAll(async () => {
+        debug('releasing adapter');
+        await releaseAdapter(adapter.state.serialNumber);
+    });
+
+    it('shall set and get the values of many attributes in one call', async () => {
+        const [errors] = await outcome([
+            setLocalValues(adapter, [
+                { attributeId: attributes.first, value: Buffer.from([1, 2, 3]) },
+                { attributeId: attributes.second, value: [4, 5] },
+                { attributeId: attributes.descriptor, value: [6] },
+            ]),
+        ]);
+
+        expect(errors).toEqual([undefined, undefined, undefined]);
+
+        const [values] = await outcome([
+            getLocalValues(adapter, [attributes.first, attributes.second, attributes.descriptor]),
+        ]);
+
+        expect(values).toEqual({
+            [attributes.first]: [1, 2, 3],
+            [attributes.second]: [4, 5],
+            [attributes.descriptor]: [6],
+        });
+    });
+
+    it('shall set values at an offset', async () => {
+        await outcome([setLocalValues(adapter, [{ attributeId: attributes.first, value: [9, 9], offset: 2 }])]);
+
+        const [values] = await outcome([getLocalValues(adapter, [attributes.first])]);
+        expect(values[attributes.first]).toEqual([1, 2, 9, 9]);
+    });
+
+    it('shall get the same attribute more than once', async () => {
+        const [values] = await outcome([getLocalValues(adapter, [attributes.second, attributes.second])]);
+        expect(values[attributes.second]).toEqual([4, 5]);
+    });
+
+    it('shall report the values the SoftDevice refuses', async () => {
+        const value = [];
+        for (let i = 0; i <= MAX_LENGTH; i += 1) {
+            value.push(i);
+        }
+
+        let errors;
+
+        await expect(new Promise((resolve, reject) => {
+            adapter.setLocalValues([
+                { attributeId: attributes.first, value: [7] },
+                { attributeId: attributes.second, value },
+            ], (err, valueErrors) => {
+                errors = valueErrors;
+                return err ? reject(err) : resolve();
+            });
+        })).rejects.toBeDefined();
+
+        expect(errors[0]).toBeUndefined();
+        expect(errors[1]).toBeDefined();
+
+        // The values before the one refused are set, the one refused is unchanged
+        const [values] = await outcome([getLocalValues(adapter, [attributes.first, attributes.second])]);
+        expect(values[attributes.first]).toEqual([7]);
+        expect(values[attributes.second]).toEqual([4, 5]);
+    });
+
+    it('shall refuse values longer than any attribute before setting any of them', async () => {
+        // A length that does not fit in 16 bits must not wrap around to a short one
+        const wrapping = Buffer.alloc(0x10000 + 1);
+
+        expect(() => adapter.setLocalValues([{ attributeId: attributes.first, value: wrapping }])).toThrow();
+        expect(() => adapter.setLocalValues([{ attributeId: attributes.first, value: Buffer.alloc(VAR_ATTR_LEN_MAX + 1) }])).toThrow();
+        expect(() => adapter.setLocalValues([
+            { attributeId: attributes.second, value: [8] },
+            { attributeId: attributes.first, value: [1], offset: VAR_ATTR_LEN_MAX },
+        ])).toThrow();
+
+        const [values] = await outcome([getLocalValues(adapter, [attributes.first, attributes.second])]);
+        expect(values[attributes.first]).toEqual([7]);
+        expect(values[attributes.second]).toEqual([4, 5]);
+    });
+});
@@ -0,0 +1,184 @@
+/* Copyright (c) 2010 - 2017, Nordic Semiconductor ASA
+ *
+ * All rights reserved.
+ *
+ * Use in source and binary forms, redistribution in binary form only, with
+ * or without modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions in binary form, except as embedded into a Nordic
+ *    Semiconductor ASA integrated circuit in a product or a software update for
+ *    such product, must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other
+ *    materials provided with the distribution.
+ *
+ * 2. Neither the name of Nordic Semiconductor ASA nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * 3. This software, with or without modification, must only be used with a Nordic
+ *    Semiconductor ASA integrated circuit.
+ *
+ * 4. Any software provided in binary form under this license must not be reverse
+ *    engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY NORDIC SEMICONDUCTOR ASA "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NORDIC SEMICONDUCTOR ASA OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+ * TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+'use strict';
+
+const { grabAdapter, releaseAdapter, setupAdapter, outcome } = require('./setup');
+const common = require('./common');
+
+const debug = require('debug')('ble-driver:test:metrics');
+
+const CENTRAL_DEVICE_ADDRESS = 'FF:11:22:33:AA:CF';
+const CENTRAL_DEVICE_ADDRESS_TYPE = 'BLE_GAP_ADDR_TYPE_RANDOM_STATIC';
+
+const PERIPHERAL_DEVICE_ADDRESS = 'FF:11:22:33:AA:CE';
+const PERIPHERAL_DEVICE_ADDRESS_TYPE = 'BLE_GAP_ADDR_TYPE_RANDOM_STATIC';
+
+const NUMBER_OF_CALLS = 5;
+const SCAN_DURATION_WAIT_TIME = 3000;
+
+const serialNumberA = process.env.DEVICE_A_SERIAL_NUMBER;
+const serialNumberB = process.env.DEVICE_B_SERIAL_NUMBER;
+
+if (!serialNumberA) {
+    console.log('Missing env DEVICE_A_SERIAL_NUMBER=<SN e.g. from nrf-device-lister>');
+    process.exit(1);
+}
+
+if (!serialNumberB) {
+    console.log('Missing env DEVICE_B_SERIAL_NUMBER=<SN e.g. from nrf-device-lister>');
+    process.exit(1);
+}
+
+// Parse the Prometheus text format into { family: [{ labels, value }] }
+function parseMetrics(text) {
+    const families = {};
+
+    text.split('\n')
+        .filter(line => line.length > 0 && !line.startsWith('#'))
+        .forEach(line => {
+            const match = /^(\w+)\{(.*)\} (\d+)$/.exec(line);
+            expect(match).not.toBeNull();
+
+            const labels = {};
+            match[2].replace(/(\w+)="((?:[^"\\]|\\.)*)"/g, (all, name, value) => {
+                labels[name] = value;
+            });
+
+            families[match[1]] = families[match[1]] || [];
+            families[match[1]].push({ labels, value: Number(match[3]) });
+        });
+
+    return families;
+}
+
+function sample(families, family, labels) {
+    const samples = (families[family] || []).filter(candidate =>
+        Object.keys(labels).every(name => candidate.labels[name] === labels[name]));
+
+    expect(samples.length).toBeLessThanOrEqual(1);
+    return samples.length > 0 ? samples[0].value : 0;
+}
+
+function setNames(adapter, count) {
+    let names = Promise.resolve();
+
+    for (let i = 0; i < count; i += 1) {
+        names = names.then(() => new Promise((resolve, reject) => {
+            adapter.setName(`central${i}`, err => (err ? reject(err) : resolve()));
+        }));
+    }
+
+    return names;
+}
+
+describe('the API', () => {
+    let adapter;
+    let peripheralAdapter;
+
+    beforeAll(async () => {
+        // Errors here will not stop the tests from running.
+        // Issue filed regarding this: https://github.com/facebook/jest/issues/2713
+        adapter = await grabAdapter(serialNumberA);
+        peripheralAdapter = await grabAdapter(serialNumberB);
+
+        await Promise.all([
+            setupAdapter(adapter, '#CENTRAL', 'central', CENTRAL_DEVICE_ADDRESS, CENTRAL_DEVICE_ADDRESS_TYPE),
+            setupAdapter(peripheralAdapter, '#PERIPH', 'periph', PERIPHERAL_DEVICE_ADDRESS, PERIPHERAL_DEVICE_ADDRESS_TYPE)]);
+
+        await common.startAdvertising(peripheralAdapter);
+    });
+
+    afterAll(async () => {
+        await Promise.all([
+            releaseAdapter(adapter.state.serialNumber),
+            releaseAdapter(peripheralAdapter.state.serialNumber)]);
+    });
+
+    it('shall count commands and events', async () => {
+        const before = parseMetrics(adapter.getMetrics());
+        const commandsBefore = sample(before, 'pc_ble_driver_commands_total', { command: 'gapSetDeviceName' });
+        const reportsBefore = sample(before, 'pc_ble_driver_events_total', { event: 'BLE_GAP_EVT_ADV_REPORT' });
+
+        await setNames(adapter, NUMBER_OF_CALLS);
+
+        const advertisingReport = new Promise(resolve => {
+            adapter.once('deviceDiscovered', device => {
+                debug(`Discovered ${device.address}`);
+                resolve();
+            });
+        });
+
+        await new Promise((resolve, reject) => {
+            adapter.startScan({
+                active: true,
+                interval: 100,
+                window: 50,
+                timeout: 2,
+            }, err => (err ? reject(err) : resolve()));
+        });
+
+        await outcome([advertisingReport], SCAN_DURATION_WAIT_TIME);
+
+        await new Promise((resolve, reject) => {
+            adapter.stopScan(err => (err ? reject(err) : resolve()));
+        });
+
+        const metrics = adapter.getMetrics();
+        debug(metrics);
+
+        const after = parseMetrics(metrics);
+
+        expect(sample(after, 'pc_ble_driver_commands_total', { command: 'gapSetDeviceName' }))
+            .toBe(commandsBefore + NUMBER_OF_CALLS);
+        expect(sample(after, 'pc_ble_driver_command_errors_total', { command: 'gapSetDeviceName' })).toBe(0);
+        expect(sample(after, 'pc_ble_driver_events_total', { event: 'BLE_GAP_EVT_ADV_REPORT' }))
+            .toBeGreaterThan(reportsBefore);
+    });
+
+    it('shall report the queues to JavaScript', () => {
+        const metrics = parseMetrics(adapter.getMetrics());
+
+        ['event', 'log', 'status'].forEach(queue => {
+            // Nothing is dropped while JavaScript keeps up with the connectivity chip
+            expect(sample(metrics, 'pc_ble_driver_queue_dropped_total', { queue })).toBe(0);
+            expect(sample(metrics, 'pc_ble_driver_queue_depth', { queue }))
+                .toBeLessThanOrEqual(sample(metrics, 'pc_ble_driver_queue_depth_max', { queue }));
+        });
+
+        expect(sample(metrics, 'pc_ble_driver_queue_depth_max', { queue: 'event' })).toBeGreaterThan(0);
+    });
+});
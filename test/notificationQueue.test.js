@@ -0,0 +1,202 @@
+/* Copyright (c) 2010 - 2017, Nordic Semiconductor ASA
+ *
+ * All rights reserved.
+ *
+ * Use in source and binary forms, redistribution in binary form only, with
+ * or without modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions in binary form, except as embedded into a Nordic
+ *    Semiconductor ASA integrated circuit in a product or a software update for
+ *    such product, must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other
+ *    materials provided with the distribution.
+ *
+ * 2. Neither the name of Nordic Semiconductor ASA nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * 3. This software, with or without modification, must only be used with a Nordic
+ *    Semiconductor ASA integrated circuit.
+ *
+ * 4. Any software provided in binary form under this license must not be reverse
+ *    engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY NORDIC SEMICONDUCTOR ASA "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NORDIC SEMICONDUCTOR ASA OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+ * TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+'use strict';
+
+const { grabAdapter, releaseAdapter, setupAdapter, outcome } = require('./setup');
+const common = require('./common');
+
+const api = require('../index');
+const debug = require('debug')('ble-driver:test:notificationQueue');
+
+const serviceFactory = new api.ServiceFactory();
+
+const PERIPHERAL_DEVICE_ADDRESS = 'FF:11:22:33:AA:CE';
+const PERIPHERAL_DEVICE_ADDRESS_TYPE = 'BLE_GAP_ADDR_TYPE_RANDOM_STATIC';
+
+const CENTRAL_DEVICE_ADDRESS = 'FF:11:22:33:AA:CF';
+const CENTRAL_DEVICE_ADDRESS_TYPE = 'BLE_GAP_ADDR_TYPE_RANDOM_STATIC';
+
+const SERVICE_UUID = 'F004F000AAAAAAAAAAAAAAAAAAAAAAAA';
+const CHAR_NOTIFY_UUID = 'F004F001AAAAAAAAAAAAAAAAAAAAAAAA';
+
+// More than the queue of a device takes before queueNotification asks the caller to wait
+const NOTIFICATION_COUNT = 100;
+
+const serialNumberA = process.env.DEVICE_A_SERIAL_NUMBER;
+if (!serialNumberA) {
+    console.log('Missing env DEVICE_A_SERIAL_NUMBER=<SN e.g. from nrf-device-lister>');
+    process.exit(1);
+}
+
+const serialNumberB = process.env.DEVICE_B_SERIAL_NUMBER;
+if (!serialNumberB) {
+    console.log('Missing env DEVICE_B_SERIAL_NUMBER=<SN e.g. from nrf-device-lister>');
+    process.exit(1);
+}
+
+function servicesInit(adapter) {
+    const service = serviceFactory.createService(SERVICE_UUID);
+    const notifyCharacteristic = common.addCharacteristicWithCccd(serviceFactory, service, CHAR_NOTIFY_UUID, { notify: true });
+
+    return new Promise((resolve, reject) => {
+        adapter.setServices([service], err => {
+            if (err) {
+                return reject(new Error(`Error initializing services: ${JSON.stringify(err, null, 1)}'.`));
+            }
+
+            return resolve({ notify: notifyCharacteristic.instanceId });
+        });
+    });
+}
+
+// Notifications that have waited in the native queue of a connection, from the metrics
+function queuedNotificationCount(adapter, connectionHandle) {
+    const sample = new RegExp(`^pc_ble_driver_gatts_queue_wait_microseconds_count\\{.*conn_handle="${connectionHandle}".*\\} (\\d+)$`, 'm');
+    const match = sample.exec(adapter.getMetrics());
+    return match ? Number(match[1]) : 0;
+}
+
+// Queue notifications as fast as the queue takes them, waiting for the drain event when it is full
+function queueNotifications(adapter, device, characteristicId, count) {
+    return new Promise((resolve, reject) => {
+        let i = 0;
+        let accepted = 0;
+        let drains = 0;
+
+        const queueMore = () => {
+            while (i < count) {
+                const more = adapter.queueNotification(device.instanceId, characteristicId, [i], err => {
+                    if (err) {
+                        reject(err);
+                        return;
+                    }
+
+                    accepted += 1;
+                    if (accepted === count) {
+                        resolve(drains);
+                    }
+                });
+
+                i += 1;
+
+                if (!more && i < count) {
+                    adapter.once('notificationQueueDrain', drainedDevice => {
+                        expect(drainedDevice.instanceId).toBe(device.instanceId);
+                        drains += 1;
+                        queueMore();
+                    });
+                    return;
+                }
+            }
+        };
+
+        queueMore();
+    });
+}
+
+describe('the API', () => {
+    let centralAdapter;
+    let peripheralAdapter;
+    let centralDevice;
+    let peripheralDevice;
+    let localCharacteristics;
+    let remoteCharacteristics;
+
+    beforeAll(async () => {
+        // Errors here will not stop the tests from running.
+        // Issue filed regarding this: https://github.com/facebook/jest/issues/2713
+
+        centralAdapter = await grabAdapter(serialNumberA);
+        peripheralAdapter = await grabAdapter(serialNumberB);
+
+        await Promise.all([
+            setupAdapter(centralAdapter, '#CENTRAL', 'central', CENTRAL_DEVICE_ADDRESS, CENTRAL_DEVICE_ADDRESS_TYPE),
+            setupAdapter(peripheralAdapter, '#PERIPH', 'peripheral', PERIPHERAL_DEVICE_ADDRESS, PERIPHERAL_DEVICE_ADDRESS_TYPE)]);
+
+        localCharacteristics = await servicesInit(peripheralAdapter);
+
+        const [connection] = await outcome([
+            common.connectAndDiscover(centralAdapter, peripheralAdapter, {
+                address: PERIPHERAL_DEVICE_ADDRESS,
+                type: PERIPHERAL_DEVICE_ADDRESS_TYPE,
+            }),
+        ], 10000);
+
+        ({ centralDevice, peripheralDevice } = connection);
+        remoteCharacteristics = common.findCharacteristics(connection.attributes, { notify: CHAR_NOTIFY_UUID });
+    });
+
+    afterAll(async () => {
+        await common.disconnect(centralAdapter, peripheralAdapter, peripheralDevice);
+
+        debug('releasing adapters');
+        await Promise.all([
+            releaseAdapter(centralAdapter.state.serialNumber),
+            releaseAdapter(peripheralAdapter.state.serialNumber)]);
+    });
+
+    it('shall fail notifications to a device that has not enabled them', async () => {
+        await expect(new Promise((resolve, reject) => {
+            peripheralAdapter.queueNotification(centralDevice.instanceId, localCharacteristics.notify, [0], err => (
+                err ? reject(err) : resolve()
+            ));
+        })).rejects.toBeDefined();
+    });
+
+    it('shall send queued notifications in order', async () => {
+        await outcome([common.subscribe(centralAdapter, peripheralAdapter, remoteCharacteristics.notify, false)]);
+
+        const queuedBefore = queuedNotificationCount(peripheralAdapter, centralDevice.connectionHandle);
+
+        const [drains, values] = await outcome([
+            queueNotifications(peripheralAdapter, centralDevice, localCharacteristics.notify, NOTIFICATION_COUNT),
+            common.receiveValues(centralAdapter, remoteCharacteristics.notify, NOTIFICATION_COUNT),
+        ], 10000);
+
+        const expected = [];
+        for (let i = 0; i < NOTIFICATION_COUNT; i += 1) {
+            expected.push([i]);
+        }
+
+        expect(values).toEqual(expected);
+
+        // The queue asked for back-pressure, and resumed by itself as packets were sent
+        expect(drains).toBeGreaterThan(0);
+        expect(queuedNotificationCount(peripheralAdapter, centralDevice.connectionHandle))
+            .toBe(queuedBefore + NOTIFICATION_COUNT);
+    });
+});
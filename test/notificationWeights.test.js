@@ -0,0 +1,114 @@
+/* Copyright (c) 2010 - 2017, Nordic Semiconductor ASA
+ *
+ * All rights reserved.
+ *
+ * Use in source and binary forms, redistribution in binary form only, with
+ * or without modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions in binary form, except as embedded into a Nordic
+ *    Semiconductor ASA integrated circuit in a product or a software update for
+ *    such product, must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other
+ *    materials provided with the distribution.
+ *
+ * 2. Neither the name of Nordic Semiconductor ASA nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * 3. This software, with or without modification, must only be used with a Nordic
+ *    Semiconductor ASA integrated circuit.
+ *
+ * 4. Any software provided in binary form under this license must not be reverse
+ *    engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY NORDIC SEMICONDUCTOR ASA "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NORDIC SEMICONDUCTOR ASA OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+ * TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+'use strict';
+
+// Needs no devices, the scheduler is run with a SoftDevice that always has room
+const drivers = {
+    v2: require('bindings')('pc-ble-driver-js-sd_api_v2'),
+    v5: require('bindings')('pc-ble-driver-js-sd_api_v5'),
+};
+
+// Payload of a notification with the default ATT MTU, the quantum of the scheduler
+const QUANTUM = 20;
+
+function notifications(count, length) {
+    return new Array(count).fill(length);
+}
+
+// Bytes each connection issued in the first count notifications
+function bytesIssued(issued, connections, count) {
+    const bytes = connections.map(() => 0);
+    const next = connections.map(() => 0);
+
+    issued.slice(0, count).forEach(connection => {
+        bytes[connection] += connections[connection].lengths[next[connection]];
+        next[connection] += 1;
+    });
+
+    return bytes;
+}
+
+Object.keys(drivers).forEach(version => {
+    const driver = drivers[version];
+
+    describe(`the ${version} notification scheduler`, () => {
+        it('shall issue all notifications', () => {
+            const connections = [
+                { weight: 1, lengths: notifications(7, QUANTUM) },
+                { weight: 2, lengths: notifications(3, 3 * QUANTUM) },
+                { weight: 5, lengths: [] },
+            ];
+
+            const issued = driver.simulateNotificationSchedule(connections);
+
+            expect(issued.filter(connection => connection === 0).length).toBe(7);
+            expect(issued.filter(connection => connection === 1).length).toBe(3);
+            expect(issued.filter(connection => connection === 2).length).toBe(0);
+        });
+
+        it('shall share the link between connections by their weights', () => {
+            const connections = [
+                { weight: 1, lengths: notifications(20, QUANTUM) },
+                { weight: 3, lengths: notifications(60, QUANTUM) },
+            ];
+
+            const issued = driver.simulateNotificationSchedule(connections);
+            const [light, heavy] = bytesIssued(issued, connections, 40);
+
+            // Ten rounds while both connections have notifications waiting
+            expect(light).toBe(10 * QUANTUM);
+            expect(heavy).toBe(30 * QUANTUM);
+        });
+
+        it('shall share bytes, not notifications', () => {
+            const connections = [
+                { weight: 1, lengths: notifications(5, 3 * QUANTUM) },
+                { weight: 1, lengths: notifications(15, QUANTUM) },
+            ];
+
+            const issued = driver.simulateNotificationSchedule(connections);
+
+            // While both have notifications waiting, neither is ahead by more than a long notification
+            const bothWaiting = Math.min(issued.lastIndexOf(0), issued.lastIndexOf(1));
+
+            for (let count = 1; count <= bothWaiting; count += 1) {
+                const [long, short] = bytesIssued(issued, connections, count);
+                expect(Math.abs(long - short)).toBeLessThanOrEqual(3 * QUANTUM);
+            }
+        });
+    });
+});
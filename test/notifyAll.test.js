@@ -0,0 +1,192 @@
+/* Copyright (c) 2010 - 2017, Nordic Semiconductor ASA
+ *
+ * All rights reserved.
+ *
+ * Use in source and binary forms, redistribution in binary form only, with
+ * or without modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions in binary form, except as embedded into a Nordic
+ *    Semiconductor ASA integrated circuit in a product or a software update for
+ *    such product, must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other
+ *    materials provided with the distribution.
+ *
+ * 2. Neither the name of Nordic Semiconductor ASA nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * 3. This software, with or without modification, must only be used with a Nordic
+ *    Semiconductor ASA integrated circuit.
+ *
+ * 4. Any software provided in binary form under this license must not be reverse
+ *    engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY NORDIC SEMICONDUCTOR ASA "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NORDIC SEMICONDUCTOR ASA OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+ * TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+'use strict';
+
+const { grabAdapter, releaseAdapter, setupAdapter, outcome } = require('./setup');
+const common = require('./common');
+
+const api = require('../index');
+const debug = require('debug')('ble-driver:test:notifyAll');
+
+const serviceFactory = new api.ServiceFactory();
+
+const PERIPHERAL_DEVICE_ADDRESS = 'FF:11:22:33:AA:CE';
+const PERIPHERAL_DEVICE_ADDRESS_TYPE = 'BLE_GAP_ADDR_TYPE_RANDOM_STATIC';
+
+const CENTRAL_DEVICE_ADDRESS = 'FF:11:22:33:AA:CF';
+const CENTRAL_DEVICE_ADDRESS_TYPE = 'BLE_GAP_ADDR_TYPE_RANDOM_STATIC';
+
+const SERVICE_UUID = 'F005F000AAAAAAAAAAAAAAAAAAAAAAAA';
+const CHAR_NOTIFY_UUID = 'F005F001AAAAAAAAAAAAAAAAAAAAAAAA';
+
+const VALUE_LENGTH = 20;
+
+// Time to wait for a notification that shall not arrive
+const NO_NOTIFICATION_WAIT_TIME = 1000;
+
+const serialNumberA = process.env.DEVICE_A_SERIAL_NUMBER;
+if (!serialNumberA) {
+    console.log('Missing env DEVICE_A_SERIAL_NUMBER=<SN e.g. from nrf-device-lister>');
+    process.exit(1);
+}
+
+const serialNumberB = process.env.DEVICE_B_SERIAL_NUMBER;
+if (!serialNumberB) {
+    console.log('Missing env DEVICE_B_SERIAL_NUMBER=<SN e.g. from nrf-device-lister>');
+    process.exit(1);
+}
+
+function servicesInit(adapter) {
+    const service = serviceFactory.createService(SERVICE_UUID);
+    const notifyCharacteristic = common.addCharacteristicWithCccd(serviceFactory, service, CHAR_NOTIFY_UUID, { notify: true }, {
+        maxLength: VALUE_LENGTH,
+        variableLength: true,
+    });
+
+    return new Promise((resolve, reject) => {
+        adapter.setServices([service], err => {
+            if (err) {
+                return reject(new Error(`Error initializing services: ${JSON.stringify(err, null, 1)}'.`));
+            }
+
+            return resolve({ notify: notifyCharacteristic.instanceId });
+        });
+    });
+}
+
+function notifyAll(adapter, characteristicId, value) {
+    return new Promise((resolve, reject) => {
+        adapter.notifyAll(characteristicId, value, (err, errors) => (
+            err ? reject(err) : resolve(errors)
+        ));
+    });
+}
+
+describe('the API', () => {
+    let centralAdapter;
+    let peripheralAdapter;
+    let centralDevice;
+    let peripheralDevice;
+    let localCharacteristics;
+    let remoteCharacteristics;
+
+    const value = [];
+    for (let i = 0; i < VALUE_LENGTH; i += 1) {
+        value.push(i);
+    }
+
+    beforeAll(async () => {
+        // Errors here will not stop the tests from running.
+        // Issue filed regarding this: https://github.com/facebook/jest/issues/2713
+
+        centralAdapter = await grabAdapter(serialNumberA);
+        peripheralAdapter = await grabAdapter(serialNumberB);
+
+        await Promise.all([
+            setupAdapter(centralAdapter, '#CENTRAL', 'central', CENTRAL_DEVICE_ADDRESS, CENTRAL_DEVICE_ADDRESS_TYPE),
+            setupAdapter(peripheralAdapter, '#PERIPH', 'peripheral', PERIPHERAL_DEVICE_ADDRESS, PERIPHERAL_DEVICE_ADDRESS_TYPE)]);
+
+        localCharacteristics = await servicesInit(peripheralAdapter);
+
+        const [connection] = await outcome([
+            common.connectAndDiscover(centralAdapter, peripheralAdapter, {
+                address: PERIPHERAL_DEVICE_ADDRESS,
+                type: PERIPHERAL_DEVICE_ADDRESS_TYPE,
+            }),
+        ], 10000);
+
+        ({ centralDevice, peripheralDevice } = connection);
+        remoteCharacteristics = common.findCharacteristics(connection.attributes, { notify: CHAR_NOTIFY_UUID });
+    });
+
+    afterAll(async () => {
+        await common.disconnect(centralAdapter, peripheralAdapter, peripheralDevice);
+
+        debug('releasing adapters');
+        await Promise.all([
+            releaseAdapter(centralAdapter.state.serialNumber),
+            releaseAdapter(peripheralAdapter.state.serialNumber)]);
+    });
+
+    it('shall notify no device before notifications are enabled', async () => {
+        const [errors] = await outcome([notifyAll(peripheralAdapter, localCharacteristics.notify, value)]);
+        expect(errors).toEqual({});
+    });
+
+    it('shall notify every subscribed device', async () => {
+        await outcome([common.subscribe(centralAdapter, peripheralAdapter, remoteCharacteristics.notify, false)]);
+
+        const [errors, values] = await outcome([
+            notifyAll(peripheralAdapter, localCharacteristics.notify, value),
+            common.receiveValues(centralAdapter, remoteCharacteristics.notify, 1),
+        ]);
+
+        expect(Object.keys(errors)).toEqual([centralDevice.instanceId]);
+        expect(errors[centralDevice.instanceId]).toBeUndefined();
+        expect(values).toEqual([value]);
+    });
+
+    it('shall stop notifying a device that has disabled notifications', async () => {
+        await outcome([
+            new Promise((resolve, reject) => {
+                centralAdapter.stopCharacteristicsNotifications(remoteCharacteristics.notify, err => (
+                    err ? reject(err) : resolve()
+                ));
+            }),
+
+            // The binding tracks the CCCD write of the device
+            new Promise(resolve => {
+                peripheralAdapter.once('descriptorValueChanged', () => resolve());
+            }),
+        ]);
+
+        let received = false;
+        const onValueChanged = () => {
+            received = true;
+        };
+
+        centralAdapter.on('characteristicValueChanged', onValueChanged);
+
+        const [errors] = await outcome([notifyAll(peripheralAdapter, localCharacteristics.notify, value)]);
+        await new Promise(resolve => setTimeout(resolve, NO_NOTIFICATION_WAIT_TIME));
+
+        centralAdapter.removeListener('characteristicValueChanged', onValueChanged);
+
+        expect(errors).toEqual({});
+        expect(received).toBe(false);
+    });
+});
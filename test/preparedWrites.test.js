@@ -0,0 +1,248 @@
+/* Copyright (c) 2010 - 2017, Nordic Semiconductor ASA
+ *
+ * All rights reserved.
+ *
+ * Use in source and binary forms, redistribution in binary form only, with
+ * or without modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions in binary form, except as embedded into a Nordic
+ *    Semiconductor ASA integrated circuit in a product or a software update for
+ *    such product, must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other
+ *    materials provided with the distribution.
+ *
+ * 2. Neither the name of Nordic Semiconductor ASA nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * 3. This software, with or without modification, must only be used with a Nordic
+ *    Semiconductor ASA integrated circuit.
+ *
+ * 4. Any software provided in binary form under this license must not be reverse
+ *    engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY NORDIC SEMICONDUCTOR ASA "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NORDIC SEMICONDUCTOR ASA OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+ * TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+'use strict';
+
+const { grabAdapter, releaseAdapter, setupAdapter, outcome } = require('./setup');
+const common = require('./common');
+
+const api = require('../index');
+const debug = require('debug')('ble-driver:test:preparedWrites');
+
+const serviceFactory = new api.ServiceFactory();
+
+const PERIPHERAL_DEVICE_ADDRESS = 'FF:11:22:33:AA:CE';
+const PERIPHERAL_DEVICE_ADDRESS_TYPE = 'BLE_GAP_ADDR_TYPE_RANDOM_STATIC';
+
+const CENTRAL_DEVICE_ADDRESS = 'FF:11:22:33:AA:CF';
+const CENTRAL_DEVICE_ADDRESS_TYPE = 'BLE_GAP_ADDR_TYPE_RANDOM_STATIC';
+
+const SERVICE_UUID = 'F008F000AAAAAAAAAAAAAAAAAAAAAAAA';
+const CHAR_LONG_UUID = 'F008F001AAAAAAAAAAAAAAAAAAAAAAAA';
+const CHAR_SHORT_UUID = 'F008F002AAAAAAAAAAAAAAAAAAAAAAAA';
+
+// Both are longer than one write request, so they are written with prepared writes
+const LONG_MAX_LENGTH = 100;
+const SHORT_MAX_LENGTH = 30;
+
+const INITIAL_VALUE = [1, 2, 3];
+
+// Time to wait for value changes that shall not be reported
+const NO_CHANGE_WAIT_TIME = 1000;
+
+const serialNumberA = process.env.DEVICE_A_SERIAL_NUMBER;
+if (!serialNumberA) {
+    console.log('Missing env DEVICE_A_SERIAL_NUMBER=<SN e.g. from nrf-device-lister>');
+    process.exit(1);
+}
+
+const serialNumberB = process.env.DEVICE_B_SERIAL_NUMBER;
+if (!serialNumberB) {
+    console.log('Missing env DEVICE_B_SERIAL_NUMBER=<SN e.g. from nrf-device-lister>');
+    process.exit(1);
+}
+
+function servicesInit(adapter) {
+    const service = serviceFactory.createService(SERVICE_UUID);
+
+    // With write authorization the binding queues and executes the prepared writes
+    const authorizedCharacteristic = (uuid, maxLength) => serviceFactory.createCharacteristic(
+        service,
+        uuid,
+        INITIAL_VALUE,
+        {
+            broadcast: false,
+            read: true,
+            write: true,
+            writeWoResp: false,
+            reliableWrite: false,
+            notify: false,
+            indicate: false,
+        },
+        {
+            maxLength,
+            variableLength: true,
+            readPerm: ['open'],
+            writePerm: ['open'],
+            writeAuth: true,
+        });
+
+    const longCharacteristic = authorizedCharacteristic(CHAR_LONG_UUID, LONG_MAX_LENGTH);
+    const shortCharacteristic = authorizedCharacteristic(CHAR_SHORT_UUID, SHORT_MAX_LENGTH);
+
+    return new Promise((resolve, reject) => {
+        adapter.setServices([service], err => {
+            if (err) {
+                return reject(new Error(`Error initializing services: ${JSON.stringify(err, null, 1)}'.`));
+            }
+
+            return resolve({
+                long: longCharacteristic.instanceId,
+                short: shortCharacteristic.instanceId,
+            });
+        });
+    });
+}
+
+function sequence(length, start = 0) {
+    const value = [];
+    for (let i = 0; i < length; i += 1) {
+        value.push((start + i) & 0xFF);
+    }
+
+    return value;
+}
+
+// Collects the value changes reported by the peripheral
+function recordValueChanges(adapter) {
+    const changes = [];
+    const onValueChanged = characteristic => {
+        changes.push({ instanceId: characteristic.instanceId, value: Array.from(characteristic.value) });
+    };
+
+    adapter.on('characteristicValueChanged', onValueChanged);
+
+    return {
+        changes,
+        stop: () => adapter.removeListener('characteristicValueChanged', onValueChanged),
+    };
+}
+
+describe('the API', () => {
+    let centralAdapter;
+    let peripheralAdapter;
+    let peripheralDevice;
+    let localCharacteristics;
+    let remoteCharacteristics;
+
+    beforeAll(async () => {
+        // Errors here will not stop the tests from running.
+        // Issue filed regarding this: https://github.com/facebook/jest/issues/2713
+
+        centralAdapter = await grabAdapter(serialNumberA);
+        peripheralAdapter = await grabAdapter(serialNumberB);
+
+        await Promise.all([
+            setupAdapter(centralAdapter, '#CENTRAL', 'central', CENTRAL_DEVICE_ADDRESS, CENTRAL_DEVICE_ADDRESS_TYPE),
+            setupAdapter(peripheralAdapter, '#PERIPH', 'peripheral', PERIPHERAL_DEVICE_ADDRESS, PERIPHERAL_DEVICE_ADDRESS_TYPE)]);
+
+        localCharacteristics = await servicesInit(peripheralAdapter);
+
+        const [connection] = await outcome([
+            common.connectAndDiscover(centralAdapter, peripheralAdapter, {
+                address: PERIPHERAL_DEVICE_ADDRESS,
+                type: PERIPHERAL_DEVICE_ADDRESS_TYPE,
+            }),
+        ], 10000);
+
+        ({ peripheralDevice } = connection);
+        remoteCharacteristics = common.findCharacteristics(connection.attributes, {
+            long: CHAR_LONG_UUID,
+            short: CHAR_SHORT_UUID,
+        });
+    });
+
+    afterAll(async () => {
+        await common.disconnect(centralAdapter, peripheralAdapter, peripheralDevice);
+
+        debug('releasing adapters');
+        await Promise.all([
+            releaseAdapter(centralAdapter.state.serialNumber),
+            releaseAdapter(peripheralAdapter.state.serialNumber)]);
+    });
+
+    it('shall execute prepared writes as one value change', async () => {
+        const value = sequence(LONG_MAX_LENGTH);
+        const recorder = recordValueChanges(peripheralAdapter);
+
+        await outcome([
+            common.writeValue(centralAdapter, remoteCharacteristics.long, value, true),
+
+            new Promise(resolve => {
+                peripheralAdapter.once('characteristicValueChanged', () => resolve());
+            }),
+        ]);
+
+        await new Promise(resolve => setTimeout(resolve, NO_CHANGE_WAIT_TIME));
+        recorder.stop();
+
+        // The writes of the queue are coalesced into one
+        expect(recorder.changes).toEqual([{ instanceId: localCharacteristics.long, value }]);
+
+        const [readBytes] = await outcome([common.readValue(centralAdapter, remoteCharacteristics.long)]);
+        expect(readBytes).toEqual(value);
+    });
+
+    it('shall reject prepared writes beyond the maximum length without applying any of them', async () => {
+        // Each prepared write fits, together they are longer than the attribute
+        const recorder = recordValueChanges(peripheralAdapter);
+
+        await expect(common.writeValue(centralAdapter, remoteCharacteristics.short, sequence(2 * SHORT_MAX_LENGTH), true))
+            .rejects.toBeDefined();
+
+        await new Promise(resolve => setTimeout(resolve, NO_CHANGE_WAIT_TIME));
+        recorder.stop();
+
+        expect(recorder.changes).toEqual([]);
+
+        const [readBytes] = await outcome([common.readValue(centralAdapter, remoteCharacteristics.short)]);
+        expect(readBytes).toEqual(INITIAL_VALUE);
+    });
+
+    it('shall start a new queue after a rejected execution', async () => {
+        const value = sequence(SHORT_MAX_LENGTH, 0x80);
+
+        await outcome([common.writeValue(centralAdapter, remoteCharacteristics.short, value, true)]);
+
+        const [readBytes] = await outcome([common.readValue(centralAdapter, remoteCharacteristics.short)]);
+        expect(readBytes).toEqual(value);
+    });
+
+    it('shall keep the values of other attributes when a queue is rejected', async () => {
+        const [longBefore] = await outcome([common.readValue(centralAdapter, remoteCharacteristics.long)]);
+
+        await expect(common.writeValue(centralAdapter, remoteCharacteristics.long, sequence(LONG_MAX_LENGTH + 1), true))
+            .rejects.toBeDefined();
+
+        const [longAfter, shortAfter] = await outcome([
+            common.readValue(centralAdapter, remoteCharacteristics.long),
+            common.readValue(centralAdapter, remoteCharacteristics.short),
+        ]);
+
+        expect(longAfter).toEqual(longBefore);
+        expect(shortAfter).toEqual(sequence(SHORT_MAX_LENGTH, 0x80));
+    });
+});
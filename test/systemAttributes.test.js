@@ -0,0 +1,250 @@
+/* Copyright (c) 2010 - 2017, Nordic Semiconductor ASA
+ *
+ * All rights reserved.
+ *
+ * Use in source and binary forms, redistribution in binary form only, with
+ * or without modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions in binary form, except as embedded into a Nordic
+ *    Semiconductor ASA integrated circuit in a product or a software update for
+ *    such product, must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other
+ *    materials provided with the distribution.
+ *
+ * 2. Neither the name of Nordic Semiconductor ASA nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * 3. This software, with or without modification, must only be used with a Nordic
+ *    Semiconductor ASA integrated circuit.
+ *
+ * 4. Any software provided in binary form under this license must not be reverse
+ *    engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY NORDIC SEMICONDUCTOR ASA "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NORDIC SEMICONDUCTOR ASA OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+ * TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+'use strict';
+
+const fs = require('fs');
+const os = require('os');
+const path = require('path');
+
+const { grabAdapter, releaseAdapter, setupAdapter, outcome } = require('./setup');
+const common = require('./common');
+
+const api = require('../index');
+const debug = require('debug')('ble-driver:test:systemAttributes');
+
+const serviceFactory = new api.ServiceFactory();
+
+const PERIPHERAL_DEVICE_ADDRESS = 'FF:11:22:33:AA:CE';
+const PERIPHERAL_DEVICE_ADDRESS_TYPE = 'BLE_GAP_ADDR_TYPE_RANDOM_STATIC';
+
+const CENTRAL_DEVICE_ADDRESS = 'FF:11:22:33:AA:CF';
+const CENTRAL_DEVICE_ADDRESS_TYPE = 'BLE_GAP_ADDR_TYPE_RANDOM_STATIC';
+
+// File the system attributes of the central are saved in, by its identity address
+const CENTRAL_SYSTEM_ATTRIBUTE_FILE = 'FF112233AACF_1.sysattr';
+
+const SERVICE_UUID = 'F007F000AAAAAAAAAAAAAAAAAAAAAAAA';
+const CHAR_NOTIFY_UUID = 'F007F001AAAAAAAAAAAAAAAAAAAAAAAA';
+
+const VALUE_LENGTH = 20;
+
+// Time for the files to be written in the background
+const FILE_WAIT_TIME = 5000;
+
+const serialNumberA = process.env.DEVICE_A_SERIAL_NUMBER;
+if (!serialNumberA) {
+    console.log('Missing env DEVICE_A_SERIAL_NUMBER=<SN e.g. from nrf-device-lister>');
+    process.exit(1);
+}
+
+const serialNumberB = process.env.DEVICE_B_SERIAL_NUMBER;
+if (!serialNumberB) {
+    console.log('Missing env DEVICE_B_SERIAL_NUMBER=<SN e.g. from nrf-device-lister>');
+    process.exit(1);
+}
+
+function servicesInit(adapter) {
+    const service = serviceFactory.createService(SERVICE_UUID);
+    const notifyCharacteristic = common.addCharacteristicWithCccd(serviceFactory, service, CHAR_NOTIFY_UUID, { notify: true }, {
+        maxLength: VALUE_LENGTH,
+        variableLength: true,
+    });
+
+    return new Promise((resolve, reject) => {
+        adapter.setServices([service], err => {
+            if (err) {
+                return reject(new Error(`Error initializing services: ${JSON.stringify(err, null, 1)}'.`));
+            }
+
+            return resolve({ notify: notifyCharacteristic.instanceId });
+        });
+    });
+}
+
+function bond(centralAdapter, peripheralAdapter, peripheralDevice) {
+    const secParams = adapter => ({
+        bond: true,
+        mitm: false,
+        lesc: false,
+        keypress: false,
+        io_caps: adapter.driver.BLE_GAP_IO_CAPS_NONE,
+        oob: false,
+        min_key_size: 7,
+        max_key_size: 16,
+        kdist_own: { enc: true, id: false, sign: false, link: false },
+        kdist_peer: { enc: true, id: false, sign: false, link: false },
+    });
+
+    return Promise.all([
+        new Promise((resolve, reject) => {
+            peripheralAdapter.once('secParamsRequest', device => {
+                peripheralAdapter.replySecParams(device.instanceId, peripheralAdapter.driver.BLE_GAP_SEC_STATUS_SUCCESS, secParams(peripheralAdapter), null, err => (
+                    err ? reject(err) : resolve()
+                ));
+            });
+        }),
+
+        new Promise((resolve, reject) => {
+            centralAdapter.once('secParamsRequest', device => {
+                centralAdapter.replySecParams(device.instanceId, centralAdapter.driver.BLE_GAP_SEC_STATUS_SUCCESS, null, null, err => (
+                    err ? reject(err) : resolve()
+                ));
+            });
+        }),
+
+        new Promise((resolve, reject) => {
+            peripheralAdapter.once('authStatus', (device, status) => (
+                status.auth_status === 0 && status.bonded ? resolve() : reject(new Error(`Bonding failed: ${JSON.stringify(status)}`))
+            ));
+        }),
+
+        new Promise((resolve, reject) => {
+            centralAdapter.authenticate(peripheralDevice.instanceId, secParams(centralAdapter), err => (
+                err ? reject(err) : resolve()
+            ));
+        }),
+    ]);
+}
+
+function notifyAll(adapter, characteristicId, value) {
+    return new Promise((resolve, reject) => {
+        adapter.notifyAll(characteristicId, value, (err, errors) => (
+            err ? reject(err) : resolve(errors)
+        ));
+    });
+}
+
+async function waitForFile(file) {
+    const start = Date.now();
+
+    while (!fs.existsSync(file)) {
+        if (Date.now() - start > FILE_WAIT_TIME) {
+            throw new Error(`${file} was not written`);
+        }
+
+        await new Promise(resolve => setTimeout(resolve, 100));
+    }
+}
+
+describe('the API', () => {
+    let centralAdapter;
+    let peripheralAdapter;
+    let localCharacteristics;
+    let directory;
+
+    const value = [];
+    for (let i = 0; i < VALUE_LENGTH; i += 1) {
+        value.push(i);
+    }
+
+    const peripheralAddress = {
+        address: PERIPHERAL_DEVICE_ADDRESS,
+        type: PERIPHERAL_DEVICE_ADDRESS_TYPE,
+    };
+
+    beforeAll(async () => {
+        // Errors here will not stop the tests from running.
+        // Issue filed regarding this: https://github.com/facebook/jest/issues/2713
+
+        directory = fs.mkdtempSync(path.join(os.tmpdir(), 'pc-ble-driver-js-sysattr-'));
+
+        centralAdapter = await grabAdapter(serialNumberA);
+        peripheralAdapter = await grabAdapter(serialNumberB);
+
+        await Promise.all([
+            setupAdapter(centralAdapter, '#CENTRAL', 'central', CENTRAL_DEVICE_ADDRESS, CENTRAL_DEVICE_ADDRESS_TYPE),
+            setupAdapter(peripheralAdapter, '#PERIPH', 'peripheral', PERIPHERAL_DEVICE_ADDRESS, PERIPHERAL_DEVICE_ADDRESS_TYPE)]);
+
+        localCharacteristics = await servicesInit(peripheralAdapter);
+        peripheralAdapter.setSystemAttributeDirectory(directory);
+    });
+
+    afterAll(async () => {
+        peripheralAdapter.setSystemAttributeDirectory('');
+
+        debug('releasing adapters');
+        await Promise.all([
+            releaseAdapter(centralAdapter.state.serialNumber),
+            releaseAdapter(peripheralAdapter.state.serialNumber)]);
+
+        fs.readdirSync(directory).forEach(file => fs.unlinkSync(path.join(directory, file)));
+        fs.rmdirSync(directory);
+    });
+
+    it('shall save the system attributes of a bonded central', async () => {
+        const [connection] = await outcome([common.connectAndDiscover(centralAdapter, peripheralAdapter, peripheralAddress)], 10000);
+        const remoteCharacteristics = common.findCharacteristics(connection.attributes, { notify: CHAR_NOTIFY_UUID });
+
+        await outcome([bond(centralAdapter, peripheralAdapter, connection.peripheralDevice)], 10000);
+        await outcome([common.subscribe(centralAdapter, peripheralAdapter, remoteCharacteristics.notify, false)]);
+        await outcome([common.disconnect(centralAdapter, peripheralAdapter, connection.peripheralDevice)]);
+
+        const file = path.join(directory, CENTRAL_SYSTEM_ATTRIBUTE_FILE);
+        await waitForFile(file);
+
+        expect(fs.statSync(file).size).toBeGreaterThan(0);
+
+        if (process.platform !== 'win32') {
+            // Only for the current user, the files have the CCCDs of the bonded peers
+            expect(fs.statSync(file).mode & 0o077).toBe(0);
+        }
+
+        // Written next to the path and renamed into place
+        expect(fs.readdirSync(directory).filter(name => name.endsWith('.tmp'))).toEqual([]);
+    });
+
+    it('shall restore the system attributes saved in the directory', async () => {
+        // Read again from the files written before
+        peripheralAdapter.setSystemAttributeDirectory('');
+        peripheralAdapter.setSystemAttributeDirectory(directory);
+
+        const [connection] = await outcome([common.connectAndDiscover(centralAdapter, peripheralAdapter, peripheralAddress)], 10000);
+        const remoteCharacteristics = common.findCharacteristics(connection.attributes, { notify: CHAR_NOTIFY_UUID });
+
+        // Notifications are enabled without the central writing the CCCD again
+        const [errors, values] = await outcome([
+            notifyAll(peripheralAdapter, localCharacteristics.notify, value),
+            common.receiveValues(centralAdapter, remoteCharacteristics.notify, 1),
+        ]);
+
+        expect(Object.keys(errors)).toEqual([connection.centralDevice.instanceId]);
+        expect(errors[connection.centralDevice.instanceId]).toBeUndefined();
+        expect(values).toEqual([value]);
+
+        await outcome([common.disconnect(centralAdapter, peripheralAdapter, connection.peripheralDevice)]);
+    });
+});
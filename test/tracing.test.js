@@ -0,0 +1,189 @@
+/* Copyright (c) 2010 - 2017, Nordic Semiconductor ASA
+ *
+ * All rights reserved.
+ *
+ * Use in source and binary forms, redistribution in binary form only, with
+ * or without modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions in binary form, except as embedded into a Nordic
+ *    Semiconductor ASA integrated circuit in a product or a software update for
+ *    such product, must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other
+ *    materials provided with the distribution.
+ *
+ * 2. Neither the name of Nordic Semiconductor ASA nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * 3. This software, with or without modification, must only be used with a Nordic
+ *    Semiconductor ASA integrated circuit.
+ *
+ * 4. Any software provided in binary form under this license must not be reverse
+ *    engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY NORDIC SEMICONDUCTOR ASA "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NORDIC SEMICONDUCTOR ASA OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+ * TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+'use strict';
+
+const fs = require('fs');
+const os = require('os');
+const path = require('path');
+
+const { grabAdapter, releaseAdapter, setupAdapter, outcome } = require('./setup');
+const common = require('./common');
+
+const debug = require('debug')('ble-driver:test:tracing');
+
+const CENTRAL_DEVICE_ADDRESS = 'FF:11:22:33:AA:CF';
+const CENTRAL_DEVICE_ADDRESS_TYPE = 'BLE_GAP_ADDR_TYPE_RANDOM_STATIC';
+
+const PERIPHERAL_DEVICE_ADDRESS = 'FF:11:22:33:AA:CE';
+const PERIPHERAL_DEVICE_ADDRESS_TYPE = 'BLE_GAP_ADDR_TYPE_RANDOM_STATIC';
+
+const NUMBER_OF_CALLS = 3;
+const SCAN_DURATION_WAIT_TIME = 3000;
+
+const serialNumberA = process.env.DEVICE_A_SERIAL_NUMBER;
+const serialNumberB = process.env.DEVICE_B_SERIAL_NUMBER;
+
+if (!serialNumberA) {
+    console.log('Missing env DEVICE_A_SERIAL_NUMBER=<SN e.g. from nrf-device-lister>');
+    process.exit(1);
+}
+
+if (!serialNumberB) {
+    console.log('Missing env DEVICE_B_SERIAL_NUMBER=<SN e.g. from nrf-device-lister>');
+    process.exit(1);
+}
+
+function setNames(adapter, count) {
+    let names = Promise.resolve();
+
+    for (let i = 0; i < count; i += 1) {
+        names = names.then(() => new Promise((resolve, reject) => {
+            adapter.setName(`central${i}`, err => (err ? reject(err) : resolve()));
+        }));
+    }
+
+    return names;
+}
+
+function stopTracing(adapter, tracePath) {
+    return new Promise((resolve, reject) => {
+        adapter.stopTracing(tracePath, err => {
+            if (err) {
+                reject(err);
+                return;
+            }
+
+            resolve(JSON.parse(fs.readFileSync(tracePath, 'utf8')).traceEvents);
+        });
+    });
+}
+
+function spans(traceEvents, category, name) {
+    return traceEvents.filter(traceEvent => traceEvent.cat === category && traceEvent.name === name);
+}
+
+describe('the API', () => {
+    let adapter;
+    let peripheralAdapter;
+    const tracePath = path.join(os.tmpdir(), `pc-ble-driver-js-trace-${process.pid}.json`);
+
+    beforeAll(async () => {
+        // Errors here will not stop the tests from running.
+        // Issue filed regarding this: https://github.com/facebook/jest/issues/2713
+        adapter = await grabAdapter(serialNumberA);
+        peripheralAdapter = await grabAdapter(serialNumberB);
+
+        await Promise.all([
+            setupAdapter(adapter, '#CENTRAL', 'central', CENTRAL_DEVICE_ADDRESS, CENTRAL_DEVICE_ADDRESS_TYPE),
+            setupAdapter(peripheralAdapter, '#PERIPH', 'periph', PERIPHERAL_DEVICE_ADDRESS, PERIPHERAL_DEVICE_ADDRESS_TYPE)]);
+
+        await common.startAdvertising(peripheralAdapter);
+    });
+
+    afterAll(async () => {
+        if (fs.existsSync(tracePath)) {
+            fs.unlinkSync(tracePath);
+        }
+
+        await Promise.all([
+            releaseAdapter(adapter.state.serialNumber),
+            releaseAdapter(peripheralAdapter.state.serialNumber)]);
+    });
+
+    it('shall trace commands and events', async () => {
+        adapter.startTracing();
+
+        await setNames(adapter, NUMBER_OF_CALLS);
+
+        const advertisingReport = new Promise(resolve => {
+            adapter.once('deviceDiscovered', device => {
+                debug(`Discovered ${device.address}`);
+                resolve();
+            });
+        });
+
+        await new Promise((resolve, reject) => {
+            adapter.startScan({
+                active: true,
+                interval: 100,
+                window: 50,
+                timeout: 2,
+            }, err => (err ? reject(err) : resolve()));
+        });
+
+        await outcome([advertisingReport], SCAN_DURATION_WAIT_TIME);
+
+        await new Promise((resolve, reject) => {
+            adapter.stopScan(err => (err ? reject(err) : resolve()));
+        });
+
+        const traceEvents = await stopTracing(adapter, tracePath);
+        debug(`Trace has ${traceEvents.length} events`);
+
+        const calls = spans(traceEvents, 'command.call', 'gapSetDeviceName');
+        expect(calls.length).toBe(NUMBER_OF_CALLS);
+        calls.forEach(call => {
+            expect(call.ph).toBe('X');
+            expect(call.dur).toBeGreaterThan(0);
+        });
+
+        expect(spans(traceEvents, 'event.toJs', 'BLE_GAP_EVT_ADV_REPORT').length).toBeGreaterThan(0);
+
+        // Async spans are written as begin and end pairs
+        const queued = spans(traceEvents, 'command.queue', 'gapSetDeviceName');
+        expect(queued.filter(span => span.ph === 'b').length).toBe(NUMBER_OF_CALLS);
+        expect(queued.filter(span => span.ph === 'e').length).toBe(NUMBER_OF_CALLS);
+
+        // Each adapter is a named process
+        const processNames = traceEvents.filter(traceEvent => traceEvent.name === 'process_name');
+        calls.forEach(call => {
+            expect(processNames.some(processName => processName.pid === call.pid)).toBe(true);
+        });
+    });
+
+    it('shall only write the spans recorded since tracing started', async () => {
+        await setNames(adapter, 1);
+
+        adapter.startTracing({ bufferSize: 1024 });
+        await setNames(adapter, 1);
+
+        const traceEvents = await stopTracing(adapter, tracePath);
+
+        expect(spans(traceEvents, 'command.call', 'gapSetDeviceName').length).toBe(1);
+        expect(spans(traceEvents, 'event.toJs', 'BLE_GAP_EVT_ADV_REPORT').length).toBe(0);
+    });
+});
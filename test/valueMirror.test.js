@@ -0,0 +1,251 @@
+/* Copyright (c) 2010 - 2017, Nordic Semiconductor ASA
+ *
+ * All rights reserved.
+ *
+ * Use in source and binary forms, redistribution in binary form only, with
+ * or without modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions in binary form, except as embedded into a Nordic
+ *    Semiconductor ASA integrated circuit in a product or a software update for
+ *    such product, must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other
+ *    materials provided with the distribution.
+ *
+ * 2. Neither the name of Nordic Semiconductor ASA nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * 3. This software, with or without modification, must only be used with a Nordic
+ *    Semiconductor ASA integrated circuit.
+ *
+ * 4. Any software provided in binary form under this license must not be reverse
+ *    engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY NORDIC SEMICONDUCTOR ASA "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NORDIC SEMICONDUCTOR ASA OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+ * TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+'use strict';
+
+const { grabAdapter, releaseAdapter, setupAdapter, outcome } = require('./setup');
+const common = require('./common');
+
+const api = require('../index');
+const debug = require('debug')('ble-driver:test:valueMirror');
+
+const serviceFactory = new api.ServiceFactory();
+
+const PERIPHERAL_DEVICE_ADDRESS = 'FF:11:22:33:AA:CE';
+const PERIPHERAL_DEVICE_ADDRESS_TYPE = 'BLE_GAP_ADDR_TYPE_RANDOM_STATIC';
+
+const CENTRAL_DEVICE_ADDRESS = 'FF:11:22:33:AA:CF';
+const CENTRAL_DEVICE_ADDRESS_TYPE = 'BLE_GAP_ADDR_TYPE_RANDOM_STATIC';
+
+const SERVICE_UUID = 'F00AF000AAAAAAAAAAAAAAAAAAAAAAAA';
+const CHAR_VALUE_UUID = 'F00AF001AAAAAAAAAAAAAAAAAAAAAAAA';
+
+// Longer than one write request, so that it is written with prepared writes
+const MAX_LENGTH = 60;
+
+const serialNumberA = process.env.DEVICE_A_SERIAL_NUMBER;
+if (!serialNumberA) {
+    console.log('Missing env DEVICE_A_SERIAL_NUMBER=<SN e.g. from nrf-device-lister>');
+    process.exit(1);
+}
+
+const serialNumberB = process.env.DEVICE_B_SERIAL_NUMBER;
+if (!serialNumberB) {
+    console.log('Missing env DEVICE_B_SERIAL_NUMBER=<SN e.g. from nrf-device-lister>');
+    process.exit(1);
+}
+
+function servicesInit(adapter) {
+    const service = serviceFactory.createService(SERVICE_UUID);
+    const valueCharacteristic = common.addCharacteristicWithCccd(serviceFactory, service, CHAR_VALUE_UUID, {
+        read: true,
+        write: true,
+        notify: true,
+    }, {
+        maxLength: MAX_LENGTH,
+        variableLength: true,
+    });
+
+    return new Promise((resolve, reject) => {
+        adapter.setServices([service], err => {
+            if (err) {
+                return reject(new Error(`Error initializing services: ${JSON.stringify(err, null, 1)}'.`));
+            }
+
+            return resolve({ value: valueCharacteristic.instanceId });
+        });
+    });
+}
+
+function sequence(length, start = 0) {
+    const value = [];
+    for (let i = 0; i < length; i += 1) {
+        value.push((start + i) & 0xFF);
+    }
+
+    return value;
+}
+
+function setLocalValue(adapter, attributeId, value) {
+    return new Promise((resolve, reject) => {
+        adapter.setLocalValues([{ attributeId, value }], err => (err ? reject(err) : resolve()));
+    });
+}
+
+// Served from the mirror of the binding once it has the value
+function getLocalValue(adapter, attributeId) {
+    return new Promise((resolve, reject) => {
+        adapter.getLocalValues([attributeId], (err, values) => (
+            err ? reject(err) : resolve(Array.from(values[attributeId]))
+        ));
+    });
+}
+
+function valueChanged(adapter, attributeId) {
+    return new Promise(resolve => {
+        const onValueChanged = characteristic => {
+            if (characteristic.instanceId === attributeId) {
+                adapter.removeListener('characteristicValueChanged', onValueChanged);
+                resolve();
+            }
+        };
+
+        adapter.on('characteristicValueChanged', onValueChanged);
+    });
+}
+
+describe('the API', () => {
+    let centralAdapter;
+    let peripheralAdapter;
+    let peripheralDevice;
+    let localCharacteristics;
+    let remoteCharacteristics;
+
+    beforeAll(async () => {
+        // Errors here will not stop the tests from running.
+        // Issue filed regarding this: https://github.com/facebook/jest/issues/2713
+
+        centralAdapter = await grabAdapter(serialNumberA);
+        peripheralAdapter = await grabAdapter(serialNumberB);
+
+        await Promise.all([
+            setupAdapter(centralAdapter, '#CENTRAL', 'central', CENTRAL_DEVICE_ADDRESS, CENTRAL_DEVICE_ADDRESS_TYPE),
+            setupAdapter(peripheralAdapter, '#PERIPH', 'peripheral', PERIPHERAL_DEVICE_ADDRESS, PERIPHERAL_DEVICE_ADDRESS_TYPE)]);
+
+        localCharacteristics = await servicesInit(peripheralAdapter);
+
+        const [connection] = await outcome([
+            common.connectAndDiscover(centralAdapter, peripheralAdapter, {
+                address: PERIPHERAL_DEVICE_ADDRESS,
+                type: PERIPHERAL_DEVICE_ADDRESS_TYPE,
+            }),
+        ], 10000);
+
+        ({ peripheralDevice } = connection);
+        remoteCharacteristics = common.findCharacteristics(connection.attributes, { value: CHAR_VALUE_UUID });
+    });
+
+    afterAll(async () => {
+        debug('releasing adapters');
+        await Promise.all([
+            releaseAdapter(centralAdapter.state.serialNumber),
+            releaseAdapter(peripheralAdapter.state.serialNumber)]);
+    });
+
+    // Each test first gets the value, so that the binding mirrors it before it is changed
+
+    it('shall get the values set from JavaScript', async () => {
+        await outcome([setLocalValue(peripheralAdapter, localCharacteristics.value, sequence(10))]);
+
+        const [first, second] = await outcome([
+            getLocalValue(peripheralAdapter, localCharacteristics.value),
+            getLocalValue(peripheralAdapter, localCharacteristics.value),
+        ]);
+
+        expect(first).toEqual(sequence(10));
+        expect(second).toEqual(sequence(10));
+
+        await outcome([setLocalValue(peripheralAdapter, localCharacteristics.value, sequence(10, 0x10))]);
+
+        const [changed] = await outcome([getLocalValue(peripheralAdapter, localCharacteristics.value)]);
+        expect(changed).toEqual(sequence(10, 0x10));
+    });
+
+    it('shall get the values set with a single value write', async () => {
+        await outcome([getLocalValue(peripheralAdapter, localCharacteristics.value)]);
+
+        await outcome([
+            new Promise((resolve, reject) => {
+                peripheralAdapter.writeCharacteristicValue(localCharacteristics.value, sequence(12, 0x20), false, err => (
+                    err ? reject(err) : resolve()
+                ));
+            }),
+        ]);
+
+        const [value] = await outcome([getLocalValue(peripheralAdapter, localCharacteristics.value)]);
+        expect(value).toEqual(sequence(12, 0x20));
+    });
+
+    it('shall get the values the central writes, also when they are shorter', async () => {
+        await outcome([getLocalValue(peripheralAdapter, localCharacteristics.value)]);
+
+        await outcome([
+            common.writeValue(centralAdapter, remoteCharacteristics.value, [9, 8], true),
+            valueChanged(peripheralAdapter, localCharacteristics.value),
+        ]);
+
+        const [value] = await outcome([getLocalValue(peripheralAdapter, localCharacteristics.value)]);
+        expect(value).toEqual([9, 8]);
+    });
+
+    it('shall get the values the central writes with prepared writes', async () => {
+        await outcome([getLocalValue(peripheralAdapter, localCharacteristics.value)]);
+
+        await outcome([
+            common.writeValue(centralAdapter, remoteCharacteristics.value, sequence(MAX_LENGTH, 0x30), true),
+            valueChanged(peripheralAdapter, localCharacteristics.value),
+        ]);
+
+        const [value] = await outcome([getLocalValue(peripheralAdapter, localCharacteristics.value)]);
+        expect(value).toEqual(sequence(MAX_LENGTH, 0x30));
+    });
+
+    it('shall get the values sent in notifications', async () => {
+        await outcome([common.subscribe(centralAdapter, peripheralAdapter, remoteCharacteristics.value, false)]);
+        await outcome([getLocalValue(peripheralAdapter, localCharacteristics.value)]);
+
+        const [, values] = await outcome([
+            new Promise((resolve, reject) => {
+                peripheralAdapter.notifyAll(localCharacteristics.value, sequence(20, 0x40), err => (
+                    err ? reject(err) : resolve()
+                ));
+            }),
+            common.receiveValues(centralAdapter, remoteCharacteristics.value, 1),
+        ]);
+
+        expect(values).toEqual([sequence(20, 0x40)]);
+
+        const [value] = await outcome([getLocalValue(peripheralAdapter, localCharacteristics.value)]);
+        expect(value).toEqual(sequence(20, 0x40));
+    });
+
+    it('shall keep the values that are not per connection after a disconnect', async () => {
+        await outcome([common.disconnect(centralAdapter, peripheralAdapter, peripheralDevice)]);
+
+        const [value] = await outcome([getLocalValue(peripheralAdapter, localCharacteristics.value)]);
+        expect(value).toEqual(sequence(20, 0x40));
+    });
+});
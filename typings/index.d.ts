@@ -14,6 +14,7 @@ export declare interface AdapterOpenOptions {
   retransmissionInterval?: number;
   responseTimeout?: number;
   enableBLE?: boolean;
+  autoConfirmIndications?: boolean;
 }
 
 export declare interface AdapterStatus {
@@ -211,15 +212,35 @@ declare class Adapter extends EventEmitter {
   requestAttMtu(deviceInstanceId: string, mtu: number, callback?: (err: any, value: number) => void): void;
   getCurrentAttMtu(deviceInstanceId: string): number|undefined;
 
+  setGattCacheDirectory(directory: string | null): void;
   getService(serviceInstanceId: string): Service;
+  discoverAll(deviceInstanceId: string, callback?: (err: any, attributes: any) => void): void;
   getServices(deviceInstanceId: string, callback?: (err: any, services: Array<Service>) => void): void;
   getCharacteristic(characteristicId: string): Characteristic;
   getCharacteristics(serviceInstanceId: string, callback?: (err: any, services: Array<Characteristic>) => void): void;
   getDescriptor(descriptorId: string): Descriptor;
   getDescriptors(characteristicId: string, callback?: (err?: any, descriptors?: Array<Descriptor>) => void): void;
   readCharacteristicValue(characteristicId: string, callback?: (err: any, bytesRead: Array<number>) => void): void;
+  /** Without ack the callback is called when the SoftDevice has accepted the write command, not when it has been sent. */
   writeCharacteristicValue(characteristicId: string, value: Array<number>, ack: boolean, callback?: (error: Error) => void): void;
+  writeCharacteristicValueStream(characteristicId: string, data: Buffer | Array<number>, progress?: (bytesWritten: number, bytesTotal: number) => void, callback?: (err: any, bytesWritten: number) => void): void;
   readDescriptorValue(descriptorId: string, callback?: (err: any, value: Array<number>) => void): void;
+  readMany(deviceInstanceId: string, attributes: Array<number | { handle: number, length?: number }>, callback?: (err: any, values: { [handle: number]: Array<number> }) => void): void;
+  startCharacteristicsNotificationBuffer(characteristicId: string, capacity: number, callback?: (err: any) => void): void;
+  drainCharacteristicNotifications(characteristicId: string): { data: Buffer, offsets: Array<number>, timestamps: Array<number>, dropped: number };
+  subscribeMany(subscriptions: Array<{ characteristicId: string, mode: number }>, callback?: (err: any, errors: Array<any>) => void): void;
+  queueNotification(deviceInstanceId: string, characteristicId: string, value: Array<number> | Buffer, callback?: (err: any) => void): boolean;
+  notifyAll(characteristicId: string, value: Array<number> | Buffer, callback?: (err: any, errors: { [deviceInstanceId: string]: any }) => void): void;
+  queueIndication(deviceInstanceId: string, characteristicId: string, value: Array<number> | Buffer, callback?: (err: any) => void): void;
+  setIndicationTimeout(milliseconds: number): void;
+  setNotificationWeight(deviceInstanceId: string, weight: number): void;
+  startLocalAttributeStore(attributeId: string, options?: { serveReads?: boolean, writes?: 'accept' | 'reject' | 'pass', maxLength?: number, rejectStatus?: number }): void;
+  stopLocalAttributeStore(attributeId: string): void;
+  setSystemAttributeDirectory(directory: string): void;
+  /** Buffers are read in place until the callback is called, they must not be changed before then. */
+  setLocalValues(values: Array<{ attributeId: string, value: Array<number> | Buffer, offset?: number }>, callback?: (err: any, errors: Array<any>) => void): void;
+  getLocalValues(attributeIds: Array<string>, callback: (err: any, values?: { [attributeId: string]: Buffer }) => void): void;
+  /** Without ack the callback is called when the SoftDevice has accepted the write command, not when it has been sent. */
   writeDescriptorValue(descriptorId: string, value: Array<number>, ack: boolean, callback?: (error: Error) => void): void;
 
   authenticate(deviceInstanceId: string, secParams: any, callback?: (err: any) => void): void;
@@ -266,12 +287,15 @@ declare class Adapter extends EventEmitter {
   on(event: 'attMtuChanged', listener: (device: Device, newMtu: number) => void): this;
   on(event: 'deviceNotifiedOrIndicated', listener: (remoteDevice: Device, characteristic: Characteristic) => void): this;
   on(event: 'txComplete', listener: (remoteDevice: Device, count: number) => void): this;
+  on(event: 'notificationQueueDrain', listener: (device: Device) => void): this;
+  on(event: 'attributeReadsServed', listener: (attribute: Characteristic | Descriptor, reads: number) => void): this;
   on(event: 'dataLengthChanged', listener: (remoteDevice: Device, maxTxOctets: number) => void): this;
 }
 
 export declare class AdapterFactory extends EventEmitter {
   static getInstance(): AdapterFactory;
   getAdapters(callback?: (err: any, adapters: Adapter[]) => void): void;
+  stopMonitoring(): void;
   createAdapter(sdVersion: 'v2' | 'v5', path: string, instanceId: string): Adapter;
 }
 